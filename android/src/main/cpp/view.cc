@@ -77,4 +77,13 @@ Java_com_ollix_moui_View_shouldHandleEventFromJNI(
   return view->ShouldHandleEvent({x, y});
 }
 
+// Asks moui view if the animating view should render the current frame.
+JNIEXPORT jboolean
+JNICALL
+Java_com_ollix_moui_View_shouldRenderFrameFromJNI(
+    JNIEnv* env, jobject, jlong moui_view_ptr) {
+  auto view = reinterpret_cast<moui::View*>(moui_view_ptr);
+  return view->ShouldRenderFrame();
+}
+
 }  // extern "C"
@@ -35,6 +35,7 @@ abstract class View(context: Context, mouiViewPtr: Long)
     private var handlingEvent = false
     private var isAnimating = false
     private val mouiViewPtr: Long
+    private var needsRedraw = false
 
     init {
         displayDensity = context.getResources().getDisplayMetrics().density
@@ -94,21 +95,38 @@ abstract class View(context: Context, mouiViewPtr: Long)
             return
         }
 
+        /**
+         * Skips the frame if nothing requested a redraw and the animations
+         * don't need a new frame yet.
+         */
+        val isAnimatingFrame = isAnimating && !animationIsPaused
+        if (isAnimatingFrame && !needsRedraw &&
+                !shouldRenderFrameFromJNI(mouiViewPtr)) {
+            postFrameCallback()
+            return
+        }
+        needsRedraw = false
+
         prepareDrawable()
         drawFrameFromJNI(mouiViewPtr)
         presentDrawable()
 
-        if (isAnimating && !animationIsPaused) {
-            redrawView()
+        if (isAnimatingFrame) {
+            postFrameCallback()
         }
     }
 
-    fun redrawView() {
+    private fun postFrameCallback() {
         if (drawableIsValid) {
             Choreographer.getInstance().postFrameCallback(frameCallback)
         }
     }
 
+    fun redrawView() {
+        needsRedraw = true
+        postFrameCallback()
+    }
+
     fun setBackgroundOpaque(isOpaque: Boolean) {
         backgroundIsOpaque = isOpaque
     }
@@ -179,4 +197,6 @@ abstract class View(context: Context, mouiViewPtr: Long)
                                           y: Float): Boolean
 
     external fun onSurfaceDestroyedFromJNI(mouiViewPtr: Long)
+
+    external fun shouldRenderFrameFromJNI(mouiViewPtr: Long): Boolean
 }
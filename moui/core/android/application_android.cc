@@ -26,6 +26,7 @@
 
 namespace {
 
+AAssetManager* asset_manager_native = nullptr;
 JavaVM* java_vm = nullptr;
 jobject main_activity = nullptr;
 
@@ -42,7 +43,12 @@ void Application::InitJNI(JNIEnv* env, jobject activity,
   env->GetJavaVM(&java_vm);
 
   // Initializes the aasset library.
-  aasset_init(AAssetManager_fromJava(env, asset_manager));
+  asset_manager_native = AAssetManager_fromJava(env, asset_manager);
+  aasset_init(asset_manager_native);
+}
+
+AAssetManager* Application::GetAssetManager() {
+  return asset_manager_native;
 }
 
 JNIEnv* Application::GetJNIEnv() {
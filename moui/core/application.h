@@ -23,6 +23,8 @@
 
 #ifdef MOUI_ANDROID
 #include "jni.h"  // NOLINT
+
+#include <android/asset_manager.h>
 #endif  // MOUI_ANDROID
 
 namespace moui {
@@ -58,6 +60,10 @@ class Application : public BaseApplication {
   // Initializes the JNI environemnt. This method must be called at least once.
   static void InitJNI(JNIEnv* env, jobject activity, jobject asset_manager);
 
+  // Returns the native asset manager of the `AssetManager` object that set in
+  // the `InitJNI()` method.
+  static AAssetManager* GetAssetManager();
+
   // Returns the `JNIEnv` variable that set in the `InitJNI()` method.
   static JNIEnv* GetJNIEnv();
 
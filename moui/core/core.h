@@ -22,7 +22,14 @@
 #include "moui/core/clock.h"
 #include "moui/core/device.h"
 #include "moui/core/event.h"
+#include "moui/core/fenwick_tree.h"
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/core/image_loader.h"
+#include "moui/core/index_set.h"
 #include "moui/core/log.h"
 #include "moui/core/path.h"
+#include "moui/core/resource_archive.h"
+#include "moui/core/shelf_packer.h"
+#include "moui/core/text_layout_engine.h"
 
 #endif  // MOUI_CORE_CORE_H_
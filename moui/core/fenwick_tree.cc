@@ -0,0 +1,107 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/fenwick_tree.h"
+
+#include <vector>
+
+namespace moui {
+
+FenwickTree::FenwickTree() {
+}
+
+FenwickTree::~FenwickTree() {
+}
+
+void FenwickTree::Assign(const std::vector<double>& values) {
+  values_ = values;
+  const int kSize = size();
+  tree_.assign(kSize + 1, 0);
+  for (int i = 1; i <= kSize; ++i) {
+    tree_[i] += values_[i - 1];
+    const int kParent = i + (i & -i);
+    if (kParent <= kSize)
+      tree_[kParent] += tree_[i];
+  }
+}
+
+void FenwickTree::AssignFrom(const int index,
+                             const std::vector<double>& values) {
+  values_.resize(index);
+  values_.insert(values_.end(), values.begin(), values.end());
+  const int kSize = size();
+  tree_.resize(kSize + 1, 0);
+
+  // Positions up to `index` only cover the kept values. Every position after
+  // it keeps the difference of two prefix sums, where the prefix sums before
+  // `index + 1` are still answered by the kept positions.
+  std::vector<double> prefix_sums(kSize - index + 1);
+  prefix_sums[0] = GetPrefixSum(index);
+  for (int i = index + 1; i <= kSize; ++i)
+    prefix_sums[i - index] = prefix_sums[i - index - 1] + values_[i - 1];
+  for (int i = index + 1; i <= kSize; ++i) {
+    const int kBegin = i - (i & -i);
+    const double kBeginPrefixSum = kBegin >= index ?
+                                   prefix_sums[kBegin - index] :
+                                   GetPrefixSum(kBegin);
+    tree_[i] = prefix_sums[i - index] - kBeginPrefixSum;
+  }
+}
+
+void FenwickTree::Clear() {
+  tree_.clear();
+  values_.clear();
+}
+
+int FenwickTree::FindLowerBound(const double target) const {
+  const int kSize = size();
+  int bit_mask = 1;
+  while ((bit_mask << 1) <= kSize)
+    bit_mask <<= 1;
+
+  // Finds the largest position whose prefix sum is less than `target`.
+  int position = 0;
+  double sum = 0;
+  for (; bit_mask > 0; bit_mask >>= 1) {
+    const int kNextPosition = position + bit_mask;
+    if (kNextPosition <= kSize && sum + tree_[kNextPosition] < target) {
+      position = kNextPosition;
+      sum += tree_[kNextPosition];
+    }
+  }
+  return position;
+}
+
+double FenwickTree::GetPrefixSum(const int count) const {
+  double sum = 0;
+  for (int i = count; i > 0; i -= (i & -i))
+    sum += tree_[i];
+  return sum;
+}
+
+void FenwickTree::SetValue(const int index, const double value) {
+  const double kDelta = value - values_[index];
+  if (kDelta == 0)
+    return;
+
+  values_[index] = value;
+  const int kSize = size();
+  for (int i = index + 1; i <= kSize; i += (i & -i))
+    tree_[i] += kDelta;
+}
+
+}  // namespace moui
@@ -0,0 +1,81 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_FENWICK_TREE_H_
+#define MOUI_CORE_FENWICK_TREE_H_
+
+#include <vector>
+
+#include "moui/base.h"
+
+namespace moui {
+
+// The `FenwickTree` class maintains prefix sums of a sequence of non-negative
+// values. Both updating a single value and querying a prefix sum take
+// O(log n) time, which makes it suitable for indexing the offsets of a large
+// number of variable-length items such as the rows of a table view.
+class FenwickTree {
+ public:
+  FenwickTree();
+  ~FenwickTree();
+
+  // Replaces all values with the passed `values` in O(n) time.
+  void Assign(const std::vector<double>& values);
+
+  // Keeps the first `index` values and replaces the rest with the passed
+  // `values` in O(k + log^2 n) time for k replaced values, so changes near
+  // the end don't rebuild the whole tree.
+  void AssignFrom(const int index, const std::vector<double>& values);
+
+  // Removes all values.
+  void Clear();
+
+  // Returns the smallest index whose inclusive prefix sum is greater than or
+  // equal to the specified `target`. Returns `size()` if no such index exists.
+  // The result is only meaningful if all values are non-negative.
+  int FindLowerBound(const double target) const;
+
+  // Returns the sum of the first `count` values.
+  double GetPrefixSum(const int count) const;
+
+  // Returns the sum of all values.
+  double GetTotal() const { return GetPrefixSum(size()); }
+
+  // Returns the value at the specified index.
+  double GetValue(const int index) const { return values_[index]; }
+
+  // Sets the value at the specified index.
+  void SetValue(const int index, const double value);
+
+  // Accessors and setters.
+  bool empty() const { return values_.empty(); }
+  int size() const { return static_cast<int>(values_.size()); }
+
+ private:
+  // The implicit tree whose element at position `i` keeps the sum of values
+  // in the range `(i - lowbit(i), i]`. The element at position 0 is unused.
+  std::vector<double> tree_;
+
+  // Keeps a copy of every value for constant-time lookups.
+  std::vector<double> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(FenwickTree);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_FENWICK_TREE_H_
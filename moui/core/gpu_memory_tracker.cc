@@ -0,0 +1,198 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/gpu_memory_tracker.h"
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#include "moui/nanovg_hook.h"
+
+namespace {
+
+// Returns the demangled name of the class name returned by
+// `typeid().name()`, or the name itself if it cannot be demangled.
+std::string DemangleClassName(const char* name) {
+  int status = 0;
+  char* demangled_name = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (demangled_name == nullptr)
+    return name;
+  const std::string kResult = demangled_name;
+  std::free(demangled_name);
+  return kResult;
+}
+
+}  // namespace
+
+namespace moui {
+
+GpuMemoryTracker::GpuMemoryTracker()
+    : current_owner_(nullptr), current_owner_class_(nullptr),
+      peak_number_of_bytes_(0), total_usage_({0, 0, 0}) {
+}
+
+GpuMemoryTracker::~GpuMemoryTracker() {
+}
+
+GpuMemoryTracker::ScopedOwner::ScopedOwner(const void* owner,
+                                           const char* owner_class) {
+  GpuMemoryTracker* tracker = GpuMemoryTracker::GetSharedTracker();
+  previous_owner_ = tracker->current_owner_;
+  previous_owner_class_ = tracker->current_owner_class_;
+  tracker->current_owner_ = owner;
+  tracker->current_owner_class_ = owner_class;
+}
+
+GpuMemoryTracker::ScopedOwner::~ScopedOwner() {
+  GpuMemoryTracker* tracker = GpuMemoryTracker::GetSharedTracker();
+  tracker->current_owner_ = previous_owner_;
+  tracker->current_owner_class_ = previous_owner_class_;
+}
+
+void GpuMemoryTracker::AddAllocation(NVGcontext* context, const int image,
+                                     const bool is_framebuffer,
+                                     const size_t number_of_bytes) {
+  if (image < 0)
+    return;
+
+  // Replaces the stale allocation if the image id is reused.
+  RemoveAllocation(context, image);
+
+  const Allocation kAllocation = {is_framebuffer, number_of_bytes,
+                                  current_owner_, current_owner_class_};
+  allocations_[context][image] = kAllocation;
+  UpdateUsage(kAllocation, 1, &total_usage_);
+  UpdateOwnerUsage(kAllocation, 1);
+  peak_number_of_bytes_ = std::max(peak_number_of_bytes_,
+                                   total_usage_.number_of_bytes);
+}
+
+void GpuMemoryTracker::ChangeOwner(NVGcontext* context, const int image,
+                                   const void* owner,
+                                   const char* owner_class) {
+  auto context_match = allocations_.find(context);
+  if (context_match == allocations_.end())
+    return;
+  auto match = context_match->second.find(image);
+  if (match == context_match->second.end())
+    return;
+
+  Allocation* allocation = &match->second;
+  UpdateOwnerUsage(*allocation, -1);
+  allocation->owner = owner;
+  allocation->owner_class = owner_class;
+  UpdateOwnerUsage(*allocation, 1);
+}
+
+GpuMemoryTracker* GpuMemoryTracker::GetSharedTracker() {
+  static GpuMemoryTracker* shared_tracker = new GpuMemoryTracker;
+  return shared_tracker;
+}
+
+std::unordered_map<std::string, GpuMemoryTracker::Usage>
+GpuMemoryTracker::GetUsageByClass() const {
+  // Groups by the mangled names first to demangle each class only once.
+  std::unordered_map<const char*, Usage> mangled_usages;
+  for (auto& context_allocations : allocations_) {
+    for (auto& image_allocation : context_allocations.second) {
+      const Allocation& kAllocation = image_allocation.second;
+      auto insertion = mangled_usages.insert(
+          {kAllocation.owner_class, Usage{0, 0, 0}});
+      UpdateUsage(kAllocation, 1, &insertion.first->second);
+    }
+  }
+
+  std::unordered_map<std::string, Usage> usages;
+  for (auto& mangled_usage : mangled_usages) {
+    const std::string kClassName = \
+        mangled_usage.first == nullptr ?
+        "" : DemangleClassName(mangled_usage.first);
+    auto insertion = usages.insert({kClassName, Usage{0, 0, 0}});
+    Usage* usage = &insertion.first->second;
+    usage->number_of_bytes += mangled_usage.second.number_of_bytes;
+    usage->number_of_framebuffers += \
+        mangled_usage.second.number_of_framebuffers;
+    usage->number_of_images += mangled_usage.second.number_of_images;
+  }
+  return usages;
+}
+
+GpuMemoryTracker::Usage GpuMemoryTracker::GetUsageForOwner(
+    const void* owner) const {
+  auto match = owner_usages_.find(owner);
+  if (match == owner_usages_.end())
+    return Usage{0, 0, 0};
+  return match->second;
+}
+
+void GpuMemoryTracker::RemoveAllocation(NVGcontext* context,
+                                        const int image) {
+  auto context_match = allocations_.find(context);
+  if (context_match == allocations_.end())
+    return;
+  auto match = context_match->second.find(image);
+  if (match == context_match->second.end())
+    return;
+
+  UpdateUsage(match->second, -1, &total_usage_);
+  UpdateOwnerUsage(match->second, -1);
+  context_match->second.erase(match);
+}
+
+void GpuMemoryTracker::RemoveContext(NVGcontext* context) {
+  auto context_match = allocations_.find(context);
+  if (context_match == allocations_.end())
+    return;
+
+  for (auto& image_allocation : context_match->second) {
+    UpdateUsage(image_allocation.second, -1, &total_usage_);
+    UpdateOwnerUsage(image_allocation.second, -1);
+  }
+  allocations_.erase(context_match);
+}
+
+void GpuMemoryTracker::ResetPeakNumberOfBytes() {
+  peak_number_of_bytes_ = total_usage_.number_of_bytes;
+}
+
+void GpuMemoryTracker::UpdateOwnerUsage(const Allocation& allocation,
+                                        const int sign) {
+  auto insertion = owner_usages_.insert({allocation.owner, Usage{0, 0, 0}});
+  Usage* usage = &insertion.first->second;
+  UpdateUsage(allocation, sign, usage);
+  if (usage->number_of_framebuffers == 0 && usage->number_of_images == 0)
+    owner_usages_.erase(insertion.first);
+}
+
+void GpuMemoryTracker::UpdateUsage(const Allocation& allocation,
+                                   const int sign, Usage* usage) {
+  if (sign > 0)
+    usage->number_of_bytes += allocation.number_of_bytes;
+  else
+    usage->number_of_bytes -= allocation.number_of_bytes;
+  if (allocation.is_framebuffer)
+    usage->number_of_framebuffers += sign;
+  else
+    usage->number_of_images += sign;
+}
+
+}  // namespace moui
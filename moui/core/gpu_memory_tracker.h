@@ -0,0 +1,159 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_GPU_MEMORY_TRACKER_H_
+#define MOUI_CORE_GPU_MEMORY_TRACKER_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `GpuMemoryTracker` class accounts for the textures created through
+// `nanovg_hook`: framebuffers created by `nvgCreateFramebuffer()` and images
+// created by `nvgCreateImageAtPath()`, `nvgCreateImageFromPixels()` and
+// `nvgCreateTrackedImageRGBA()`. Images created by calling nanovg directly,
+// including the font atlas of fontstash, are not tracked. Sizes are
+// estimated from the texture dimensions as the GPU drivers don't report
+// them.
+//
+// Every allocation is attributed to the owner that is current when it is
+// created. `WidgetView` makes each widget the owner while preparing and
+// rendering its offscreen content, and shared caches take over the
+// allocations they keep. Allocations without an owner are attributed to
+// `nullptr`. This class is not thread-safe and must be used on the main
+// thread.
+class GpuMemoryTracker {
+ public:
+  // The memory used by a set of allocations.
+  struct Usage {
+    // The estimated number of bytes.
+    size_t number_of_bytes;
+    // The number of framebuffers.
+    int number_of_framebuffers;
+    // The number of images not belonging to framebuffers.
+    int number_of_images;
+  };
+
+  // Makes the passed owner current for the lifetime of the object, and
+  // restores the previous owner on destruction. `owner_class` must outlive
+  // the allocations, such as a string literal or `typeid().name()`, which is
+  // demangled by `GetUsageByClass()`.
+  class ScopedOwner {
+   public:
+    ScopedOwner(const void* owner, const char* owner_class);
+    ~ScopedOwner();
+
+   private:
+    const void* previous_owner_;
+    const char* previous_owner_class_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedOwner);
+  };
+
+  // Returns the tracker shared by the entire process.
+  static GpuMemoryTracker* GetSharedTracker();
+
+  // Records the texture of the framebuffer or image created in the context.
+  // The allocation is attributed to the current owner.
+  void AddAllocation(NVGcontext* context, const int image,
+                     const bool is_framebuffer, const size_t number_of_bytes);
+
+  // Attributes an existing allocation to the specified owner. This is called
+  // by caches keeping textures created by others.
+  void ChangeOwner(NVGcontext* context, const int image, const void* owner,
+                   const char* owner_class);
+
+  // Returns the memory used by all allocations.
+  Usage GetTotalUsage() const { return total_usage_; }
+
+  // Returns the memory used by allocations of each owner class. The keys are
+  // demangled class names, and "" for allocations without an owner class.
+  std::unordered_map<std::string, Usage> GetUsageByClass() const;
+
+  // Returns the memory used by allocations of each owner.
+  std::unordered_map<const void*, Usage> GetUsageByOwner() const {
+    return owner_usages_;
+  }
+
+  // Returns the memory used by allocations of the specified owner.
+  Usage GetUsageForOwner(const void* owner) const;
+
+  // Forgets the allocation when its texture is deleted.
+  void RemoveAllocation(NVGcontext* context, const int image);
+
+  // Forgets all allocations of the context. This method must be called
+  // before the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Resets the high-water mark to the current number of bytes.
+  void ResetPeakNumberOfBytes();
+
+  // Accessors.
+  size_t peak_number_of_bytes() const { return peak_number_of_bytes_; }
+
+ private:
+  // A tracked texture.
+  struct Allocation {
+    // Indicates whether the texture belongs to a framebuffer.
+    bool is_framebuffer;
+    // The estimated number of bytes.
+    size_t number_of_bytes;
+    // The owner and its class the allocation is attributed to.
+    const void* owner;
+    const char* owner_class;
+  };
+
+  GpuMemoryTracker();
+  ~GpuMemoryTracker();
+
+  // Adds the allocation to `usage`, or subtracts it if `sign` is negative.
+  static void UpdateUsage(const Allocation& allocation, const int sign,
+                          Usage* usage);
+
+  // Adds the allocation to the usages of its owner, or subtracts it if
+  // `sign` is negative.
+  void UpdateOwnerUsage(const Allocation& allocation, const int sign);
+
+  // The tracked allocations indexed by the image ids for each context.
+  std::unordered_map<NVGcontext*, std::unordered_map<int, Allocation>>
+      allocations_;
+
+  // The owner and its class new allocations are attributed to.
+  const void* current_owner_;
+  const char* current_owner_class_;
+
+  // The memory used by allocations of each owner.
+  std::unordered_map<const void*, Usage> owner_usages_;
+
+  // The highest number of bytes used at a time since the tracker was
+  // created or `ResetPeakNumberOfBytes()` was called.
+  size_t peak_number_of_bytes_;
+
+  // The memory used by all allocations.
+  Usage total_usage_;
+
+  DISALLOW_COPY_AND_ASSIGN(GpuMemoryTracker);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_GPU_MEMORY_TRACKER_H_
@@ -0,0 +1,234 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/image_loader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "moui/core/clock.h"
+#include "moui/core/resource_archive.h"
+#include "nanovg/src/stb_image.h"
+
+#if defined(MOUI_ANDROID)
+#  include "aasset.h"
+#endif
+
+namespace {
+
+// The number of threads decoding images.
+const int kNumberOfWorkerThreads = 2;
+
+// Closes the file opened by `OpenFile()`.
+void CloseFile(const std::string& path, std::FILE* file) {
+#ifdef MOUI_ANDROID
+  if (path.find("file:///android_assets/") == 0) {
+    aasset_fclose(file);
+    return;
+  }
+#endif  // MOUI_ANDROID
+  std::fclose(file);
+}
+
+// Downsamples the RGBA `pixels` of `width` by `height` pixels to
+// `bitmap->width` by `bitmap->height` pixels by averaging the covered source
+// pixels. Colors are weighted by their alpha values to avoid dark fringes
+// around transparent areas.
+void Downsample(const unsigned char* pixels, const int width,
+                const int height, moui::ImageLoader::Bitmap* bitmap) {
+  const int kTargetWidth = bitmap->width;
+  const int kTargetHeight = bitmap->height;
+  bitmap->pixels.resize(static_cast<size_t>(kTargetWidth) * kTargetHeight * 4);
+  unsigned char* target = bitmap->pixels.data();
+  for (int y = 0; y < kTargetHeight; ++y) {
+    const int kTop = static_cast<int64_t>(y) * height / kTargetHeight;
+    const int kBottom = std::max(
+        kTop + 1,
+        static_cast<int>(static_cast<int64_t>(y + 1) * height / kTargetHeight));
+    for (int x = 0; x < kTargetWidth; ++x) {
+      const int kLeft = static_cast<int64_t>(x) * width / kTargetWidth;
+      const int kRight = std::max(
+          kLeft + 1,
+          static_cast<int>(static_cast<int64_t>(x + 1) * width / kTargetWidth));
+      uint64_t red = 0, green = 0, blue = 0, alpha = 0;
+      for (int source_y = kTop; source_y < kBottom; ++source_y) {
+        const unsigned char* source = \
+            pixels + (static_cast<size_t>(source_y) * width + kLeft) * 4;
+        for (int source_x = kLeft; source_x < kRight; ++source_x) {
+          red += source[0] * source[3];
+          green += source[1] * source[3];
+          blue += source[2] * source[3];
+          alpha += source[3];
+          source += 4;
+        }
+      }
+      const int kCount = (kBottom - kTop) * (kRight - kLeft);
+      if (alpha > 0) {
+        target[0] = static_cast<unsigned char>(red / alpha);
+        target[1] = static_cast<unsigned char>(green / alpha);
+        target[2] = static_cast<unsigned char>(blue / alpha);
+      } else {
+        target[0] = target[1] = target[2] = 0;
+      }
+      target[3] = static_cast<unsigned char>(alpha / kCount);
+      target += 4;
+    }
+  }
+}
+
+// Opens the file at `path` for reading. Android assets are specified with
+// the "file:///android_assets/" prefix. Returns `NULL` on failure.
+std::FILE* OpenFile(const std::string& path) {
+#ifdef MOUI_ANDROID
+  if (path.find("file:///android_assets/") == 0)
+    return aasset_fopen(path.substr(23).c_str(), "r");
+#endif  // MOUI_ANDROID
+  return std::fopen(path.c_str(), "rb");
+}
+
+}  // namespace
+
+namespace moui {
+
+ImageLoader::ImageLoader() : last_request_id_(0),
+                             stops_worker_threads_(false) {
+}
+
+ImageLoader::~ImageLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stops_worker_threads_ = true;
+  }
+  pending_requests_condition_.notify_all();
+  for (std::thread& worker_thread : worker_threads_)
+    worker_thread.join();
+}
+
+void ImageLoader::CancelRequest(const int request_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  active_request_ids_.erase(request_id);
+  for (auto iterator = pending_requests_.begin();
+       iterator != pending_requests_.end(); ++iterator) {
+    if (iterator->id == request_id) {
+      pending_requests_.erase(iterator);
+      break;
+    }
+  }
+}
+
+bool ImageLoader::DecodeImage(const std::string& path, const int pixel_width,
+                              const int pixel_height, Bitmap* bitmap) {
+  int width = 0;
+  int height = 0;
+  int number_of_components;
+  unsigned char* pixels = nullptr;
+  const unsigned char* packed_data;
+  size_t packed_size;
+  if (ResourceArchive::GetSharedArchive()->GetData(path, &packed_data,
+                                                   &packed_size)) {
+    pixels = stbi_load_from_memory(packed_data, static_cast<int>(packed_size),
+                                   &width, &height, &number_of_components, 4);
+  } else {
+    std::FILE* file = OpenFile(path);
+    if (file == NULL)
+      return false;
+    pixels = stbi_load_from_file(file, &width, &height, &number_of_components,
+                                 4);
+    CloseFile(path, file);
+  }
+  if (pixels == nullptr)
+    return false;
+
+  // Determines the smallest size covering the pixel size.
+  float scale = 1;
+  if (pixel_width > 0 && pixel_height > 0) {
+    scale = std::min(1.0f, std::max(static_cast<float>(pixel_width) / width,
+                                    static_cast<float>(pixel_height) / height));
+  }
+  bitmap->width = std::max(1, static_cast<int>(std::ceil(width * scale)));
+  bitmap->height = std::max(1, static_cast<int>(std::ceil(height * scale)));
+  if (bitmap->width == width && bitmap->height == height) {
+    bitmap->pixels.assign(pixels,
+                          pixels + static_cast<size_t>(width) * height * 4);
+  } else {
+    Downsample(pixels, width, height, bitmap);
+  }
+  stbi_image_free(pixels);
+  return true;
+}
+
+ImageLoader* ImageLoader::GetSharedLoader() {
+  static ImageLoader* shared_loader = new ImageLoader;
+  return shared_loader;
+}
+
+int ImageLoader::LoadImage(const std::string& path, const int pixel_width,
+                           const int pixel_height, Callback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int kRequestId = ++last_request_id_;
+  active_request_ids_.insert(kRequestId);
+  pending_requests_.push_back(
+      {callback, kRequestId, path, pixel_height, pixel_width});
+  if (worker_threads_.empty()) {
+    for (int i = 0; i < kNumberOfWorkerThreads; ++i)
+      worker_threads_.emplace_back(&ImageLoader::RunWorkerThread, this);
+  }
+  pending_requests_condition_.notify_one();
+  return kRequestId;
+}
+
+void ImageLoader::RunWorkerThread() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      pending_requests_condition_.wait(lock, [this] {
+        return stops_worker_threads_ || !pending_requests_.empty();
+      });
+      if (stops_worker_threads_)
+        return;
+      request = std::move(pending_requests_.back());
+      pending_requests_.pop_back();
+    }
+
+    std::shared_ptr<Bitmap> bitmap(new Bitmap);
+    const bool kResult = DecodeImage(request.path, request.pixel_width,
+                                     request.pixel_height, bitmap.get());
+    const int kRequestId = request.id;
+    Callback callback = std::move(request.callback);
+    Clock::ExecuteCallbackOnMainThread(
+        [this, bitmap, callback, kRequestId, kResult]() {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_request_ids_.erase(kRequestId) == 0)
+              return;  // cancelled
+          }
+          callback(kResult ? bitmap.get() : nullptr);
+        });
+  }
+}
+
+}  // namespace moui
@@ -0,0 +1,124 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_IMAGE_LOADER_H_
+#define MOUI_CORE_IMAGE_LOADER_H_
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "moui/base.h"
+
+namespace moui {
+
+// The `ImageLoader` class decodes and downsamples images on background
+// threads so the render thread only has to upload the pixels. Images are
+// read from the shared `ResourceArchive` if packed, or from the file system
+// and Android assets otherwise, and are decoded by the stb_image library
+// bundled with nanovg.
+//
+// Pending requests are processed from the most recently submitted one, as
+// the latest requests usually come from the content scrolled into view.
+// `LoadImage()` and `CancelRequest()` must be called on the main thread.
+class ImageLoader {
+ public:
+  // A decoded image.
+  struct Bitmap {
+    int height;
+    // The non-premultiplied RGBA pixels row by row.
+    std::vector<unsigned char> pixels;
+    int width;
+  };
+
+  // The callback receiving the result of `LoadImage()`. The bitmap is
+  // `nullptr` if the image cannot be decoded. The callback may take the
+  // pixels of the bitmap.
+  typedef std::function<void(Bitmap* bitmap)> Callback;
+
+  // Returns the loader shared by the application.
+  static ImageLoader* GetSharedLoader();
+
+  // Cancels the request returned by `LoadImage()`. The callback of the
+  // request will never be executed after this call.
+  void CancelRequest(const int request_id);
+
+  // Decodes the image at `path` into `bitmap` on the calling thread. The
+  // image is downsampled to the smallest size that still covers
+  // `pixel_width` by `pixel_height` pixels while preserving its aspect
+  // ratio. Images are never upsampled, and a pixel size of 0 keeps the full
+  // resolution. Returns `false` on failure.
+  static bool DecodeImage(const std::string& path, const int pixel_width,
+                          const int pixel_height, Bitmap* bitmap);
+
+  // Decodes the image at `path` like `DecodeImage()` on a background thread
+  // and executes `callback` with the result on the main thread. Returns the
+  // id of the request for cancelling, which is always positive.
+  int LoadImage(const std::string& path, const int pixel_width,
+                const int pixel_height, Callback callback);
+
+ private:
+  // A pending request.
+  struct Request {
+    Callback callback;
+    int id;
+    std::string path;
+    int pixel_height;
+    int pixel_width;
+  };
+
+  ImageLoader();
+  ~ImageLoader();
+
+  // Keeps decoding pending requests until the loader is destroyed.
+  void RunWorkerThread();
+
+  // The ids of the requests whose callbacks have not been executed or
+  // cancelled.
+  std::unordered_set<int> active_request_ids_;
+
+  // The id of the last submitted request.
+  int last_request_id_;
+
+  // Guards `active_request_ids_`, `pending_requests_`,
+  // `stops_worker_threads_` and `worker_threads_`.
+  std::mutex mutex_;
+
+  // The requests waiting for a worker thread, the latest last.
+  std::deque<Request> pending_requests_;
+
+  // Notifies worker threads of pending requests.
+  std::condition_variable pending_requests_condition_;
+
+  // Indicates whether the worker threads should exit.
+  bool stops_worker_threads_;
+
+  // The threads decoding images. They start on the first call to
+  // `LoadImage()`.
+  std::vector<std::thread> worker_threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageLoader);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_IMAGE_LOADER_H_
@@ -0,0 +1,90 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/index_set.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace moui {
+
+IndexSet::IndexSet() : count_(0) {
+}
+
+IndexSet::~IndexSet() {
+}
+
+void IndexSet::AddRange(const int first_index, const int count) {
+  if (count <= 0)
+    return;
+
+  int begin = first_index;
+  int end = first_index + count;
+  // Merges the ranges that overlap or touch the new range.
+  auto iterator = ranges_.upper_bound(begin);
+  if (iterator != ranges_.begin() && std::prev(iterator)->second >= begin)
+    --iterator;
+  while (iterator != ranges_.end() && iterator->first <= end) {
+    begin = std::min(begin, iterator->first);
+    end = std::max(end, iterator->second);
+    count_ -= iterator->second - iterator->first;
+    iterator = ranges_.erase(iterator);
+  }
+  ranges_.insert(iterator, {begin, end});
+  count_ += end - begin;
+}
+
+void IndexSet::Clear() {
+  count_ = 0;
+  ranges_.clear();
+}
+
+bool IndexSet::ContainsIndex(const int index) const {
+  auto iterator = ranges_.upper_bound(index);
+  if (iterator == ranges_.begin())
+    return false;
+  return std::prev(iterator)->second > index;
+}
+
+void IndexSet::RemoveRange(const int first_index, const int count) {
+  if (count <= 0)
+    return;
+
+  const int kBegin = first_index;
+  const int kEnd = first_index + count;
+  auto iterator = ranges_.upper_bound(kBegin);
+  if (iterator != ranges_.begin() && std::prev(iterator)->second > kBegin)
+    --iterator;
+  while (iterator != ranges_.end() && iterator->first < kEnd) {
+    const int kRangeBegin = iterator->first;
+    const int kRangeEnd = iterator->second;
+    count_ -= kRangeEnd - kRangeBegin;
+    iterator = ranges_.erase(iterator);
+    // Keeps the parts of the range outside the removed range.
+    if (kRangeBegin < kBegin) {
+      ranges_.insert(iterator, {kRangeBegin, kBegin});
+      count_ += kBegin - kRangeBegin;
+    }
+    if (kRangeEnd > kEnd) {
+      ranges_.insert(iterator, {kEnd, kRangeEnd});
+      count_ += kRangeEnd - kEnd;
+    }
+  }
+}
+
+}  // namespace moui
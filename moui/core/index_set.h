@@ -0,0 +1,73 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_INDEX_SET_H_
+#define MOUI_CORE_INDEX_SET_H_
+
+#include <map>
+
+namespace moui {
+
+// The `IndexSet` class represents a set of non-negative integers compressed
+// into disjoint ranges of consecutive indexes. Adding, removing and looking up
+// a range of any length takes O(log n) time where n is the number of ranges,
+// which makes it suitable for tracking a large number of selected rows.
+// Unlike most classes in this library, index sets can be copied.
+class IndexSet {
+ public:
+  IndexSet();
+  ~IndexSet();
+
+  // Adds the specified index to the set.
+  void AddIndex(const int index) { AddRange(index, 1); }
+
+  // Adds `count` consecutive indexes beginning at `first_index` to the set.
+  void AddRange(const int first_index, const int count);
+
+  // Removes all indexes.
+  void Clear();
+
+  // Returns `true` if the set contains the specified index.
+  bool ContainsIndex(const int index) const;
+
+  // Returns the number of indexes in the set.
+  int GetCount() const { return count_; }
+
+  // Removes the specified index from the set.
+  void RemoveIndex(const int index) { RemoveRange(index, 1); }
+
+  // Removes `count` consecutive indexes beginning at `first_index` from the
+  // set.
+  void RemoveRange(const int first_index, const int count);
+
+  // Accessors and setters.
+  bool empty() const { return ranges_.empty(); }
+  const std::map<int, int>& ranges() const { return ranges_; }
+
+ private:
+  // Keeps the number of indexes in the set.
+  int count_;
+
+  // The disjoint and non-adjacent ranges of the set. The key indicates the
+  // first index of a range and the value indicates the index past the last
+  // index of that range.
+  std::map<int, int> ranges_;
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_INDEX_SET_H_
@@ -0,0 +1,190 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/resource_archive.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef MOUI_ANDROID
+#include "moui/core/application.h"
+#endif  // MOUI_ANDROID
+
+namespace {
+
+// The magic number at the beginning of an archive.
+const char kMagic[] = {'M', 'O', 'U', 'I', 'P', 'A', 'C', 'K'};
+
+// The number of bytes of the header.
+const size_t kHeaderSize = sizeof(kMagic) + 4 + 4;
+
+// The version of the archive format.
+const uint32_t kVersion = 1;
+
+// Reads an unsigned little-endian integer of `number_of_bytes` bytes.
+uint64_t ReadInteger(const unsigned char* data, const int number_of_bytes) {
+  uint64_t value = 0;
+  for (int i = number_of_bytes - 1; i >= 0; --i)
+    value = (value << 8) | data[i];
+  return value;
+}
+
+}  // namespace
+
+namespace moui {
+
+ResourceArchive::ResourceArchive() : data_(nullptr), mapped_data_(nullptr),
+                                     size_(0) {
+#ifdef MOUI_ANDROID
+  asset_ = nullptr;
+#endif  // MOUI_ANDROID
+}
+
+ResourceArchive::~ResourceArchive() {
+  Close();
+}
+
+ResourceArchive* ResourceArchive::GetSharedArchive() {
+  static ResourceArchive* shared_archive = new ResourceArchive;
+  return shared_archive;
+}
+
+void ResourceArchive::Close() {
+#ifdef MOUI_ANDROID
+  if (asset_ != nullptr) {
+    AAsset_close(asset_);
+    asset_ = nullptr;
+  }
+#endif  // MOUI_ANDROID
+  if (mapped_data_ != nullptr) {
+    munmap(mapped_data_, size_);
+    mapped_data_ = nullptr;
+  }
+  data_ = nullptr;
+  entries_.clear();
+  root_.clear();
+  size_ = 0;
+}
+
+bool ResourceArchive::GetData(const std::string& path,
+                              const unsigned char** data,
+                              size_t* size) const {
+  if (data_ == nullptr)
+    return false;
+
+  auto iterator = entries_.end();
+  if (path.compare(0, root_.size(), root_) == 0)
+    iterator = entries_.find(path.substr(root_.size()));
+  if (iterator == entries_.end())
+    iterator = entries_.find(path);
+  if (iterator == entries_.end())
+    return false;
+
+  *data = data_ + iterator->second.offset;
+  *size = iterator->second.size;
+  return true;
+}
+
+bool ResourceArchive::Open(const std::string& path) {
+  Close();
+
+#ifdef MOUI_ANDROID
+  // Loads the archive from Android's assets folder. The buffer of an
+  // uncompressed asset is mapped from the APK directly.
+  if (path.find("file:///android_assets/") == 0) {
+    AAssetManager* manager = Application::GetAssetManager();
+    if (manager == nullptr)
+      return false;
+    asset_ = AAssetManager_open(manager, path.substr(23).c_str(),
+                                AASSET_MODE_BUFFER);
+    if (asset_ == nullptr)
+      return false;
+    data_ = static_cast<const unsigned char*>(AAsset_getBuffer(asset_));
+    size_ = static_cast<size_t>(AAsset_getLength64(asset_));
+    if (data_ == nullptr) {
+      Close();
+      return false;
+    }
+  }
+#endif  // MOUI_ANDROID
+
+  if (data_ == nullptr) {
+    const int kFile = open(path.c_str(), O_RDONLY);
+    if (kFile < 0)
+      return false;
+    struct stat file_stat;
+    void* mapped_data = MAP_FAILED;
+    if (fstat(kFile, &file_stat) == 0 && file_stat.st_size > 0) {
+      mapped_data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                         kFile, 0);
+    }
+    close(kFile);
+    if (mapped_data == MAP_FAILED)
+      return false;
+    mapped_data_ = mapped_data;
+    data_ = static_cast<const unsigned char*>(mapped_data);
+    size_ = static_cast<size_t>(file_stat.st_size);
+  }
+
+  if (!ReadIndex()) {
+    Close();
+    return false;
+  }
+  const size_t kLastSlash = path.rfind('/');
+  if (kLastSlash != std::string::npos)
+    root_ = path.substr(0, kLastSlash + 1);
+  return true;
+}
+
+bool ResourceArchive::ReadIndex() {
+  if (data_ == nullptr || size_ < kHeaderSize ||
+      std::memcmp(data_, kMagic, sizeof(kMagic)) != 0 ||
+      ReadInteger(data_ + sizeof(kMagic), 4) != kVersion) {
+    return false;
+  }
+
+  const size_t kNumberOfEntries = \
+      static_cast<size_t>(ReadInteger(data_ + sizeof(kMagic) + 4, 4));
+  size_t position = kHeaderSize;
+  for (size_t i = 0; i < kNumberOfEntries; ++i) {
+    if (size_ - position < 8 + 8 + 4)
+      return false;
+    const uint64_t kOffset = ReadInteger(data_ + position, 8);
+    const uint64_t kSize = ReadInteger(data_ + position + 8, 8);
+    const size_t kNameLength = \
+        static_cast<size_t>(ReadInteger(data_ + position + 16, 4));
+    position += 8 + 8 + 4;
+    if (size_ - position < kNameLength || kOffset > size_ ||
+        kSize > size_ - kOffset) {
+      return false;
+    }
+    const char* kName = reinterpret_cast<const char*>(data_ + position);
+    entries_[std::string(kName, kNameLength)] = \
+        {static_cast<size_t>(kOffset), static_cast<size_t>(kSize)};
+    position += kNameLength;
+  }
+  return true;
+}
+
+}  // namespace moui
@@ -0,0 +1,120 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_RESOURCE_ARCHIVE_H_
+#define MOUI_CORE_RESOURCE_ARCHIVE_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "moui/base.h"
+
+#ifdef MOUI_ANDROID
+#include <android/asset_manager.h>
+#endif  // MOUI_ANDROID
+
+namespace moui {
+
+// The `ResourceArchive` class provides zero-copy access to the files packed
+// into a single archive by `tools/pack_resources.py`. The archive is
+// memory-mapped as a whole, or loaded through `AAsset_getBuffer()` for
+// Android assets, so fonts and images can be handed to nanovg straight from
+// the archive instead of opening and reading every file separately. Android
+// assets should be stored uncompressed (e.g. `noCompress "pack"`) so the
+// buffer is mapped rather than inflated.
+//
+// The archive format is little-endian and consists of:
+//   - A header: the magic "MOUIPACK", a 32-bit version and a 32-bit number
+//     of entries.
+//   - An index entry for each file: a 64-bit offset, a 64-bit size, a 32-bit
+//     name length and the UTF-8 name relative to the packed directory.
+//   - The file data, each aligned to 16 bytes from the beginning.
+//
+// Lookups are thread-safe, but `Open()` and `Close()` must not be called
+// while the archive is in use.
+class ResourceArchive {
+ public:
+  ResourceArchive();
+  ~ResourceArchive();
+
+  // Returns the archive shared by the application. `nvgCreateFontAtPath()`
+  // and `nvgCreateImageAtPath()` look up files in this archive first. The
+  // shared archive should be opened once at launch and never be closed, as
+  // registered fonts keep referencing its data.
+  static ResourceArchive* GetSharedArchive();
+
+  // Closes the archive. Any data retrieved from the archive becomes invalid.
+  void Close();
+
+  // Retrieves the data of the packed file at the specified path. The path
+  // can be either the name of the file in the archive or a path in the
+  // directory containing the archive. Returns `false` if the archive doesn't
+  // contain such file.
+  bool GetData(const std::string& path, const unsigned char** data,
+               size_t* size) const;
+
+  // Returns `true` if the archive is open.
+  bool IsOpen() const { return data_ != nullptr; }
+
+  // Opens the archive at the specified path. Android assets are specified
+  // with the "file:///android_assets/" prefix. Any previously opened archive
+  // is closed first. Returns `false` if the file cannot be loaded or is not a
+  // valid archive.
+  bool Open(const std::string& path);
+
+  // Returns the number of packed files.
+  size_t number_of_files() const { return entries_.size(); }
+
+ private:
+  // The location of a packed file.
+  struct Entry {
+    size_t offset;
+    size_t size;
+  };
+
+  // Populates `entries_` from the index of the loaded archive. Returns
+  // `false` if the archive is malformed.
+  bool ReadIndex();
+
+#ifdef MOUI_ANDROID
+  // The opened Android asset that owns `data_`.
+  AAsset* asset_;
+#endif  // MOUI_ANDROID
+
+  // The data of the entire archive.
+  const unsigned char* data_;
+
+  // The packed files keyed by their names.
+  std::unordered_map<std::string, Entry> entries_;
+
+  // The memory mapped from the archive file.
+  void* mapped_data_;
+
+  // The directory containing the archive with a trailing slash, which is
+  // stripped from paths passed to `GetData()`.
+  std::string root_;
+
+  // The number of bytes of `data_`.
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourceArchive);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_RESOURCE_ARCHIVE_H_
@@ -0,0 +1,62 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/shelf_packer.h"
+
+#include <algorithm>
+
+namespace moui {
+
+ShelfPacker::ShelfPacker(const int page_size, const int padding)
+    : number_of_pages_(0), padding_(padding), page_size_(page_size),
+      shelf_height_(0), shelf_x_(0), shelf_y_(0), used_area_(0) {
+}
+
+ShelfPacker::~ShelfPacker() {
+}
+
+bool ShelfPacker::Pack(const int width, const int height, int* page, int* x,
+                       int* y) {
+  const int kWidth = width + padding_ * 2;
+  const int kHeight = height + padding_ * 2;
+  if (kWidth > page_size_ || kHeight > page_size_)
+    return false;
+
+  // Starts a new shelf if the rectangle doesn't fit the current one.
+  if (shelf_x_ + kWidth > page_size_) {
+    shelf_x_ = 0;
+    shelf_y_ += shelf_height_;
+    shelf_height_ = 0;
+  }
+  // Starts a new page if the rectangle doesn't fit the last page.
+  if (number_of_pages_ == 0 || shelf_y_ + kHeight > page_size_) {
+    ++number_of_pages_;
+    shelf_height_ = 0;
+    shelf_x_ = 0;
+    shelf_y_ = 0;
+  }
+
+  *page = number_of_pages_ - 1;
+  *x = shelf_x_ + padding_;
+  *y = shelf_y_ + padding_;
+  shelf_x_ += kWidth;
+  shelf_height_ = std::max(shelf_height_, kHeight);
+  used_area_ += kWidth * kHeight;
+  return true;
+}
+
+}  // namespace moui
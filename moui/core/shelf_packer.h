@@ -0,0 +1,73 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_SHELF_PACKER_H_
+#define MOUI_CORE_SHELF_PACKER_H_
+
+#include "moui/base.h"
+
+namespace moui {
+
+// The `ShelfPacker` class places rectangles in square pages of a fixed size
+// for texture atlases. Rectangles are placed from left to right in rows
+// called shelves, and a new shelf starts below the tallest rectangle of the
+// current shelf when the next rectangle doesn't fit. Only the last page
+// accepts new rectangles, which wastes some space but makes packing O(1).
+// Every rectangle is surrounded by the same amount of padding so filtering
+// never samples neighboring rectangles.
+class ShelfPacker {
+ public:
+  ShelfPacker(const int page_size, const int padding);
+  ~ShelfPacker();
+
+  // Places a rectangle of the specified size and stores the index of its
+  // page and the position of its top-left corner excluding the padding. A
+  // new page is started if the rectangle doesn't fit the last page. Returns
+  // `false` if the rectangle and its padding are larger than a page.
+  bool Pack(const int width, const int height, int* page, int* x, int* y);
+
+  // Accessors and setters.
+  int number_of_pages() const { return number_of_pages_; }
+  int page_size() const { return page_size_; }
+  int used_area() const { return used_area_; }
+
+ private:
+  // The number of pages containing any rectangle.
+  int number_of_pages_;
+
+  // The number of empty pixels around every rectangle.
+  const int padding_;
+
+  // The width and height of a page in pixels.
+  const int page_size_;
+
+  // The height of the current shelf in the last page.
+  int shelf_height_;
+
+  // The position to place the next rectangle in the current shelf.
+  int shelf_x_;
+  int shelf_y_;
+
+  // The area occupied by rectangles including their padding in all pages.
+  int used_area_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShelfPacker);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_SHELF_PACKER_H_
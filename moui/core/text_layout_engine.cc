@@ -0,0 +1,680 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/core/text_layout_engine.h"
+
+#include <fcntl.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "moui/core/clock.h"
+#include "moui/core/resource_archive.h"
+
+#if defined(MOUI_ANDROID)
+#  include "aasset.h"
+#endif
+
+namespace {
+
+// The types of characters that matter to line breaking, which are the same
+// as the ones distinguished by `nvgTextBreakLines()`.
+enum class CodepointType {
+  kSpace,
+  kNewline,
+  kChar,
+  kCjkChar,
+};
+
+// The metrics of a glyph in font units.
+struct Glyph {
+  FT_UInt index;
+  FT_Pos advance;
+};
+
+typedef std::unordered_map<uint32_t, Glyph> GlyphMap;
+
+// Decodes the UTF-8 character beginning at `string` and returns the position
+// of the next character. An invalid byte is decoded as U+FFFD.
+const char* DecodeUtf8(const char* string, const char* end,
+                       uint32_t* codepoint) {
+  const unsigned char kLeadingByte = static_cast<unsigned char>(*string);
+  int number_of_continuation_bytes;
+  if (kLeadingByte < 0x80) {
+    *codepoint = kLeadingByte;
+    return string + 1;
+  } else if ((kLeadingByte & 0xE0) == 0xC0) {
+    *codepoint = kLeadingByte & 0x1F;
+    number_of_continuation_bytes = 1;
+  } else if ((kLeadingByte & 0xF0) == 0xE0) {
+    *codepoint = kLeadingByte & 0x0F;
+    number_of_continuation_bytes = 2;
+  } else if ((kLeadingByte & 0xF8) == 0xF0) {
+    *codepoint = kLeadingByte & 0x07;
+    number_of_continuation_bytes = 3;
+  } else {
+    *codepoint = 0xFFFD;
+    return string + 1;
+  }
+  if (end - string <= number_of_continuation_bytes) {
+    *codepoint = 0xFFFD;
+    return string + 1;
+  }
+  for (int i = 1; i <= number_of_continuation_bytes; ++i) {
+    const unsigned char kByte = static_cast<unsigned char>(string[i]);
+    if ((kByte & 0xC0) != 0x80) {
+      *codepoint = 0xFFFD;
+      return string + 1;
+    }
+    *codepoint = (*codepoint << 6) | (kByte & 0x3F);
+  }
+  return string + number_of_continuation_bytes + 1;
+}
+
+// Returns the type of the specified `codepoint` following the
+// `previous_codepoint`.
+CodepointType GetCodepointType(const uint32_t codepoint,
+                               const uint32_t previous_codepoint) {
+  switch (codepoint) {
+    case 9:  // \t
+    case 11:  // \v
+    case 12:  // \f
+    case 32:  // space
+    case 0x00A0:  // NBSP
+      return CodepointType::kSpace;
+    case 10:  // \n
+      return previous_codepoint == 13 ? CodepointType::kSpace :
+                                        CodepointType::kNewline;
+    case 13:  // \r
+      return previous_codepoint == 10 ? CodepointType::kSpace :
+                                        CodepointType::kNewline;
+    case 0x0085:  // NEL
+      return CodepointType::kNewline;
+    default:
+      break;
+  }
+  if ((codepoint >= 0x4E00 && codepoint <= 0x9FFF) ||
+      (codepoint >= 0x3000 && codepoint <= 0x30FF) ||
+      (codepoint >= 0xFF00 && codepoint <= 0xFFEF) ||
+      (codepoint >= 0x1100 && codepoint <= 0x11FF) ||
+      (codepoint >= 0x3130 && codepoint <= 0x318F) ||
+      (codepoint >= 0xAC00 && codepoint <= 0xD7AF)) {
+    return CodepointType::kCjkChar;
+  }
+  return CodepointType::kChar;
+}
+
+// Returns the glyph of the specified `codepoint` from the passed `glyphs` and
+// adds it to `glyphs` on first use.
+const Glyph& GetGlyph(FT_Face face, const uint32_t codepoint,
+                      GlyphMap* glyphs) {
+  auto iterator = glyphs->find(codepoint);
+  if (iterator != glyphs->end())
+    return iterator->second;
+
+  Glyph glyph = {FT_Get_Char_Index(face, codepoint), 0};
+  if (FT_Load_Glyph(face, glyph.index, FT_LOAD_NO_SCALE) == 0)
+    glyph.advance = face->glyph->advance.x;
+  return glyphs->insert({codepoint, glyph}).first->second;
+}
+
+// Returns the kerning between two glyphs in font units.
+FT_Pos GetKerning(FT_Face face, const FT_UInt left_glyph,
+                  const FT_UInt right_glyph) {
+  FT_Vector kerning;
+  if (!FT_HAS_KERNING(face) ||
+      FT_Get_Kerning(face, left_glyph, right_glyph, FT_KERNING_UNSCALED,
+                     &kerning) != 0) {
+    return 0;
+  }
+  return kerning.x;
+}
+
+// Returns the scale converting font units to points for the specified font
+// size, which is the same scale fontstash uses.
+float GetFontScale(FT_Face face, const float font_size) {
+  const FT_Pos kHeight = face->ascender - face->descender;
+  return kHeight > 0 ? font_size / kHeight : 0;
+}
+
+// Maps the entire file at `path` into memory as read-only pages without
+// copying. Returns `false` on failure.
+bool MapFile(const std::string& path, void** data, size_t* size) {
+  const int kFile = open(path.c_str(), O_RDONLY);
+  if (kFile < 0)
+    return false;
+
+  struct stat file_stat;
+  void* mapped_data = MAP_FAILED;
+  if (fstat(kFile, &file_stat) == 0 && file_stat.st_size > 0) {
+    mapped_data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                       kFile, 0);
+  }
+  close(kFile);
+  if (mapped_data == MAP_FAILED)
+    return false;
+  *data = mapped_data;
+  *size = static_cast<size_t>(file_stat.st_size);
+  return true;
+}
+
+// Reads the entire file at `path` into `data`. Returns `false` on failure.
+bool ReadFile(const std::string& path, std::vector<unsigned char>* data) {
+#ifdef MOUI_ANDROID
+  // Loads the file from Android's assets folder.
+  if (path.find("file:///android_assets/") == 0) {
+    std::string asset_path = path.substr(23);
+    std::FILE* file = aasset_fopen(asset_path.c_str(), "r");
+    if (file == NULL) {
+      return false;
+    }
+    const int kDataSize = aasset_fsize(file);
+    data->resize(kDataSize);
+    const bool kResult = \
+        aasset_fread(data->data(), 1, kDataSize, file) == kDataSize;
+    aasset_fclose(file);
+    return kResult;
+  }
+#endif  // MOUI_ANDROID
+
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  std::fseek(file, 0, SEEK_END);
+  const long kDataSize = std::ftell(file);  // NOLINT
+  std::fseek(file, 0, SEEK_SET);
+  bool result = false;
+  if (kDataSize > 0) {
+    data->resize(kDataSize);
+    result = std::fread(data->data(), 1, kDataSize, file) == \
+             static_cast<size_t>(kDataSize);
+  }
+  std::fclose(file);
+  return result;
+}
+
+}  // namespace
+
+namespace moui {
+
+// A registered font.
+struct TextLayoutEngine::Font {
+  Font() : data(nullptr), face(nullptr), index(-1), mapped_data(nullptr),
+           mapped_size(0), size(0) {}
+  ~Font() {
+    if (face != nullptr)
+      FT_Done_Face(face);
+    if (mapped_data != nullptr)
+      munmap(mapped_data, mapped_size);
+  }
+
+  // Keeps the font data if it is neither packed nor mapped from a file.
+  std::vector<unsigned char> buffer;
+  // The font file data shared with fontstash, which points to the shared
+  // `ResourceArchive`, `mapped_data` or `buffer`.
+  const unsigned char* data;
+  // The FreeType face loaded from `data` on first use.
+  FT_Face face;
+  // Caches the metrics of glyphs in `face`.
+  GlyphMap glyphs;
+  // The index of the font in `indexed_fonts_`.
+  int index;
+  // The memory mapped from the font file.
+  void* mapped_data;
+  size_t mapped_size;
+  // Guards `face` and `glyphs`.
+  std::mutex mutex;
+  // The path the font is registered with, or empty if the font is registered
+  // with data in memory.
+  std::string path;
+  // The number of bytes of `data`.
+  size_t size;
+};
+
+TextLayoutEngine::TextLayoutEngine() : library_(nullptr),
+                                       stops_worker_thread_(false) {
+  FT_Library library;
+  if (FT_Init_FreeType(&library) == 0)
+    library_ = library;
+}
+
+TextLayoutEngine::~TextLayoutEngine() {
+  {
+    std::lock_guard<std::mutex> lock(pending_tasks_mutex_);
+    stops_worker_thread_ = true;
+  }
+  pending_tasks_condition_.notify_all();
+  if (worker_thread_.joinable())
+    worker_thread_.join();
+
+  fonts_.clear();  // releases faces before the library
+  if (library_ != nullptr)
+    FT_Done_FreeType(library_);
+}
+
+bool TextLayoutEngine::AddFont(const std::string& name,
+                               const std::string& path) {
+  if (path.empty())
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iterator = fonts_.find(name);
+    if (iterator != fonts_.end())
+      return iterator->second->path == path;
+  }
+
+  // Uses the data in the shared resource archive or maps the font file if
+  // possible so the data is neither copied nor kept in memory until used.
+  std::unique_ptr<Font> font(new Font);
+  ResourceArchive* archive = ResourceArchive::GetSharedArchive();
+  if (!archive->GetData(path, &font->data, &font->size)) {
+    if (MapFile(path, &font->mapped_data, &font->mapped_size)) {
+      font->data = static_cast<const unsigned char*>(font->mapped_data);
+      font->size = font->mapped_size;
+    } else if (ReadFile(path, &font->buffer)) {
+      font->data = font->buffer.data();
+      font->size = font->buffer.size();
+    } else {
+      return false;
+    }
+  }
+  font->path = path;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iterator = fonts_.find(name);
+  if (iterator != fonts_.end())
+    return iterator->second->path == path;
+  RegisterFont(name, std::move(font));
+  return true;
+}
+
+bool TextLayoutEngine::AddFontMem(const std::string& name,
+                                  const unsigned char* data,
+                                  const size_t size) {
+  if (data == nullptr || size == 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fonts_.find(name) != fonts_.end())
+    return true;
+  std::unique_ptr<Font> font(new Font);
+  font->buffer.assign(data, data + size);
+  font->data = font->buffer.data();
+  font->size = size;
+  RegisterFont(name, std::move(font));
+  return true;
+}
+
+TextLayoutEngine::Font* TextLayoutEngine::GetFont(const int index) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index < 0 || index >= static_cast<int>(indexed_fonts_.size()) ||
+      library_ == nullptr) {
+    return nullptr;
+  }
+
+  Font* font = indexed_fonts_[index];
+  if (font->face == nullptr) {
+    FT_Face face;
+    if (FT_New_Memory_Face(library_, font->data,
+                           static_cast<FT_Long>(font->size), 0,
+                           &face) != 0) {
+      return nullptr;
+    }
+    font->face = face;
+  }
+  return font;
+}
+
+bool TextLayoutEngine::GetFontData(const std::string& name,
+                                   const unsigned char** data,
+                                   size_t* size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iterator = fonts_.find(name);
+  if (iterator == fonts_.end())
+    return false;
+  *data = iterator->second->data;
+  *size = iterator->second->size;
+  return true;
+}
+
+int TextLayoutEngine::GetFontIndex(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iterator = fonts_.find(name);
+  if (iterator == fonts_.end())
+    return -1;
+  return iterator->second->index;
+}
+
+bool TextLayoutEngine::GetGlyphPositions(
+    const std::string& font_name, const float font_size, const char* begin,
+    const char* end, std::vector<GlyphPosition>* positions, float* ascender) {
+  return GetGlyphPositions(GetFontIndex(font_name), font_size, begin, end,
+                           positions, ascender);
+}
+
+bool TextLayoutEngine::GetGlyphPositions(
+    const int font_index, const float font_size, const char* begin,
+    const char* end, std::vector<GlyphPosition>* positions, float* ascender) {
+  Font* font = GetFont(font_index);
+  if (font == nullptr)
+    return false;
+
+  std::lock_guard<std::mutex> lock(font->mutex);
+  FT_Face face = font->face;
+  const float kScale = GetFontScale(face, font_size);
+  positions->clear();
+  const Glyph* previous_glyph = nullptr;
+  FT_Pos x = 0;
+  for (const char* string = begin; string < end;) {
+    uint32_t codepoint;
+    string = DecodeUtf8(string, end, &codepoint);
+    const Glyph& kGlyph = GetGlyph(face, codepoint, &font->glyphs);
+    if (previous_glyph != nullptr)
+      x += GetKerning(face, previous_glyph->index, kGlyph.index);
+    positions->push_back({codepoint, x * kScale});
+    x += kGlyph.advance;
+    previous_glyph = &kGlyph;
+  }
+  *ascender = face->ascender * kScale;
+  return true;
+}
+
+TextLayoutEngine* TextLayoutEngine::GetSharedEngine() {
+  static TextLayoutEngine* shared_engine = new TextLayoutEngine;
+  return shared_engine;
+}
+
+// The implementation follows `nvgTextBreakLines()` closely so rows end at
+// the same positions as the ones broken by nanovg.
+bool TextLayoutEngine::LayoutText(Layout* layout) {
+  Font* font = GetFont(GetFontIndex(layout->font_name));
+  if (font == nullptr)
+    return false;
+
+  std::lock_guard<std::mutex> lock(font->mutex);
+  FT_Face face = font->face;
+  const float kScale = GetFontScale(face, layout->font_size);
+  const size_t kMaximumNumberOfRows = \
+      layout->maximum_number_of_rows > 0 ?
+      static_cast<size_t>(layout->maximum_number_of_rows) : SIZE_MAX;
+  const char* kText = layout->text.c_str();
+  const char* kTextEnd = kText + layout->text.size();
+  std::vector<Row>& rows = layout->rows;
+  rows.clear();
+
+  // The position where the text following the last added row begins.
+  const char* next_row_start = kText;
+  auto add_row = [&](const char* begin, const char* end, const float width,
+                     const char* next) {
+    rows.push_back({static_cast<size_t>(begin - kText),
+                    static_cast<size_t>(end - kText), width});
+    next_row_start = next;
+    return rows.size() >= kMaximumNumberOfRows;
+  };
+
+  float row_start_x = 0;
+  float row_width = 0;
+  const char* row_start = nullptr;
+  const char* row_end = nullptr;
+  const char* word_start = nullptr;
+  float word_start_x = 0;
+  const char* break_end = nullptr;
+  float break_width = 0;
+  CodepointType type = CodepointType::kSpace;
+  CodepointType previous_type = CodepointType::kSpace;
+  uint32_t previous_codepoint = 0;
+  const Glyph* previous_glyph = nullptr;
+  bool reaches_maximum_number_of_rows = false;
+  float x = 0;
+  for (const char* string = kText; string < kTextEnd;) {
+    uint32_t codepoint;
+    const char* kNext = DecodeUtf8(string, kTextEnd, &codepoint);
+    const Glyph& kGlyph = GetGlyph(face, codepoint, &font->glyphs);
+    FT_Pos advance = kGlyph.advance;
+    if (previous_glyph != nullptr)
+      advance += GetKerning(face, previous_glyph->index, kGlyph.index);
+    const float kNextX = x + advance * kScale;
+    type = GetCodepointType(codepoint, previous_codepoint);
+    const bool kIsChar = type == CodepointType::kChar ||
+                         type == CodepointType::kCjkChar;
+
+    if (type == CodepointType::kNewline) {
+      // Always handles new lines.
+      if (add_row(row_start != nullptr ? row_start : string,
+                  row_end != nullptr ? row_end : string, row_width, kNext)) {
+        reaches_maximum_number_of_rows = true;
+        break;
+      }
+      // Skips the white space at the beginning of the next row.
+      break_end = row_start;
+      break_width = 0;
+      row_start = nullptr;
+      row_end = nullptr;
+      row_width = 0;
+    } else if (row_start == nullptr) {
+      // Skips white space until the beginning of the row.
+      if (kIsChar) {
+        row_start_x = x;
+        row_start = string;
+        row_end = kNext;
+        row_width = kNextX - row_start_x;
+        word_start = string;
+        word_start_x = x;
+        break_end = row_start;
+        break_width = 0;
+      }
+    } else {
+      const float kNextWidth = kNextX - row_start_x;
+
+      // Tracks the last non-white space character.
+      if (kIsChar) {
+        row_end = kNext;
+        row_width = kNextX - row_start_x;
+      }
+      // Tracks the last end of a word.
+      if ((previous_type != CodepointType::kSpace &&
+           previous_type != CodepointType::kNewline &&
+           type == CodepointType::kSpace) ||
+          type == CodepointType::kCjkChar) {
+        break_end = string;
+        break_width = row_width;
+      }
+      // Tracks the last beginning of a word.
+      if ((previous_type == CodepointType::kSpace && kIsChar) ||
+          type == CodepointType::kCjkChar) {
+        word_start = string;
+        word_start_x = x;
+      }
+
+      // Breaks to a new row when a character is beyond the width.
+      if (kIsChar && kNextWidth > layout->width) {
+        if (break_end == row_start) {
+          // The current word is longer than the row, just breaks it here.
+          if (add_row(row_start, string, row_width, string)) {
+            reaches_maximum_number_of_rows = true;
+            break;
+          }
+          row_start_x = x;
+          row_start = string;
+          row_end = kNext;
+          row_width = kNextX - row_start_x;
+          word_start = string;
+          word_start_x = x;
+        } else {
+          // Breaks the row at the end of the last word and starts a new row
+          // from the beginning of the current word.
+          if (add_row(row_start, break_end, break_width, word_start)) {
+            reaches_maximum_number_of_rows = true;
+            break;
+          }
+          row_start_x = word_start_x;
+          row_start = word_start;
+          row_end = kNext;
+          row_width = kNextX - row_start_x;
+        }
+        break_end = row_start;
+        break_width = 0;
+      }
+    }
+
+    previous_codepoint = codepoint;
+    previous_type = type;
+    previous_glyph = &kGlyph;
+    x = kNextX;
+    string = kNext;
+  }
+  if (!reaches_maximum_number_of_rows && row_start != nullptr)
+    add_row(row_start, row_end, row_width, kTextEnd);
+
+  layout->is_complete = !reaches_maximum_number_of_rows ||
+                        next_row_start == kTextEnd;
+  layout->row_height = face->height * kScale;
+  layout->text_height = \
+      rows.size() * layout->row_height * layout->line_height;
+  layout->text_width = 0;
+  for (const Row& row : rows)
+    layout->text_width = std::max(layout->text_width, row.width);
+  return true;
+}
+
+void TextLayoutEngine::LayoutTextAsync(const Layout& layout,
+                                       Callback callback) {
+  std::shared_ptr<Layout> result(new Layout(layout));
+  std::lock_guard<std::mutex> lock(pending_tasks_mutex_);
+  pending_tasks_.push_back([this, result, callback]() {
+    if (!LayoutText(result.get()))
+      return;
+    Clock::ExecuteCallbackOnMainThread([result, callback]() {
+      callback(*result);
+    });
+  });
+  if (!worker_thread_.joinable())
+    worker_thread_ = std::thread(&TextLayoutEngine::RunWorkerThread, this);
+  pending_tasks_condition_.notify_one();
+}
+
+float TextLayoutEngine::MeasureText(const std::string& font_name,
+                                    const float font_size,
+                                    const std::string& text) {
+  Font* font = GetFont(GetFontIndex(font_name));
+  if (font == nullptr)
+    return -1;
+
+  std::lock_guard<std::mutex> lock(font->mutex);
+  FT_Face face = font->face;
+  const char* kTextEnd = text.c_str() + text.size();
+  const Glyph* previous_glyph = nullptr;
+  FT_Pos advance = 0;
+  for (const char* string = text.c_str(); string < kTextEnd;) {
+    uint32_t codepoint;
+    string = DecodeUtf8(string, kTextEnd, &codepoint);
+    const Glyph& kGlyph = GetGlyph(face, codepoint, &font->glyphs);
+    if (previous_glyph != nullptr)
+      advance += GetKerning(face, previous_glyph->index, kGlyph.index);
+    advance += kGlyph.advance;
+    previous_glyph = &kGlyph;
+  }
+  return advance * GetFontScale(face, font_size);
+}
+
+bool TextLayoutEngine::RasterizeGlyph(const std::string& font_name,
+                                      const uint32_t codepoint,
+                                      const float font_size,
+                                      GlyphBitmap* bitmap) {
+  return RasterizeGlyph(GetFontIndex(font_name), codepoint, font_size,
+                        bitmap);
+}
+
+bool TextLayoutEngine::RasterizeGlyph(const int font_index,
+                                      const uint32_t codepoint,
+                                      const float font_size,
+                                      GlyphBitmap* bitmap) {
+  Font* font = GetFont(font_index);
+  if (font == nullptr)
+    return false;
+
+  std::lock_guard<std::mutex> lock(font->mutex);
+  FT_Face face = font->face;
+  const FT_Pos kHeight = face->ascender - face->descender;
+  if (kHeight <= 0)
+    return false;
+  const FT_UInt kPixelSize = static_cast<FT_UInt>(
+      font_size * face->units_per_EM / kHeight);
+  const Glyph& kGlyph = GetGlyph(face, codepoint, &font->glyphs);
+  if (FT_Set_Pixel_Sizes(face, 0, kPixelSize) != 0 ||
+      FT_Load_Glyph(face, kGlyph.index,
+                    FT_LOAD_RENDER | FT_LOAD_NO_HINTING) != 0) {
+    return false;
+  }
+
+  const FT_GlyphSlot kSlot = face->glyph;
+  const FT_Bitmap& kBitmap = kSlot->bitmap;
+  if (kBitmap.pixel_mode != FT_PIXEL_MODE_GRAY && kBitmap.rows > 0)
+    return false;
+  bitmap->width = static_cast<int>(kBitmap.width);
+  bitmap->height = static_cast<int>(kBitmap.rows);
+  bitmap->left = kSlot->bitmap_left;
+  bitmap->top = kSlot->bitmap_top;
+  bitmap->coverage.resize(bitmap->width * bitmap->height);
+  for (int row = 0; row < bitmap->height; ++row) {
+    std::copy(kBitmap.buffer + row * kBitmap.pitch,
+              kBitmap.buffer + row * kBitmap.pitch + bitmap->width,
+              bitmap->coverage.begin() + row * bitmap->width);
+  }
+  return true;
+}
+
+void TextLayoutEngine::RegisterFont(const std::string& name,
+                                    std::unique_ptr<Font> font) {
+  font->index = static_cast<int>(indexed_fonts_.size());
+  indexed_fonts_.push_back(font.get());
+  fonts_[name] = std::move(font);
+}
+
+void TextLayoutEngine::RunWorkerThread() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(pending_tasks_mutex_);
+      pending_tasks_condition_.wait(lock, [this] {
+        return stops_worker_thread_ || !pending_tasks_.empty();
+      });
+      if (stops_worker_thread_)
+        return;
+      task = std::move(pending_tasks_.front());
+      pending_tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace moui
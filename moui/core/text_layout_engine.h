@@ -0,0 +1,233 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_CORE_TEXT_LAYOUT_ENGINE_H_
+#define MOUI_CORE_TEXT_LAYOUT_ENGINE_H_
+
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "moui/base.h"
+
+// Forward declaration.
+struct FT_LibraryRec_;
+
+namespace moui {
+
+// The `TextLayoutEngine` class breaks text into rows and measures text
+// without an `NVGcontext`, so layouts can be computed on any thread ahead of
+// rendering. It reads glyph metrics through FreeType from the same font data
+// that fontstash renders with, but never touches fontstash's glyph atlas.
+//
+// Fonts registered through `nvgCreateFontAtPath()` are added to the shared
+// engine automatically. The rows are broken the same way as
+// `nvgTextBreakLines()`. Widths may still differ from nanovg's by a fraction
+// of a pixel because fontstash rounds glyph advances to device pixels.
+//
+// All public methods are thread-safe.
+class TextLayoutEngine {
+ public:
+  // A row of broken text.
+  struct Row {
+    // The byte offset of the first character of the row in the text.
+    size_t begin;
+    // The byte offset past the last character of the row in the text.
+    size_t end;
+    // The logical width of the row.
+    float width;
+  };
+
+  // Describes the text to lay out and receives the result.
+  struct Layout {
+    // Attributes to lay out the text with.
+    std::string font_name;
+    float font_size;
+    // The proportional line height as multiple of the font's line height.
+    float line_height;
+    // The maximum number of rows to break. 0 means no limit.
+    int maximum_number_of_rows;
+    std::string text;
+    // The width to break the text within.
+    float width;
+
+    // Indicates whether the rows cover the entire text.
+    bool is_complete;
+    // The font's line height, which is also the vertical extent of a row.
+    float row_height;
+    // The broken rows.
+    std::vector<Row> rows;
+    // The height required to render all rows.
+    float text_height;
+    // The width of the widest row.
+    float text_width;
+  };
+
+  // The coverage bitmap of a rasterized glyph.
+  struct GlyphBitmap {
+    // The 8-bit coverage values of `width` x `height` pixels in rows.
+    std::vector<unsigned char> coverage;
+    int height;
+    // The distance from the pen position to the left edge of the bitmap.
+    int left;
+    // The distance from the baseline up to the top edge of the bitmap.
+    int top;
+    int width;
+  };
+
+  // A glyph positioned along a row of text.
+  struct GlyphPosition {
+    uint32_t codepoint;
+    // The pen position relative to the beginning of the row with kerning
+    // applied.
+    float x;
+  };
+
+  // The callback receiving the result of `LayoutTextAsync()`.
+  typedef std::function<void(const Layout& layout)> Callback;
+
+  // Returns the engine shared by the application.
+  static TextLayoutEngine* GetSharedEngine();
+
+  // Registers the font at the specified path with the specified name. The
+  // file is memory-mapped instead of being read whenever possible. Returns
+  // `true` if the font is registered or has been registered with the same
+  // name and path. Returns `false` if the name is taken by a font from
+  // another path or from memory, because registered fonts are never removed
+  // or replaced while fontstash may share their data.
+  bool AddFont(const std::string& name, const std::string& path);
+
+  // Registers a copy of the passed font data with the specified name.
+  // Returns `true` on success.
+  bool AddFontMem(const std::string& name, const unsigned char* data,
+                  const size_t size);
+
+  // Retrieves the data of the font registered with the specified name. The
+  // data stays valid as long as the engine exists, which allows fontstash to
+  // share it through `nvgCreateFontMem()` without copying. Returns `false` if
+  // the font is not registered.
+  bool GetFontData(const std::string& name, const unsigned char** data,
+                   size_t* size);
+
+  // Returns the index of the font registered with the specified name, or -1
+  // if no such font is registered. Fonts are never removed, so the index
+  // identifies the font without looking up its name in later calls.
+  int GetFontIndex(const std::string& name);
+
+  // Retrieves the position of every glyph in the text between `begin` and
+  // `end` rendered in a single row, and the distance from the top of the row
+  // to the baseline as `ascender`. Returns `false` if the font is not
+  // registered or cannot be loaded.
+  bool GetGlyphPositions(const std::string& font_name, const float font_size,
+                         const char* begin, const char* end,
+                         std::vector<GlyphPosition>* positions,
+                         float* ascender);
+
+  // Same as above but the font is specified by the index returned by
+  // `GetFontIndex()`.
+  bool GetGlyphPositions(const int font_index, const float font_size,
+                         const char* begin, const char* end,
+                         std::vector<GlyphPosition>* positions,
+                         float* ascender);
+
+  // Lays out `layout->text` with the attributes in `layout` and stores the
+  // result in the same `layout`. Returns `false` if the font is not
+  // registered or cannot be loaded.
+  bool LayoutText(Layout* layout);
+
+  // Lays out the passed layout on the engine's worker thread and executes
+  // `callback` with the result on the main thread. Layouts are processed in
+  // order. The callback is not executed if the layout fails.
+  void LayoutTextAsync(const Layout& layout, Callback callback);
+
+  // Returns the advance width of the passed `text` rendered in a single row.
+  // Returns -1 if the font is not registered or cannot be loaded.
+  float MeasureText(const std::string& font_name, const float font_size,
+                    const std::string& text);
+
+  // Rasterizes the glyph of `codepoint` at the specified font size into
+  // `bitmap`. The font size is interpreted the same way as fontstash does.
+  // Returns `false` on failure.
+  bool RasterizeGlyph(const std::string& font_name, const uint32_t codepoint,
+                      const float font_size, GlyphBitmap* bitmap);
+
+  // Same as above but the font is specified by the index returned by
+  // `GetFontIndex()`.
+  bool RasterizeGlyph(const int font_index, const uint32_t codepoint,
+                      const float font_size, GlyphBitmap* bitmap);
+
+ private:
+  // Forward declaration.
+  struct Font;
+
+  TextLayoutEngine();
+  ~TextLayoutEngine();
+
+  // Returns the font at the specified index returned by `GetFontIndex()` and
+  // loads its face on first use. Returns `nullptr` on failure.
+  Font* GetFont(const int index);
+
+  // Registers the font with the specified name and indexes it. `mutex_` must
+  // be locked and the name must not be taken.
+  void RegisterFont(const std::string& name, std::unique_ptr<Font> font);
+
+  // Keeps laying out pending layouts until the engine is destroyed.
+  void RunWorkerThread();
+
+  // The registered fonts keyed by names.
+  std::map<std::string, std::unique_ptr<Font>> fonts_;
+
+  // The registered fonts in the order of registration, which are indexed by
+  // the indexes returned by `GetFontIndex()`.
+  std::vector<Font*> indexed_fonts_;
+
+  // The FreeType library that loads the font faces.
+  FT_LibraryRec_* library_;
+
+  // Guards `fonts_`, `indexed_fonts_` and `library_`.
+  std::mutex mutex_;
+
+  // The layouts waiting for the worker thread.
+  std::deque<std::function<void()>> pending_tasks_;
+
+  // Guards `pending_tasks_`, `stops_worker_thread_` and `worker_thread_`.
+  std::mutex pending_tasks_mutex_;
+
+  // Notifies the worker thread of pending tasks.
+  std::condition_variable pending_tasks_condition_;
+
+  // Indicates whether the worker thread should exit.
+  bool stops_worker_thread_;
+
+  // The thread processing `pending_tasks_`. It starts on the first call to
+  // `LayoutTextAsync()`.
+  std::thread worker_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(TextLayoutEngine);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_CORE_TEXT_LAYOUT_ENGINE_H_
@@ -30,10 +30,17 @@
 #include "moui/nanovg_hook.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <cstdio>
 #include <string>
+#include <vector>
 
+#include "moui/core/device.h"
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/core/resource_archive.h"
+#include "moui/core/text_layout_engine.h"
 #include "nanovg/src/nanovg.h"
 
 #if defined(MOUI_ANDROID)
@@ -45,8 +52,450 @@
 #  include "nanovg/src/nanovg_gl_utils.h"
 #endif
 
+namespace {
+
+// The maximum number of scales a retained path caches flattened curves or
+// tessellated vertices for.
+const int kMaximumNumberOfRetainedPathScales = 4;
+
+// The number of steps per unit scale for quantizing the scales of retained
+// paths, so slightly different scales share the same flattened curves.
+const float kRetainedPathScaleSteps = 4;
+
+// The estimated number of bytes per pixel of a framebuffer, which consists of
+// an RGBA texture and an 8-bit stencil buffer.
+const int kFramebufferBytesPerPixel = 5;
+
+// A path tessellated by nanovg with its own copy of the vertices.
+struct TessellatedPath {
+  std::vector<NVGvertex> fill_vertices;
+  // The pointers to the vertices are only valid while rendering.
+  NVGpath path;
+  std::vector<NVGvertex> stroke_vertices;
+};
+
+// The render state of the last fill or stroke captured by `CaptureFill()` or
+// `CaptureStroke()`.
+struct CapturedRenderState {
+  NVGcompositeOperationState composite_operation;
+  float fringe;
+  NVGpaint paint;
+  NVGscissor scissor;
+  // The stroke width resolved by nanovg, which is only set for strokes.
+  float stroke_width;
+};
+
+CapturedRenderState captured_render_state;
+
+// The paths of the captured fill or stroke are copied to `captured_paths` if
+// not `nullptr`.
+std::vector<TessellatedPath>* captured_paths = nullptr;
+
+// Copies the vertices of `paths` to `captured_paths` if requested.
+void CapturePaths(const NVGpath* paths, const int number_of_paths) {
+  if (captured_paths == nullptr)
+    return;
+  captured_paths->resize(number_of_paths);
+  for (int i = 0; i < number_of_paths; ++i) {
+    const NVGpath& kPath = paths[i];
+    TessellatedPath& tessellated_path = (*captured_paths)[i];
+    tessellated_path.fill_vertices.assign(kPath.fill,
+                                          kPath.fill + kPath.nfill);
+    tessellated_path.path = kPath;
+    tessellated_path.stroke_vertices.assign(kPath.stroke,
+                                            kPath.stroke + kPath.nstroke);
+  }
+}
+
+// Replaces the `renderFill` callback of the backend temporarily to capture
+// the paint, scissor and composite operation that nanovg resolves from the
+// current state, without rendering anything.
+void CaptureFill(void* user_ptr, NVGpaint* paint,
+                 NVGcompositeOperationState composite_operation,
+                 NVGscissor* scissor, float fringe, const float* bounds,
+                 const NVGpath* paths, int number_of_paths) {
+  captured_render_state.composite_operation = composite_operation;
+  captured_render_state.fringe = fringe;
+  captured_render_state.paint = *paint;
+  captured_render_state.scissor = *scissor;
+  captured_render_state.stroke_width = 0;
+  CapturePaths(paths, number_of_paths);
+}
+
+// Replaces the `renderStroke` callback of the backend temporarily like
+// `CaptureFill()` does for fills.
+void CaptureStroke(void* user_ptr, NVGpaint* paint,
+                   NVGcompositeOperationState composite_operation,
+                   NVGscissor* scissor, float fringe, float stroke_width,
+                   const NVGpath* paths, int number_of_paths) {
+  captured_render_state.composite_operation = composite_operation;
+  captured_render_state.fringe = fringe;
+  captured_render_state.paint = *paint;
+  captured_render_state.scissor = *scissor;
+  captured_render_state.stroke_width = stroke_width;
+  CapturePaths(paths, number_of_paths);
+}
+
+// Fills or strokes the current path with the backend callbacks replaced by
+// `CaptureFill()` and `CaptureStroke()`, so the render state and optionally
+// the paths are captured without rendering anything.
+void CaptureRender(NVGcontext* context, const bool is_stroke,
+                   std::vector<TessellatedPath>* paths) {
+  NVGparams* params = nvgInternalParams(context);
+  auto render_fill = params->renderFill;
+  auto render_stroke = params->renderStroke;
+  params->renderFill = CaptureFill;
+  params->renderStroke = CaptureStroke;
+  captured_paths = paths;
+  if (is_stroke)
+    nvgStroke(context);
+  else
+    nvgFill(context);
+  captured_paths = nullptr;
+  params->renderFill = render_fill;
+  params->renderStroke = render_stroke;
+}
+
+// Records the image created in the context to `GpuMemoryTracker` and returns
+// the image. The texture is estimated as RGBA pixels plus mipmaps.
+int TrackImage(NVGcontext* context, const int image, const int image_flags) {
+  if (image < 0)
+    return image;
+  int width = 0;
+  int height = 0;
+  nvgImageSize(context, image, &width, &height);
+  size_t number_of_bytes = static_cast<size_t>(width) * height * 4;
+  if (image_flags & NVG_IMAGE_GENERATE_MIPMAPS)
+    number_of_bytes = number_of_bytes * 4 / 3;
+  moui::GpuMemoryTracker::GetSharedTracker()->AddAllocation(
+      context, image, false, number_of_bytes);
+  return image;
+}
+
+// Flattens the cubic bezier curve into `points` the same way as nanovg does.
+// The start point is not added.
+void FlattenBezier(const float x1, const float y1, const float x2,
+                   const float y2, const float x3, const float y3,
+                   const float x4, const float y4, const float tolerance,
+                   const int level, std::vector<float>* points) {
+  if (level > 10)
+    return;
+
+  const float kDeltaX = x4 - x1;
+  const float kDeltaY = y4 - y1;
+  const float kDistance2 = std::fabs((x2 - x4) * kDeltaY - (y2 - y4) * kDeltaX);
+  const float kDistance3 = std::fabs((x3 - x4) * kDeltaY - (y3 - y4) * kDeltaX);
+  if ((kDistance2 + kDistance3) * (kDistance2 + kDistance3) <
+      tolerance * (kDeltaX * kDeltaX + kDeltaY * kDeltaY)) {
+    points->push_back(x4);
+    points->push_back(y4);
+    return;
+  }
+
+  const float kX12 = (x1 + x2) * 0.5f;
+  const float kY12 = (y1 + y2) * 0.5f;
+  const float kX23 = (x2 + x3) * 0.5f;
+  const float kY23 = (y2 + y3) * 0.5f;
+  const float kX34 = (x3 + x4) * 0.5f;
+  const float kY34 = (y3 + y4) * 0.5f;
+  const float kX123 = (kX12 + kX23) * 0.5f;
+  const float kY123 = (kY12 + kY23) * 0.5f;
+  const float kX234 = (kX23 + kX34) * 0.5f;
+  const float kY234 = (kY23 + kY34) * 0.5f;
+  const float kX1234 = (kX123 + kX234) * 0.5f;
+  const float kY1234 = (kY123 + kY234) * 0.5f;
+  FlattenBezier(x1, y1, kX12, kY12, kX123, kY123, kX1234, kY1234, tolerance,
+                level + 1, points);
+  FlattenBezier(kX1234, kY1234, kX234, kY234, kX34, kY34, x4, y4, tolerance,
+                level + 1, points);
+}
+
+}  // namespace
+
 namespace moui {
 
+// The recorded commands of a retained path, and the subpaths flattened from
+// them and the vertices tessellated from them for recently rendered scales.
+struct NVGretainedPath {
+  // A recorded path command.
+  struct Command {
+    enum class Type {
+      kBezierTo,
+      kClose,
+      kLineTo,
+      kMoveTo,
+      kWinding,
+    };
+    Type type;
+    float values[6];
+  };
+
+  // A flattened subpath.
+  struct Subpath {
+    bool is_closed;
+    // The x and y coordinates of the points in order.
+    std::vector<float> points;
+    int winding;
+  };
+
+  // The subpaths flattened for a quantized scale.
+  struct Flattening {
+    int scale;
+    std::vector<Subpath> subpaths;
+  };
+
+  // The paths tessellated by nanovg for filling or stroking at a quantized
+  // scale. The vertices are in the coordinates of the recorded commands.
+  struct Tessellation {
+    bool is_stroke;
+    std::vector<TessellatedPath> paths;
+    int scale;
+    // The stroke width in the coordinates of the recorded commands, which is
+    // 0 for fills.
+    float stroke_width;
+  };
+
+  std::vector<Command> commands;
+  // The cached flattenings, the least recently created first.
+  std::vector<Flattening> flattenings;
+  // The cached tessellations, the least recently created first.
+  std::vector<Tessellation> tessellations;
+};
+
+namespace {
+
+// Appends the flattened subpaths to the current path of the context. The
+// points are transformed by `transform` first if not `nullptr`.
+void AppendSubpaths(NVGcontext* context,
+                    const std::vector<NVGretainedPath::Subpath>& subpaths,
+                    const float* transform) {
+  for (const NVGretainedPath::Subpath& kSubpath : subpaths) {
+    const std::vector<float>& kPoints = kSubpath.points;
+    for (size_t i = 0; i + 1 < kPoints.size(); i += 2) {
+      float x = kPoints[i];
+      float y = kPoints[i + 1];
+      if (transform != nullptr)
+        nvgTransformPoint(&x, &y, transform, kPoints[i], kPoints[i + 1]);
+      if (i == 0)
+        nvgMoveTo(context, x, y);
+      else
+        nvgLineTo(context, x, y);
+    }
+    if (kSubpath.is_closed)
+      nvgClosePath(context);
+    nvgPathWinding(context, kSubpath.winding);
+  }
+}
+
+// Returns the subpaths of the path flattened for the quantized `scale`. The
+// subpaths are flattened if not cached.
+const std::vector<NVGretainedPath::Subpath>& GetFlattenedSubpaths(
+    NVGretainedPath* path, const int scale) {
+  auto flattening = std::find_if(
+      path->flattenings.begin(), path->flattenings.end(),
+      [scale](const NVGretainedPath::Flattening& flattening) {
+        return flattening.scale == scale;
+      });
+  if (flattening != path->flattenings.end())
+    return flattening->subpaths;
+
+  if (path->flattenings.size() >= kMaximumNumberOfRetainedPathScales)
+    path->flattenings.erase(path->flattenings.begin());
+  path->flattenings.push_back(NVGretainedPath::Flattening());
+  flattening = path->flattenings.end() - 1;
+  flattening->scale = scale;
+  // Keeps the flattening error within a quarter of a device pixel on
+  // screen. nanovg uses a tolerance of 0.25 / devicePxRatio regardless of
+  // the transform, so both only flatten the same way at scale 1.
+  const float kTolerance = 0.25f * kRetainedPathScaleSteps / scale;
+  std::vector<NVGretainedPath::Subpath>& subpaths = flattening->subpaths;
+  float x = 0;
+  float y = 0;
+  for (const NVGretainedPath::Command& kCommand : path->commands) {
+    const float* kValues = kCommand.values;
+    if (kCommand.type == NVGretainedPath::Command::Type::kMoveTo ||
+        subpaths.empty()) {
+      subpaths.push_back({false, {}, NVG_CCW});
+      if (kCommand.type != NVGretainedPath::Command::Type::kMoveTo) {
+        subpaths.back().points.push_back(x);
+        subpaths.back().points.push_back(y);
+      }
+    }
+    NVGretainedPath::Subpath& subpath = subpaths.back();
+    switch (kCommand.type) {
+      case NVGretainedPath::Command::Type::kBezierTo:
+        FlattenBezier(x, y, kValues[0], kValues[1], kValues[2], kValues[3],
+                      kValues[4], kValues[5], kTolerance, 0, &subpath.points);
+        x = kValues[4];
+        y = kValues[5];
+        break;
+      case NVGretainedPath::Command::Type::kClose:
+        subpath.is_closed = true;
+        break;
+      case NVGretainedPath::Command::Type::kLineTo:
+      case NVGretainedPath::Command::Type::kMoveTo:
+        x = kValues[0];
+        y = kValues[1];
+        subpath.points.push_back(x);
+        subpath.points.push_back(y);
+        break;
+      case NVGretainedPath::Command::Type::kWinding:
+        subpath.winding = static_cast<int>(kValues[0]);
+        break;
+    }
+  }
+  return subpaths;
+}
+
+// Returns the quantized scale the path is rendered at on screen, and stores
+// `transform` combined with the current transform in `combined_transform`.
+int GetRetainedPathScale(NVGcontext* context, const float* transform,
+                         float* combined_transform) {
+  float current_transform[6];
+  if (transform != nullptr)
+    std::copy(transform, transform + 6, combined_transform);
+  else
+    nvgTransformIdentity(combined_transform);
+  nvgCurrentTransform(context, current_transform);
+  nvgTransformMultiply(combined_transform, current_transform);
+  const float kScale = \
+      std::sqrt(std::fabs(combined_transform[0] * combined_transform[3] -
+                          combined_transform[1] * combined_transform[2])) *
+      Device::GetScreenScaleFactor();
+  return std::max(
+      1, static_cast<int>(std::ceil(kScale * kRetainedPathScaleSteps)));
+}
+
+// Fills or strokes the retained path with the vertices tessellated for the
+// quantized scale it is rendered at. The path is tessellated by nanovg the
+// first time through the captured render callbacks, and the cached vertices
+// are only transformed afterwards.
+void RenderRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                        const float* transform, const bool is_stroke) {
+  float combined_transform[6];
+  const int kScale = GetRetainedPathScale(context, transform,
+                                          combined_transform);
+
+  // Lets nanovg resolve the render state from the current state. The
+  // resolved stroke width is scaled by the current transform only.
+  nvgBeginPath(context);
+  CaptureRender(context, is_stroke, nullptr);
+  const CapturedRenderState kRenderState = captured_render_state;
+  float stroke_width = 0;
+  if (is_stroke) {
+    const float kCombinedScale = std::sqrt(std::fabs(
+        combined_transform[0] * combined_transform[3] -
+        combined_transform[1] * combined_transform[2]));
+    if (kCombinedScale <= 0)
+      return;
+    stroke_width = kRenderState.stroke_width / kCombinedScale;
+  }
+
+  // Tessellates the path for the scale if not cached.
+  auto tessellation = std::find_if(
+      path->tessellations.begin(), path->tessellations.end(),
+      [is_stroke, kScale, stroke_width](
+          const NVGretainedPath::Tessellation& tessellation) {
+        return tessellation.is_stroke == is_stroke &&
+               tessellation.scale == kScale &&
+               tessellation.stroke_width == stroke_width;
+      });
+  if (tessellation == path->tessellations.end()) {
+    if (path->tessellations.size() >= kMaximumNumberOfRetainedPathScales)
+      path->tessellations.erase(path->tessellations.begin());
+    path->tessellations.push_back(NVGretainedPath::Tessellation());
+    tessellation = path->tessellations.end() - 1;
+    tessellation->is_stroke = is_stroke;
+    tessellation->scale = kScale;
+    tessellation->stroke_width = stroke_width;
+    // Tessellates the path at the quantized scale, so the fringes and the
+    // curves of round caps and joins match the scale the path is rendered
+    // at, and then scales the vertices back.
+    const float kTessellationScale = \
+        kScale / kRetainedPathScaleSteps / Device::GetScreenScaleFactor();
+    nvgSave(context);
+    nvgResetTransform(context);
+    nvgScale(context, kTessellationScale, kTessellationScale);
+    nvgStrokeWidth(context, stroke_width);
+    nvgBeginPath(context);
+    AppendSubpaths(context, GetFlattenedSubpaths(path, kScale), nullptr);
+    CaptureRender(context, is_stroke, &tessellation->paths);
+    nvgBeginPath(context);
+    nvgRestore(context);
+    for (TessellatedPath& tessellated_path : tessellation->paths) {
+      for (NVGvertex& vertex : tessellated_path.fill_vertices) {
+        vertex.x /= kTessellationScale;
+        vertex.y /= kTessellationScale;
+      }
+      for (NVGvertex& vertex : tessellated_path.stroke_vertices) {
+        vertex.x /= kTessellationScale;
+        vertex.y /= kTessellationScale;
+      }
+    }
+  }
+
+  // Transforms the cached vertices to the current coordinate space, which
+  // the backend copies before returning.
+  static std::vector<NVGvertex> vertices;
+  static std::vector<NVGpath> paths;
+  size_t number_of_vertices = 0;
+  for (const TessellatedPath& kPath : tessellation->paths) {
+    number_of_vertices += kPath.fill_vertices.size() + \
+                          kPath.stroke_vertices.size();
+  }
+  vertices.resize(number_of_vertices);
+  paths.clear();
+  float bounds[4] = {1e6f, 1e6f, -1e6f, -1e6f};
+  NVGvertex* vertex = vertices.data();
+  auto transform_vertices = [&](const std::vector<NVGvertex>& source,
+                                NVGvertex** first_vertex) {
+    *first_vertex = vertex;
+    for (const NVGvertex& kVertex : source) {
+      nvgTransformPoint(&vertex->x, &vertex->y, combined_transform, kVertex.x,
+                        kVertex.y);
+      vertex->u = kVertex.u;
+      vertex->v = kVertex.v;
+      bounds[0] = std::min(bounds[0], vertex->x);
+      bounds[1] = std::min(bounds[1], vertex->y);
+      bounds[2] = std::max(bounds[2], vertex->x);
+      bounds[3] = std::max(bounds[3], vertex->y);
+      ++vertex;
+    }
+  };
+  for (const TessellatedPath& kPath : tessellation->paths) {
+    paths.push_back(kPath.path);
+    transform_vertices(kPath.fill_vertices, &paths.back().fill);
+    transform_vertices(kPath.stroke_vertices, &paths.back().stroke);
+  }
+  if (paths.empty())
+    return;
+
+  NVGparams* params = nvgInternalParams(context);
+  CapturedRenderState render_state = kRenderState;
+  if (is_stroke) {
+    params->renderStroke(params->userPtr, &render_state.paint,
+                         render_state.composite_operation,
+                         &render_state.scissor, render_state.fringe,
+                         render_state.stroke_width, paths.data(),
+                         static_cast<int>(paths.size()));
+  } else {
+    params->renderFill(params->userPtr, &render_state.paint,
+                       render_state.composite_operation,
+                       &render_state.scissor, render_state.fringe, bounds,
+                       paths.data(), static_cast<int>(paths.size()));
+  }
+}
+
+}  // namespace
+
+void nvgAppendRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                           const float* transform) {
+  float combined_transform[6];
+  const int kScale = GetRetainedPathScale(context, transform,
+                                          combined_transform);
+  AppendSubpaths(context, GetFlattenedSubpaths(path, kScale), transform);
+}
+
 void nvgClearColor(NVGcontext* context, const int width, const int height,
                    const NVGcolor& clear_color) {
 #ifdef MOUI_GL
@@ -85,32 +534,42 @@ int nvgContextFlags(const bool antialias, const bool stencil_strokes,
 
 int nvgCreateFontAtPath(NVGcontext* context, const std::string name,
                         const std::string path) {
-#ifdef MOUI_ANDROID
-  // Loads the image from Android's assets folder.
-  if (path.find("file:///android_assets/") == 0) {
-    std::string asset_path = path.substr(23);
-    std::FILE* file = aasset_fopen(asset_path.c_str(), "r");
-    if (file == NULL) {
-      return -1;
-    }
-    const int kDataSize = aasset_fsize(file);
-    unsigned char* data = \
-        reinterpret_cast<unsigned char*>(std::malloc(kDataSize));
-    int image = -1;
-    if (aasset_fread(data, 1, kDataSize, file) == kDataSize) {
-      image = nvgCreateFontMem(context, name.c_str(), data, kDataSize,
-                               true);  // frees data
-    }
-    aasset_fclose(file);
-    return image;
-  }
-#endif  // MOUI_ANDROID
+  // Registers the font to the shared text layout engine first, so fontstash
+  // and the engine share the same font data instead of loading it twice. This
+  // also fails if the name is taken by a font at another path.
+  TextLayoutEngine* engine = TextLayoutEngine::GetSharedEngine();
+  if (!engine->AddFont(name, path))
+    return -1;
+
+  const int kFontId = nvgFindFont(context, name.c_str());
+  if (kFontId >= 0)
+    return kFontId;
 
-  return nvgCreateFont(context, name.c_str(), path.c_str());
+  const unsigned char* data;
+  size_t data_size;
+  if (!engine->GetFontData(name, &data, &data_size))
+    return -1;
+  return nvgCreateFontMem(context, name.c_str(),
+                          const_cast<unsigned char*>(data),
+                          static_cast<int>(data_size),
+                          false);  // the data is owned by the engine
 }
 
 int nvgCreateImageAtPath(NVGcontext* context, const std::string path,
                          const int image_flags) {
+  // Decodes the image straight from the shared resource archive if packed.
+  const unsigned char* packed_data;
+  size_t packed_size;
+  if (ResourceArchive::GetSharedArchive()->GetData(path, &packed_data,
+                                                   &packed_size)) {
+    return TrackImage(
+        context,
+        nvgCreateImageMem(context, image_flags,
+                          const_cast<unsigned char*>(packed_data),
+                          static_cast<int>(packed_size)),
+        image_flags);
+  }
+
 #ifdef MOUI_ANDROID
   // Loads the image from Android's assets folder.
   if (path.find("file:///android_assets/") == 0) {
@@ -128,11 +587,12 @@ int nvgCreateImageAtPath(NVGcontext* context, const std::string path,
       std::free(data);
     }
     aasset_fclose(file);
-    return image;
+    return TrackImage(context, image, image_flags);
   }
 #endif  // MOUI_ANDROID
 
-  return nvgCreateImage(context, path.c_str(), image_flags);
+  return TrackImage(context, nvgCreateImage(context, path.c_str(), image_flags),
+                    image_flags);
 }
 
 int nvgCreateImageFromPixels(NVGcontext* context, const int width,
@@ -142,17 +602,64 @@ int nvgCreateImageFromPixels(NVGcontext* context, const int width,
 #ifdef MOUI_GL
   flags |= NVG_IMAGE_FLIPY;
 #endif
-  return nvgCreateImageRGBA(context, width, height, flags, data);
+  return nvgCreateTrackedImageRGBA(context, width, height, flags, data);
+}
+
+NVGretainedPath* nvgCreateRetainedPath() {
+  return new NVGretainedPath;
+}
+
+NVGframebuffer* nvgCreateTrackedFramebuffer(NVGcontext* context,
+                                            const int width, const int height,
+                                            const int image_flags) {
+#if defined(MOUI_GL)
+  NVGframebuffer* framebuffer = nvgluCreateFramebuffer(context, width, height,
+                                                       image_flags);
+#elif defined(MOUI_METAL)
+  NVGframebuffer* framebuffer = mnvgCreateFramebuffer(context, width, height,
+                                                      image_flags);
+#endif
+  if (framebuffer == NULL)
+    return nullptr;
+  GpuMemoryTracker::GetSharedTracker()->AddAllocation(
+      context, framebuffer->image, true,
+      static_cast<size_t>(width) * height * kFramebufferBytesPerPixel);
+  return framebuffer;
+}
+
+int nvgCreateTrackedImageRGBA(NVGcontext* context, const int width,
+                              const int height, const int image_flags,
+                              const unsigned char* data) {
+  return TrackImage(
+      context, nvgCreateImageRGBA(context, width, height, image_flags, data),
+      image_flags);
 }
 
 void nvgDeleteImage(NVGcontext* context, int* image) {
   if (*image < 0)
     return;
 
+  GpuMemoryTracker::GetSharedTracker()->RemoveAllocation(context, *image);
   nvgDeleteImage(context, *image);
   *image = -1;
 }
 
+void nvgDeleteRetainedPath(NVGretainedPath* path) {
+  delete path;
+}
+
+void nvgDeleteTrackedFramebuffer(NVGframebuffer* framebuffer) {
+  if (framebuffer == nullptr)
+    return;
+  GpuMemoryTracker::GetSharedTracker()->RemoveAllocation(framebuffer->ctx,
+                                                         framebuffer->image);
+#if defined(MOUI_GL)
+  nvgluDeleteFramebuffer(framebuffer);
+#elif defined(MOUI_METAL)
+  mnvgDeleteFramebuffer(framebuffer);
+#endif
+}
+
 void nvgDrawDropShadow(NVGcontext* context, const float x, const float y,
                        const float width, const float height,
                        const float radius, float feather,
@@ -168,6 +675,56 @@ void nvgDrawDropShadow(NVGcontext* context, const float x, const float y,
   nvgFill(context);
 }
 
+void nvgDrawImageQuads(NVGcontext* context, const NVGpaint& paint,
+                       const std::vector<NVGimageQuad>& quads) {
+  if (quads.empty())
+    return;
+
+  // Lets nanovg resolve the paint and the render state for a fill without
+  // rendering it, so the quads are clipped and blended the same way.
+  nvgSave(context);
+  nvgFillPaint(context, paint);
+  nvgBeginPath(context);
+  nvgRect(context, quads[0].x0, quads[0].y0, quads[0].x1 - quads[0].x0,
+          quads[0].y1 - quads[0].y0);
+  CaptureRender(context, false, nullptr);
+  nvgRestore(context);
+
+  // Builds two triangles for every quad like nanovg does for text.
+  float transform[6];
+  nvgCurrentTransform(context, transform);
+  std::vector<NVGvertex> vertices(quads.size() * 6);
+  NVGvertex* vertex = vertices.data();
+  for (const NVGimageQuad& kQuad : quads) {
+    float corners[8];
+    nvgTransformPoint(&corners[0], &corners[1], transform, kQuad.x0,
+                      kQuad.y0);
+    nvgTransformPoint(&corners[2], &corners[3], transform, kQuad.x1,
+                      kQuad.y0);
+    nvgTransformPoint(&corners[4], &corners[5], transform, kQuad.x1,
+                      kQuad.y1);
+    nvgTransformPoint(&corners[6], &corners[7], transform, kQuad.x0,
+                      kQuad.y1);
+    *vertex++ = {corners[0], corners[1], kQuad.s0, kQuad.t0};
+    *vertex++ = {corners[4], corners[5], kQuad.s1, kQuad.t1};
+    *vertex++ = {corners[2], corners[3], kQuad.s1, kQuad.t0};
+    *vertex++ = {corners[0], corners[1], kQuad.s0, kQuad.t0};
+    *vertex++ = {corners[6], corners[7], kQuad.s0, kQuad.t1};
+    *vertex++ = {corners[4], corners[5], kQuad.s1, kQuad.t1};
+  }
+  NVGparams* params = nvgInternalParams(context);
+  params->renderTriangles(params->userPtr, &captured_render_state.paint,
+                          captured_render_state.composite_operation,
+                          &captured_render_state.scissor, vertices.data(),
+                          static_cast<int>(vertices.size()),
+                          captured_render_state.fringe);
+}
+
+void nvgFillRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                         const float* transform) {
+  RenderRetainedPath(context, path, transform, false);
+}
+
 void nvgReadPixels(NVGcontext* context, int image, int x, int y, int width,
                    int height, void* data) {
 #if defined(MOUI_GL)
@@ -177,6 +734,77 @@ void nvgReadPixels(NVGcontext* context, int image, int x, int y, int width,
 #endif
 }
 
+void nvgRetainedPathBezierTo(NVGretainedPath* path, const float c1x,
+                             const float c1y, const float c2x,
+                             const float c2y, const float x, const float y) {
+  path->commands.push_back({NVGretainedPath::Command::Type::kBezierTo,
+                            {c1x, c1y, c2x, c2y, x, y}});
+  path->flattenings.clear();
+  path->tessellations.clear();
+}
+
+void nvgRetainedPathClose(NVGretainedPath* path) {
+  path->commands.push_back({NVGretainedPath::Command::Type::kClose, {}});
+  path->flattenings.clear();
+  path->tessellations.clear();
+}
+
+void nvgRetainedPathLineTo(NVGretainedPath* path, const float x,
+                           const float y) {
+  path->commands.push_back({NVGretainedPath::Command::Type::kLineTo,
+                            {x, y}});
+  path->flattenings.clear();
+  path->tessellations.clear();
+}
+
+void nvgRetainedPathMoveTo(NVGretainedPath* path, const float x,
+                           const float y) {
+  path->commands.push_back({NVGretainedPath::Command::Type::kMoveTo,
+                            {x, y}});
+  path->flattenings.clear();
+  path->tessellations.clear();
+}
+
+void nvgRetainedPathWinding(NVGretainedPath* path, const int direction) {
+  path->commands.push_back({NVGretainedPath::Command::Type::kWinding,
+                            {static_cast<float>(direction)}});
+  path->flattenings.clear();
+  path->tessellations.clear();
+}
+
+void nvgStrokeRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                           const float* transform) {
+  RenderRetainedPath(context, path, transform, true);
+}
+
+void nvgUpdateImageRegion(NVGcontext* context, const int image, const int x,
+                          const int y, const int width, const int height,
+                          const int image_flags, const unsigned char* data) {
+  if (image < 0 || width <= 0 || height <= 0)
+    return;
+
+  NVGparams* params = nvgInternalParams(context);
+  params->renderUpdateTexture(params->userPtr, image, x, y, width, height,
+                              data);
+  if (!(image_flags & NVG_IMAGE_GENERATE_MIPMAPS))
+    return;
+  // The GL2 backend sets `GL_GENERATE_MIPMAP` so the mipmaps follow every
+  // update, but other GL backends only generate them on creation.
+#if defined(MOUI_GLES2) || defined(MOUI_GL3) || defined(MOUI_GLES3)
+#  if defined(MOUI_GLES2)
+  const GLuint kTexture = nvglImageHandleGLES2(context, image);
+#  elif defined(MOUI_GL3)
+  const GLuint kTexture = nvglImageHandleGL3(context, image);
+#  else
+  const GLuint kTexture = nvglImageHandleGLES3(context, image);
+#  endif
+  glBindTexture(GL_TEXTURE_2D, kTexture);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  // Matches the texture binding nanovg leaves after updating textures.
+  glBindTexture(GL_TEXTURE_2D, 0);
+#endif
+}
+
 void nvgUnpremultiplyImageAlpha(unsigned char* image, const int width,
                                 const int height) {
   const int kStride = width * 4;
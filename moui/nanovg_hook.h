@@ -19,6 +19,7 @@
 #define MOUI_NANOVG_HOOK_H_
 
 #include <string>
+#include <vector>
 
 #include "moui/defines.h"
 
@@ -65,18 +66,18 @@ extern "C" {
 #  define nvgCreateContext(layer, flags) nvgCreateMTL(layer, flags)
 #  define nvgDeleteContext(context) nvgDeleteMTL(context)
 #  define nvgBindFramebuffer(fb) mnvgBindFramebuffer(fb)
-#  define nvgCreateFramebuffer(ctx, w, h, flags) \
-          mnvgCreateFramebuffer(ctx, w, h, flags)
-#  define nvgDeleteFramebuffer(fb) mnvgDeleteFramebuffer(fb)
 #endif
 
 #ifdef MOUI_GL
 #  define nvgBindFramebuffer(fb) nvgluBindFramebuffer(fb)
-#  define nvgCreateFramebuffer(ctx, w, h, flags) \
-          nvgluCreateFramebuffer(ctx, w, h, flags)
-#  define nvgDeleteFramebuffer(fb) nvgluDeleteFramebuffer(fb)
 #endif
 
+// Framebuffers are created and deleted through `nanovg_hook` so their memory
+// is accounted by `GpuMemoryTracker`.
+#define nvgCreateFramebuffer(ctx, w, h, flags) \
+        moui::nvgCreateTrackedFramebuffer(ctx, w, h, flags)
+#define nvgDeleteFramebuffer(fb) moui::nvgDeleteTrackedFramebuffer(fb)
+
 #if defined(MOUI_GL)
   typedef NVGLUframebuffer NVGframebuffer;
 #elif defined(MOUI_METAL)
@@ -86,6 +87,34 @@ extern "C" {
 // Additonal APIs for nanovg.
 namespace moui {
 
+// A path recorded once in local coordinates and appended to the current
+// nanovg path any number of times. Created by `nvgCreateRetainedPath()`.
+struct NVGretainedPath;
+
+// A textured rectangle drawn by `nvgDrawImageQuads()`. The corners are in
+// the current coordinate space and the texture coordinates are normalized.
+struct NVGimageQuad {
+  float x0;
+  float y0;
+  float x1;
+  float y1;
+  float s0;
+  float t0;
+  float s1;
+  float t1;
+};
+
+// Appends the retained path to the current path of the context like calling
+// the recorded commands again. The points are transformed by `transform`
+// first, which can be `nullptr` for the identity transform. The flattened
+// curves are cached for the scale the path is rendered at, so replaying
+// the path only adds straight segments. The caller fills or strokes the path
+// afterwards, which tessellates the segments again. Use
+// `nvgFillRetainedPath()` or `nvgStrokeRetainedPath()` to reuse the
+// tessellated vertices as well.
+void nvgAppendRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                           const float* transform);
+
 // Clears the current color buffer with the specified `clear_color`. Note that
 // this function should be called between `nvgBindFramebuffer()` and
 // `nvgBeginFrame()`.
@@ -101,24 +130,57 @@ int nvgContextFlags(const bool antialias, const bool stencil_strokes,
 
 // Creates a font at the specified path and returns the font handle.
 // This function is the enhanced version of `nvgCreateFont()` that has
-// better cross-platform support.
+// better cross-platform support. The font is also registered to the shared
+// `TextLayoutEngine`, which shares the font data with fontstash. Fonts packed
+// in the shared `ResourceArchive` are used without loading the file. The
+// existing font is returned if a font with the same name is already created
+// from the same path. Returns -1 if the name is taken by a font at another
+// path, since fonts in use are never replaced.
 int nvgCreateFontAtPath(NVGcontext* context, const std::string name,
                         const std::string path);
 
 // Creates an image at the specified path and returns the image handle.
 // This function is the enhanced version of `nvgCreateImage()` that has
-// better cross-platform support.
+// better cross-platform support. Images packed in the shared
+// `ResourceArchive` are decoded from the archive without loading the file.
+// The image is tracked by `GpuMemoryTracker`.
 int nvgCreateImageAtPath(NVGcontext* context, const std::string path,
                          const int image_flags);
 
-// Creates an image for pixels read from `nvgReadPixels()`.
+// Creates an image for pixels read from `nvgReadPixels()`. The image is
+// tracked by `GpuMemoryTracker`.
 int nvgCreateImageFromPixels(NVGcontext* context, const int width,
                              const int height, const int image_flags,
                              const unsigned char* data);
 
-// Deletes the passed image and set the image id to -1.
+// Creates an empty retained path. The path doesn't belong to any context and
+// must be deleted by `nvgDeleteRetainedPath()`.
+NVGretainedPath* nvgCreateRetainedPath();
+
+// Creates a framebuffer tracked by `GpuMemoryTracker`. This function is
+// called through the `nvgCreateFramebuffer()` macro.
+NVGframebuffer* nvgCreateTrackedFramebuffer(NVGcontext* context,
+                                            const int width, const int height,
+                                            const int image_flags);
+
+// Creates an image like `nvgCreateImageRGBA()` that is tracked by
+// `GpuMemoryTracker`.
+int nvgCreateTrackedImageRGBA(NVGcontext* context, const int width,
+                              const int height, const int image_flags,
+                              const unsigned char* data);
+
+// Deletes the passed image and set the image id to -1. Tracked images must
+// be deleted by this function.
 void nvgDeleteImage(NVGcontext* context, int* image);
 
+// Deletes the retained path created by `nvgCreateRetainedPath()`.
+void nvgDeleteRetainedPath(NVGretainedPath* path);
+
+// Deletes the framebuffer created by `nvgCreateTrackedFramebuffer()`. This
+// function is called through the `nvgDeleteFramebuffer()` macro and accepts
+// `nullptr`.
+void nvgDeleteTrackedFramebuffer(NVGframebuffer* framebuffer);
+
 // Draws drop shadow.
 void nvgDrawDropShadow(NVGcontext* context, const float x, const float y,
                        const float width, const float height,
@@ -126,12 +188,57 @@ void nvgDrawDropShadow(NVGcontext* context, const float x, const float y,
                        const NVGcolor inner_color,
                        const NVGcolor outer_color);
 
+// Draws the quads textured with the image of `paint` in a single draw call
+// like nanovg draws text. The inner color of `paint` tints the image. The
+// current transform, scissor, global alpha and composite operation apply
+// the same as `nvgFill()`. The current path is cleared. This function must
+// only be called on the render thread.
+void nvgDrawImageQuads(NVGcontext* context, const NVGpaint& paint,
+                       const std::vector<NVGimageQuad>& quads);
+
+// Fills the retained path with the current fill style like calling
+// `nvgAppendRetainedPath()` and `nvgFill()`. The vertices nanovg tessellates
+// are cached for the scale the path is rendered at, so later calls only
+// transform the vertices. The current path is cleared. This function must
+// only be called on the render thread.
+void nvgFillRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                         const float* transform);
+
 // Copies the pixels from the specified image into the specified `data`.
 // Note that for OpenGL, this function reads the pixels from the currently
 // binded render buffer directly instead of the specified `image`.
 void nvgReadPixels(NVGcontext* context, int image, int x, int y, int width,
                    int height, void* data);
 
+// Records path commands into a retained path. These functions work the same
+// as their nanovg counterparts and invalidate the cached flattened curves and
+// tessellated vertices.
+void nvgRetainedPathBezierTo(NVGretainedPath* path, const float c1x,
+                             const float c1y, const float c2x,
+                             const float c2y, const float x, const float y);
+void nvgRetainedPathClose(NVGretainedPath* path);
+void nvgRetainedPathLineTo(NVGretainedPath* path, const float x,
+                           const float y);
+void nvgRetainedPathMoveTo(NVGretainedPath* path, const float x,
+                           const float y);
+void nvgRetainedPathWinding(NVGretainedPath* path, const int direction);
+
+// Strokes the retained path with the current stroke style like
+// `nvgFillRetainedPath()` fills it. The vertices are cached for the scale and
+// the stroke width only, since nanovg doesn't expose the other attributes, so
+// a path must always be stroked with the same line cap, line join and miter
+// limit. This function must only be called on the render thread.
+void nvgStrokeRetainedPath(NVGcontext* context, NVGretainedPath* path,
+                           const float* transform);
+
+// Uploads the pixels within the specified region of `image` like
+// `nvgUpdateImage()`, which always uploads the whole image. `data` holds the
+// pixels of the whole image. The mipmaps are regenerated if `image_flags`
+// contains `NVG_IMAGE_GENERATE_MIPMAPS`.
+void nvgUpdateImageRegion(NVGcontext* context, const int image, const int x,
+                          const int y, const int width, const int height,
+                          const int image_flags, const unsigned char* data);
+
 // Updates the specified `image` data to unpremultiply its alpha values.
 void nvgUnpremultiplyImageAlpha(unsigned char* image, const int width,
                                 const int height);
@@ -21,30 +21,64 @@
 #include <cstdio>
 #include <string>
 
+#include "moui/core/clock.h"
 #include "moui/native/native_view.h"
 
+namespace {
+
+// The time in seconds by which a frame may arrive earlier than the animation
+// interval and still be rendered, which absorbs the jitter of display
+// refreshes.
+const double kFrameIntervalTolerance = 0.004;
+
+}  // namespace
+
 namespace moui {
 
-BaseView::BaseView() : NativeView(nullptr), animation_count_(0) {
+BaseView::BaseView() : NativeView(nullptr), last_frame_timestamp_(0) {
 }
 
 BaseView::~BaseView() {
 }
 
+double BaseView::GetAnimationInterval() const {
+  return animation_intervals_.empty() ? 0 : *animation_intervals_.begin();
+}
+
 bool BaseView::IsAnimating() const {
-  return animation_count_ > 0;
+  return !animation_intervals_.empty();
+}
+
+bool BaseView::ShouldRenderFrame() {
+  const double kInterval = GetAnimationInterval();
+  const double kTimestamp = Clock::GetTimestamp();
+  if (kInterval > 0 &&
+      kTimestamp - last_frame_timestamp_ < kInterval - kFrameIntervalTolerance)
+    return false;
+  last_frame_timestamp_ = kTimestamp;
+  return true;
 }
 
 void BaseView::StartAnimation() {
-  ++animation_count_;
+  StartAnimation(0);
+}
+
+void BaseView::StartAnimation(const double interval) {
+  animation_intervals_.insert(std::max(0.0, interval));
   StartUpdatingNativeView();
 }
 
 void BaseView::StopAnimation() {
-  --animation_count_;
-  if (animation_count_ == 0)
+  StopAnimation(0);
+}
+
+void BaseView::StopAnimation(const double interval) {
+  auto iterator = animation_intervals_.find(std::max(0.0, interval));
+  if (iterator == animation_intervals_.end())
+    return;
+  animation_intervals_.erase(iterator);
+  if (animation_intervals_.empty())
     StopUpdatingNativeView();
-  animation_count_ = std::max(0, animation_count_);
 }
 
 }  // namespace moui
@@ -18,6 +18,7 @@
 #ifndef MOUI_UI_BASE_VIEW_H_
 #define MOUI_UI_BASE_VIEW_H_
 
+#include <set>
 #include <string>
 
 #include "moui/base.h"
@@ -39,6 +40,12 @@ class BaseView : public NativeView {
   // the `ShouldHandleEvent()` method should be overriden to return `true`.
   virtual void HandleEvent(Event* event) {}
 
+  // Returns the interval in seconds between the frames required by all active
+  // animations, which is the smallest interval passed to `StartAnimation()`.
+  // Returns 0 if an animation updates on every refresh of the display or no
+  // animation is active.
+  double GetAnimationInterval() const;
+
   // Returns `true` if the view is animating, that is, the view is keeping
   // updated continuously on the refresh rate of the display.
   bool IsAnimating() const;
@@ -49,15 +56,30 @@ class BaseView : public NativeView {
   // The place for writing rendering code.
   virtual void Render() {}
 
+  // Returns `true` if the animating view should render on the current refresh
+  // of the display. The native view calls this method on every refresh while
+  // animating without pending redraw requests, and skips the refresh if the
+  // animation interval has not elapsed since the last rendered frame.
+  bool ShouldRenderFrame();
+
   // Starts updating the view synchronized to the refresh rate of the display
   // continuously. `StopAnimation()` must be called for each `StartAnimation()`
   // call.
   void StartAnimation();
 
+  // Same as `StartAnimation()` but the animation only changes its visual state
+  // every `interval` seconds, which allows the view to skip the refreshes in
+  // between as long as no other animation requires them. `StopAnimation()`
+  // must be called with the same interval.
+  void StartAnimation(const double interval);
+
   // Ends previous `StartAnimation()` call. The animation will actually stop if
   // all `StartAnimation()` calls are ended.
   void StopAnimation();
 
+  // Ends previous `StartAnimation()` call with the specified interval.
+  void StopAnimation(const double interval);
+
   // This method gets called when an event is about to occur. The returned
   // boolean indicates whether the view should handle the event. By default
   // it returns `false` so it simply ignores any coming event and the platform
@@ -77,10 +99,13 @@ class BaseView : public NativeView {
   // and the actual native implementation requests stoping native view updates.
   virtual void StopUpdatingNativeView() {}
 
-  // The number of animation requests. The default value is 0.
-  // `StartAnimation()` increases the value and `StopAnimation()` decreases the
-  // value. A view is treated as animating if this value is greater than 0.
-  int animation_count_;
+  // The intervals of the animation requests. `StartAnimation()` inserts an
+  // interval and `StopAnimation()` removes one. A view is treated as animating
+  // if this is not empty.
+  std::multiset<double> animation_intervals_;
+
+  // The timestamp of the last frame allowed by `ShouldRenderFrame()`.
+  double last_frame_timestamp_;
 
   DISALLOW_COPY_AND_ASSIGN(BaseView);
 };
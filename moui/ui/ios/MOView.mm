@@ -80,6 +80,13 @@
     return;
   }
 
+  // Skips the refresh if nothing requested a redraw and the animations don't
+  // need a new frame yet.
+  @synchronized(self) {
+    if (_isUpdatingView && !_needsRedraw && !_mouiView->ShouldRenderFrame())
+      return;
+  }
+
   [self prepareDrawable];
   _mouiView->Render();
   [self presentDrawable];
@@ -167,6 +174,10 @@
     [self createDrawableWithSize:
         CGSizeMake(_drawableSize.width * self.layer.contentsScale,
                    _drawableSize.height * self.layer.contentsScale)];
+    // Renders the new drawable even if the animations don't need a frame.
+    @synchronized(self) {
+      _needsRedraw = YES;
+    }
     [self render];
   }
 }
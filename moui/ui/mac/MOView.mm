@@ -87,6 +87,15 @@ static CVReturn renderCallback(CVDisplayLinkRef displayLink,
     return;
   }
 
+  // Skips the refresh if nothing requested a redraw and the animations don't
+  // need a new frame yet.
+  @synchronized(self) {
+    if (!_stopsUpdatingView && !_needsRedraw &&
+        !_mouiView->ShouldRenderFrame()) {
+      return;
+    }
+  }
+
   [self prepareDrawable];
   _mouiView->Render();
   [self presentDrawable];
@@ -116,6 +125,10 @@ static CVReturn renderCallback(CVDisplayLinkRef displayLink,
   _mouiView->SetBounds(0, 0, self.bounds.size.width, self.bounds.size.height);
   [self destroyDrawable];
   [self createDrawableWithSize:_drawableSize];
+  // Renders the new drawable even if the animations don't need a frame.
+  @synchronized(self) {
+    _needsRedraw = YES;
+  }
   [self render];
   return YES;
 }
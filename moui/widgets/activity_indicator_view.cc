@@ -22,6 +22,7 @@
 
 #include "moui/core/clock.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
 
 namespace {
 
@@ -29,6 +30,9 @@ const int kDefaultColorStartLineIndex = 9;
 const int kDefaultNumberOfColoredLines = 6;
 const int kDefaultNumberOfLines = 12;
 
+// The interval in seconds between advancing the colored lines.
+const double kLineAdvanceInterval = 0.1;
+
 }  // namespace
 
 namespace moui {
@@ -37,6 +41,8 @@ ActivityIndicatorView::ActivityIndicatorView()
     : animation_start_timestamp_(-1),
       color_start_line_index_(kDefaultColorStartLineIndex),
       last_color_(nvgRGBAf(0, 0, 0, 0.2)),
+      line_path_(nvgCreateRetainedPath()),
+      line_path_radius_(-1),
       number_of_colored_lines_(kDefaultNumberOfColoredLines),
       number_of_lines_(kDefaultNumberOfLines),
       number_of_visible_lines_(number_of_lines_),
@@ -45,19 +51,22 @@ ActivityIndicatorView::ActivityIndicatorView()
 }
 
 ActivityIndicatorView::~ActivityIndicatorView() {
+  nvgDeleteRetainedPath(line_path_);
 }
 
 void ActivityIndicatorView::StartAnimating() {
-  if (IsAnimating())
+  if (animation_start_timestamp_ >= 0)
     return;
   animation_start_timestamp_ = Clock::GetTimestamp();
   animation_color_start_line_index_ = color_start_line_index_;
-  StartAnimation();
+  StartAnimation(kLineAdvanceInterval);
 }
 
 void ActivityIndicatorView::StopAnimating() {
+  if (animation_start_timestamp_ < 0)
+    return;
   animation_start_timestamp_ = -1;
-  StopAnimation(true);
+  StopAnimation(kLineAdvanceInterval);
 }
 
 void ActivityIndicatorView::Render(NVGcontext* context) {
@@ -69,17 +78,30 @@ void ActivityIndicatorView::Render(NVGcontext* context) {
   const float kLineEndPoint = kIndicatorRadius - kLineWidth / 2 - 1;
 
   if (animation_start_timestamp_ > 0) {
-    const double kElapsedTime = \
-        Clock::GetTimestamp() - animation_start_timestamp_;
+    const double kElapsedTime = std::max(
+        0.0, AnimationEngine::GetSharedEngine()->frame_timestamp()
+             - animation_start_timestamp_);
     color_start_line_index_ = \
-        static_cast<int>(animation_color_start_line_index_ + kElapsedTime / 0.1)
+        static_cast<int>(animation_color_start_line_index_
+                         + kElapsedTime / kLineAdvanceInterval)
         % number_of_lines_;
   }
 
+  if (kIndicatorRadius != line_path_radius_) {
+    nvgDeleteRetainedPath(line_path_);
+    line_path_ = nvgCreateRetainedPath();
+    nvgRetainedPathMoveTo(line_path_, kLineStartPoint, 0);
+    nvgRetainedPathLineTo(line_path_, kLineEndPoint, 0);
+    line_path_radius_ = kIndicatorRadius;
+  }
+
   nvgLineCap(context, NVG_ROUND);
   nvgLineJoin(context, NVG_ROUND);
   nvgStrokeWidth(context, kLineWidth);
-  nvgTranslate(context, kWidth / 2, kHeight / 2);
+
+  float transform[6];
+  float translation[6];
+  nvgTransformTranslate(translation, kWidth / 2, kHeight / 2);
 
   for (int line_index = 0; line_index < number_of_lines_; ++line_index) {
     if (line_index >= number_of_visible_lines_)
@@ -92,14 +114,11 @@ void ActivityIndicatorView::Render(NVGcontext* context) {
         start_color_, last_color_,
         static_cast<float>(kColorIndex) / (number_of_colored_lines_ - 1));
 
-    nvgSave(context);
-    nvgBeginPath(context);
-    nvgRotate(context, 2 * M_PI / number_of_lines_ * line_index - 0.5 * M_PI);
-    nvgMoveTo(context, kLineStartPoint, 0);
-    nvgLineTo(context, kLineEndPoint, 0);
+    nvgTransformRotate(
+        transform, 2 * M_PI / number_of_lines_ * line_index - 0.5 * M_PI);
+    nvgTransformMultiply(transform, translation);
     nvgStrokeColor(context, kLineColor);
-    nvgStroke(context);
-    nvgRestore(context);
+    nvgStrokeRetainedPath(context, line_path_, transform);
   }
 }
 
@@ -67,6 +67,12 @@ class ActivityIndicatorView : public Widget {
   // Indicates the color applied to the last line.
   NVGcolor last_color_;
 
+  // The retained path of a line pointing right from the center, which is
+  // rotated for every line. The path is recorded again only if the indicator
+  // radius differs from `line_path_radius_`.
+  NVGretainedPath* line_path_;
+  float line_path_radius_;
+
   // Indicates the number of lines that should apply graduated colors from the
   // `start_color_` to `last_color_`. All other lines are applied the
   // `last_color_`. The default number is 6.
@@ -0,0 +1,395 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/animation_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <vector>
+
+#include "moui/core/clock.h"
+#include "moui/widgets/widget.h"
+#include "moui/widgets/widget_view.h"
+
+namespace {
+
+// The displacement below which a spring is considered settled.
+const float kSpringRestingDisplacement = 0.001;
+
+// The interval in seconds used for checking whether a spring is settled.
+const double kSpringRestingInterval = 1.0 / 60;
+
+// Returns the y value of the cubic bezier curve from (0, 0) to (1, 1) with
+// the control points (x1, y1) and (x2, y2) at the specified x value.
+float GetCubicBezierY(const float x1, const float y1, const float x2,
+                      const float y2, const float x) {
+  const float kAx = 1 + 3 * x1 - 3 * x2;
+  const float kBx = 3 * x2 - 6 * x1;
+  const float kCx = 3 * x1;
+  const float kAy = 1 + 3 * y1 - 3 * y2;
+  const float kBy = 3 * y2 - 6 * y1;
+  const float kCy = 3 * y1;
+
+  // Finds the parameter t for x with Newton's method first, and falls back to
+  // bisection if it doesn't converge.
+  float t = x;
+  bool found = false;
+  for (int i = 0; i < 8; ++i) {
+    const float kError = ((kAx * t + kBx) * t + kCx) * t - x;
+    if (std::abs(kError) < 1e-6) {
+      found = true;
+      break;
+    }
+    const float kSlope = (3 * kAx * t + 2 * kBx) * t + kCx;
+    if (std::abs(kSlope) < 1e-6)
+      break;
+    t -= kError / kSlope;
+  }
+  if (!found) {
+    float lower = 0;
+    float upper = 1;
+    t = x;
+    for (int i = 0; i < 32 && upper - lower > 1e-6; ++i) {
+      const float kX = ((kAx * t + kBx) * t + kCx) * t;
+      if (kX < x)
+        lower = t;
+      else
+        upper = t;
+      t = (lower + upper) / 2;
+    }
+  }
+  return ((kAy * t + kBy) * t + kCy) * t;
+}
+
+// Returns the displacement at the specified time of a spring released from a
+// displacement of 1 with no initial velocity.
+float GetSpringDisplacement(const float damping_ratio, const float response,
+                            const double time) {
+  const double kOmega = 2 * M_PI / std::max(response, 0.001f);
+  const double kZeta = std::max(damping_ratio, 0.0f);
+  if (kZeta < 1) {
+    const double kDampedOmega = kOmega * std::sqrt(1 - kZeta * kZeta);
+    return std::exp(-kZeta * kOmega * time)
+           * (std::cos(kDampedOmega * time)
+              + kZeta * kOmega / kDampedOmega * std::sin(kDampedOmega * time));
+  }
+  if (kZeta == 1)
+    return std::exp(-kOmega * time) * (1 + kOmega * time);
+  const double kRoot = kOmega * std::sqrt(kZeta * kZeta - 1);
+  const double kR1 = -kZeta * kOmega + kRoot;
+  const double kR2 = -kZeta * kOmega - kRoot;
+  return (kR2 * std::exp(kR1 * time) - kR1 * std::exp(kR2 * time))
+         / (kR2 - kR1);
+}
+
+}  // namespace
+
+namespace moui {
+
+AnimationEngine::AnimationEngine() : frame_timestamp_(Clock::GetTimestamp()),
+                                     is_updating_(false),
+                                     next_animation_id_(0) {
+}
+
+AnimationEngine::~AnimationEngine() {
+}
+
+AnimationEngine* AnimationEngine::GetSharedEngine() {
+  static AnimationEngine* shared_engine = new AnimationEngine;
+  return shared_engine;
+}
+
+AnimationEngine::Timing AnimationEngine::GetCurveTiming(
+    const Curve curve, const double duration) {
+  Timing timing;
+  timing.curve = curve;
+  timing.duration = duration;
+  timing.damping_ratio = 1;
+  timing.response = 0.5;
+  return timing;
+}
+
+AnimationEngine::Timing AnimationEngine::GetSpringTiming(
+    const float damping_ratio, const float response) {
+  Timing timing;
+  timing.curve = Curve::kSpring;
+  timing.duration = 0;
+  timing.damping_ratio = damping_ratio;
+  timing.response = response;
+  return timing;
+}
+
+int AnimationEngine::AddAnimation(Animation* animation) {
+  animation->id = next_animation_id_++;
+  animation->is_cancelled = false;
+  animation->start_timestamp = Clock::GetTimestamp();
+  animation->value = animation->from_value;
+  // Compositor-only animations of widgets not yet attached to a widget view
+  // keep their widgets animating until attached.
+  animation->widget_view = nullptr;
+  if (IsCompositorOnly(*animation))
+    animation->widget_view = animation->widget->widget_view();
+  if (animation->widget_view != nullptr) {
+    animation->widget_view->StartAnimation();
+    animation->widget->RetainLayer();
+    animation->widget->Recomposite();
+  } else {
+    animation->widget->StartAnimation();
+  }
+  animations_.push_back(*animation);
+  return animation->id;
+}
+
+int AnimationEngine::Animate(Widget* widget, const Property property,
+                             const float to_value, const Timing& timing,
+                             Completion completion) {
+  for (auto it = animations_.begin(); it != animations_.end(); ++it) {
+    if (!it->is_cancelled && it->widget == widget && it->updater == NULL &&
+        it->property == property) {
+      RemoveAnimation(it);
+      break;
+    }
+  }
+
+  Animation animation;
+  animation.widget = widget;
+  animation.property = property;
+  animation.from_value = GetPropertyValue(widget, property);
+  animation.to_value = to_value;
+  animation.timing = timing;
+  animation.updater = NULL;
+  animation.completion = completion;
+  return AddAnimation(&animation);
+}
+
+int AnimationEngine::AnimateValue(Widget* widget, const float from_value,
+                                  const float to_value, const Timing& timing,
+                                  Updater updater, Completion completion) {
+  Animation animation;
+  animation.widget = widget;
+  animation.property = Property::kAlpha;
+  animation.from_value = from_value;
+  animation.to_value = to_value;
+  animation.timing = timing;
+  animation.updater = updater;
+  animation.completion = completion;
+  return AddAnimation(&animation);
+}
+
+void AnimationEngine::ApplyValue(const Animation& animation,
+                                 const float value) const {
+  if (animation.updater != NULL) {
+    animation.updater(value);
+    return;
+  }
+  Widget* widget = animation.widget;
+  Point offset = widget->presentation_offset_;
+  switch (animation.property) {
+    case Property::kAlpha:
+      widget->set_presentation_alpha(std::max(0.0f, value));
+      break;
+    case Property::kHeight:
+      widget->SetHeight(value);
+      break;
+    case Property::kScale:
+      // Keeps the scale positive as springs may overshoot below zero.
+      widget->set_presentation_scale(std::max(0.001f, value));
+      break;
+    case Property::kWidth:
+      widget->SetWidth(value);
+      break;
+    case Property::kX:
+      offset.x = value - widget->GetX();
+      widget->set_presentation_offset(offset);
+      break;
+    case Property::kY:
+      offset.y = value - widget->GetY();
+      widget->set_presentation_offset(offset);
+      break;
+  }
+}
+
+void AnimationEngine::CancelAnimation(const int animation_id) {
+  for (auto it = animations_.begin(); it != animations_.end(); ++it) {
+    if (it->id == animation_id) {
+      if (!it->is_cancelled)
+        RemoveAnimation(it);
+      return;
+    }
+  }
+}
+
+void AnimationEngine::CancelAnimations(Widget* widget) {
+  auto it = animations_.begin();
+  while (it != animations_.end()) {
+    auto animation = it++;
+    if (animation->widget == widget && !animation->is_cancelled)
+      RemoveAnimation(animation);
+  }
+}
+
+void AnimationEngine::CommitValue(const Animation& animation,
+                                  const float value) const {
+  if (!IsCompositorOnly(animation)) {
+    ApplyValue(animation, value);
+    return;
+  }
+  Widget* widget = animation.widget;
+  Point offset = widget->presentation_offset_;
+  switch (animation.property) {
+    case Property::kAlpha:
+      widget->set_alpha(value);
+      widget->set_presentation_alpha(-1);
+      break;
+    case Property::kScale:
+      widget->set_scale(value);
+      widget->set_presentation_scale(-1);
+      break;
+    case Property::kX:
+      widget->SetX(value);
+      offset.x = 0;
+      widget->set_presentation_offset(offset);
+      break;
+    case Property::kY:
+      widget->SetY(value);
+      offset.y = 0;
+      widget->set_presentation_offset(offset);
+      break;
+    default:
+      break;
+  }
+}
+
+float AnimationEngine::GetProgress(const Timing& timing,
+                                   const double elapsed_time, bool* finished) {
+  if (timing.curve == Curve::kSpring) {
+    const float kDisplacement = GetSpringDisplacement(
+        timing.damping_ratio, timing.response, elapsed_time);
+    const float kNextDisplacement = GetSpringDisplacement(
+        timing.damping_ratio, timing.response,
+        elapsed_time + kSpringRestingInterval);
+    *finished = std::abs(kDisplacement) < kSpringRestingDisplacement &&
+                std::abs(kNextDisplacement) < kSpringRestingDisplacement;
+    return *finished ? 1 : 1 - kDisplacement;
+  }
+
+  if (timing.duration <= 0 || elapsed_time >= timing.duration) {
+    *finished = true;
+    return 1;
+  }
+  *finished = false;
+  const float kTime = elapsed_time / timing.duration;
+  switch (timing.curve) {
+    case Curve::kEaseIn:
+      return GetCubicBezierY(0.42, 0, 1, 1, kTime);
+    case Curve::kEaseInOut:
+      return GetCubicBezierY(0.42, 0, 0.58, 1, kTime);
+    case Curve::kEaseOut:
+      return GetCubicBezierY(0, 0, 0.58, 1, kTime);
+    default:
+      return kTime;
+  }
+}
+
+float AnimationEngine::GetPropertyValue(Widget* widget,
+                                        const Property property) {
+  switch (property) {
+    case Property::kAlpha:
+      return widget->alpha();
+    case Property::kHeight:
+      return widget->GetHeight();
+    case Property::kScale:
+      return widget->scale();
+    case Property::kWidth:
+      return widget->GetWidth();
+    case Property::kX:
+      return widget->GetX();
+    case Property::kY:
+      return widget->GetY();
+  }
+  return 0;
+}
+
+bool AnimationEngine::IsAnimationActive(const int animation_id) const {
+  for (const Animation& animation : animations_) {
+    if (animation.id == animation_id)
+      return !animation.is_cancelled;
+  }
+  return false;
+}
+
+bool AnimationEngine::IsCompositorOnly(const Animation& animation) {
+  if (animation.updater != NULL)
+    return false;
+  return animation.property == Property::kAlpha ||
+         animation.property == Property::kScale ||
+         animation.property == Property::kX ||
+         animation.property == Property::kY;
+}
+
+void AnimationEngine::RemoveAnimation(
+    std::list<Animation>::iterator animation) {
+  if (IsCompositorOnly(*animation))
+    CommitValue(*animation, animation->value);
+  if (animation->widget_view != nullptr) {
+    animation->widget->ReleaseLayer();
+    animation->widget_view->StopAnimation();
+  } else {
+    animation->widget->StopAnimation(false);
+  }
+  if (is_updating_)
+    animation->is_cancelled = true;
+  else
+    animations_.erase(animation);
+}
+
+void AnimationEngine::Update(const double timestamp) {
+  frame_timestamp_ = timestamp;
+  if (animations_.empty())
+    return;
+
+  // Animations added by updaters are appended and visited by the same loop,
+  // while removed ones are only marked and erased afterward.
+  is_updating_ = true;
+  std::vector<Completion> completions;
+  for (auto it = animations_.begin(); it != animations_.end(); ++it) {
+    if (it->is_cancelled)
+      continue;
+    bool finished;
+    const float kProgress = GetProgress(
+        it->timing, std::max(0.0, timestamp - it->start_timestamp),
+        &finished);
+    it->value = finished ? it->to_value :
+                it->from_value + (it->to_value - it->from_value) * kProgress;
+    ApplyValue(*it, it->value);
+    if (finished && !it->is_cancelled) {
+      if (it->completion != NULL)
+        completions.push_back(it->completion);
+      RemoveAnimation(it);
+    }
+  }
+  is_updating_ = false;
+  animations_.remove_if([](const Animation& animation) {
+    return animation.is_cancelled;
+  });
+
+  for (Completion& completion : completions)
+    completion();
+}
+
+}  // namespace moui
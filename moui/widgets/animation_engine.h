@@ -0,0 +1,225 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_ANIMATION_ENGINE_H_
+#define MOUI_WIDGETS_ANIMATION_ENGINE_H_
+
+#include <functional>
+#include <list>
+
+#include "moui/base.h"
+
+namespace moui {
+
+// Forward declarations.
+class Widget;
+class WidgetView;
+
+// The `AnimationEngine` class drives animations of widgets. `WidgetView`
+// updates the engine once at the beginning of every frame with a single
+// sampled timestamp, so all animations advance in lockstep and widgets
+// animating on their own can read the same `frame_timestamp()` instead of
+// sampling the clock themselves. The built-in widgets that animate on their
+// own, such as `Button`, `ScrollView` and `TableView`, do so and end only the
+// `Widget::StartAnimation()` requests they made, so engine animations on the
+// same widget keep running.
+//
+// Animations of the alpha, position and scale of widgets are compositor-only:
+// the widget and its descendants are rasterized into a layer once when the
+// animation starts, and the animation changes the presentation values applied
+// when compositing the layer and asks the widget view to composite again, so
+// neither the layout hooks nor the render functions run while they play. The
+// actual property is set once the animation finishes or is cancelled. They
+// keep the widget view animating directly, so frames keep coming and
+// completions fire even if the value doesn't change. All other animations
+// keep their widgets animating through `Widget::StartAnimation()` and release
+// them through `Widget::StopAnimation()`. Either way, the display link only
+// runs while at least one animation is active.
+//
+// Animation values are computed from the elapsed time rather than
+// accumulated per frame, so dropped frames don't slow animations down. This
+// class is not thread-safe and must be used on the main thread.
+class AnimationEngine {
+ public:
+  // The widget properties that can be animated.
+  enum class Property {
+    kAlpha,  // `Widget::alpha()`
+    kHeight,  // `Widget::GetHeight()` in points
+    kScale,  // `Widget::scale()`
+    kWidth,  // `Widget::GetWidth()` in points
+    kX,  // `Widget::GetX()` in points
+    kY,  // `Widget::GetY()` in points
+  };
+
+  // The timing curves of animations.
+  enum class Curve {
+    kEaseIn,  // starts slowly and accelerates
+    kEaseInOut,  // starts and ends slowly
+    kEaseOut,  // starts quickly and decelerates
+    kLinear,  // progresses evenly
+    kSpring,  // settles like a damped spring
+  };
+
+  // Describes how an animation progresses over time.
+  struct Timing {
+    // The timing curve.
+    Curve curve;
+    // The duration in seconds. Ignored by `Curve::kSpring`, which lasts
+    // until the spring settles.
+    double duration;
+    // The damping ratio of `Curve::kSpring`. 1 is critically damped, and
+    // smaller values overshoot and oscillate.
+    float damping_ratio;
+    // The period in seconds of the undamped oscillation of `Curve::kSpring`,
+    // which determines how quickly the spring responds.
+    float response;
+  };
+
+  // The signature of the function called when an animation finishes.
+  typedef std::function<void()> Completion;
+
+  // The signature of the function applying the value of a custom animation.
+  typedef std::function<void(const float value)> Updater;
+
+  // Returns the engine shared by the entire process.
+  static AnimationEngine* GetSharedEngine();
+
+  // Returns the timing of the specified curve and duration.
+  static Timing GetCurveTiming(const Curve curve, const double duration);
+
+  // Returns the timing of a spring with the specified damping ratio and
+  // response.
+  static Timing GetSpringTiming(const float damping_ratio,
+                                const float response);
+
+  // Animates the widget's property from its current value to `to_value`.
+  // An animation of the same property of the widget in progress is
+  // cancelled, leaving the property where it was. The `completion` function
+  // is called once the animation finishes and can be `nullptr`. Returns the
+  // animation id.
+  int Animate(Widget* widget, const Property property, const float to_value,
+              const Timing& timing, Completion completion);
+
+  // Animates a custom value from `from_value` to `to_value` on behalf of the
+  // widget by calling `updater` with the value on every frame. The
+  // `completion` function is called once the animation finishes and can be
+  // `nullptr`. Returns the animation id.
+  int AnimateValue(Widget* widget, const float from_value,
+                   const float to_value, const Timing& timing, Updater updater,
+                   Completion completion);
+
+  // Cancels the animation with the specified id. The animated value stays
+  // where it is, which is also set to the property for compositor-only
+  // animations, and the completion function is not called. Does nothing if
+  // the animation has finished.
+  void CancelAnimation(const int animation_id);
+
+  // Cancels all animations of the widget like `CancelAnimation()`. This is
+  // called when the widget is destroyed.
+  void CancelAnimations(Widget* widget);
+
+  // Returns `true` if the animation with the specified id is in progress.
+  bool IsAnimationActive(const int animation_id) const;
+
+  // Advances all animations to the specified timestamp, which becomes the
+  // `frame_timestamp()`. This is called by `WidgetView` before rendering.
+  void Update(const double timestamp);
+
+  // Accessors.
+  double frame_timestamp() const { return frame_timestamp_; }
+
+ private:
+  // An animation in progress.
+  struct Animation {
+    // The unique id of the animation.
+    int id;
+    // Indicates whether the animation was cancelled while updating.
+    bool is_cancelled;
+    // The widget the animation belongs to.
+    Widget* widget;
+    // The animated property. Only used if `updater` is `NULL`.
+    Property property;
+    // The value when the animation started.
+    float from_value;
+    // The value when the animation finishes.
+    float to_value;
+    // The value applied by the latest update.
+    float value;
+    // The timing of the animation.
+    Timing timing;
+    // The timestamp when the animation started.
+    double start_timestamp;
+    // The function applying the value of a custom animation, or `NULL` for
+    // property animations.
+    Updater updater;
+    // The function called once the animation finishes.
+    Completion completion;
+    // The widget view kept animating by a compositor-only animation, or
+    // `nullptr` if the animation keeps its widget animating instead.
+    WidgetView* widget_view;
+  };
+
+  AnimationEngine();
+  ~AnimationEngine();
+
+  // Adds the animation, keeps its widget or widget view animating and returns
+  // its id.
+  int AddAnimation(Animation* animation);
+
+  // Applies the value of the animation, which only changes the presentation
+  // values of the widget for compositor-only animations.
+  void ApplyValue(const Animation& animation, const float value) const;
+
+  // Applies the final value of the animation. For compositor-only animations,
+  // this sets the property to the value and resets the presentation value.
+  void CommitValue(const Animation& animation, const float value) const;
+
+  // Returns the progress of the timing after the elapsed time in seconds.
+  // The progress goes from 0 to 1 but may overshoot for springs. Sets
+  // `finished` to whether the animation is finished.
+  static float GetProgress(const Timing& timing, const double elapsed_time,
+                           bool* finished);
+
+  // Returns the current value of the widget's property.
+  static float GetPropertyValue(Widget* widget, const Property property);
+
+  // Returns `true` if the animation is compositor-only.
+  static bool IsCompositorOnly(const Animation& animation);
+
+  // Removes the animation and releases its widget. The current value of a
+  // compositor-only animation is committed to the property.
+  void RemoveAnimation(std::list<Animation>::iterator animation);
+
+  // The animations in progress in the order of creation.
+  std::list<Animation> animations_;
+
+  // The timestamp passed to the latest `Update()`.
+  double frame_timestamp_;
+
+  // Indicates whether `Update()` is in progress, in which case cancelled
+  // animations are only marked and removed by `Update()`.
+  bool is_updating_;
+
+  // The id of the next animation.
+  int next_animation_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(AnimationEngine);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_ANIMATION_ENGINE_H_
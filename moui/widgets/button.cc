@@ -19,13 +19,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <string>
 
 #include "moui/base.h"
 #include "moui/core/clock.h"
 #include "moui/core/device.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
 #include "moui/widgets/control.h"
 #include "moui/widgets/label.h"
+#include "moui/widgets/rasterization_cache.h"
 #include "moui/widgets/widget_view.h"
 
 namespace {
@@ -44,6 +48,10 @@ const float kDefaultSemiTransparentStyleOpacity = 0.5;
 // The number of ControlStates constants.
 const int kNumberOfControlStates = 4;
 
+// The duration in seconds to keep the framebuffer of a control state other
+// than the current one since it was last rendered.
+const double kUnusedFramebufferTimeout = 5;
+
 // The duration in seconds for transition happened when a finger dragged into
 // the bounds of the button.
 const double kTransitionDragEnterDuration = 0.2;
@@ -60,22 +68,24 @@ Button::Button() : Control(false),
                    adjusts_button_height_to_fit_title_label_(false),
                    adjusts_button_width_to_fit_title_label_(false),
                    current_framebuffer_(nullptr),
+                   current_framebuffer_is_opaque_(false),
                    default_disabled_style_(Style::kSemiTransparent),
                    default_highlighted_style_(Style::kSemiTransparent),
                    semi_transparent_style_opacity_(
                        kDefaultSemiTransparentStyleOpacity),
                    disabled_state_framebuffer_(nullptr),
-                   final_framebuffer_(nullptr),
+                   eviction_token_(new bool(true)),
                    highlighted_state_framebuffer_(nullptr),
+                   is_eviction_scheduled_(false),
                    normal_state_framebuffer_(nullptr),
                    normal_state_with_highlighted_effect_framebuffer_(nullptr),
                    previous_framebuffer_(nullptr),
+                   previous_framebuffer_is_opaque_(false),
                    selected_state_framebuffer_(nullptr),
                    selected_state_with_highlighted_effect_framebuffer_(nullptr),
                    title_edge_insets_({0, 0, 0, 0}),
                    title_label_(new Label) {
   transition_states_.is_transitioning = false;
-  transition_states_.framebuffer = nullptr;
 
   const NVGcolor kDefaultColor = nvgRGBA(0, 0, 0, 255);
   for (int i = 0; i < kNumberOfControlStates; ++i) {
@@ -107,6 +117,8 @@ Button::Button() : Control(false),
 }
 
 Button::~Button() {
+  eviction_token_.reset();
+  ResetFramebuffers();
   delete title_label_;
 }
 
@@ -116,30 +128,24 @@ void Button::BindRenderFunction(
   if (states & ControlState::kNormal) {
     render_functions_[GetControlStateIndex(ControlState::kNormal)] = \
         render_function;
-    nvgDeleteFramebuffer(normal_state_framebuffer_);
-    nvgDeleteFramebuffer(normal_state_with_highlighted_effect_framebuffer_);
-    normal_state_framebuffer_ = nullptr;
-    normal_state_with_highlighted_effect_framebuffer_ = nullptr;
+    DeleteFramebuffer(&normal_state_framebuffer_);
+    DeleteFramebuffer(&normal_state_with_highlighted_effect_framebuffer_);
   }
   if (states & ControlState::kHighlighted) {
     render_functions_[GetControlStateIndex(ControlState::kHighlighted)] = \
         render_function;
-    nvgDeleteFramebuffer(highlighted_state_framebuffer_);
-    highlighted_state_framebuffer_ = nullptr;
+    DeleteFramebuffer(&highlighted_state_framebuffer_);
   }
   if (states & ControlState::kDisabled) {
     render_functions_[GetControlStateIndex(ControlState::kDisabled)] = \
         render_function;
-    nvgDeleteFramebuffer(disabled_state_framebuffer_);
-    disabled_state_framebuffer_ = nullptr;
+    DeleteFramebuffer(&disabled_state_framebuffer_);
   }
   if (states & ControlState::kSelected) {
     render_functions_[GetControlStateIndex(ControlState::kSelected)] = \
         render_function;
-    nvgDeleteFramebuffer(selected_state_framebuffer_);
-    nvgDeleteFramebuffer(selected_state_with_highlighted_effect_framebuffer_);
-    selected_state_framebuffer_ = nullptr;
-    selected_state_with_highlighted_effect_framebuffer_ = nullptr;
+    DeleteFramebuffer(&selected_state_framebuffer_);
+    DeleteFramebuffer(&selected_state_with_highlighted_effect_framebuffer_);
   }
 }
 
@@ -148,6 +154,52 @@ void Button::ContextWillChange(NVGcontext* context) {
   ResetFramebuffers();
 }
 
+void Button::DeleteFramebuffer(NVGframebuffer** framebuffer) {
+  if (*framebuffer == nullptr)
+    return;
+  if (*framebuffer == current_framebuffer_)
+    current_framebuffer_ = nullptr;
+  if (*framebuffer == previous_framebuffer_)
+    previous_framebuffer_ = nullptr;
+  framebuffer_timestamps_.erase(*framebuffer);
+  if (rasterization_key_.empty()) {
+    nvgDeleteFramebuffer(*framebuffer);
+  } else {
+    RasterizationCache::GetSharedCache()->ReleaseFramebuffer(
+        (*framebuffer)->ctx, *framebuffer);
+  }
+  *framebuffer = nullptr;
+}
+
+bool Button::EvictUnusedFramebuffers(const double timestamp) {
+  NVGframebuffer** framebuffers[] = {
+      &disabled_state_framebuffer_,
+      &highlighted_state_framebuffer_,
+      &normal_state_framebuffer_,
+      &normal_state_with_highlighted_effect_framebuffer_,
+      &selected_state_framebuffer_,
+      &selected_state_with_highlighted_effect_framebuffer_,
+  };
+  bool keeps_unused_framebuffers = false;
+  for (NVGframebuffer** framebuffer : framebuffers) {
+    if (*framebuffer == nullptr || *framebuffer == current_framebuffer_)
+      continue;
+    if (transition_states_.is_transitioning &&
+        *framebuffer == previous_framebuffer_) {
+      keeps_unused_framebuffers = true;
+      continue;
+    }
+    auto match = framebuffer_timestamps_.find(*framebuffer);
+    if (match == framebuffer_timestamps_.end() ||
+        timestamp - match->second >= kUnusedFramebufferTimeout) {
+      DeleteFramebuffer(framebuffer);
+    } else {
+      keeps_unused_framebuffers = true;
+    }
+  }
+  return keeps_unused_framebuffers;
+}
+
 void Button::ExecuteRenderFunction(NVGcontext* context,
                                    const ControlState state) {
   auto render_function = render_functions_[GetControlStateIndex(state)];
@@ -230,16 +282,33 @@ void Button::HandleMemoryWarning(NVGcontext* context) {
 }
 
 void Button::Render(NVGcontext* context) {
-  if (final_framebuffer_ == nullptr)
+  if (current_framebuffer_ == nullptr)
     return;
 
   const float kWidth = GetWidth();
   const float kHeight = GetHeight();
+  float alpha = 1;
+  // Fades out the previous control state while fading in the current one.
+  // If both states are opaque, the previous one stays opaque underneath so
+  // the blended result never turns translucent midway.
+  if (transition_states_.is_transitioning &&
+      previous_framebuffer_ != nullptr) {
+    alpha = transition_states_.progress;
+    const float kPreviousAlpha = \
+        current_framebuffer_is_opaque_ && previous_framebuffer_is_opaque_ ?
+        1 : 1 - alpha;
+    nvgBeginPath(context);
+    nvgRect(context, 0, 0, kWidth, kHeight);
+    nvgFillPaint(context,
+                 nvgImagePattern(context, 0, 0, kWidth, kHeight, 0,
+                                 previous_framebuffer_->image,
+                                 kPreviousAlpha));
+    nvgFill(context);
+  }
   nvgBeginPath(context);
   nvgRect(context, 0, 0, kWidth, kHeight);
-  const NVGpaint kPaint = nvgImagePattern(context, 0, 0, kWidth, kHeight,
-                                          0, final_framebuffer_->image, 1);
-  nvgFillPaint(context, kPaint);
+  nvgFillPaint(context, nvgImagePattern(context, 0, 0, kWidth, kHeight, 0,
+                                        current_framebuffer_->image, alpha));
   nvgFill(context);
 }
 
@@ -295,8 +364,7 @@ void Button::RenderFramebuffer(NVGcontext* context) {
                  &framebuffer_width, &framebuffer_height);
     if (framebuffer_width != static_cast<int>(GetWidth() * kScaleFactor) ||
         framebuffer_height != static_cast<int>(GetHeight() * kScaleFactor)) {
-      nvgDeleteFramebuffer(*framebuffer);
-      *framebuffer = nullptr;
+      DeleteFramebuffer(framebuffer);
     }
   }
   // Renders the new framebuffer.
@@ -306,16 +374,24 @@ void Button::RenderFramebuffer(NVGcontext* context) {
                                      renders_default_highlighted_effect);
   }
   // Updates the `current_framebuffer_` and `previous_framebuffer_` properties.
+  const bool kFramebufferIsOpaque = \
+      is_opaque() && background_color().a >= 1 &&
+      !(renders_default_disabled_effect &&
+        default_disabled_style_ == Style::kSemiTransparent) &&
+      !(renders_default_highlighted_effect &&
+        default_highlighted_style_ == Style::kSemiTransparent);
   if (*framebuffer != current_framebuffer_) {
     previous_framebuffer_ = current_framebuffer_;
+    previous_framebuffer_is_opaque_ = current_framebuffer_is_opaque_;
     current_framebuffer_ = *framebuffer;
   }
+  current_framebuffer_is_opaque_ = kFramebufferIsOpaque;
 
-  if (transition_states_.is_transitioning &&
-      RenderFramebufferForTransition(context, &transition_states_.framebuffer))
-    final_framebuffer_ = transition_states_.framebuffer;
-  else
-    final_framebuffer_ = current_framebuffer_;
+  const double kTimestamp = Clock::GetTimestamp();
+  if (current_framebuffer_ != nullptr)
+    framebuffer_timestamps_[current_framebuffer_] = kTimestamp;
+  if (EvictUnusedFramebuffers(kTimestamp))
+    ScheduleEvictingUnusedFramebuffers();
 }
 
 bool Button::RenderFramebufferForControlState(
@@ -323,6 +399,34 @@ bool Button::RenderFramebufferForControlState(
     const ControlState control_state,
     const bool renders_default_disabled_effect,
     const bool renders_default_highlighted_effect) {
+  // Reuses the framebuffer rendered by another button with the same key.
+  std::string key;
+  if (!rasterization_key_.empty()) {
+    const float kScaleFactor = \
+        Device::GetScreenScaleFactor() * GetMeasuredScale();
+    key = "Button|" + rasterization_key_ + "|" +
+          std::to_string(GetControlStateIndex(control_state)) + "|" +
+          std::to_string(renders_default_disabled_effect) +
+          std::to_string(renders_default_highlighted_effect) + "|" +
+          std::to_string(static_cast<int>(default_disabled_style_)) +
+          std::to_string(static_cast<int>(default_highlighted_style_)) + "|" +
+          std::to_string(semi_transparent_style_opacity_) + "|" +
+          std::to_string(static_cast<int>(GetWidth() * kScaleFactor)) + "x" +
+          std::to_string(static_cast<int>(GetHeight() * kScaleFactor)) + "|" +
+          std::to_string(kScaleFactor) + "|" +
+          std::to_string(rendering_offset().x) + "," +
+          std::to_string(rendering_offset().y) + "|" +
+          std::to_string(rendering_scale());
+    if (is_opaque()) {
+      for (const float kComponent : background_color().rgba)
+        key += "|" + std::to_string(kComponent);
+    }
+    *framebuffer = RasterizationCache::GetSharedCache()->FindFramebuffer(
+        context, key);
+    if (*framebuffer != nullptr)
+      return true;
+  }
+
   float scale_factor;
   if (!BeginFramebufferUpdates(context, framebuffer, &scale_factor))
     return false;
@@ -369,40 +473,10 @@ bool Button::RenderFramebufferForControlState(
   }
   nvgEndFrame(context);
   EndFramebufferUpdates();
-  return true;
-}
-
-bool Button::RenderFramebufferForTransition(NVGcontext* context,
-                                            NVGframebuffer** framebuffer) {
-  if (!transition_states_.is_transitioning)
-    return false;
-
-  float scale_factor;
-  if (!BeginFramebufferUpdates(context, framebuffer, &scale_factor)) {
-    return false;
+  if (!key.empty()) {
+    *framebuffer = RasterizationCache::GetSharedCache()->AddFramebuffer(
+        context, key, *framebuffer);
   }
-  const int kWidth = static_cast<int>(GetWidth());
-  const int kHeight = static_cast<int>(GetHeight());
-  nvgBeginFrame(context, kWidth, kHeight, scale_factor);
-  nvgGlobalCompositeOperation(context, NVG_LIGHTER);
-  // Draws for the previous control state.
-  nvgBeginPath(context);
-  nvgRect(context, 0, 0, kWidth, kHeight);
-  NVGpaint paint = nvgImagePattern(context, 0, 0, kWidth, kHeight, 0,
-                                   previous_framebuffer_->image,
-                                   1 - transition_states_.progress);
-  nvgFillPaint(context, paint);
-  nvgFill(context);
-  // Draws for the current control state.
-  nvgBeginPath(context);
-  nvgRect(context, 0, 0, kWidth, kHeight);
-  paint = nvgImagePattern(context, 0, 0, kWidth, kHeight, 0,
-                          current_framebuffer_->image,
-                          transition_states_.progress);
-  nvgFillPaint(context, paint);
-  nvgFill(context);
-  nvgEndFrame(context);
-  EndFramebufferUpdates();
   return true;
 }
 
@@ -412,24 +486,29 @@ bool Button::RenderFunctionIsBinded(const ControlState state) const {
 
 void Button::ResetFramebuffers() {
   StopTransitioningBetweenControlStates(this);
-  nvgDeleteFramebuffer(disabled_state_framebuffer_);
-  nvgDeleteFramebuffer(highlighted_state_framebuffer_);
-  nvgDeleteFramebuffer(normal_state_framebuffer_);
-  nvgDeleteFramebuffer(normal_state_with_highlighted_effect_framebuffer_);
-  nvgDeleteFramebuffer(selected_state_framebuffer_);
-  nvgDeleteFramebuffer(selected_state_with_highlighted_effect_framebuffer_);
-  nvgDeleteFramebuffer(transition_states_.framebuffer);
-
-  current_framebuffer_ = nullptr;
-  disabled_state_framebuffer_ = nullptr;
-  final_framebuffer_ = nullptr;
-  highlighted_state_framebuffer_ = nullptr;
-  normal_state_framebuffer_ = nullptr;
-  normal_state_with_highlighted_effect_framebuffer_ = nullptr;
-  previous_framebuffer_ = nullptr;
-  selected_state_framebuffer_ = nullptr;
-  selected_state_with_highlighted_effect_framebuffer_ = nullptr;
-  transition_states_.framebuffer = nullptr;
+  DeleteFramebuffer(&disabled_state_framebuffer_);
+  DeleteFramebuffer(&highlighted_state_framebuffer_);
+  DeleteFramebuffer(&normal_state_framebuffer_);
+  DeleteFramebuffer(&normal_state_with_highlighted_effect_framebuffer_);
+  DeleteFramebuffer(&selected_state_framebuffer_);
+  DeleteFramebuffer(&selected_state_with_highlighted_effect_framebuffer_);
+}
+
+void Button::ScheduleEvictingUnusedFramebuffers() {
+  if (is_eviction_scheduled_)
+    return;
+
+  is_eviction_scheduled_ = true;
+  std::weak_ptr<bool> token = eviction_token_;
+  Clock::ExecuteCallbackOnMainThread(
+      kUnusedFramebufferTimeout,
+      [this, token]() {
+        if (token.expired())
+          return;
+        is_eviction_scheduled_ = false;
+        if (EvictUnusedFramebuffers(Clock::GetTimestamp()))
+          ScheduleEvictingUnusedFramebuffers();
+      });
 }
 
 void Button::SetTitle(const std::string& title, const ControlState states) {
@@ -457,7 +536,7 @@ void Button::SetTitleColor(const NVGcolor color, const ControlState states) {
 void Button::StopTransitioningBetweenControlStates(Control* control) {
   if (transition_states_.is_transitioning) {
     transition_states_.is_transitioning = false;
-    StopAnimation(true);
+    StopAnimation(false);
     Redraw();
   }
 }
@@ -501,24 +580,18 @@ void Button::TransitionBetweenControlStates(Control* control) {
 void Button::UnbindRenderFunction(const ControlState states) {
   if (states & ControlState::kNormal) {
     render_functions_[GetControlStateIndex(ControlState::kNormal)] = NULL;
-    nvgDeleteFramebuffer(normal_state_framebuffer_);
-    normal_state_framebuffer_ = nullptr;
+    DeleteFramebuffer(&normal_state_framebuffer_);
   } else if (states & ControlState::kHighlighted) {
     render_functions_[GetControlStateIndex(ControlState::kHighlighted)] = NULL;
-    nvgDeleteFramebuffer(highlighted_state_framebuffer_);
-    nvgDeleteFramebuffer(normal_state_with_highlighted_effect_framebuffer_);
-    nvgDeleteFramebuffer(selected_state_with_highlighted_effect_framebuffer_);
-    highlighted_state_framebuffer_ = nullptr;
-    normal_state_with_highlighted_effect_framebuffer_ = nullptr;
-    selected_state_with_highlighted_effect_framebuffer_ = nullptr;
+    DeleteFramebuffer(&highlighted_state_framebuffer_);
+    DeleteFramebuffer(&normal_state_with_highlighted_effect_framebuffer_);
+    DeleteFramebuffer(&selected_state_with_highlighted_effect_framebuffer_);
   } else if (states & ControlState::kSelected) {
     render_functions_[GetControlStateIndex(ControlState::kSelected)] = NULL;
-    nvgDeleteFramebuffer(selected_state_framebuffer_);
-    selected_state_framebuffer_ = nullptr;
+    DeleteFramebuffer(&selected_state_framebuffer_);
   } else if (states & ControlState::kDisabled) {
     render_functions_[GetControlStateIndex(ControlState::kDisabled)] = NULL;
-    nvgDeleteFramebuffer(disabled_state_framebuffer_);
-    disabled_state_framebuffer_ = nullptr;
+    DeleteFramebuffer(&disabled_state_framebuffer_);
   }
 }
 
@@ -591,8 +664,9 @@ void Button::WidgetDidRender(NVGcontext* context) {
 
 bool Button::WidgetViewWillRender(NVGcontext* context) {
   if (transition_states_.is_transitioning) {
-    const float kElapsedTime = \
-        Clock::GetTimestamp() - transition_states_.initial_timestamp;
+    const float kElapsedTime = std::max(
+        0.0, AnimationEngine::GetSharedEngine()->frame_timestamp()
+             - transition_states_.initial_timestamp);
     transition_states_.progress = \
         std::min(1.0, kElapsedTime / transition_states_.duration);
   }
@@ -624,8 +698,7 @@ void Button::set_default_disabled_style(const Style style) {
   if (style == default_disabled_style_)
     return;
 
-  nvgDeleteFramebuffer(disabled_state_framebuffer_);
-  disabled_state_framebuffer_ = nullptr;
+  DeleteFramebuffer(&disabled_state_framebuffer_);
   default_disabled_style_ = style;
 }
 
@@ -633,13 +706,19 @@ void Button::set_default_highlighted_style(const Style style) {
   if (style == default_highlighted_style_)
     return;
 
-  nvgDeleteFramebuffer(normal_state_with_highlighted_effect_framebuffer_);
-  nvgDeleteFramebuffer(selected_state_with_highlighted_effect_framebuffer_);
-  normal_state_with_highlighted_effect_framebuffer_ = nullptr;
-  selected_state_with_highlighted_effect_framebuffer_ = nullptr;
+  DeleteFramebuffer(&normal_state_with_highlighted_effect_framebuffer_);
+  DeleteFramebuffer(&selected_state_with_highlighted_effect_framebuffer_);
   default_highlighted_style_ = style;
 }
 
+void Button::set_rasterization_key(const std::string& key) {
+  if (key == rasterization_key_)
+    return;
+  ResetFramebuffers();
+  rasterization_key_ = key;
+  Redraw();
+}
+
 void Button::set_semi_transparent_style_opacity(const float opacity) {
   if (opacity == semi_transparent_style_opacity_)
     return;
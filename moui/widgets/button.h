@@ -19,7 +19,9 @@
 #define MOUI_WIDGETS_BUTTON_H_
 
 #include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "moui/base.h"
@@ -129,6 +131,8 @@ class Button : public Control {
     return default_highlighted_style_;
   }
   void set_default_highlighted_style(const Style style);
+  std::string rasterization_key() const { return rasterization_key_; }
+  void set_rasterization_key(const std::string& key);
   float semi_transparent_style_opacity() const {
     return semi_transparent_style_opacity_;
   }
@@ -165,8 +169,6 @@ class Button : public Control {
     double duration;
     // Records the transition progress, specified as a value from 0.0 to 1.0.
     float progress;
-    // The framebuffer to render while transitioning.
-    NVGframebuffer* framebuffer;
     // Keeps the `title_label_`'s text color that should be transitioned from.
     NVGcolor previous_title_color;
   };
@@ -176,6 +178,16 @@ class Button : public Control {
       const ControlState states,
       std::function<void(Button*, NVGcontext*)> render_function);
 
+  // Deletes the framebuffer of a control state, or releases it back to
+  // `RasterizationCache` if shared, and sets it to `nullptr`.
+  void DeleteFramebuffer(NVGframebuffer** framebuffer);
+
+  // Deletes the framebuffers of control states other than the current one
+  // that have not been rendered for a while. The framebuffer of the previous
+  // state is kept while transitioning. Returns `true` if any framebuffer
+  // other than the current one is still kept.
+  bool EvictUnusedFramebuffers(const double timestamp);
+
   // Executes the render function for passed state or fills white background
   // if nothing binded.
   void ExecuteRenderFunction(NVGcontext* context, const ControlState state);
@@ -186,7 +198,9 @@ class Button : public Control {
   // Inherited from `Widget` class. This method takes control of how to render
   // the button. Subclasses should never override this method either.
   // To render customized appearance. Use `BindRenderFunction()` to bind a
-  // function for rendering a specific control state.
+  // function for rendering a specific control state. While transitioning,
+  // the framebuffers of the previous and current states are crossfaded
+  // directly.
   void Render(NVGcontext* context) final;
 
   // Inherited from `Widget` class. Renders for the current state into the
@@ -201,14 +215,14 @@ class Button : public Control {
       const bool renders_default_disabled_effect,
       const bool renders_default_highlighted_effect);
 
-  // Renders the button's current transition state to the passed `framebuffer`.
-  // Returns `false` on failure.
-  bool RenderFramebufferForTransition(NVGcontext* context,
-                                      NVGframebuffer** framebuffer);
-
   // Returns `true` if a render function is binded to the passed control state.
   bool RenderFunctionIsBinded(const ControlState state) const;
 
+  // Schedules `EvictUnusedFramebuffers()` to run once the unused framebuffers
+  // time out, so they are deleted even if the button is not rendered again.
+  // The callback reschedules itself while unused framebuffers are kept.
+  void ScheduleEvictingUnusedFramebuffers();
+
   // Stops transitioning between different control states. The is a callback
   // function for `kTouchCancel`, `kTouchUpInside` and `kTouchUpOutside`
   // control events. And it is called in `WidgetDidRender()` once the
@@ -238,6 +252,11 @@ class Button : public Control {
   // This value is updated in the `RenderFramebuffer()` method.
   NVGframebuffer* current_framebuffer_;
 
+  // Indicates whether `current_framebuffer_` is fully opaque, that is, the
+  // button is opaque with an opaque background color and no semi-transparent
+  // effect is applied.
+  bool current_framebuffer_is_opaque_;
+
   // The style used to render default disabled state when no corresponded
   // render function is binded. The default style is `kSemiTransparent`. Note
   // that this value has nothing to do with any child widget including the
@@ -253,14 +272,21 @@ class Button : public Control {
   // The framebuffer for rendering the button in disabled state.
   NVGframebuffer* disabled_state_framebuffer_;
 
-  // The reference to the framebuffer pointer that will be actually rendered
-  // in the `Render()` method. This value is updated in the
-  // `RenderFramebuffer()` method.
-  NVGframebuffer* final_framebuffer_;
+  // The token observed by the scheduled eviction callback, which is reset on
+  // destruction so the pending callback does nothing.
+  std::shared_ptr<bool> eviction_token_;
+
+  // The timestamps at which the framebuffers of control states were last
+  // rendered on screen, which determine when they are evicted.
+  std::unordered_map<NVGframebuffer*, double> framebuffer_timestamps_;
 
   // The framebuffer for rendering the button in highlighted state.
   NVGframebuffer* highlighted_state_framebuffer_;
 
+  // Indicates whether `ScheduleEvictingUnusedFramebuffers()` has scheduled a
+  // callback that has not run yet.
+  bool is_eviction_scheduled_;
+
   // The framebuffer for rendering the button in normal state.
   NVGframebuffer* normal_state_framebuffer_;
 
@@ -272,6 +298,16 @@ class Button : public Control {
   // This value is updated in the `RenderFramebuffer()` method.
   NVGframebuffer* previous_framebuffer_;
 
+  // Indicates whether `previous_framebuffer_` is fully opaque.
+  bool previous_framebuffer_is_opaque_;
+
+  // The key shared by buttons whose render functions render identically for
+  // every control state, such as the keys of a keypad. If not empty, the
+  // framebuffers of control states are shared through `RasterizationCache`
+  // with other buttons of the same key, size, rendering offset and styles.
+  // The default value is empty, which never shares.
+  std::string rasterization_key_;
+
   // Keeps the binded render functions for different control states. The vector
   // will be initialized in constructor to have the same number of elemens as
   // control states. The element position corresponded to a control state is
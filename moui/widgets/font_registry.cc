@@ -0,0 +1,149 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/font_registry.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/core/text_layout_engine.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/glyph_atlas.h"
+
+namespace moui {
+
+FontRegistry::FontRegistry() {
+}
+
+FontRegistry::~FontRegistry() {
+}
+
+void FontRegistry::AddCharacterSet(const std::string& font_name,
+                                   const std::string& characters,
+                                   const std::vector<float>& font_sizes) {
+  character_sets_.push_back({characters, GetFontHandle(font_name),
+                             font_sizes});
+}
+
+bool FontRegistry::AddFont(const std::string& name, const std::string& path) {
+  if (!TextLayoutEngine::GetSharedEngine()->AddFont(name, path))
+    return false;
+  GetFontHandle(name);
+  return true;
+}
+
+int FontRegistry::GetEngineFontIndex(const int handle) {
+  if (handle < 0 || handle >= static_cast<int>(font_names_.size()))
+    return -1;
+
+  int& index = engine_font_indexes_[handle];
+  if (index < 0) {
+    index = TextLayoutEngine::GetSharedEngine()->GetFontIndex(
+        font_names_[handle]);
+  }
+  return index;
+}
+
+int FontRegistry::GetFontHandle(const std::string& name) {
+  auto iterator = font_handles_.find(name);
+  if (iterator != font_handles_.end())
+    return iterator->second;
+
+  const int kHandle = static_cast<int>(font_names_.size());
+  engine_font_indexes_.push_back(-1);
+  font_names_.push_back(name);
+  font_handles_[name] = kHandle;
+  return kHandle;
+}
+
+int FontRegistry::GetFontId(NVGcontext* context, const int handle) {
+  if (handle < 0 || handle >= static_cast<int>(font_names_.size()))
+    return -1;
+
+  ContextStates& states = contexts_[context];
+  if (handle >= static_cast<int>(states.font_ids.size()))
+    states.font_ids.resize(font_names_.size(), -1);
+  int& font_id = states.font_ids[handle];
+  if (font_id >= 0)
+    return font_id;
+
+  // Reuses the font created in the context by name, or creates it from the
+  // data shared with the text layout engine without copying.
+  const std::string& kName = font_names_[handle];
+  font_id = nvgFindFont(context, kName.c_str());
+  const unsigned char* data;
+  size_t data_size;
+  if (font_id < 0 &&
+      TextLayoutEngine::GetSharedEngine()->GetFontData(kName, &data,
+                                                       &data_size)) {
+    font_id = nvgCreateFontMem(context, kName.c_str(),
+                               const_cast<unsigned char*>(data),
+                               static_cast<int>(data_size),
+                               false);  // the data is owned by the engine
+  }
+  return font_id;
+}
+
+FontRegistry* FontRegistry::GetSharedRegistry() {
+  static FontRegistry* shared_registry = new FontRegistry;
+  return shared_registry;
+}
+
+void FontRegistry::PrepareContext(NVGcontext* context) {
+  GlyphAtlas* glyph_atlas = GlyphAtlas::GetSharedAtlas();
+  for (const CharacterSet& kCharacterSet : character_sets_) {
+    GetFontId(context, kCharacterSet.font_handle);
+    if (glyph_atlas->FontUsesScalableGlyphs(kCharacterSet.font_handle)) {
+      glyph_atlas->PrepareText(context, kCharacterSet.font_handle,
+                               kCharacterSet.characters);
+    }
+  }
+}
+
+void FontRegistry::RemoveContext(NVGcontext* context) {
+  contexts_.erase(context);
+}
+
+void FontRegistry::WarmUpContext(NVGcontext* context) {
+  ContextStates& states = contexts_[context];
+  if (states.is_warmed_up)
+    return;
+  states.is_warmed_up = true;
+  if (character_sets_.empty())
+    return;
+
+  // Fontstash rasterizes glyphs when drawing them, so the characters are
+  // drawn in transparent color.
+  nvgSave(context);
+  nvgFillColor(context, nvgRGBA(0, 0, 0, 0));
+  nvgTextAlign(context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+  for (const CharacterSet& kCharacterSet : character_sets_) {
+    const int kFontId = GetFontId(context, kCharacterSet.font_handle);
+    if (kFontId < 0)
+      continue;
+    nvgFontFaceId(context, kFontId);
+    for (const float kFontSize : kCharacterSet.font_sizes) {
+      nvgFontSize(context, kFontSize);
+      nvgText(context, 0, 0, kCharacterSet.characters.c_str(), nullptr);
+    }
+  }
+  nvgRestore(context);
+}
+
+}  // namespace moui
@@ -0,0 +1,125 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_FONT_REGISTRY_H_
+#define MOUI_WIDGETS_FONT_REGISTRY_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `FontRegistry` class resolves font names to integer handles once, so
+// widgets can select fonts in every frame without looking up names. Each
+// handle maps to the font id in every nanovg context, and fonts added to
+// the registry are created in a context on first use from the memory-mapped
+// data shared with `TextLayoutEngine`.
+//
+// The registry can also warm up the glyph atlases with declared character
+// sets when a context is created, so the first screen doesn't stall on
+// rasterizing glyphs. The class should only be used on the render thread.
+class FontRegistry {
+ public:
+  // Returns the registry shared by the application.
+  static FontRegistry* GetSharedRegistry();
+
+  // Declares characters to rasterize in advance for the specified font at
+  // each of the specified font sizes.
+  void AddCharacterSet(const std::string& font_name,
+                       const std::string& characters,
+                       const std::vector<float>& font_sizes);
+
+  // Adds the font at the specified path with the specified name. The font
+  // file is memory-mapped through `TextLayoutEngine` and the font is created
+  // in every context when first used. Returns `false` on failure or if the
+  // name is taken by a font at another path.
+  bool AddFont(const std::string& name, const std::string& path);
+
+  // Returns the handle of the font with the specified name. Every name gets
+  // a unique handle even if no such font exists yet.
+  int GetFontHandle(const std::string& name);
+
+  // Returns the `TextLayoutEngine` index of the font of the specified handle,
+  // or -1 if the font is not registered in the engine. The name of the font
+  // is only looked up until the font is registered.
+  int GetEngineFontIndex(const int handle);
+
+  // Returns the nanovg font id of the specified font handle in the context,
+  // or -1 if the font is not available in the context. Fonts added through
+  // `AddFont()` are created in the context if necessary.
+  int GetFontId(NVGcontext* context, const int handle);
+
+  // Creates the fonts of the declared character sets in the context and
+  // rasterizes their scalable glyphs. This method should be called right
+  // after creating the context and outside `nvgBeginFrame()` and
+  // `nvgEndFrame()`.
+  void PrepareContext(NVGcontext* context);
+
+  // Removes the font ids of the context. This method must be called before
+  // the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Rasterizes the declared character sets into fontstash's atlas of the
+  // context if not done yet. This method must be called between
+  // `nvgBeginFrame()` and `nvgEndFrame()`. Nothing visible is drawn.
+  void WarmUpContext(NVGcontext* context);
+
+ private:
+  // Characters to rasterize in advance.
+  struct CharacterSet {
+    std::string characters;
+    int font_handle;
+    std::vector<float> font_sizes;
+  };
+
+  // The states of a nanovg context.
+  struct ContextStates {
+    // The font ids indexed by font handles. Unresolved ids are -1.
+    std::vector<int> font_ids;
+    // Indicates whether `WarmUpContext()` has been done.
+    bool is_warmed_up;
+  };
+
+  FontRegistry();
+  ~FontRegistry();
+
+  // The declared character sets.
+  std::vector<CharacterSet> character_sets_;
+
+  // The states of contexts.
+  std::unordered_map<NVGcontext*, ContextStates> contexts_;
+
+  // The `TextLayoutEngine` indexes of fonts indexed by font handles.
+  // Unresolved indexes are -1.
+  std::vector<int> engine_font_indexes_;
+
+  // The font handles keyed by font names.
+  std::unordered_map<std::string, int> font_handles_;
+
+  // The font names indexed by font handles.
+  std::vector<std::string> font_names_;
+
+  DISALLOW_COPY_AND_ASSIGN(FontRegistry);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_FONT_REGISTRY_H_
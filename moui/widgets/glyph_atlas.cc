@@ -0,0 +1,284 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/glyph_atlas.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/core/text_layout_engine.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/font_registry.h"
+
+namespace {
+
+// The number of empty pixels around every glyph in a page, which keeps
+// neighboring glyphs from bleeding into each other in smaller mipmap levels.
+const int kGlyphPadding = 4;
+
+// The width and height of an atlas page in pixels.
+const int kPageSize = 512;
+
+// The font size to rasterize glyphs at. Glyphs are scaled from this size to
+// any font size when drawing.
+const float kReferenceFontSize = 64;
+
+}  // namespace
+
+namespace moui {
+
+GlyphAtlas::Atlas::Atlas() : packer(kPageSize, kGlyphPadding) {
+}
+
+GlyphAtlas::GlyphAtlas() : number_of_rasterized_glyphs_(0),
+                           scalable_fonts_version_(0) {
+}
+
+GlyphAtlas::~GlyphAtlas() {
+}
+
+bool GlyphAtlas::AllocateGlyph(const int width, const int height,
+                               Atlas* atlas, Glyph* glyph) {
+  if (!atlas->packer.Pack(width, height, &glyph->page, &glyph->x,
+                          &glyph->y)) {
+    return false;
+  }
+  glyph->width = width;
+  glyph->height = height;
+  if (glyph->page < static_cast<int>(atlas->pages.size()))
+    return true;
+
+  atlas->pages.push_back(Page());
+  Page& page = atlas->pages.back();
+  page.image = -1;
+  page.is_dirty = false;
+  page.pixels.assign(kPageSize * kPageSize * 4, 0);
+  return true;
+}
+
+bool GlyphAtlas::DrawGlyphs(
+    NVGcontext* context, const int font_handle, const float font_size,
+    const NVGcolor& color, const float x, const float y, const float ascender,
+    const std::vector<TextLayoutEngine::GlyphPosition>& positions) {
+  auto atlas_iterator = atlases_.find(context);
+  if (atlas_iterator == atlases_.end())
+    return false;
+  Atlas& atlas = atlas_iterator->second;
+  auto font_iterator = atlas.fonts.find(font_handle);
+  if (font_iterator == atlas.fonts.end())
+    return false;
+  const std::unordered_map<uint32_t, Glyph>& kGlyphs = font_iterator->second;
+
+  // Makes sure all glyphs are available before drawing anything.
+  for (const TextLayoutEngine::GlyphPosition& kPosition : positions) {
+    auto glyph_iterator = kGlyphs.find(kPosition.codepoint);
+    if (glyph_iterator == kGlyphs.end())
+      return false;
+    const int kPageIndex = glyph_iterator->second.page;
+    if (kPageIndex >= 0 && (atlas.pages[kPageIndex].image < 0 ||
+                            atlas.pages[kPageIndex].is_dirty)) {
+      return false;
+    }
+  }
+
+  // Groups the glyph quads by pages.
+  const float kScale = font_size / kReferenceFontSize;
+  const float kBaseline = y + ascender;
+  if (quads_.size() < atlas.pages.size())
+    quads_.resize(atlas.pages.size());
+  for (const TextLayoutEngine::GlyphPosition& kPosition : positions) {
+    const Glyph& kGlyph = kGlyphs.find(kPosition.codepoint)->second;
+    if (kGlyph.page < 0)
+      continue;
+    const float kGlyphX = x + kPosition.x + kGlyph.left * kScale;
+    const float kGlyphY = kBaseline - kGlyph.top * kScale;
+    quads_[kGlyph.page].push_back({
+        kGlyphX, kGlyphY, kGlyphX + kGlyph.width * kScale,
+        kGlyphY + kGlyph.height * kScale,
+        static_cast<float>(kGlyph.x) / kPageSize,
+        static_cast<float>(kGlyph.y) / kPageSize,
+        static_cast<float>(kGlyph.x + kGlyph.width) / kPageSize,
+        static_cast<float>(kGlyph.y + kGlyph.height) / kPageSize});
+  }
+
+  for (size_t page_index = 0; page_index < atlas.pages.size(); ++page_index) {
+    std::vector<NVGimageQuad>& quads = quads_[page_index];
+    if (quads.empty())
+      continue;
+    NVGpaint paint = nvgImagePattern(context, 0, 0, kPageSize, kPageSize, 0,
+                                     atlas.pages[page_index].image, 1);
+    // Tints the white glyph image with the text color.
+    paint.innerColor = color;
+    paint.outerColor = color;
+    nvgDrawImageQuads(context, paint, quads);
+    quads.clear();
+  }
+  return true;
+}
+
+bool GlyphAtlas::DrawText(NVGcontext* context, const int font_handle,
+                          const float font_size, const NVGcolor& color,
+                          const float x, const float y, const char* begin,
+                          const char* end) {
+  const int kFontIndex = \
+      FontRegistry::GetSharedRegistry()->GetEngineFontIndex(font_handle);
+  float ascender;
+  if (!TextLayoutEngine::GetSharedEngine()->GetGlyphPositions(
+          kFontIndex, font_size, begin, end, &positions_, &ascender)) {
+    return false;
+  }
+  return DrawGlyphs(context, font_handle, font_size, color, x, y, ascender,
+                    positions_);
+}
+
+bool GlyphAtlas::FontUsesScalableGlyphs(const int font_handle) const {
+  return scalable_font_handles_.find(font_handle) !=
+         scalable_font_handles_.end();
+}
+
+GlyphAtlas* GlyphAtlas::GetSharedAtlas() {
+  static GlyphAtlas* shared_atlas = new GlyphAtlas;
+  return shared_atlas;
+}
+
+int GlyphAtlas::GetNumberOfPages(NVGcontext* context) const {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end())
+    return 0;
+  return static_cast<int>(iterator->second.pages.size());
+}
+
+float GlyphAtlas::GetUsage(NVGcontext* context) const {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end() || iterator->second.pages.empty())
+    return 0;
+
+  const ShelfPacker& kPacker = iterator->second.packer;
+  return kPacker.used_area() / (static_cast<float>(kPageSize) * kPageSize *
+                                kPacker.number_of_pages());
+}
+
+bool GlyphAtlas::PrepareText(NVGcontext* context, const int font_handle,
+                             const std::string& text) {
+  TextLayoutEngine* engine = TextLayoutEngine::GetSharedEngine();
+  const int kFontIndex = \
+      FontRegistry::GetSharedRegistry()->GetEngineFontIndex(font_handle);
+  const char* kText = text.c_str();
+  float ascender;
+  if (!engine->GetGlyphPositions(kFontIndex, kReferenceFontSize, kText,
+                                 kText + text.size(), &positions_,
+                                 &ascender)) {
+    return false;
+  }
+
+  Atlas& atlas = atlases_[context];
+  std::unordered_map<uint32_t, Glyph>& glyphs = atlas.fonts[font_handle];
+  TextLayoutEngine::GlyphBitmap bitmap;
+  for (const TextLayoutEngine::GlyphPosition& kPosition : positions_) {
+    if (glyphs.find(kPosition.codepoint) != glyphs.end())
+      continue;
+    if (!engine->RasterizeGlyph(kFontIndex, kPosition.codepoint,
+                                kReferenceFontSize, &bitmap)) {
+      return false;
+    }
+    ++number_of_rasterized_glyphs_;
+
+    Glyph glyph = {-1, 0, 0, 0, 0, bitmap.left, bitmap.top};
+    if (bitmap.width > 0 && bitmap.height > 0 &&
+        AllocateGlyph(bitmap.width, bitmap.height, &atlas, &glyph)) {
+      // Copies the coverage to the alpha channel of white pixels.
+      Page& page = atlas.pages[glyph.page];
+      for (int row = 0; row < bitmap.height; ++row) {
+        unsigned char* pixel = page.pixels.data() +
+                               ((glyph.y + row) * kPageSize + glyph.x) * 4;
+        const unsigned char* kCoverage = \
+            bitmap.coverage.data() + row * bitmap.width;
+        for (int column = 0; column < bitmap.width; ++column) {
+          pixel[0] = pixel[1] = pixel[2] = 255;
+          pixel[3] = kCoverage[column];
+          pixel += 4;
+        }
+      }
+      // Extends the bounds of the changed pixels with the glyph.
+      if (!page.is_dirty) {
+        page.dirty_bottom = glyph.y + glyph.height;
+        page.dirty_left = glyph.x;
+        page.dirty_right = glyph.x + glyph.width;
+        page.dirty_top = glyph.y;
+        page.is_dirty = true;
+      } else {
+        page.dirty_bottom = std::max(page.dirty_bottom,
+                                     glyph.y + glyph.height);
+        page.dirty_left = std::min(page.dirty_left, glyph.x);
+        page.dirty_right = std::max(page.dirty_right, glyph.x + glyph.width);
+        page.dirty_top = std::min(page.dirty_top, glyph.y);
+      }
+    }
+    glyphs[kPosition.codepoint] = glyph;
+  }
+
+  // Creates the images of new pages, or uploads only the changed regions of
+  // existing pages.
+  GpuMemoryTracker::ScopedOwner scoped_owner(this, "moui::GlyphAtlas");
+  for (Page& page : atlas.pages) {
+    if (page.image < 0) {
+      page.image = nvgCreateTrackedImageRGBA(context, kPageSize, kPageSize,
+                                             NVG_IMAGE_GENERATE_MIPMAPS,
+                                             page.pixels.data());
+      if (page.image <= 0) {
+        page.image = -1;
+        return false;
+      }
+    } else if (page.is_dirty) {
+      nvgUpdateImageRegion(context, page.image, page.dirty_left,
+                           page.dirty_top, page.dirty_right - page.dirty_left,
+                           page.dirty_bottom - page.dirty_top,
+                           NVG_IMAGE_GENERATE_MIPMAPS, page.pixels.data());
+    }
+    page.is_dirty = false;
+  }
+  return true;
+}
+
+void GlyphAtlas::RemoveContext(NVGcontext* context) {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end())
+    return;
+
+  for (Page& page : iterator->second.pages) {
+    if (page.image >= 0)
+      nvgDeleteImage(context, &page.image);
+  }
+  atlases_.erase(iterator);
+}
+
+void GlyphAtlas::SetFontUsesScalableGlyphs(const std::string& font_name,
+                                           const bool value) {
+  const int kFontHandle = \
+      FontRegistry::GetSharedRegistry()->GetFontHandle(font_name);
+  const bool kChanged = value ?
+      scalable_font_handles_.insert(kFontHandle).second :
+      scalable_font_handles_.erase(kFontHandle) > 0;
+  if (kChanged)
+    ++scalable_fonts_version_;
+}
+
+}  // namespace moui
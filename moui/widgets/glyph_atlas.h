@@ -0,0 +1,180 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_GLYPH_ATLAS_H_
+#define MOUI_WIDGETS_GLYPH_ATLAS_H_
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/core/shelf_packer.h"
+#include "moui/core/text_layout_engine.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `GlyphAtlas` class renders text with glyphs rasterized only once at a
+// fixed reference size, and scales the glyph images to any font size when
+// drawing. Fontstash instead rasterizes glyphs at every exact pixel size,
+// which fills its atlas with new glyphs on every frame while animating the
+// scale of text. The scalable glyphs are slightly softer than the glyphs
+// rasterized by fontstash, so the mode is opted in per font through
+// `SetFontUsesScalableGlyphs()`.
+//
+// Fonts are identified by `FontRegistry` handles so drawing never looks up
+// font names. Glyphs are rasterized through `TextLayoutEngine`, so the fonts
+// must be created by `nvgCreateFontAtPath()` or `FontRegistry::AddFont()`.
+// Each nanovg context has its own atlas pages. The class is not thread-safe
+// and should only be used on the render thread.
+class GlyphAtlas {
+ public:
+  // Returns the atlas shared by the application.
+  static GlyphAtlas* GetSharedAtlas();
+
+  // Draws the glyphs positioned by `TextLayoutEngine::GetGlyphPositions()`
+  // at `font_size` in a single row whose top-left corner is at (`x`, `y`).
+  // `ascender` is the one retrieved along with the positions. This allows
+  // callers to position the glyphs once and draw them in every frame.
+  // Returns `false` like `DrawText()`.
+  bool DrawGlyphs(NVGcontext* context, const int font_handle,
+                  const float font_size, const NVGcolor& color, const float x,
+                  const float y, const float ascender,
+                  const std::vector<TextLayoutEngine::GlyphPosition>&
+                      positions);
+
+  // Draws the text between `begin` and `end` in a single row whose top-left
+  // corner is at (`x`, `y`) like `nvgText()` with top-left alignment. The
+  // glyphs in the same page are drawn in a single draw call. Returns `false`
+  // without drawing anything if any glyph has not been prepared by
+  // `PrepareText()` for the context.
+  bool DrawText(NVGcontext* context, const int font_handle,
+                const float font_size, const NVGcolor& color, const float x,
+                const float y, const char* begin, const char* end);
+
+  // Returns `true` if the text in the font of the specified `FontRegistry`
+  // handle should be rendered with scalable glyphs.
+  bool FontUsesScalableGlyphs(const int font_handle) const;
+
+  // Returns the number of atlas pages created for the specified context.
+  int GetNumberOfPages(NVGcontext* context) const;
+
+  // Returns the proportion of the area occupied by glyphs in all atlas pages
+  // of the specified context.
+  float GetUsage(NVGcontext* context) const;
+
+  // Rasterizes the glyphs of `text` that are not in the context's atlas yet
+  // and uploads the changed regions of the atlas pages. Returns `false` on
+  // failure. This method updates the page images and therefore must not be
+  // called between `nvgBeginFrame()` and `nvgEndFrame()`.
+  bool PrepareText(NVGcontext* context, const int font_handle,
+                   const std::string& text);
+
+  // Deletes the atlas pages of the specified context. This method must be
+  // called before the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Sets whether the text in the specified font should be rendered with
+  // scalable glyphs.
+  void SetFontUsesScalableGlyphs(const std::string& font_name,
+                                 const bool value);
+
+  // Accessors and setters.
+  int number_of_rasterized_glyphs() const {
+    return number_of_rasterized_glyphs_;
+  }
+  int scalable_fonts_version() const { return scalable_fonts_version_; }
+
+ private:
+  // The location of a glyph in the atlas.
+  struct Glyph {
+    // The index of the page containing the glyph, or -1 if the glyph has no
+    // visible pixels.
+    int page;
+    // The bounds of the glyph's bitmap in the page.
+    int x;
+    int y;
+    int width;
+    int height;
+    // The offset of the bitmap relative to the pen position on the baseline.
+    int left;
+    int top;
+  };
+
+  // An atlas page containing glyphs.
+  struct Page {
+    // The bounds of the pixels changed since `image` was last updated, which
+    // are only valid if `is_dirty` is `true`.
+    int dirty_bottom;
+    int dirty_left;
+    int dirty_right;
+    int dirty_top;
+    // The nanovg image of the page, or -1 if not created yet.
+    int image;
+    // Indicates whether `pixels` has changed since `image` was updated.
+    bool is_dirty;
+    // The RGBA pixels of the page.
+    std::vector<unsigned char> pixels;
+  };
+
+  // The atlas of a nanovg context.
+  struct Atlas {
+    Atlas();
+
+    // The glyphs keyed by codepoints for every font handle.
+    std::unordered_map<int, std::unordered_map<uint32_t, Glyph>> fonts;
+    // Places the glyphs in `pages`.
+    ShelfPacker packer;
+    std::vector<Page> pages;
+  };
+
+  GlyphAtlas();
+  ~GlyphAtlas();
+
+  // Places a bitmap of the specified size in the atlas and stores its
+  // location in `glyph`. Returns `false` if the bitmap is larger than a page.
+  bool AllocateGlyph(const int width, const int height, Atlas* atlas,
+                     Glyph* glyph);
+
+  // The atlases keyed by nanovg contexts.
+  std::unordered_map<NVGcontext*, Atlas> atlases_;
+
+  // The total number of glyphs rasterized for all contexts.
+  int number_of_rasterized_glyphs_;
+
+  // The buffer of glyph positions reused by `DrawText()`.
+  std::vector<TextLayoutEngine::GlyphPosition> positions_;
+
+  // The buffers of glyph quads for every page reused by `DrawGlyphs()`.
+  std::vector<std::vector<NVGimageQuad>> quads_;
+
+  // The handles of the fonts rendered with scalable glyphs.
+  std::set<int> scalable_font_handles_;
+
+  // Increases whenever `scalable_font_handles_` changes, so callers caching
+  // `FontUsesScalableGlyphs()` know when to ask again.
+  int scalable_fonts_version_;
+
+  DISALLOW_COPY_AND_ASSIGN(GlyphAtlas);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_GLYPH_ATLAS_H_
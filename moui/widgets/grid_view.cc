@@ -0,0 +1,352 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/grid_view.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/grid_view_cell.h"
+#include "moui/widgets/reuse_pool.h"
+#include "moui/widgets/scroll_view.h"
+#include "moui/widgets/widget_view.h"
+
+namespace {
+
+// The default column width in points.
+const float kDefaultColumnWidth = 100;
+// The default row height in points.
+const float kDefaultRowHeight = 44;
+
+}  // namespace
+
+namespace moui {
+
+GridView::GridView() :
+    ScrollView(), column_width_(GridView::kAutomaticDimension),
+    data_source_(nullptr), delegate_(nullptr),
+    last_content_view_offset_({-1, -1}), last_size_({-1, -1}),
+    number_of_frozen_columns_(0), number_of_frozen_rows_(0),
+    row_height_(GridView::kAutomaticDimension), should_update_layout_(true),
+    should_update_offsets_(true) {
+  set_always_scroll_both_directions(false);
+}
+
+GridView::~GridView() {
+  // Releases visible cells.
+  for (auto& pair : visible_cells_) {
+    GridViewCell* cell = pair.second;
+    cell->RemoveFromParent();
+    delete cell;
+  }
+}
+
+GridViewCell* GridView::DequeueReusableCell(const std::string& identifier) {
+  return DequeueReusableCell(ReusePool::GetReuseId(identifier));
+}
+
+GridViewCell* GridView::DequeueReusableCell(const int reuse_id) {
+  auto cell = static_cast<GridViewCell*>(reusable_cells_.Dequeue(reuse_id));
+  if (cell == nullptr)
+    return nullptr;
+
+  cell->PrepareForReuse();
+  return cell;
+}
+
+GridViewCell* GridView::GetCell(const CellIndex cell_index) const {
+  auto match = visible_cells_.find(
+      GetCellKey(cell_index.row_index, cell_index.column_index));
+  if (match == visible_cells_.end())
+    return nullptr;
+  return match->second;
+}
+
+GridView::CellIndex GridView::GetCellIndex(GridViewCell* cell) const {
+  for (auto& pair : visible_cells_) {
+    if (pair.second == cell) {
+      return {static_cast<int>(pair.first >> 32),
+              static_cast<int>(pair.first & 0xFFFFFFFF)};
+    }
+  }
+  return {-1, -1};
+}
+
+int GridView::GetIndexAtOffset(const std::vector<double>& offsets,
+                               const double offset) {
+  const int kNumberOfItems = static_cast<int>(offsets.size()) - 1;
+  if (kNumberOfItems <= 0)
+    return -1;
+
+  const int kIndex = static_cast<int>(
+      std::upper_bound(offsets.begin(), offsets.end(), offset)
+      - offsets.begin()) - 1;
+  return std::min(kNumberOfItems - 1, std::max(0, kIndex));
+}
+
+void GridView::HandleMemoryWarning(NVGcontext* context) {
+  ScrollView::HandleMemoryWarning(context);
+  reusable_cells_.Clear();
+}
+
+void GridView::ReloadData() {
+  for (auto& pair : visible_cells_)
+    ReuseCell(pair.second);
+  visible_cells_.clear();
+  should_update_layout_ = true;
+  should_update_offsets_ = true;
+  SetContentViewOffset({0, 0});
+  Redraw();
+}
+
+void GridView::RefreshLayout() {
+  should_update_layout_ = true;
+  should_update_offsets_ = true;
+  Redraw();
+}
+
+void GridView::ReuseCell(GridViewCell* cell) {
+  cell->RemoveFromParent();
+  reusable_cells_.Enqueue(cell->reuse_id(), cell);
+}
+
+GridViewCell* GridView::UpdateCell(
+    const int row_index, const int column_index, const float x, const float y,
+    std::map<int64_t, GridViewCell*>* visible_cells) {
+  const int64_t kKey = GetCellKey(row_index, column_index);
+  GridViewCell* cell = nullptr;
+  auto match = visible_cells_.find(kKey);
+  if (match != visible_cells_.end()) {
+    cell = match->second;
+    visible_cells_.erase(match);
+  } else {
+    const int kNumberOfHits = reusable_cells_.number_of_hits();
+    cell = data_source_->GetGridViewCell(this, row_index, column_index);
+    if (cell == nullptr)
+      return nullptr;
+    // The data source created a new cell if no reusable cell was dequeued.
+    if (reusable_cells_.number_of_hits() == kNumberOfHits)
+      reusable_cells_.RecordAllocation();
+    AddChild(cell);
+  }
+  cell->SetBounds(x, y,
+                  column_offsets_[column_index + 1]
+                      - column_offsets_[column_index],
+                  row_offsets_[row_index + 1] - row_offsets_[row_index]);
+  (*visible_cells)[kKey] = cell;
+  return cell;
+}
+
+bool GridView::UpdateLayout() {
+  if (data_source_ == nullptr || IsHidden() || widget_view() == nullptr ||
+      (GetWidth() == 0 && GetHeight() == 0)) {
+    return false;
+  }
+
+  if (should_update_offsets_) {
+    should_update_offsets_ = false;
+    should_update_layout_ = true;
+    UpdateOffsets();
+  }
+
+  const Point kContentViewOffset = GetContentViewOffset();
+  const float kWidth = GetWidth();
+  const float kHeight = GetHeight();
+  if (!should_update_layout_ &&
+      kContentViewOffset.x == last_content_view_offset_.x &&
+      kContentViewOffset.y == last_content_view_offset_.y &&
+      kWidth == last_size_.width && kHeight == last_size_.height) {
+    return false;
+  }
+  should_update_layout_ = false;
+  last_content_view_offset_ = kContentViewOffset;
+  last_size_ = {kWidth, kHeight};
+
+  std::map<int64_t, GridViewCell*> visible_cells;
+  const int kNumberOfColumns = static_cast<int>(column_offsets_.size()) - 1;
+  const int kNumberOfRows = static_cast<int>(row_offsets_.size()) - 1;
+  if (kNumberOfColumns > 0 && kNumberOfRows > 0) {
+    const int kNumberOfFrozenColumns = \
+        std::min(number_of_frozen_columns_, kNumberOfColumns);
+    const int kNumberOfFrozenRows = \
+        std::min(number_of_frozen_rows_, kNumberOfRows);
+    const float kFrozenWidth = column_offsets_[kNumberOfFrozenColumns];
+    const float kFrozenHeight = row_offsets_[kNumberOfFrozenRows];
+
+    // Frozen cells follow the content view only when it is pulled beyond its
+    // leading edges. Otherwise, they stay pinned to the grid view's edges.
+    const float kPinnedX = std::max(0.0f, kContentViewOffset.x);
+    const float kPinnedY = std::max(0.0f, kContentViewOffset.y);
+
+    // Determines the range of visible cells that are not frozen.
+    const int kFirstColumn = std::max(
+        kNumberOfFrozenColumns,
+        GetIndexAtOffset(column_offsets_, kContentViewOffset.x + kFrozenWidth));
+    const int kLastColumn = GetIndexAtOffset(column_offsets_,
+                                             kContentViewOffset.x + kWidth);
+    const int kFirstRow = std::max(
+        kNumberOfFrozenRows,
+        GetIndexAtOffset(row_offsets_, kContentViewOffset.y + kFrozenHeight));
+    const int kLastRow = GetIndexAtOffset(row_offsets_,
+                                          kContentViewOffset.y + kHeight);
+
+    // Scrollable cells.
+    for (int row = kFirstRow; row <= kLastRow; ++row) {
+      for (int column = kFirstColumn; column <= kLastColumn; ++column) {
+        UpdateCell(row, column, column_offsets_[column], row_offsets_[row],
+                   &visible_cells);
+      }
+    }
+    // Frozen columns. The cells are brought to front to cover the scrollable
+    // cells scrolled beneath them.
+    for (int row = kFirstRow; row <= kLastRow; ++row) {
+      for (int column = 0; column < kNumberOfFrozenColumns; ++column) {
+        GridViewCell* cell = UpdateCell(
+            row, column, kPinnedX + column_offsets_[column], row_offsets_[row],
+            &visible_cells);
+        if (cell != nullptr)
+          BringChildToFront(cell);
+      }
+    }
+    // Frozen rows.
+    for (int row = 0; row < kNumberOfFrozenRows; ++row) {
+      for (int column = kFirstColumn; column <= kLastColumn; ++column) {
+        GridViewCell* cell = UpdateCell(
+            row, column, column_offsets_[column], kPinnedY + row_offsets_[row],
+            &visible_cells);
+        if (cell != nullptr)
+          BringChildToFront(cell);
+      }
+    }
+    // Cells frozen in both directions.
+    for (int row = 0; row < kNumberOfFrozenRows; ++row) {
+      for (int column = 0; column < kNumberOfFrozenColumns; ++column) {
+        GridViewCell* cell = UpdateCell(
+            row, column, kPinnedX + column_offsets_[column],
+            kPinnedY + row_offsets_[row], &visible_cells);
+        if (cell != nullptr)
+          BringChildToFront(cell);
+      }
+    }
+  }
+
+  // Reuses cells that are no longer visible.
+  for (auto& pair : visible_cells_)
+    ReuseCell(pair.second);
+  visible_cells_.swap(visible_cells);
+
+  SetContentViewSize(column_offsets_.empty() ? 0 : column_offsets_.back(),
+                     row_offsets_.empty() ? 0 : row_offsets_.back());
+  return true;
+}
+
+void GridView::UpdateOffsets() {
+  const int kNumberOfColumns = data_source_->GetNumberOfColumns(this);
+  const int kNumberOfRows = data_source_->GetNumberOfRows(this);
+  const float kColumnWidth = column_width_ == GridView::kAutomaticDimension ?
+                             kDefaultColumnWidth : column_width_;
+  const float kRowHeight = row_height_ == GridView::kAutomaticDimension ?
+                           kDefaultRowHeight : row_height_;
+
+  column_offsets_.resize(std::max(0, kNumberOfColumns) + 1);
+  column_offsets_[0] = 0;
+  for (int column = 0; column < kNumberOfColumns; ++column) {
+    float width = GridView::kAutomaticDimension;
+    if (delegate_ != nullptr)
+      width = delegate_->GetGridViewColumnWidth(this, column);
+    if (width == GridView::kAutomaticDimension)
+      width = kColumnWidth;
+    column_offsets_[column + 1] = column_offsets_[column] + width;
+  }
+
+  row_offsets_.resize(std::max(0, kNumberOfRows) + 1);
+  row_offsets_[0] = 0;
+  if (delegate_ == nullptr) {
+    // Calculates the offsets directly to avoid accumulating rounding errors
+    // for grids with a large number of rows.
+    for (int row = 1; row <= kNumberOfRows; ++row)
+      row_offsets_[row] = static_cast<double>(row) * kRowHeight;
+    return;
+  }
+  for (int row = 0; row < kNumberOfRows; ++row) {
+    float height = delegate_->GetGridViewRowHeight(this, row);
+    if (height == GridView::kAutomaticDimension)
+      height = kRowHeight;
+    row_offsets_[row + 1] = row_offsets_[row] + height;
+  }
+}
+
+bool GridView::WidgetViewWillRender(NVGcontext* context) {
+  const bool kResult = ScrollView::WidgetViewWillRender(context);
+  if (!kResult)
+    return false;
+
+  UpdateLayout();
+  return true;
+}
+
+void GridView::set_column_width(const float column_width) {
+  if (column_width == column_width_)
+    return;
+  column_width_ = column_width;
+  RefreshLayout();
+}
+
+void GridView::set_data_source(GridViewDataSource* data_source) {
+  if (data_source != data_source_) {
+    data_source_ = data_source;
+    ReloadData();
+  }
+}
+
+void GridView::set_delegate(GridViewDelegate* delegate) {
+  if (delegate != delegate_) {
+    delegate_ = delegate;
+    RefreshLayout();
+  }
+}
+
+void GridView::set_number_of_frozen_columns(
+    const int number_of_frozen_columns) {
+  if (number_of_frozen_columns == number_of_frozen_columns_)
+    return;
+  number_of_frozen_columns_ = std::max(0, number_of_frozen_columns);
+  should_update_layout_ = true;
+  Redraw();
+}
+
+void GridView::set_number_of_frozen_rows(const int number_of_frozen_rows) {
+  if (number_of_frozen_rows == number_of_frozen_rows_)
+    return;
+  number_of_frozen_rows_ = std::max(0, number_of_frozen_rows);
+  should_update_layout_ = true;
+  Redraw();
+}
+
+void GridView::set_row_height(const float row_height) {
+  if (row_height == row_height_)
+    return;
+  row_height_ = row_height;
+  RefreshLayout();
+}
+
+}  // namespace moui
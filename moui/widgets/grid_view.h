@@ -0,0 +1,237 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_GRID_VIEW_H_
+#define MOUI_WIDGETS_GRID_VIEW_H_
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/reuse_pool.h"
+#include "moui/widgets/scroll_view.h"
+
+namespace moui {
+
+// Forward declaration.
+class GridViewCell;
+class GridViewDataSource;
+class GridViewDelegate;
+
+// The `GridView` widget displays a two-dimensional grid of cells similar to a
+// spreadsheet. Unlike `GridLayout` that manages every child widget, the grid
+// view only asks its data source for the cells that are currently visible and
+// recycles cells scrolled out of the viewport by their reuse identifiers. The
+// leading rows and columns can be frozen to stay pinned at the top and left
+// edges of the grid view while scrolling.
+class GridView : public ScrollView {
+ public:
+  // Indicates the default value for a given dimension.
+  static constexpr float kAutomaticDimension = INT_MIN;
+
+  // A cell index representing the row and column of the cell.
+  struct CellIndex {
+    int row_index;
+    int column_index;
+  };
+
+  GridView();
+  ~GridView();
+
+  // Returns a reusable grid-view cell object located by its identifier.
+  GridViewCell* DequeueReusableCell(const std::string& identifier);
+
+  // Returns a reusable grid-view cell object located by its reuse ID, which
+  // avoids interning the identifier on every call. See
+  // `ReusePool::GetReuseId()`.
+  GridViewCell* DequeueReusableCell(const int reuse_id);
+
+  // Returns the cell object at the specified cell index, or `nullptr` if the
+  // cell is not visible.
+  GridViewCell* GetCell(const CellIndex cell_index) const;
+
+  // Returns a cell index representing the row and column of the given
+  // grid-view cell. `{-1, -1}` is returned if the cell is not visible.
+  CellIndex GetCellIndex(GridViewCell* cell) const;
+
+  // Inherited from `Widget` class. Releases the reusable cells.
+  void HandleMemoryWarning(NVGcontext* context) override;
+
+  // Reloads the rows and columns of the grid view.
+  void ReloadData();
+
+  // Refreshes the layout.
+  void RefreshLayout();
+
+  // Setters and accessors.
+  float column_width() const { return column_width_; }
+  void set_column_width(const float column_width);
+  GridViewDataSource* data_source() const { return data_source_; }
+  void set_data_source(GridViewDataSource* data_source);
+  GridViewDelegate* delegate() const { return delegate_; }
+  void set_delegate(GridViewDelegate* delegate);
+  int number_of_frozen_columns() const { return number_of_frozen_columns_; }
+  void set_number_of_frozen_columns(const int number_of_frozen_columns);
+  int number_of_frozen_rows() const { return number_of_frozen_rows_; }
+  void set_number_of_frozen_rows(const int number_of_frozen_rows);
+  ReusePool* reusable_cells() { return &reusable_cells_; }
+  float row_height() const { return row_height_; }
+  void set_row_height(const float row_height);
+
+ protected:
+  // Inherited from `Widget` class. Updates the layout of visible cells right
+  // after the content view is moved so the frozen cells stay pinned in the
+  // same frame.
+  bool WidgetViewWillRender(NVGcontext* context) override;
+
+ private:
+  // Returns the key of `visible_cells_` for the specified cell index.
+  static int64_t GetCellKey(const int row_index, const int column_index) {
+    return (static_cast<int64_t>(row_index) << 32) | column_index;
+  }
+
+  // Returns the index of the row or column whose extent covers the specified
+  // `offset`. The `offsets` is expected to be one of `column_offsets_` and
+  // `row_offsets_`.
+  static int GetIndexAtOffset(const std::vector<double>& offsets,
+                              const double offset);
+
+  // Adds the specified cell to `reusable_cells_` if the cell's reusable
+  // identifier is not empty. Otherwise, the cell is released.
+  void ReuseCell(GridViewCell* cell);
+
+  // Lays out the cell at the specified location. The cell is requested from
+  // the data source if it was not visible in the last layout. Returns the
+  // laid out cell.
+  GridViewCell* UpdateCell(const int row_index, const int column_index,
+                           const float x, const float y,
+                           std::map<int64_t, GridViewCell*>* visible_cells);
+
+  // Updates the layout of displayed cells. Returns `true` if the layout did
+  // update.
+  bool UpdateLayout();
+
+  // Rebuilds `column_offsets_` and `row_offsets_` by asking the delegate for
+  // the dimension of every column and row.
+  void UpdateOffsets();
+
+  // Keeps the leading offset of every column in the content view. The vector
+  // has one extra element at the end indicating the width of all columns.
+  // Offsets are kept in double precision as a float can't tell consecutive
+  // offsets apart accurately in very large grids.
+  std::vector<double> column_offsets_;
+
+  // Indicates the width of each column in the grid view.
+  float column_width_;
+
+  // The weak reference to the `GridViewDataSource` instance.
+  GridViewDataSource* data_source_;
+
+  // The weak reference to the `GridViewDelegate` instance.
+  GridViewDelegate* delegate_;
+
+  // Keeps the content view offset last time updated layout.
+  Point last_content_view_offset_;
+
+  // Keeps the size of the grid view last time updated layout.
+  Size last_size_;
+
+  // Indicates the number of leading columns that are pinned to the left edge
+  // of the grid view.
+  int number_of_frozen_columns_;
+
+  // Indicates the number of leading rows that are pinned to the top edge of
+  // the grid view.
+  int number_of_frozen_rows_;
+
+  // Keeps strong reference to the cell objects that are marked as reusable.
+  ReusePool reusable_cells_;
+
+  // Indicates the height of each row in the grid view.
+  float row_height_;
+
+  // Keeps the leading offset of every row in the content view. The vector has
+  // one extra element at the end indicating the height of all rows. Kept in
+  // double precision like `column_offsets_`.
+  std::vector<double> row_offsets_;
+
+  // Indicates whether the layout should update.
+  bool should_update_layout_;
+
+  // Indicates whether `column_offsets_` and `row_offsets_` should be rebuilt.
+  bool should_update_offsets_;
+
+  // The grid cells that are visible in the grid view. The key is generated by
+  // `GetCellKey()`.
+  std::map<int64_t, GridViewCell*> visible_cells_;
+
+  DISALLOW_COPY_AND_ASSIGN(GridView);
+};
+
+// The `GridViewDataSource` class is adopted by an object that mediates the
+// application's data model for a `GridView` object.
+class GridViewDataSource {
+ public:
+  GridViewDataSource() {}
+  ~GridViewDataSource() {}
+
+  // Asks the data source for a cell to insert in a particular location of
+  // the grid view.
+  virtual GridViewCell* GetGridViewCell(GridView* grid_view,
+                                        const int row_index,
+                                        const int column_index) = 0;
+
+  // Asks the data source to return the number of columns in the grid view.
+  virtual int GetNumberOfColumns(GridView* grid_view) = 0;
+
+  // Asks the data source to return the number of rows in the grid view.
+  virtual int GetNumberOfRows(GridView* grid_view) = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(GridViewDataSource);
+};
+
+// The `GridViewDelegate` class allows the grid view delegate to customize the
+// dimensions of rows and columns.
+class GridViewDelegate {
+ public:
+  GridViewDelegate() {}
+  ~GridViewDelegate() {}
+
+  // Asks the delegate for the width to use for a particular column.
+  virtual float GetGridViewColumnWidth(GridView* grid_view,
+                                       const int column_index) {
+    return GridView::kAutomaticDimension;
+  }
+
+  // Asks the delegate for the height to use for a particular row.
+  virtual float GetGridViewRowHeight(GridView* grid_view,
+                                     const int row_index) {
+    return GridView::kAutomaticDimension;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(GridViewDelegate);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_GRID_VIEW_H_
@@ -0,0 +1,39 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/grid_view_cell.h"
+
+#include <string>
+
+#include "moui/widgets/reuse_pool.h"
+#include "moui/widgets/widget.h"
+
+namespace moui {
+
+GridViewCell::GridViewCell(const std::string& reuse_identifier)
+    : reuse_id_(ReusePool::GetReuseId(reuse_identifier)),
+      reuse_identifier_(reuse_identifier) {
+  set_frees_children_on_destruction(true);
+}
+
+GridViewCell::GridViewCell() : GridViewCell("") {
+}
+
+GridViewCell::~GridViewCell() {
+}
+
+}  // namespace moui
@@ -0,0 +1,62 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_GRID_VIEW_CELL_H_
+#define MOUI_WIDGETS_GRID_VIEW_CELL_H_
+
+#include <string>
+
+#include "moui/base.h"
+#include "moui/widgets/widget.h"
+
+namespace moui {
+
+// The `GridViewCell` class defines the attributes and behavior of the cells
+// that appear in `GridView` objects. Subclasses are expected to add their own
+// child widgets or bind a render function to display the cell's content.
+class GridViewCell : public Widget {
+ public:
+  explicit GridViewCell(const std::string& reuse_identifier);
+  GridViewCell();
+  ~GridViewCell();
+
+  // Prepares a reusable cell for reuse by the grid view's data source. This
+  // method is invoked just before the object is returned from the
+  // `GridView::DequeueReusableCell()` method. If the cell object does not
+  // have an associated reuse identifier, this method is not called.
+  virtual void PrepareForReuse() {}
+
+  // Setters and accessors.
+  int reuse_id() const { return reuse_id_; }
+  std::string reuse_identifier() const { return reuse_identifier_; }
+
+ private:
+  // The reuse ID interned from `reuse_identifier_` by
+  // `ReusePool::GetReuseId()`.
+  int reuse_id_;
+
+  // Indicates a string used to identify the cell object if it is to be reused
+  // for drawing multiple cells of a grid view. Pass an empty string if the
+  // cell object is not to be reused.
+  std::string reuse_identifier_;
+
+  DISALLOW_COPY_AND_ASSIGN(GridViewCell);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_GRID_VIEW_CELL_H_
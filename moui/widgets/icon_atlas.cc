@@ -0,0 +1,235 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/icon_atlas.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/core/image_loader.h"
+#include "moui/nanovg_hook.h"
+
+namespace {
+
+// The number of pixels around every icon in a page. The padding repeats the
+// edge pixels of the icon so filtering never samples neighboring icons.
+const int kIconPadding = 2;
+
+// The width and height of an atlas page in pixels.
+const int kPageSize = 1024;
+
+}  // namespace
+
+namespace moui {
+
+IconAtlas::Atlas::Atlas() : has_dirty_pages(false),
+                            packer(kPageSize, kIconPadding) {
+}
+
+IconAtlas::IconAtlas() {
+}
+
+IconAtlas::~IconAtlas() {
+}
+
+void IconAtlas::AddIcon(const std::string& name, const std::string& path) {
+  icon_paths_[name] = path;
+}
+
+bool IconAtlas::AllocateIcon(const int width, const int height,
+                             Atlas* atlas, Entry* entry) {
+  if (width > kMaximumIconSize || height > kMaximumIconSize ||
+      !atlas->packer.Pack(width, height, &entry->page, &entry->x,
+                          &entry->y)) {
+    return false;
+  }
+  entry->width = width;
+  entry->height = height;
+  if (entry->page < static_cast<int>(atlas->pages.size()))
+    return true;
+
+  atlas->pages.push_back(Page());
+  Page& page = atlas->pages.back();
+  page.image = -1;
+  page.is_dirty = true;
+  page.pixels.assign(kPageSize * kPageSize * 4, 0);
+  page.dirty_bottom = 0;
+  page.dirty_left = 0;
+  page.dirty_right = 0;
+  page.dirty_top = 0;
+  return true;
+}
+
+bool IconAtlas::DrawIcon(NVGcontext* context, const std::string& name,
+                         const float x, const float y, const float width,
+                         const float height, const float alpha) {
+  Icon icon;
+  if (!GetIcon(context, name, &icon))
+    return false;
+
+  nvgBeginPath(context);
+  nvgRect(context, x, y, width, height);
+  nvgFillPaint(context,
+               GetIconPattern(context, icon, x, y, width, height, alpha));
+  nvgFill(context);
+  return true;
+}
+
+bool IconAtlas::GetIcon(NVGcontext* context, const std::string& name,
+                        Icon* icon) const {
+  auto atlas_iterator = atlases_.find(context);
+  if (atlas_iterator == atlases_.end())
+    return false;
+  const Atlas& kAtlas = atlas_iterator->second;
+  auto icon_iterator = kAtlas.icons.find(name);
+  if (icon_iterator == kAtlas.icons.end() || icon_iterator->second.page < 0)
+    return false;
+
+  const Entry& kEntry = icon_iterator->second;
+  const Page& kPage = kAtlas.pages[kEntry.page];
+  if (kPage.image < 0 || kPage.is_dirty)
+    return false;
+  icon->image = kPage.image;
+  icon->x = kEntry.x;
+  icon->y = kEntry.y;
+  icon->width = kEntry.width;
+  icon->height = kEntry.height;
+  return true;
+}
+
+NVGpaint IconAtlas::GetIconPattern(NVGcontext* context, const Icon& icon,
+                                   const float x, const float y,
+                                   const float width, const float height,
+                                   const float alpha) const {
+  const float kHorizontalScale = width / icon.width;
+  const float kVerticalScale = height / icon.height;
+  return nvgImagePattern(context, x - icon.x * kHorizontalScale,
+                         y - icon.y * kVerticalScale,
+                         kPageSize * kHorizontalScale,
+                         kPageSize * kVerticalScale, 0, icon.image, alpha);
+}
+
+int IconAtlas::GetNumberOfPages(NVGcontext* context) const {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end())
+    return 0;
+  return static_cast<int>(iterator->second.pages.size());
+}
+
+IconAtlas* IconAtlas::GetSharedAtlas() {
+  static IconAtlas* shared_atlas = new IconAtlas;
+  return shared_atlas;
+}
+
+bool IconAtlas::PrepareIcon(NVGcontext* context, const std::string& name) {
+  Atlas& atlas = atlases_[context];
+  auto icon_iterator = atlas.icons.find(name);
+  if (icon_iterator != atlas.icons.end())
+    return icon_iterator->second.page >= 0;
+
+  // Remembers icons that cannot be packed so they are not loaded again.
+  Entry& entry = atlas.icons[name];
+  entry.page = -1;
+  auto path_iterator = icon_paths_.find(name);
+  ImageLoader::Bitmap bitmap;
+  if (path_iterator == icon_paths_.end() ||
+      !ImageLoader::DecodeImage(path_iterator->second, 0, 0, &bitmap) ||
+      !AllocateIcon(bitmap.width, bitmap.height, &atlas, &entry)) {
+    return false;
+  }
+
+  // Copies the icon and extends its edge pixels into the padding.
+  Page& page = atlas.pages[entry.page];
+  for (int row = -kIconPadding; row < bitmap.height + kIconPadding; ++row) {
+    const int kSourceRow = std::min(std::max(row, 0), bitmap.height - 1);
+    unsigned char* pixel = page.pixels.data() +
+        ((entry.y + row) * kPageSize + entry.x - kIconPadding) * 4;
+    for (int column = -kIconPadding; column < bitmap.width + kIconPadding;
+         ++column) {
+      const int kSourceColumn = \
+          std::min(std::max(column, 0), bitmap.width - 1);
+      const unsigned char* kSource = bitmap.pixels.data() +
+          (kSourceRow * bitmap.width + kSourceColumn) * 4;
+      std::copy(kSource, kSource + 4, pixel);
+      pixel += 4;
+    }
+  }
+  const int kLeft = entry.x - kIconPadding;
+  const int kTop = entry.y - kIconPadding;
+  const int kRight = entry.x + bitmap.width + kIconPadding;
+  const int kBottom = entry.y + bitmap.height + kIconPadding;
+  if (!page.is_dirty) {
+    page.dirty_bottom = kBottom;
+    page.dirty_left = kLeft;
+    page.dirty_right = kRight;
+    page.dirty_top = kTop;
+    page.is_dirty = true;
+  } else {
+    page.dirty_bottom = std::max(page.dirty_bottom, kBottom);
+    page.dirty_left = std::min(page.dirty_left, kLeft);
+    page.dirty_right = std::max(page.dirty_right, kRight);
+    page.dirty_top = std::min(page.dirty_top, kTop);
+  }
+  atlas.has_dirty_pages = true;
+  return true;
+}
+
+void IconAtlas::RemoveContext(NVGcontext* context) {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end())
+    return;
+
+  for (Page& page : iterator->second.pages) {
+    if (page.image >= 0)
+      nvgDeleteImage(context, &page.image);
+  }
+  atlases_.erase(iterator);
+}
+
+void IconAtlas::UpdatePages(NVGcontext* context) {
+  auto iterator = atlases_.find(context);
+  if (iterator == atlases_.end() || !iterator->second.has_dirty_pages)
+    return;
+
+  GpuMemoryTracker::ScopedOwner scoped_owner(this, "moui::IconAtlas");
+  bool has_dirty_pages = false;
+  for (Page& page : iterator->second.pages) {
+    if (!page.is_dirty)
+      continue;
+    if (page.image < 0) {
+      page.image = nvgCreateTrackedImageRGBA(context, kPageSize, kPageSize, 0,
+                                             page.pixels.data());
+      if (page.image <= 0) {
+        page.image = -1;
+        has_dirty_pages = true;  // tries again in the next frame
+        continue;
+      }
+    } else {
+      nvgUpdateImageRegion(context, page.image, page.dirty_left,
+                           page.dirty_top, page.dirty_right - page.dirty_left,
+                           page.dirty_bottom - page.dirty_top, 0,
+                           page.pixels.data());
+    }
+    page.is_dirty = false;
+  }
+  iterator->second.has_dirty_pages = has_dirty_pages;
+}
+
+}  // namespace moui
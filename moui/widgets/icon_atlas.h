@@ -0,0 +1,163 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_ICON_ATLAS_H_
+#define MOUI_WIDGETS_ICON_ATLAS_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/core/shelf_packer.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `IconAtlas` class packs small images such as icons into shared atlas
+// pages, so lists drawing an icon in every row draw from a few textures
+// instead of switching textures for every row. Icons are registered by name
+// and are decoded and packed into the atlas of a context on first use
+// through `PrepareIcon()`. The changed pages are uploaded once per frame by
+// `WidgetView` through `UpdatePages()`.
+//
+// Icons are drawn through image patterns of their atlas pages, either with
+// `DrawIcon()` or with the paint returned by `GetIconPattern()` for custom
+// shapes. Images larger than `kMaximumIconSize` pixels in any dimension are
+// not packed and should be drawn as individual images instead. The class is
+// not thread-safe and should only be used on the render thread.
+class IconAtlas {
+ public:
+  // The maximum width and height of an icon in pixels.
+  static constexpr int kMaximumIconSize = 256;
+
+  // The location of a packed icon.
+  struct Icon {
+    // The nanovg image of the atlas page containing the icon.
+    int image;
+    // The bounds of the icon in the page in pixels.
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  // Returns the atlas shared by the application.
+  static IconAtlas* GetSharedAtlas();
+
+  // Registers the image at the specified path as an icon with the specified
+  // name. The image is loaded when the icon is first prepared for a context.
+  void AddIcon(const std::string& name, const std::string& path);
+
+  // Draws the icon with the specified name to fill the specified rectangle.
+  // Returns `false` without drawing anything if the icon is not available in
+  // the context's atlas.
+  bool DrawIcon(NVGcontext* context, const std::string& name, const float x,
+                const float y, const float width, const float height,
+                const float alpha);
+
+  // Retrieves the location of the icon with the specified name in the
+  // context's atlas. Returns `false` if the icon is not prepared, cannot be
+  // packed or its page has not been uploaded yet.
+  bool GetIcon(NVGcontext* context, const std::string& name,
+               Icon* icon) const;
+
+  // Returns the image pattern that maps the icon to the specified rectangle.
+  // Filling any path within the rectangle with the pattern draws the
+  // corresponding part of the icon.
+  NVGpaint GetIconPattern(NVGcontext* context, const Icon& icon,
+                          const float x, const float y, const float width,
+                          const float height, const float alpha) const;
+
+  // Returns the number of atlas pages created for the specified context.
+  int GetNumberOfPages(NVGcontext* context) const;
+
+  // Packs the icon with the specified name into the context's atlas if not
+  // packed yet. The icon becomes available after the next `UpdatePages()`
+  // call. Returns `false` if the icon is not registered or cannot be packed.
+  bool PrepareIcon(NVGcontext* context, const std::string& name);
+
+  // Deletes the atlas pages of the specified context. This method must be
+  // called before the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Uploads the regions of the pages changed by `PrepareIcon()`. This method
+  // must not be called between `nvgBeginFrame()` and `nvgEndFrame()`.
+  void UpdatePages(NVGcontext* context);
+
+ private:
+  // The location of an icon in the atlas.
+  struct Entry {
+    // The index of the page containing the icon, or -1 if the icon cannot be
+    // packed.
+    int page;
+    // The bounds of the icon in the page.
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  // An atlas page containing icons.
+  struct Page {
+    // The bounds of the pixels changed since `image` was last updated, which
+    // are only valid if `is_dirty` is `true` and `image` is created.
+    int dirty_bottom;
+    int dirty_left;
+    int dirty_right;
+    int dirty_top;
+    // The nanovg image of the page, or -1 if not created yet.
+    int image;
+    // Indicates whether `pixels` has changed since `image` was updated.
+    bool is_dirty;
+    // The RGBA pixels of the page.
+    std::vector<unsigned char> pixels;
+  };
+
+  // The atlas of a nanovg context.
+  struct Atlas {
+    Atlas();
+
+    // Indicates whether any page is dirty.
+    bool has_dirty_pages;
+    // The packed icons keyed by names.
+    std::unordered_map<std::string, Entry> icons;
+    // Places the icons in `pages`.
+    ShelfPacker packer;
+    std::vector<Page> pages;
+  };
+
+  IconAtlas();
+  ~IconAtlas();
+
+  // Places an icon of the specified size in the atlas and stores its
+  // location in `entry`. Returns `false` if the icon is too large.
+  bool AllocateIcon(const int width, const int height, Atlas* atlas,
+                    Entry* entry);
+
+  // The atlases keyed by nanovg contexts.
+  std::unordered_map<NVGcontext*, Atlas> atlases_;
+
+  // The paths of registered icons keyed by names.
+  std::unordered_map<std::string, std::string> icon_paths_;
+
+  DISALLOW_COPY_AND_ASSIGN(IconAtlas);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_ICON_ATLAS_H_
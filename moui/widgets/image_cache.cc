@@ -0,0 +1,106 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/image_cache.h"
+
+#include <cstddef>
+#include <string>
+
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/nanovg_hook.h"
+
+namespace {
+
+// The default maximum number of bytes to be used by cached textures.
+const size_t kDefaultByteBudget = 64 * 1024 * 1024;
+
+// Deletes the image evicted from the cache.
+void DeleteImage(NVGcontext* context, int image) {
+  moui::nvgDeleteImage(context, &image);
+}
+
+}  // namespace
+
+namespace moui {
+
+ImageCache::ImageCache() : cache_(kDefaultByteBudget, DeleteImage) {
+}
+
+ImageCache::~ImageCache() {
+}
+
+int ImageCache::AddImage(NVGcontext* context, const std::string& key,
+                         const int image) {
+  if (image < 0)
+    return -1;
+
+  // Estimates the texture size as RGBA pixels.
+  int width = 0;
+  int height = 0;
+  nvgImageSize(context, image, &width, &height);
+  const int kImage = cache_.Add(context, key, image,
+                                static_cast<size_t>(width) * height * 4);
+  if (kImage == image) {
+    GpuMemoryTracker::GetSharedTracker()->ChangeOwner(context, image, this,
+                                                      "moui::ImageCache");
+  }
+  return kImage;
+}
+
+void ImageCache::EvictUnreferencedImages(NVGcontext* context) {
+  cache_.EvictUnreferenced(context);
+}
+
+int ImageCache::FindImage(NVGcontext* context, const std::string& key) {
+  int image;
+  if (!cache_.Find(context, key, &image))
+    return -1;
+  return image;
+}
+
+std::string ImageCache::GetImageKey(const std::string& path,
+                                    const int image_flags,
+                                    const int pixel_width,
+                                    const int pixel_height) {
+  return path + "|" + std::to_string(image_flags) + "|" +
+         std::to_string(pixel_width) + "x" + std::to_string(pixel_height);
+}
+
+ImageCache* ImageCache::GetSharedCache() {
+  static ImageCache* shared_cache = new ImageCache;
+  return shared_cache;
+}
+
+void ImageCache::ReleaseImage(NVGcontext* context, const int image) {
+  cache_.Release(context, image);
+}
+
+void ImageCache::RemoveContext(NVGcontext* context) {
+  cache_.RemoveContext(context);
+}
+
+int ImageCache::RetainImage(NVGcontext* context, const std::string& path,
+                            const int image_flags) {
+  const std::string kKey = GetImageKey(path, image_flags, 0, 0);
+  const int kImage = FindImage(context, kKey);
+  if (kImage >= 0)
+    return kImage;
+  return AddImage(context, kKey,
+                  nvgCreateImageAtPath(context, path, image_flags));
+}
+
+}  // namespace moui
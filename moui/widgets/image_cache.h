@@ -0,0 +1,103 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_IMAGE_CACHE_H_
+#define MOUI_WIDGETS_IMAGE_CACHE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/resource_cache.h"
+
+namespace moui {
+
+// The `ImageCache` class shares nanovg images across widgets. Images are
+// keyed by the nanovg context, the path and the decode parameters, and are
+// reference counted: every successful `RetainImage()`, `FindImage()` or
+// `AddImage()` call must be balanced by a `ReleaseImage()` call. Released
+// images stay in the cache and are deleted in least recently released
+// order once the total size of the cached textures exceeds the byte budget.
+// Images still referenced are never evicted. The bookkeeping is shared with
+// `RasterizationCache` through `ResourceCache`.
+//
+// Evicting an image deletes its texture, so `ReleaseImage()` and the other
+// methods that may evict images must not be called between
+// `nvgBeginFrame()` and `nvgEndFrame()`. This class is not thread-safe and
+// must be used on the main thread.
+class ImageCache {
+ public:
+  // Returns the cache shared by the entire process.
+  static ImageCache* GetSharedCache();
+
+  // Returns the key identifying an image decoded from `path` with the
+  // specified nanovg image flags and downsampled for the specified pixel
+  // size. A pixel size of 0 means the full resolution.
+  static std::string GetImageKey(const std::string& path,
+                                 const int image_flags,
+                                 const int pixel_width,
+                                 const int pixel_height);
+
+  // Adds an image created by the caller to the cache with the specified key
+  // and retains it. The cache takes the ownership of `image`. If an image is
+  // already cached with the key, `image` is deleted and the cached one is
+  // retained instead. Returns the retained image.
+  int AddImage(NVGcontext* context, const std::string& key, const int image);
+
+  // Deletes all images of the context that are not referenced. This method
+  // is called on memory warnings.
+  void EvictUnreferencedImages(NVGcontext* context);
+
+  // Retains and returns the image cached with the specified key, or returns
+  // -1 if no such image is cached.
+  int FindImage(NVGcontext* context, const std::string& key);
+
+  // Releases the image previously retained from the cache. The image may be
+  // deleted immediately if the cache exceeds its budget.
+  void ReleaseImage(NVGcontext* context, const int image);
+
+  // Deletes all images of the context including the referenced ones. This
+  // method must be called before the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Retains and returns the image at the specified path, which is created by
+  // `nvgCreateImageAtPath()` if not cached. Returns -1 on failure.
+  int RetainImage(NVGcontext* context, const std::string& path,
+                  const int image_flags);
+
+  // Accessors and setters.
+  size_t byte_budget() const { return cache_.byte_budget(); }
+  void set_byte_budget(const size_t byte_budget) {
+    cache_.set_byte_budget(byte_budget);
+  }
+  size_t number_of_bytes() const { return cache_.number_of_bytes(); }
+  int number_of_images() const { return cache_.size(); }
+
+ private:
+  ImageCache();
+  ~ImageCache();
+
+  // The reference-counted images.
+  ResourceCache<int> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageCache);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_IMAGE_CACHE_H_
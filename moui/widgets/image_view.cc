@@ -0,0 +1,222 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/image_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "moui/core/device.h"
+#include "moui/core/image_loader.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/image_cache.h"
+#include "moui/widgets/widget.h"
+
+namespace moui {
+
+ImageView::ImageView() : ImageView("") {
+}
+
+ImageView::ImageView(const std::string& image_path)
+    : content_mode_(ContentMode::kScaleToFill), context_(nullptr),
+      image_(-1), image_flags_(0), image_path_(image_path),
+      image_pixel_height_(0), image_pixel_width_(0),
+      placeholder_color_(nvgRGBA(0, 0, 0, 0)), request_id_(0),
+      requested_pixel_height_(0), requested_pixel_width_(0) {
+}
+
+ImageView::~ImageView() {
+  CancelRequest();
+  ReleaseImage();
+}
+
+void ImageView::CancelRequest() {
+  if (request_id_ != 0) {
+    ImageLoader::GetSharedLoader()->CancelRequest(request_id_);
+    request_id_ = 0;
+  }
+  bitmap_.reset();
+  requested_pixel_height_ = 0;
+  requested_pixel_width_ = 0;
+}
+
+void ImageView::ContextWillChange(NVGcontext* context) {
+  Widget::ContextWillChange(context);
+  CancelRequest();
+  ReleaseImage();
+}
+
+void ImageView::ReleaseImage() {
+  if (image_ < 0)
+    return;
+
+  ImageCache::GetSharedCache()->ReleaseImage(context_, image_);
+  context_ = nullptr;
+  image_ = -1;
+  image_pixel_height_ = 0;
+  image_pixel_width_ = 0;
+}
+
+void ImageView::Render(NVGcontext* context) {
+  const float kWidth = GetWidth();
+  const float kHeight = GetHeight();
+  if (image_ < 0) {
+    if (placeholder_color_.a > 0) {
+      nvgBeginPath(context);
+      nvgRect(context, 0, 0, kWidth, kHeight);
+      nvgFillColor(context, placeholder_color_);
+      nvgFill(context);
+    }
+    return;
+  }
+
+  // Determines the image's rectangle according to the content mode.
+  float x = 0;
+  float y = 0;
+  float width = kWidth;
+  float height = kHeight;
+  int image_width = 0;
+  int image_height = 0;
+  nvgImageSize(context, image_, &image_width, &image_height);
+  if (content_mode_ != ContentMode::kScaleToFill && image_width > 0 &&
+      image_height > 0) {
+    const float kHorizontalScale = kWidth / image_width;
+    const float kVerticalScale = kHeight / image_height;
+    const float kScale = content_mode_ == ContentMode::kAspectFit ?
+                         std::min(kHorizontalScale, kVerticalScale) :
+                         std::max(kHorizontalScale, kVerticalScale);
+    width = image_width * kScale;
+    height = image_height * kScale;
+    x = (kWidth - width) / 2;
+    y = (kHeight - height) / 2;
+  }
+
+  // Fills the part of the image within the bounds.
+  const float kLeft = std::max(0.0f, x);
+  const float kTop = std::max(0.0f, y);
+  const float kRight = std::min(kWidth, x + width);
+  const float kBottom = std::min(kHeight, y + height);
+  nvgBeginPath(context);
+  nvgRect(context, kLeft, kTop, kRight - kLeft, kBottom - kTop);
+  nvgFillPaint(context,
+               nvgImagePattern(context, x, y, width, height, 0, image_, 1));
+  nvgFill(context);
+}
+
+void ImageView::SetImage(NVGcontext* context, const int image,
+                         const int pixel_width, const int pixel_height) {
+  ReleaseImage();
+  if (image < 0)
+    return;
+
+  context_ = context;
+  image_ = image;
+  image_pixel_height_ = pixel_height;
+  image_pixel_width_ = pixel_width;
+  Redraw();
+}
+
+bool ImageView::WidgetViewWillRender(NVGcontext* context) {
+  if (image_path_.empty())
+    return true;
+
+  ImageCache* image_cache = ImageCache::GetSharedCache();
+  if (bitmap_ != nullptr) {
+    const int kImage = nvgCreateTrackedImageRGBA(
+        context, bitmap_->width, bitmap_->height, image_flags_,
+        bitmap_->pixels.data());
+    bitmap_.reset();
+    const std::string kKey = ImageCache::GetImageKey(
+        image_path_, image_flags_, requested_pixel_width_,
+        requested_pixel_height_);
+    SetImage(context, image_cache->AddImage(context, kKey, kImage),
+             requested_pixel_width_, requested_pixel_height_);
+  }
+
+  // Requests the image again only if it is displayed larger than it was
+  // decoded for.
+  const float kScaleFactor = \
+      Device::GetScreenScaleFactor() * GetMeasuredScale();
+  const int kPixelWidth = \
+      static_cast<int>(std::ceil(GetWidth() * kScaleFactor));
+  const int kPixelHeight = \
+      static_cast<int>(std::ceil(GetHeight() * kScaleFactor));
+  if (kPixelWidth <= 0 || kPixelHeight <= 0 || request_id_ != 0 ||
+      (image_ >= 0 && kPixelWidth <= image_pixel_width_ &&
+       kPixelHeight <= image_pixel_height_) ||
+      (kPixelWidth == requested_pixel_width_ &&
+       kPixelHeight == requested_pixel_height_)) {
+    return true;
+  }
+  requested_pixel_height_ = kPixelHeight;
+  requested_pixel_width_ = kPixelWidth;
+
+  const int kCachedImage = image_cache->FindImage(
+      context, ImageCache::GetImageKey(image_path_, image_flags_, kPixelWidth,
+                                       kPixelHeight));
+  if (kCachedImage >= 0) {
+    SetImage(context, kCachedImage, kPixelWidth, kPixelHeight);
+    return true;
+  }
+  request_id_ = ImageLoader::GetSharedLoader()->LoadImage(
+      image_path_, kPixelWidth, kPixelHeight,
+      [this](ImageLoader::Bitmap* bitmap) {
+        request_id_ = 0;
+        if (bitmap == nullptr)
+          return;
+        bitmap_.reset(new ImageLoader::Bitmap);
+        std::swap(*bitmap_, *bitmap);
+        Redraw();
+      });
+  return true;
+}
+
+void ImageView::set_content_mode(const ContentMode content_mode) {
+  if (content_mode != content_mode_) {
+    content_mode_ = content_mode;
+    Redraw();
+  }
+}
+
+void ImageView::set_image_flags(const int image_flags) {
+  if (image_flags != image_flags_) {
+    CancelRequest();
+    ReleaseImage();
+    image_flags_ = image_flags;
+    Redraw();
+  }
+}
+
+void ImageView::set_image_path(const std::string& image_path) {
+  if (image_path != image_path_) {
+    CancelRequest();
+    ReleaseImage();
+    image_path_ = image_path;
+    Redraw();
+  }
+}
+
+void ImageView::set_placeholder_color(const NVGcolor placeholder_color) {
+  if (!nvgCompareColor(placeholder_color, placeholder_color_)) {
+    placeholder_color_ = placeholder_color;
+    Redraw();
+  }
+}
+
+}  // namespace moui
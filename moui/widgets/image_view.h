@@ -0,0 +1,135 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_IMAGE_VIEW_H_
+#define MOUI_WIDGETS_IMAGE_VIEW_H_
+
+#include <memory>
+#include <string>
+
+#include "moui/base.h"
+#include "moui/core/image_loader.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/widget.h"
+
+namespace moui {
+
+// The `ImageView` widget displays an image at its path. The image is decoded
+// and downsampled to the displayed pixel size by `ImageLoader` on background
+// threads, and only the texture upload happens on the render thread. The
+// placeholder color is rendered until the image is ready. Textures are
+// shared with other image views through `ImageCache`.
+//
+// Changing the image path cancels the in-flight request, so cells reusing
+// an image view should simply set the new path in `PrepareForReuse()` or
+// when being configured.
+class ImageView : public Widget {
+ public:
+  // The ways of fitting the image into the image view's bounds.
+  enum class ContentMode {
+    // Stretches the image to fill the bounds.
+    kScaleToFill,
+    // Scales the image to fit the bounds while preserving its aspect ratio.
+    kAspectFit,
+    // Scales the image to fill the bounds while preserving its aspect ratio.
+    // The part of the image outside the bounds is clipped.
+    kAspectFill,
+  };
+
+  ImageView();
+  explicit ImageView(const std::string& image_path);
+  ~ImageView();
+
+  // Returns `true` if an image is ready to render.
+  bool IsImageLoaded() const { return image_ >= 0; }
+
+  // Accessors and setters.
+  ContentMode content_mode() const { return content_mode_; }
+  void set_content_mode(const ContentMode content_mode);
+  int image_flags() const { return image_flags_; }
+  void set_image_flags(const int image_flags);
+  std::string image_path() const { return image_path_; }
+  void set_image_path(const std::string& image_path);
+  NVGcolor placeholder_color() const { return placeholder_color_; }
+  void set_placeholder_color(const NVGcolor placeholder_color);
+
+ private:
+  // Cancels the in-flight request and discards the decoded bitmap waiting
+  // for upload.
+  void CancelRequest();
+
+  // Inherited from `Widget` class. Releases the image and cancels the
+  // in-flight request since the image belongs to the previous context.
+  void ContextWillChange(NVGcontext* context) final;
+
+  // Releases the displayed image back to `ImageCache`.
+  void ReleaseImage();
+
+  // Inherited from `Widget` class. Renders the image or the placeholder.
+  void Render(NVGcontext* context) final;
+
+  // Replaces the displayed image with the specified image retained from
+  // `ImageCache` for the specified pixel size.
+  void SetImage(NVGcontext* context, const int image, const int pixel_width,
+                const int pixel_height);
+
+  // Inherited from `Widget` class. Uploads the decoded bitmap, or looks up
+  // the image for the displayed pixel size in `ImageCache` and requests
+  // decoding it on a cache miss.
+  bool WidgetViewWillRender(NVGcontext* context) final;
+
+  // The decoded bitmap waiting to be uploaded in `WidgetViewWillRender()`.
+  std::unique_ptr<ImageLoader::Bitmap> bitmap_;
+
+  // The way of fitting the image into the bounds. The default value is
+  // `ContentMode::kScaleToFill`.
+  ContentMode content_mode_;
+
+  // The context of `image_`.
+  NVGcontext* context_;
+
+  // The displayed image retained from `ImageCache`, or -1 if not loaded.
+  int image_;
+
+  // The nanovg image flags for creating the image. The default value is 0.
+  int image_flags_;
+
+  // The path of the image to display.
+  std::string image_path_;
+
+  // The pixel size `image_` was decoded for.
+  int image_pixel_height_;
+  int image_pixel_width_;
+
+  // The color rendered until the image is loaded. The default color is
+  // transparent.
+  NVGcolor placeholder_color_;
+
+  // The id of the in-flight `ImageLoader` request, or 0 if there is none.
+  int request_id_;
+
+  // The pixel size of the last request. The same size is not requested
+  // again if the request failed.
+  int requested_pixel_height_;
+  int requested_pixel_width_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageView);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_IMAGE_VIEW_H_
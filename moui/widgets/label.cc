@@ -22,8 +22,12 @@
 #include <cfloat>
 #include <cmath>
 #include <string>
+#include <vector>
 
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/font_registry.h"
+#include "moui/widgets/glyph_atlas.h"
+#include "moui/widgets/text_measurement_cache.h"
 
 namespace {
 
@@ -38,6 +42,7 @@ const float kMinimumFontSize = 1;
 
 // Default configuration for the label.
 std::string default_font_name;
+int default_font_name_version = 0;
 float default_font_baseline = 0;
 float default_font_size = 12;
 float default_font_size_scale = 1;
@@ -55,18 +60,97 @@ Label::Label(const std::string& text) : Label(text, "") {
 Label::Label(const std::string& text, const std::string& font_name)
     : adjusts_font_size_to_fit_width_(false),
       adjusts_label_height_to_fit_width_(false), font_baseline_(FLT_MIN),
-      font_name_(font_name), font_size_(0), font_size_scale_(0),
+      font_handle_(-1), font_handle_version_(0), font_name_(font_name),
+      font_size_(0), font_size_scale_(0),
       line_height_(1), minimum_scale_factor_(0), number_of_lines_(1),
       should_prepare_for_rendering_(true), text_(text),
       text_horizontal_alignment_(Alignment::kLeft),
-      text_vertical_alignment_(Alignment::kTop) {
+      text_vertical_alignment_(Alignment::kTop), uses_scalable_glyphs_(false),
+      uses_scalable_glyphs_version_(-1) {
   set_text_color(nvgRGBA(0, 0, 0, 255));
+  text_layout_.glyph_font_size = 0;
+  text_layout_.width = -1;  // invalidates the text layout
 }
 
 Label::~Label() {
 }
 
+void Label::BreakTextIntoRows(NVGcontext* context, const float width,
+                              const int maximum_number_of_rows,
+                              TextLayout* layout) const {
+  std::vector<NVGtextRow> text_rows(maximum_number_of_rows);
+  const char* kText = text_.c_str();
+  const char* kTextEnd = kText + text_.size();
+  const int kNumberOfRows = nvgTextBreakLines(
+      context, kText, kTextEnd, width, text_rows.data(),
+      maximum_number_of_rows);
+
+  // The vertical extent of a row only depends on the font, so measuring the
+  // first row is enough.
+  float bounds[4] = {0, 0, 0, 0};  // bounds of the row string
+  if (kNumberOfRows > 0) {
+    nvgTextBounds(context, 0, 0, text_rows[0].start, text_rows[0].end,
+                  bounds);
+  }
+  float line_height = 0;
+  nvgTextMetrics(context, nullptr, nullptr, &line_height);
+
+  layout->rows.clear();
+  for (int i = 0; i < kNumberOfRows; ++i) {
+    const NVGtextRow& row = text_rows[i];
+    layout->rows.push_back({static_cast<size_t>(row.start - kText),
+                            static_cast<size_t>(row.end - kText),
+                            row.width, {}});
+  }
+  layout->is_complete = kNumberOfRows == 0 ||
+                        text_rows[kNumberOfRows - 1].end == kTextEnd;
+  layout->glyph_font_size = 0;
+  layout->row_advance = line_height * line_height_;
+  layout->row_max_y = bounds[3];
+  layout->row_min_y = bounds[1];
+  layout->text_box_height = \
+      kNumberOfRows * (bounds[3] - bounds[1]) * line_height_;
+}
+
 void Label::ConfigureTextAttributes(NVGcontext* context) {
+  nvgFillColor(context, text_color_);
+  nvgFontFaceId(context, FontRegistry::GetSharedRegistry()->GetFontId(
+      context, GetFontHandle()));
+  nvgFontSize(context, font_size_to_render_ * font_size_scale());
+  nvgTextAlign(context, GetTextAlignment());
+  nvgTextLineHeight(context, line_height_);
+  nvgTextLetterSpacing(context, 0);
+}
+
+int Label::GetFontHandle() {
+  if (font_handle_ < 0 ||
+      (font_name_.empty() &&
+       font_handle_version_ != default_font_name_version)) {
+    font_handle_ = FontRegistry::GetSharedRegistry()->GetFontHandle(
+        font_name());
+    font_handle_version_ = default_font_name_version;
+    uses_scalable_glyphs_version_ = -1;
+  }
+  return font_handle_;
+}
+
+float Label::GetHeightToFitWidth(NVGcontext* context, const float width) {
+  if (text_.empty() || width <= 0)
+    return 0;
+
+  const float kFontSizeToRender = font_size_to_render_;
+  font_size_to_render_ = font_size_ > 0 ? font_size_ : default_font_size;
+  ConfigureTextAttributes(context);
+
+  const int kExpectedNumberOfLines = number_of_lines_ == 0 ?
+                                     kMaximumNumberOfLines : number_of_lines_;
+  TextLayout layout;
+  BreakTextIntoRows(context, width, kExpectedNumberOfLines, &layout);
+  font_size_to_render_ = kFontSizeToRender;
+  return layout.text_box_height;
+}
+
+int Label::GetTextAlignment() const {
   int horizontal_alignment;
   switch (text_horizontal_alignment_) {
     case Alignment::kLeft: horizontal_alignment = NVG_ALIGN_LEFT; break;
@@ -74,12 +158,12 @@ void Label::ConfigureTextAttributes(NVGcontext* context) {
     case Alignment::kRight: horizontal_alignment = NVG_ALIGN_RIGHT; break;
     default: assert(false);
   }
-  nvgFillColor(context, text_color_);
-  nvgFontFace(context, font_name().c_str());
-  nvgFontSize(context, font_size_to_render_ * font_size_scale());
-  nvgTextAlign(context, horizontal_alignment | NVG_ALIGN_TOP);
-  nvgTextLineHeight(context, line_height_);
-  nvgTextLetterSpacing(context, 0);
+  return horizontal_alignment | NVG_ALIGN_TOP;
+}
+
+void Label::HandleMemoryWarning(NVGcontext* context) {
+  Widget::HandleMemoryWarning(context);
+  should_prepare_for_rendering_ = true;
 }
 
 void Label::Redraw() {
@@ -88,28 +172,65 @@ void Label::Redraw() {
 }
 
 void Label::Render(NVGcontext* context) {
-  if (text_to_render_.empty())
+  const std::vector<TextRow>& kRows = text_layout_.rows;
+  if (kRows.empty())
     return;
 
   ConfigureTextAttributes(context);
-  float y;  // the vertical position that will be passed to nvgTextBox()
-  float bounds[4];  // bounds of the text
-  nvgTextBoxBounds(context, 0, 0, GetWidth(), text_to_render_.c_str(), NULL,
-                   bounds);
+  // Determines the bounds of the text box the same way as
+  // `nvgTextBoxBounds()` but without breaking the text again.
+  const float kTextBoxTop = std::min(0.0f, text_layout_.row_min_y);
+  const float kTextBoxBottom = std::max(
+      0.0f,
+      (kRows.size() - 1) * text_layout_.row_advance + text_layout_.row_max_y);
+  float y;  // the vertical position of the first row
   switch (text_vertical_alignment_) {
     case Alignment::kTop:
-      y = -bounds[1] + font_baseline();
+      y = -kTextBoxTop + font_baseline();
       break;
     case Alignment::kMiddle:
-      y = (GetHeight() - (bounds[3] - bounds[1])) / 2 + font_baseline();
+      y = (GetHeight() - (kTextBoxBottom - kTextBoxTop)) / 2
+          + font_baseline();
       break;
     case Alignment::kBottom:
-      y = GetHeight() - bounds[3] + font_baseline();
+      y = GetHeight() - kTextBoxBottom + font_baseline();
       break;
     default:
       assert(false);
   }
-  nvgTextBox(context, 0, y, GetWidth(), text_to_render_.c_str(), NULL);
+
+  // Draws the cached rows directly like `nvgTextBox()` does. Rows in fonts
+  // using scalable glyphs are drawn with the cached glyph positions and fall
+  // back to `nvgText()` if the glyphs are not ready.
+  GlyphAtlas* glyph_atlas = GlyphAtlas::GetSharedAtlas();
+  const int kFontHandle = GetFontHandle();
+  const bool kUsesScalableGlyphs = UsesScalableGlyphs();
+  const float kFontSize = font_size_to_render_ * font_size_scale();
+  const bool kHasGlyphPositions = \
+      kUsesScalableGlyphs && text_layout_.glyph_font_size == kFontSize;
+  const float kWidth = GetWidth();
+  const char* kText = text_layout_.text.c_str();
+  nvgTextAlign(context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+  for (const TextRow& row : kRows) {
+    float x = 0;
+    if (text_horizontal_alignment_ == Alignment::kCenter)
+      x = (kWidth - row.width) / 2;
+    else if (text_horizontal_alignment_ == Alignment::kRight)
+      x = kWidth - row.width;
+    bool did_draw = false;
+    if (kHasGlyphPositions) {
+      did_draw = glyph_atlas->DrawGlyphs(
+          context, kFontHandle, kFontSize, text_color_, x, y,
+          text_layout_.glyph_ascender, row.glyph_positions);
+    } else if (kUsesScalableGlyphs) {
+      did_draw = glyph_atlas->DrawText(context, kFontHandle, kFontSize,
+                                       text_color_, x, y, kText + row.begin,
+                                       kText + row.end);
+    }
+    if (!did_draw)
+      nvgText(context, x, y, kText + row.begin, kText + row.end);
+    y += text_layout_.row_advance;
+  }
 }
 
 void Label::SetDefaultFontBaseline(const float font_baseline) {
@@ -117,7 +238,10 @@ void Label::SetDefaultFontBaseline(const float font_baseline) {
 }
 
 void Label::SetDefaultFontName(const std::string& name) {
-  default_font_name = name;
+  if (name != default_font_name) {
+    default_font_name = name;
+    ++default_font_name_version;
+  }
 }
 
 void Label::SetDefaultFontSize(const float font_size) {
@@ -128,18 +252,100 @@ void Label::SetDefaultFontSizeScale(const float font_size_scale) {
   default_font_size_scale = font_size_scale;
 }
 
+bool Label::SetTextLayout(const TextLayoutEngine::Layout& layout) {
+  const float kFontSize = font_size_ > 0 ? font_size_ : default_font_size;
+  const float kFontSizeScale = font_size_scale();
+  const std::string kFontName = font_name();
+  if (adjusts_font_size_to_fit_width_ || layout.font_name != kFontName ||
+      layout.font_size != kFontSize * kFontSizeScale ||
+      layout.line_height != line_height_ ||
+      layout.maximum_number_of_rows != number_of_lines_ ||
+      layout.width != GetWidth() || layout.text != text_) {
+    return false;
+  }
+
+  const size_t kNumberOfRows = std::min(
+      layout.rows.size(),
+      static_cast<size_t>(number_of_lines_ == 0 ? kMaximumNumberOfLines :
+                                                  number_of_lines_));
+  text_layout_.rows.clear();
+  for (size_t i = 0; i < kNumberOfRows; ++i) {
+    const TextLayoutEngine::Row& kRow = layout.rows[i];
+    text_layout_.rows.push_back({kRow.begin, kRow.end, kRow.width, {}});
+  }
+  // The vertical extent of a row is the same as the one measured by
+  // `nvgTextBounds()` for top-aligned text.
+  text_layout_.is_complete = \
+      layout.is_complete && kNumberOfRows == layout.rows.size();
+  text_layout_.font_size_to_render = kFontSize;
+  text_layout_.glyph_font_size = 0;
+  text_layout_.row_advance = layout.row_height * line_height_;
+  text_layout_.row_max_y = layout.row_height;
+  text_layout_.row_min_y = 0;
+  text_layout_.text_box_height = \
+      kNumberOfRows * layout.row_height * line_height_;
+
+  text_layout_.adjusts_font_size_to_fit_width = false;
+  text_layout_.font_name = kFontName;
+  text_layout_.font_size = kFontSize;
+  text_layout_.font_size_scale = kFontSizeScale;
+  text_layout_.height = 0;
+  text_layout_.line_height = line_height_;
+  text_layout_.minimum_scale_factor = minimum_scale_factor_;
+  text_layout_.number_of_lines = number_of_lines_;
+  text_layout_.text = text_;
+  text_layout_.width = layout.width;
+  Redraw();
+  return true;
+}
+
+bool Label::UsesScalableGlyphs() {
+  const int kFontHandle = GetFontHandle();
+  const GlyphAtlas* kGlyphAtlas = GlyphAtlas::GetSharedAtlas();
+  if (uses_scalable_glyphs_version_ != kGlyphAtlas->scalable_fonts_version()) {
+    uses_scalable_glyphs_ = kGlyphAtlas->FontUsesScalableGlyphs(kFontHandle);
+    uses_scalable_glyphs_version_ = kGlyphAtlas->scalable_fonts_version();
+  }
+  return uses_scalable_glyphs_;
+}
+
+void Label::UpdateGlyphPositions() {
+  const float kFontSize = font_size_to_render_ * font_size_scale();
+  if (text_layout_.glyph_font_size == kFontSize)
+    return;
+
+  TextLayoutEngine* engine = TextLayoutEngine::GetSharedEngine();
+  const int kFontIndex = \
+      FontRegistry::GetSharedRegistry()->GetEngineFontIndex(GetFontHandle());
+  const char* kText = text_layout_.text.c_str();
+  for (TextRow& row : text_layout_.rows) {
+    if (!engine->GetGlyphPositions(kFontIndex, kFontSize, kText + row.begin,
+                                   kText + row.end, &row.glyph_positions,
+                                   &text_layout_.glyph_ascender)) {
+      for (TextRow& row_to_clear : text_layout_.rows)
+        row_to_clear.glyph_positions.clear();
+      text_layout_.glyph_font_size = 0;
+      return;
+    }
+  }
+  text_layout_.glyph_font_size = kFontSize;
+}
+
 void Label::UpdateWidthToFitText(NVGcontext* context) {
   font_size_to_render_ = font_size_ > 0 ? font_size_ : default_font_size;
   if (font_size_to_render_ <= 0 || text_.empty())
     return;
 
   ConfigureTextAttributes(context);
-  float bounds[4];
+  const float kAdvance = TextMeasurementCache::GetSharedCache()->MeasureText(
+      context,
+      FontRegistry::GetSharedRegistry()->GetFontId(context, GetFontHandle()),
+      font_size_to_render_ * font_size_scale(), 0, GetTextAlignment(), text_,
+      nullptr);
 
   // This is a workaround to fix the issue that `nvgTextBounds()` may not
   // return a correct result.
-  const float kWidth = std::ceil(
-      nvgTextBounds(context, 0, 0, text_.c_str(), NULL, bounds) + 3);
+  const float kWidth = std::ceil(kAdvance + 3);
 
   if (kWidth != GetWidth())
     SetWidth(kWidth);
@@ -150,75 +356,112 @@ void Label::UpdateWidthToFitText(NVGcontext* context) {
 // `number_of_lines_` properties. It also calculates the required height to
 // render the desired result, and increases the label's height or adjusts the
 // label's position accordingly if `adjusts_label_height_to_fit_width_` is
-// set to `true`.
+// set to `true`. The broken rows are cached in `text_layout_` and reused until
+// any attribute affecting the layout changes.
 bool Label::WidgetViewWillRender(NVGcontext* context) {
   const float kLabelWidth = GetWidth();
   const float kLabelHeight = GetHeight();
   if ((!adjusts_label_height_to_fit_width_ && kLabelHeight <= 0) ||
       (adjusts_label_height_to_fit_width_ && kLabelWidth <= 0) ||
       text_.empty()) {
-    text_to_render_.clear();
+    text_layout_.rows.clear();
+    text_layout_.width = -1;  // invalidates the text layout
     return true;
   }
 
   if (!should_prepare_for_rendering_)
     return true;
   should_prepare_for_rendering_ = false;
-  font_size_to_render_ = font_size_ > 0 ? font_size_ : default_font_size;
 
-  const int kExpectedNumberOfLines = number_of_lines_ == 0 ?
-                                     kMaximumNumberOfLines : number_of_lines_;
-  const char* kExpectedLastCharToRender = text_.c_str() + text_.size();
-  const float kMinimumAcceptableFontSize = \
-      minimum_scale_factor_ > 0 ?
-      font_size_to_render_ * minimum_scale_factor_ * font_size_scale() :
-      kMinimumFontSize;
-  NVGtextRow text_rows[kExpectedNumberOfLines];
-  float text_box_height = 0;  // the required height to render text
-
-  while (true) {
-    ConfigureTextAttributes(context);
-    const int kActualNumberOfLines = nvgTextBreakLines(
-        context, text_.c_str(), kExpectedLastCharToRender, kLabelWidth,
-        text_rows, kExpectedNumberOfLines);
-
-    text_to_render_.clear();
-    text_box_height = 0;
-    const char* last_char_to_render = nullptr;
-    for (int i = 0; i < kActualNumberOfLines; ++i) {
-      if (i > 0) text_to_render_.append("\n");
-      NVGtextRow* row = &text_rows[i];
-      text_to_render_.append(std::string(row->start, (row->end - row->start)));
-      last_char_to_render = row->end;
-
-      // Updates the height of text box.
-      float bounds[4];  // bounds of the row string
-      nvgTextBounds(context, 0, 0, row->start, row->end, bounds);
-      text_box_height += (bounds[3] - bounds[1]) * line_height_;
-
-      // Stops populating the text to render if it's known the label's bounding
-      // box is not big enough.
-      if (adjusts_font_size_to_fit_width_ &&
-          font_size_to_render_ > kMinimumAcceptableFontSize &&
-          text_box_height > kLabelHeight)
-        break;
+  // The label's height only matters when fitting the font size.
+  const float kFontSize = font_size_ > 0 ? font_size_ : default_font_size;
+  const float kFontSizeScale = font_size_scale();
+  const std::string kFontName = font_name();
+  const float kFittingHeight = \
+      adjusts_font_size_to_fit_width_ ? kLabelHeight : 0;
+  if (text_layout_.width != kLabelWidth ||
+      text_layout_.height != kFittingHeight ||
+      text_layout_.font_size != kFontSize ||
+      text_layout_.font_size_scale != kFontSizeScale ||
+      text_layout_.line_height != line_height_ ||
+      text_layout_.number_of_lines != number_of_lines_ ||
+      text_layout_.minimum_scale_factor != minimum_scale_factor_ ||
+      text_layout_.adjusts_font_size_to_fit_width != \
+          adjusts_font_size_to_fit_width_ ||
+      text_layout_.font_name != kFontName || text_layout_.text != text_) {
+    const int kExpectedNumberOfLines = \
+        number_of_lines_ == 0 ? kMaximumNumberOfLines : number_of_lines_;
+    const float kMinimumAcceptableFontSize = \
+        minimum_scale_factor_ > 0 ?
+        kFontSize * minimum_scale_factor_ * kFontSizeScale :
+        kMinimumFontSize;
+
+    // The candidate font sizes decrease one point at a time from `kFontSize`
+    // and end with `kMinimumAcceptableFontSize`. The text fits a smaller font
+    // size at least as well as a larger one, so the largest font size that
+    // fits is found by a binary search over the candidates.
+    int number_of_larger_candidates = 0;
+    if (adjusts_font_size_to_fit_width_ &&
+        kFontSize > kMinimumAcceptableFontSize) {
+      number_of_larger_candidates = static_cast<int>(
+          std::ceil(kFontSize - kMinimumAcceptableFontSize));
+    }
+    auto get_candidate = [&](const int index) {
+      return index < number_of_larger_candidates ?
+             kFontSize - index : kMinimumAcceptableFontSize;
+    };
+    auto break_text = [&](const float font_size) {
+      font_size_to_render_ = font_size;
+      ConfigureTextAttributes(context);
+      BreakTextIntoRows(context, kLabelWidth, kExpectedNumberOfLines,
+                        &text_layout_);
+    };
+    if (number_of_larger_candidates == 0) {
+      break_text(kFontSize);
+    } else {
+      int first_index = 0;
+      int last_index = number_of_larger_candidates;
+      while (first_index < last_index) {
+        const int kMiddleIndex = (first_index + last_index) / 2;
+        break_text(get_candidate(kMiddleIndex));
+        if (text_layout_.is_complete &&
+            text_layout_.text_box_height < kLabelHeight) {
+          last_index = kMiddleIndex;
+        } else {
+          first_index = kMiddleIndex + 1;
+        }
+      }
+      if (font_size_to_render_ != get_candidate(first_index))
+        break_text(get_candidate(first_index));
     }
 
-    if (!adjusts_font_size_to_fit_width_ ||
-        font_size_to_render_ == kMinimumAcceptableFontSize ||
-        (text_box_height < kLabelHeight &&
-         last_char_to_render == kExpectedLastCharToRender))
-      break;
-
-    // Reduces the font size and try again.
-    font_size_to_render_ = std::max(kMinimumAcceptableFontSize,
-                                    font_size_to_render_ - 1);
-    nvgFontSize(context, font_size_to_render_);
+    text_layout_.adjusts_font_size_to_fit_width = \
+        adjusts_font_size_to_fit_width_;
+    text_layout_.font_name = kFontName;
+    text_layout_.font_size = kFontSize;
+    text_layout_.font_size_scale = kFontSizeScale;
+    text_layout_.font_size_to_render = font_size_to_render_;
+    text_layout_.height = kFittingHeight;
+    text_layout_.line_height = line_height_;
+    text_layout_.minimum_scale_factor = minimum_scale_factor_;
+    text_layout_.number_of_lines = number_of_lines_;
+    text_layout_.text = text_;
+    text_layout_.width = kLabelWidth;
+  }
+  font_size_to_render_ = text_layout_.font_size_to_render;
+
+  // Rasterizes the glyphs missing in the glyph atlas and positions the glyphs
+  // of the rows before rendering.
+  if (UsesScalableGlyphs()) {
+    GlyphAtlas::GetSharedAtlas()->PrepareText(context, GetFontHandle(),
+                                              text_);
+    UpdateGlyphPositions();
   }
 
   // Adjusts label height to fit width.
-  if (adjusts_label_height_to_fit_width_ && text_box_height != kLabelHeight)
-    SetHeight(Widget::Unit::kPoint, text_box_height);
+  const float kTextBoxHeight = text_layout_.text_box_height;
+  if (adjusts_label_height_to_fit_width_ && kTextBoxHeight != kLabelHeight)
+    SetHeight(Widget::Unit::kPoint, kTextBoxHeight);
 
   return true;
 }
@@ -260,6 +503,7 @@ std::string Label::font_name() const {
 void Label::set_font_name(const std::string& name) {
   if (font_name_ != name) {
     font_name_ = name;
+    font_handle_ = -1;
     Redraw();
   }
 }
@@ -18,9 +18,12 @@
 #ifndef MOUI_WIDGETS_LABEL_H_
 #define MOUI_WIDGETS_LABEL_H_
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "moui/base.h"
+#include "moui/core/text_layout_engine.h"
 #include "moui/nanovg_hook.h"
 #include "moui/widgets/widget.h"
 
@@ -43,6 +46,11 @@ class Label : public Widget {
   Label(const std::string& text, const std::string& font_name);
   ~Label();
 
+  // Returns the height required to render the text within the specified
+  // width without changing the label's font size. The `number_of_lines_` and
+  // `line_height_` properties are respected.
+  float GetHeightToFitWidth(NVGcontext* context, const float width);
+
   // Inherited from `Widget` class;
   void Redraw() final;
 
@@ -58,6 +66,14 @@ class Label : public Widget {
   // Sets the default font size scale.
   static void SetDefaultFontSizeScale(const float font_size_scale);
 
+  // Adopts the rows broken by `TextLayoutEngine` instead of breaking the text
+  // again before rendering. The layout is only adopted if it was laid out
+  // with the label's current font name, font size multiplied by the font
+  // size scale, line height, number of lines as the maximum number of rows,
+  // text and width. Labels that adjust the font size to fit the width never
+  // adopt layouts. Returns `true` if the layout is adopted.
+  bool SetTextLayout(const TextLayoutEngine::Layout& layout);
+
   // Updates the label's width to fit the text.
   void UpdateWidthToFitText(NVGcontext* context);
 
@@ -97,16 +113,84 @@ class Label : public Widget {
   void set_text_vertical_alignment(const Alignment alignment);
 
  private:
-  struct CachedLabelWidth {
-    float font_size_to_render;
+  // A row of broken text.
+  struct TextRow {
+    // The byte offset of the first character of the row in the text.
+    size_t begin;
+    // The byte offset past the last character of the row in the text.
+    size_t end;
+    // The logical width of the row.
+    float width;
+    // The positions of the glyphs in the row for drawing with scalable
+    // glyphs, which are computed at `TextLayout::glyph_font_size`.
+    std::vector<TextLayoutEngine::GlyphPosition> glyph_positions;
+  };
+
+  // The result of breaking text into rows, which is reused as long as the
+  // attributes affecting the layout don't change.
+  struct TextLayout {
+    // Attributes affecting the layout.
+    bool adjusts_font_size_to_fit_width;
     std::string font_name;
+    float font_size;
+    float font_size_scale;
+    float height;
+    float line_height;
+    float minimum_scale_factor;
+    int number_of_lines;
     std::string text;
     float width;
+
+    // Indicates whether the rows cover the entire text.
+    bool is_complete;
+    // The font size used for breaking the text.
+    float font_size_to_render;
+    // The distance from the top of a row to the baseline at
+    // `glyph_font_size`.
+    float glyph_ascender;
+    // The font size the glyph positions of the rows are computed at, or 0 if
+    // they are not computed.
+    float glyph_font_size;
+    // The vertical distance between the tops of two adjacent rows.
+    float row_advance;
+    // The vertical extent of a row relative to its top.
+    float row_max_y;
+    float row_min_y;
+    // The broken rows.
+    std::vector<TextRow> rows;
+    // The height required to render all rows.
+    float text_box_height;
   };
 
+  // Breaks `text_` into at most `maximum_number_of_rows` rows within `width`
+  // using the current text attributes, and stores the result in `layout`.
+  void BreakTextIntoRows(NVGcontext* context, const float width,
+                         const int maximum_number_of_rows,
+                         TextLayout* layout) const;
+
   // Configures text attributes through nanovg APIs.
   void ConfigureTextAttributes(NVGcontext* context);
 
+  // Returns the `FontRegistry` handle of `font_name()`. The handle is resolved
+  // again only if the font name or the default font name changes.
+  int GetFontHandle();
+
+  // Returns the nanovg text alignment flags for the label.
+  int GetTextAlignment() const;
+
+  // Computes the glyph positions of the rows in `text_layout_` at the font
+  // size to render if not computed yet, so rows in fonts using scalable
+  // glyphs are drawn without positioning the glyphs again in every frame.
+  void UpdateGlyphPositions();
+
+  // Returns `true` if `font_name()` is rendered with scalable glyphs. The
+  // result is cached until the font or the settings of `GlyphAtlas` change.
+  bool UsesScalableGlyphs();
+
+  // Inherited from `Widget` class. Prepares the scalable glyphs again as the
+  // glyph atlas is cleared on memory warnings.
+  void HandleMemoryWarning(NVGcontext* context) final;
+
   // Inherited from `Widget` class.
   void Render(NVGcontext* context) final;
 
@@ -127,6 +211,11 @@ class Label : public Widget {
   // Indicates the vertical offset of the font baseline. The default value is 0.
   float font_baseline_;
 
+  // The cached handle of `font_name()` and the version of the default font
+  // name when the handle was resolved. The handle is -1 if not resolved.
+  int font_handle_;
+  int font_handle_version_;
+
   // The font name of the font that applies to enitre string of text. Note
   // that the font name must previously registered through `nvgCreateFont()`,
   // or nothing will display on the screen.
@@ -172,9 +261,10 @@ class Label : public Widget {
   // The color of the text.
   NVGcolor text_color_;
 
-  // The actual text for rendering on screen. This value is populated
-  // automatically in `WidgetWillRender()` according to various configurations.
-  std::string text_to_render_;
+  // Caches the rows of text to render on screen. This value is populated
+  // automatically in `WidgetViewWillRender()` according to various
+  // configurations.
+  TextLayout text_layout_;
 
   // The technique to use for aligning the text horizontally. The value must
   // be one of `Alignment::kLeft`, `Alignment::kCenter`, `Alignment::kRight`.
@@ -186,6 +276,12 @@ class Label : public Widget {
   // The default value is `Alignment::kTop`.
   Alignment text_vertical_alignment_;
 
+  // The cached result of `UsesScalableGlyphs()` and the
+  // `GlyphAtlas::scalable_fonts_version()` when it was resolved. The version
+  // is -1 if the result is not resolved for the current font.
+  bool uses_scalable_glyphs_;
+  int uses_scalable_glyphs_version_;
+
   DISALLOW_COPY_AND_ASSIGN(Label);
 };
 
@@ -0,0 +1,91 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/rasterization_cache.h"
+
+#include <cstddef>
+#include <string>
+
+#include "moui/core/gpu_memory_tracker.h"
+#include "moui/nanovg_hook.h"
+
+namespace {
+
+// The default maximum number of bytes to be used by cached framebuffers.
+const size_t kDefaultByteBudget = 16 * 1024 * 1024;
+
+// Deletes the framebuffer evicted from the cache.
+void DeleteFramebuffer(NVGcontext* context, NVGframebuffer* framebuffer) {
+  nvgDeleteFramebuffer(framebuffer);
+}
+
+}  // namespace
+
+namespace moui {
+
+RasterizationCache::RasterizationCache()
+    : cache_(kDefaultByteBudget, DeleteFramebuffer) {
+}
+
+RasterizationCache::~RasterizationCache() {
+}
+
+NVGframebuffer* RasterizationCache::AddFramebuffer(
+    NVGcontext* context, const std::string& key, NVGframebuffer* framebuffer) {
+  if (framebuffer == nullptr)
+    return nullptr;
+
+  // Estimates the texture size as RGBA pixels.
+  int width = 0;
+  int height = 0;
+  nvgImageSize(context, framebuffer->image, &width, &height);
+  NVGframebuffer* cached_framebuffer = cache_.Add(
+      context, key, framebuffer, static_cast<size_t>(width) * height * 4);
+  if (cached_framebuffer == framebuffer) {
+    GpuMemoryTracker::GetSharedTracker()->ChangeOwner(
+        context, framebuffer->image, this, "moui::RasterizationCache");
+  }
+  return cached_framebuffer;
+}
+
+void RasterizationCache::EvictUnreferencedFramebuffers(NVGcontext* context) {
+  cache_.EvictUnreferenced(context);
+}
+
+NVGframebuffer* RasterizationCache::FindFramebuffer(NVGcontext* context,
+                                                    const std::string& key) {
+  NVGframebuffer* framebuffer;
+  if (!cache_.Find(context, key, &framebuffer))
+    return nullptr;
+  return framebuffer;
+}
+
+RasterizationCache* RasterizationCache::GetSharedCache() {
+  static RasterizationCache* shared_cache = new RasterizationCache;
+  return shared_cache;
+}
+
+void RasterizationCache::ReleaseFramebuffer(NVGcontext* context,
+                                            NVGframebuffer* framebuffer) {
+  cache_.Release(context, framebuffer);
+}
+
+void RasterizationCache::RemoveContext(NVGcontext* context) {
+  cache_.RemoveContext(context);
+}
+
+}  // namespace moui
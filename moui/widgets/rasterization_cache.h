@@ -0,0 +1,94 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_RASTERIZATION_CACHE_H_
+#define MOUI_WIDGETS_RASTERIZATION_CACHE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/resource_cache.h"
+
+namespace moui {
+
+// The `RasterizationCache` class shares the rendering results of widgets
+// whose `Widget::GetRasterizationKey()` returns equal keys, so identical
+// widgets such as the switches on a settings screen hold one framebuffer
+// instead of one each. Framebuffers are keyed by the nanovg context and the
+// key, and are reference counted: every successful `FindFramebuffer()` or
+// `AddFramebuffer()` call must be balanced by a `ReleaseFramebuffer()` call.
+// Released framebuffers stay in the cache so widgets toggling between a few
+// states can reuse them, and are deleted in least recently released order
+// once the total size of the cached framebuffers exceeds the byte budget.
+// The bookkeeping is shared with `ImageCache` through `ResourceCache`.
+//
+// Evicting a framebuffer deletes it, so `ReleaseFramebuffer()` and the other
+// methods that may evict framebuffers must not be called between
+// `nvgBeginFrame()` and `nvgEndFrame()`. This class is not thread-safe and
+// must be used on the main thread.
+class RasterizationCache {
+ public:
+  // Returns the cache shared by the entire process.
+  static RasterizationCache* GetSharedCache();
+
+  // Adds a framebuffer rendered by the caller to the cache with the
+  // specified key and retains it. The cache takes the ownership of
+  // `framebuffer`. If a framebuffer is already cached with the key,
+  // `framebuffer` is deleted and the cached one is retained instead. Returns
+  // the retained framebuffer.
+  NVGframebuffer* AddFramebuffer(NVGcontext* context, const std::string& key,
+                                 NVGframebuffer* framebuffer);
+
+  // Deletes all framebuffers of the context that are not referenced. This
+  // method is called on memory warnings.
+  void EvictUnreferencedFramebuffers(NVGcontext* context);
+
+  // Retains and returns the framebuffer cached with the specified key, or
+  // returns `nullptr` if no such framebuffer is cached.
+  NVGframebuffer* FindFramebuffer(NVGcontext* context, const std::string& key);
+
+  // Releases the framebuffer previously retained from the cache. The
+  // framebuffer may be deleted immediately if the cache exceeds its budget.
+  void ReleaseFramebuffer(NVGcontext* context, NVGframebuffer* framebuffer);
+
+  // Deletes all framebuffers of the context including the referenced ones.
+  // This method must be called before the context is deleted.
+  void RemoveContext(NVGcontext* context);
+
+  // Accessors and setters.
+  size_t byte_budget() const { return cache_.byte_budget(); }
+  void set_byte_budget(const size_t byte_budget) {
+    cache_.set_byte_budget(byte_budget);
+  }
+  size_t number_of_bytes() const { return cache_.number_of_bytes(); }
+  int number_of_framebuffers() const { return cache_.size(); }
+
+ private:
+  RasterizationCache();
+  ~RasterizationCache();
+
+  // The reference-counted framebuffers.
+  ResourceCache<NVGframebuffer*> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(RasterizationCache);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_RASTERIZATION_CACHE_H_
@@ -0,0 +1,227 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_RESOURCE_CACHE_H_
+#define MOUI_WIDGETS_RESOURCE_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `ResourceCache` class template keeps reference-counted GPU resources
+// such as nanovg images or framebuffers keyed by the nanovg context and a
+// name. Every successful `Find()` or `Add()` call must be balanced by a
+// `Release()` call. Released resources stay in the cache and are deleted in
+// least recently released order once the total size of the cached resources
+// exceeds the byte budget. Resources still referenced are never evicted.
+//
+// `ImageCache` and `RasterizationCache` wrap an instance each. Evicting a
+// resource deletes it through the deleter passed to the constructor, so the
+// methods that may evict resources must not be called between
+// `nvgBeginFrame()` and `nvgEndFrame()`. This class is not thread-safe.
+template <typename Resource>
+class ResourceCache {
+ public:
+  // Deletes a resource created in the context.
+  typedef void (*Deleter)(NVGcontext* context, Resource resource);
+
+  ResourceCache(const size_t byte_budget, Deleter deleter)
+      : byte_budget_(byte_budget), deleter_(deleter), number_of_bytes_(0) {}
+  ~ResourceCache() {}
+
+  // Adds a resource of the specified size created by the caller with the
+  // specified key and retains it. The cache takes the ownership of
+  // `resource`. If a resource is already cached with the key, `resource` is
+  // deleted and the cached one is retained instead. Returns the retained
+  // resource.
+  Resource Add(NVGcontext* context, const std::string& key,
+               Resource resource, const size_t number_of_bytes) {
+    Resource cached_resource;
+    if (Find(context, key, &cached_resource)) {
+      if (cached_resource != resource)
+        deleter_(context, resource);
+      return cached_resource;
+    }
+
+    Entry entry;
+    entry.number_of_bytes = number_of_bytes;
+    entry.reference_count = 1;
+    entry.resource = resource;
+    auto insertion = entries_.insert({Key{context, key}, entry});
+    resource_keys_[context][resource] = &insertion.first->first;
+    number_of_bytes_ += number_of_bytes;
+    Evict();
+    return resource;
+  }
+
+  // Deletes all resources of the context that are not referenced.
+  void EvictUnreferenced(NVGcontext* context) {
+    for (auto iterator = released_keys_.begin();
+         iterator != released_keys_.end();) {
+      const Key* key = *iterator;
+      ++iterator;
+      if (key->context == context)
+        Delete(key);
+    }
+  }
+
+  // Retains the resource cached with the specified key and stores it in
+  // `resource`. Returns `false` if no such resource is cached.
+  bool Find(NVGcontext* context, const std::string& key, Resource* resource) {
+    auto match = entries_.find(Key{context, key});
+    if (match == entries_.end())
+      return false;
+
+    Entry* entry = &match->second;
+    if (entry->reference_count == 0)
+      released_keys_.erase(entry->released_position);
+    ++entry->reference_count;
+    *resource = entry->resource;
+    return true;
+  }
+
+  // Releases the resource previously retained from the cache. The resource
+  // may be deleted immediately if the cache exceeds its budget. Returns
+  // `false` if the resource is not cached.
+  bool Release(NVGcontext* context, Resource resource) {
+    auto context_match = resource_keys_.find(context);
+    if (context_match == resource_keys_.end())
+      return false;
+    auto resource_match = context_match->second.find(resource);
+    if (resource_match == context_match->second.end())
+      return false;
+
+    const Key* key = resource_match->second;
+    Entry* entry = &entries_.find(*key)->second;
+    if (entry->reference_count <= 0 || --entry->reference_count > 0)
+      return true;
+    released_keys_.push_front(key);
+    entry->released_position = released_keys_.begin();
+    Evict();
+    return true;
+  }
+
+  // Deletes all resources of the context including the referenced ones.
+  void RemoveContext(NVGcontext* context) {
+    auto match = resource_keys_.find(context);
+    if (match == resource_keys_.end())
+      return;
+
+    std::vector<const Key*> keys;
+    for (auto& resource_key : match->second)
+      keys.push_back(resource_key.second);
+    for (const Key* key : keys)
+      Delete(key);
+    resource_keys_.erase(context);
+  }
+
+  // Accessors and setters.
+  size_t byte_budget() const { return byte_budget_; }
+  void set_byte_budget(const size_t byte_budget) {
+    byte_budget_ = byte_budget;
+    Evict();
+  }
+  size_t number_of_bytes() const { return number_of_bytes_; }
+  int size() const { return static_cast<int>(entries_.size()); }
+
+ private:
+  // The attributes identifying a resource.
+  struct Key {
+    NVGcontext* context;
+    std::string name;
+
+    bool operator==(const Key& other) const {
+      return context == other.context && name == other.name;
+    }
+  };
+
+  // Returns the hash value of a `Key` object.
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = std::hash<std::string>()(key.name);
+      hash ^= std::hash<NVGcontext*>()(key.context) + 0x9e3779b9 +
+              (hash << 6) + (hash >> 2);
+      return hash;
+    }
+  };
+
+  // A cached resource.
+  struct Entry {
+    // The estimated number of bytes of the resource.
+    size_t number_of_bytes;
+    // The position of the entry's key in `released_keys_`. Only valid if
+    // `reference_count` is 0.
+    typename std::list<const Key*>::iterator released_position;
+    // The number of unbalanced retains.
+    int reference_count;
+    Resource resource;
+  };
+
+  // Deletes the cached resource with the specified key.
+  void Delete(const Key* key) {
+    auto match = entries_.find(*key);
+    NVGcontext* context = key->context;
+    Resource resource = match->second.resource;
+    if (match->second.reference_count == 0)
+      released_keys_.erase(match->second.released_position);
+    number_of_bytes_ -= match->second.number_of_bytes;
+    entries_.erase(match);
+    resource_keys_[context].erase(resource);
+    deleter_(context, resource);
+  }
+
+  // Evicts the least recently released resources until the cache fits its
+  // budget or no more resources can be evicted.
+  void Evict() {
+    while (number_of_bytes_ > byte_budget_ && !released_keys_.empty())
+      Delete(released_keys_.back());
+  }
+
+  // Indicates the maximum number of bytes to be used by cached resources.
+  size_t byte_budget_;
+
+  // Deletes evicted resources.
+  const Deleter deleter_;
+
+  // The cached resources.
+  std::unordered_map<Key, Entry, KeyHash> entries_;
+
+  // Keeps the estimated number of bytes of all cached resources.
+  size_t number_of_bytes_;
+
+  // The keys of unreferenced resources, the most recently released first.
+  std::list<const Key*> released_keys_;
+
+  // The keys of the cached resources indexed by the resources for each
+  // context.
+  std::unordered_map<NVGcontext*, std::unordered_map<Resource, const Key*>>
+      resource_keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourceCache);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_RESOURCE_CACHE_H_
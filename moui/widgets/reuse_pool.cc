@@ -0,0 +1,163 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/reuse_pool.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "moui/widgets/widget.h"
+
+namespace {
+
+// The default maximum number of widgets to keep for each reuse ID.
+const int kDefaultCapacity = 32;
+
+// Returns the interned reuse identifiers indexed by reuse IDs.
+std::vector<std::string>* GetReuseIdentifiers() {
+  static std::vector<std::string> reuse_identifiers;
+  return &reuse_identifiers;
+}
+
+}  // namespace
+
+namespace moui {
+
+ReusePool::ReusePool()
+    : default_capacity_(kDefaultCapacity), number_of_allocations_(0),
+      number_of_evictions_(0), number_of_hits_(0), number_of_misses_(0) {
+}
+
+ReusePool::~ReusePool() {
+  for (Bucket& bucket : buckets_) {
+    for (Widget* widget : bucket.widgets)
+      delete widget;
+  }
+}
+
+void ReusePool::Clear() {
+  for (Bucket& bucket : buckets_)
+    TrimBucket(0, &bucket);
+}
+
+Widget* ReusePool::Dequeue(const int reuse_id) {
+  Bucket* bucket = GetBucket(reuse_id);
+  if (bucket == nullptr || bucket->widgets.empty()) {
+    ++number_of_misses_;
+    return nullptr;
+  }
+  Widget* widget = bucket->widgets.back();
+  bucket->widgets.pop_back();
+  ++number_of_hits_;
+  return widget;
+}
+
+bool ReusePool::Enqueue(const int reuse_id, Widget* widget) {
+  if (reuse_id < 0 ||
+      reuse_id >= static_cast<int>(GetReuseIdentifiers()->size())) {
+    delete widget;
+    return false;
+  }
+  if (reuse_id >= static_cast<int>(buckets_.size()))
+    buckets_.resize(reuse_id + 1, {-1, {}});
+
+  Bucket* bucket = &buckets_[reuse_id];
+  if (static_cast<int>(bucket->widgets.size()) >= GetCapacity(reuse_id)) {
+    delete widget;
+    ++number_of_evictions_;
+    return false;
+  }
+  bucket->widgets.push_back(widget);
+  return true;
+}
+
+ReusePool::Bucket* ReusePool::GetBucket(const int reuse_id) {
+  if (reuse_id < 0 || reuse_id >= static_cast<int>(buckets_.size()))
+    return nullptr;
+  return &buckets_[reuse_id];
+}
+
+int ReusePool::GetCapacity(const int reuse_id) const {
+  if (reuse_id < 0 || reuse_id >= static_cast<int>(buckets_.size()) ||
+      buckets_[reuse_id].capacity < 0) {
+    return default_capacity_;
+  }
+  return buckets_[reuse_id].capacity;
+}
+
+int ReusePool::GetNumberOfWidgets(const int reuse_id) const {
+  if (reuse_id < 0 || reuse_id >= static_cast<int>(buckets_.size()))
+    return 0;
+  return static_cast<int>(buckets_[reuse_id].widgets.size());
+}
+
+int ReusePool::GetReuseId(const std::string& identifier) {
+  if (identifier.empty())
+    return kInvalidReuseId;
+
+  static std::unordered_map<std::string, int> reuse_ids;
+  auto match = reuse_ids.find(identifier);
+  if (match != reuse_ids.end())
+    return match->second;
+
+  std::vector<std::string>* reuse_identifiers = GetReuseIdentifiers();
+  const int kReuseId = static_cast<int>(reuse_identifiers->size());
+  reuse_identifiers->push_back(identifier);
+  reuse_ids[identifier] = kReuseId;
+  return kReuseId;
+}
+
+std::string ReusePool::GetReuseIdentifier(const int reuse_id) {
+  const std::vector<std::string>* reuse_identifiers = GetReuseIdentifiers();
+  if (reuse_id < 0 || reuse_id >= static_cast<int>(reuse_identifiers->size()))
+    return "";
+  return (*reuse_identifiers)[reuse_id];
+}
+
+void ReusePool::SetCapacity(const int reuse_id, const int capacity) {
+  if (reuse_id < 0 ||
+      reuse_id >= static_cast<int>(GetReuseIdentifiers()->size()))
+    return;
+  if (reuse_id >= static_cast<int>(buckets_.size()))
+    buckets_.resize(reuse_id + 1, {-1, {}});
+
+  Bucket* bucket = &buckets_[reuse_id];
+  bucket->capacity = std::max(0, capacity);
+  TrimBucket(bucket->capacity, bucket);
+}
+
+void ReusePool::Trim(const int number_of_widgets) {
+  for (Bucket& bucket : buckets_)
+    TrimBucket(number_of_widgets, &bucket);
+}
+
+void ReusePool::TrimBucket(const int number_of_widgets, Bucket* bucket) {
+  // Releases the least recently enqueued widgets first.
+  const int kNumberOfEvictions = \
+      static_cast<int>(bucket->widgets.size()) - std::max(0, number_of_widgets);
+  if (kNumberOfEvictions <= 0)
+    return;
+  for (int i = 0; i < kNumberOfEvictions; ++i)
+    delete bucket->widgets[i];
+  bucket->widgets.erase(bucket->widgets.begin(),
+                        bucket->widgets.begin() + kNumberOfEvictions);
+  number_of_evictions_ += kNumberOfEvictions;
+}
+
+}  // namespace moui
@@ -0,0 +1,137 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_REUSE_POOL_H_
+#define MOUI_WIDGETS_REUSE_POOL_H_
+
+#include <string>
+#include <vector>
+
+#include "moui/base.h"
+
+namespace moui {
+
+// Forward declaration.
+class Widget;
+
+// The `ReusePool` class keeps widgets that are no longer displayed so
+// containers such as `TableView` and `GridView` can recycle them instead of
+// creating new ones. Widgets are grouped by reuse IDs, which are integers
+// interned from reuse identifier strings by `GetReuseId()`, so enqueuing and
+// dequeuing never compare strings. The number of widgets kept for each reuse
+// ID is capped, and `Trim()` releases pooled widgets under memory pressure.
+// Like other widget classes, this class is not thread-safe and must be used
+// on the main thread.
+class ReusePool {
+ public:
+  // The reuse ID for widgets that should not be reused.
+  static constexpr int kInvalidReuseId = -1;
+
+  ReusePool();
+  ~ReusePool();
+
+  // Returns the reuse ID interned for the specified reuse identifier. The
+  // same identifier always maps to the same ID within the process.
+  // `kInvalidReuseId` is returned if `identifier` is empty.
+  static int GetReuseId(const std::string& identifier);
+
+  // Returns the reuse identifier interned as the specified reuse ID, or an
+  // empty string if the ID is invalid.
+  static std::string GetReuseIdentifier(const int reuse_id);
+
+  // Releases all pooled widgets.
+  void Clear();
+
+  // Removes and returns a pooled widget of the specified reuse ID. Returns
+  // `nullptr` if no widget is available.
+  Widget* Dequeue(const int reuse_id);
+
+  // Adds the specified widget to the pool, which takes ownership of the
+  // widget. The widget is released immediately if the number of pooled
+  // widgets of the reuse ID already reaches its capacity. Returns `true` if
+  // the widget is pooled.
+  bool Enqueue(const int reuse_id, Widget* widget);
+
+  // Returns the maximum number of widgets to keep for the reuse ID.
+  int GetCapacity(const int reuse_id) const;
+
+  // Returns the number of pooled widgets of the reuse ID.
+  int GetNumberOfWidgets(const int reuse_id) const;
+
+  // Counts a widget that is created because no pooled widget was available.
+  void RecordAllocation() { ++number_of_allocations_; }
+
+  // Sets the maximum number of widgets to keep for the reuse ID. Pooled
+  // widgets beyond the new capacity are released.
+  void SetCapacity(const int reuse_id, const int capacity);
+
+  // Releases pooled widgets until at most `number_of_widgets` widgets are
+  // kept for each reuse ID.
+  void Trim(const int number_of_widgets);
+
+  // Accessors and setters.
+  int default_capacity() const { return default_capacity_; }
+  void set_default_capacity(const int capacity) {
+    default_capacity_ = capacity;
+  }
+  int number_of_allocations() const { return number_of_allocations_; }
+  int number_of_evictions() const { return number_of_evictions_; }
+  int number_of_hits() const { return number_of_hits_; }
+  int number_of_misses() const { return number_of_misses_; }
+
+ private:
+  // Pooled widgets sharing the same reuse ID.
+  struct Bucket {
+    // The maximum number of widgets to keep, or -1 for `default_capacity_`.
+    int capacity;
+    // The pooled widgets. The most recently enqueued widget is dequeued
+    // first.
+    std::vector<Widget*> widgets;
+  };
+
+  // Returns the bucket of the reuse ID, or `nullptr` if no bucket exists.
+  Bucket* GetBucket(const int reuse_id);
+
+  // Releases the least recently enqueued widgets of the bucket until at most
+  // `number_of_widgets` widgets are kept.
+  void TrimBucket(const int number_of_widgets, Bucket* bucket);
+
+  // The buckets indexed by reuse IDs.
+  std::vector<Bucket> buckets_;
+
+  // Indicates the maximum number of widgets to keep for each reuse ID whose
+  // capacity is not set.
+  int default_capacity_;
+
+  // Counts the widgets created because no pooled widget was available.
+  int number_of_allocations_;
+
+  // Counts the widgets released because of capacity limits or trimming.
+  int number_of_evictions_;
+
+  // Counts the `Dequeue()` calls that returned a pooled widget.
+  int number_of_hits_;
+
+  // Counts the `Dequeue()` calls that returned `nullptr`.
+  int number_of_misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReusePool);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_REUSE_POOL_H_
@@ -25,6 +25,7 @@
 #include "moui/core/clock.h"
 #include "moui/core/event.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
 #include "moui/widgets/scroller.h"
 #include "moui/widgets/widget.h"
 
@@ -39,6 +40,13 @@ const double kBounceDuration = 0.3;
 // The default deceleration rate.
 const float kDefaultDecelerationRate = 0.998;
 
+// The number of the latest scroll events kept for calculating the velocity.
+const int kEventHistorySize = 16;
+
+// The fixed time step in seconds for integrating the content view animation.
+// It divides the frame intervals of both 60 Hz and 120 Hz displays.
+const double kIntegrationStep = 1.0 / 240;
+
 // The maximum duration in seconds to animate the content view beyond the
 // boundary limits.
 const double kMaximumReachingBoundaryDuration = 0.15;
@@ -50,6 +58,10 @@ const float kMaximumScrollVelocity = 2500;
 // gradually while scrolling.
 const float kScrollVelocityThreshold = 100;
 
+// The duration in seconds of the latest scroll events used for fitting the
+// scroll velocity.
+const double kVelocitySamplingDuration = 0.1;
+
 // Returns the displacement of the passed variables.
 float CalculateDisplacement(const float initial_velocity,
                             const float deceleration,
@@ -72,7 +84,10 @@ ScrollView::ScrollView()
       always_scroll_both_directions_(true), always_scroll_to_next_page_(false),
       deceleration_rate_(kDefaultDecelerationRate), bounces_(true),
       content_view_(new Widget(false)), enables_paging_(false),
-      enables_scroll_(true), moves_content_view_to_page_(0), page_width_(0),
+      enables_scroll_(true), event_history_(kEventHistorySize),
+      event_history_head_(0), event_history_size_(0),
+      moves_content_view_to_page_(0), page_width_(0),
+      requests_animation_(false),
       scroll_indicator_insets_({0, 0, 0, 0}),
       shows_horizontal_scroll_indicator_(true),
       shows_vertical_scroll_indicator_(true) {
@@ -114,6 +129,96 @@ void ScrollView::AddChild(Widget* child) {
   child->set_parent(this);
 }
 
+void ScrollView::AdvanceAnimationStates(AnimationStates* states) {
+  states->previous_location = states->location;
+  states->simulated_time += kIntegrationStep;
+  if (states->simulated_time >= states->duration) {
+    states->is_animating = false;
+    states->location = states->destination_location;
+    SetAnimatedContentViewLocation(states, states->location);
+    return;
+  }
+  // The deceleration is constant within a step so the step is exact.
+  states->location += CalculateDisplacement(states->velocity,
+                                            states->deceleration,
+                                            kIntegrationStep);
+  states->velocity += states->deceleration * kIntegrationStep;
+
+  // Finds the timing to bounce the content view. Do nothing if it's already
+  // bouncing.
+  if (states->is_bouncing)
+    return;
+
+  const double kStepTimestamp = states->initial_timestamp + \
+                                states->simulated_time;
+  float origin = states->location;
+
+  // Bounces back immediately once the duration since reaching the boundary
+  // has exceeded `kMaximumReachingBoundaryDuration`.
+  if (states->reaches_boundary_timestamp >= 0 &&
+      (kStepTimestamp - states->reaches_boundary_timestamp) >= \
+       kMaximumReachingBoundaryDuration) {
+    SetAnimatedContentViewLocation(states, origin);
+    BounceContentView(states);
+    if (states->is_animating && states->initial_timestamp < 0)
+      BeginAnimationStates(kStepTimestamp, states);
+    return;
+  }
+
+  float min_boundary_origin, max_boundary_origin, view_length;
+  bool always_bounces = false;
+  if (states == &horizontal_animation_states_) {
+    GetContentViewBoundaries(&min_boundary_origin, nullptr,
+                             &max_boundary_origin, nullptr);
+    view_length = GetWidth();
+    always_bounces = always_bounce_horizontal_ ||
+                     content_view_->GetWidth() > GetWidth();
+  } else if (states == &vertical_animation_states_) {
+    GetContentViewBoundaries(nullptr, &min_boundary_origin,
+                             nullptr, &max_boundary_origin);
+    view_length = GetHeight();
+    always_bounces = always_bounce_vertical_ ||
+                     content_view_->GetHeight() > GetHeight();
+  }
+  const float kMaxOverflowPadding = view_length / 3;
+
+  // Stops animation immediately if reaching the content view boundary while
+  // bouncing is disabled.
+  if (!bounces_ || !always_bounces) {
+    bool stops_animation = false;
+    if (origin > max_boundary_origin) {
+      origin = max_boundary_origin;
+      stops_animation = true;
+    } else if (origin < min_boundary_origin) {
+      origin = min_boundary_origin;
+      stops_animation = true;
+    }
+
+    if (stops_animation) {
+      states->is_animating = false;
+      states->location = origin;
+      SetAnimatedContentViewLocation(states, origin);
+      return;
+    }
+  }
+
+  // Bounces back immediately if reaching the maximum acceptable overflowed
+  // boundary limits.
+  if (origin > (max_boundary_origin + kMaxOverflowPadding) ||
+      origin < (min_boundary_origin - kMaxOverflowPadding)) {
+    SetAnimatedContentViewLocation(states, origin);
+    BounceContentView(states);
+    if (states->is_animating && states->initial_timestamp < 0)
+      BeginAnimationStates(kStepTimestamp, states);
+  // Updates the timestamp when first time reaching the content view boundary.
+  } else if (states->reaches_boundary_timestamp < 0 &&
+             origin != states->initial_location &&
+             (origin >= max_boundary_origin ||
+              origin <= min_boundary_origin)) {
+    states->reaches_boundary_timestamp = kStepTimestamp;
+  }
+}
+
 void ScrollView::AnimateContentViewHorizontally(const float origin_x,
                                                 const double duration) {
   if (duration <= 0)
@@ -141,8 +246,10 @@ void ScrollView::AnimateContentViewHorizontally(const float origin_x,
   horizontal_animation_states_.initial_location = content_view_->GetX();
   horizontal_animation_states_.initial_velocity = initial_velocity;
   horizontal_animation_states_.initial_timestamp = -1;
-  if (!IsAnimating())
+  if (!requests_animation_) {
+    requests_animation_ = true;
     StartAnimation();
+  }
 }
 
 void ScrollView::AnimateContentViewOffset(const Point offset,
@@ -180,8 +287,19 @@ void ScrollView::AnimateContentViewVertically(const float origin_y,
   vertical_animation_states_.initial_location = content_view_->GetY();
   vertical_animation_states_.initial_velocity = initial_velocity;
   vertical_animation_states_.initial_timestamp = -1;
-  if (!IsAnimating())
+  if (!requests_animation_) {
+    requests_animation_ = true;
     StartAnimation();
+  }
+}
+
+void ScrollView::BeginAnimationStates(const double timestamp,
+                                      AnimationStates* states) {
+  states->initial_timestamp = timestamp;
+  states->location = states->initial_location;
+  states->previous_location = states->initial_location;
+  states->simulated_time = 0;
+  states->velocity = states->initial_velocity;
 }
 
 void ScrollView::BounceContentView(AnimationStates* animation_state) {
@@ -236,6 +354,15 @@ bool ScrollView::BringChildToFront(Widget* child) {
   return content_view_->BringChildToFront(child);
 }
 
+Point ScrollView::GetContentViewDestinationOffset() const {
+  Point offset = GetContentViewOffset();
+  if (horizontal_animation_states_.is_animating)
+    offset.x = -horizontal_animation_states_.destination_location;
+  if (vertical_animation_states_.is_animating)
+    offset.y = -vertical_animation_states_.destination_location;
+  return offset;
+}
+
 Point ScrollView::GetContentViewOffset() const {
   return {-content_view_->GetX(), -content_view_->GetY()};
 }
@@ -291,15 +418,13 @@ int ScrollView::GetPage(const float origin_x) const {
 }
 
 bool ScrollView::GetScrollDirection(ScrollDirection* direction) const {
-  if (event_history_.size() < 2)
+  if (event_history_size_ < 2)
     return false;
 
   *direction = static_cast<ScrollDirection>(0);
-  ScrollEvent latest_event = event_history_.back();
-  ScrollEvent previous_event = event_history_.front();
-
-  const float kOffsetX = latest_event.location.x - previous_event.location.x;
-  const float kOffsetY = latest_event.location.y - previous_event.location.y;
+  const Point kLatestLocation = event_history_[event_history_head_].location;
+  const float kOffsetX = kLatestLocation.x - initial_scroll_location_.x;
+  const float kOffsetY = kLatestLocation.y - initial_scroll_location_.y;
   if (kOffsetX == 0 && kOffsetY == 0) {
     return false;
   }
@@ -340,51 +465,75 @@ void ScrollView::GetScrollVelocity(float* horizontal_velocity,
     *horizontal_velocity = 0;
   if (vertical_velocity != nullptr)
     *vertical_velocity = 0;
-  if (event_history_.size() < 2) {
+  if (event_history_size_ < 2) {
     return;
   }
-  ScrollEvent last_event = event_history_.back();
-  ScrollEvent initial_event = {{0, 0}, 0};
-  double elapsed_time = -1;
-  for (int i = static_cast<int>(event_history_.size()) - 2; i >= 0; --i) {
-    initial_event = event_history_[i];
-    elapsed_time = last_event.timestamp - initial_event.timestamp;
-    // Stops if reached the expected minimum time for calculating the velocity.
-    if (elapsed_time > 0.07)
+
+  // Collects the events within `kVelocitySamplingDuration` from the latest
+  // one, but at least two events. Timestamps are relative to the latest event.
+  const int kCapacity = static_cast<int>(event_history_.size());
+  const double kLatestTimestamp = event_history_[event_history_head_].timestamp;
+  int number_of_samples = 0;
+  double mean_time = 0, mean_x = 0, mean_y = 0;
+  for (int i = 0; i < event_history_size_; ++i) {
+    const ScrollEvent& kEvent = \
+        event_history_[(event_history_head_ - i + kCapacity) % kCapacity];
+    const double kTime = kEvent.timestamp - kLatestTimestamp;
+    if (i >= 2 && kTime < -kVelocitySamplingDuration)
       break;
+    mean_time += kTime;
+    mean_x += kEvent.location.x;
+    mean_y += kEvent.location.y;
+    ++number_of_samples;
+  }
+  mean_time /= number_of_samples;
+  mean_x /= number_of_samples;
+  mean_y /= number_of_samples;
+
+  // Fits the locations against the timestamps by least squares, which is less
+  // sensitive to the jitter of individual events than a two-point difference.
+  double time_variance = 0, time_x_covariance = 0, time_y_covariance = 0;
+  for (int i = 0; i < number_of_samples; ++i) {
+    const ScrollEvent& kEvent = \
+        event_history_[(event_history_head_ - i + kCapacity) % kCapacity];
+    const double kTimeDeviation = \
+        kEvent.timestamp - kLatestTimestamp - mean_time;
+    time_variance += kTimeDeviation * kTimeDeviation;
+    time_x_covariance += kTimeDeviation * (kEvent.location.x - mean_x);
+    time_y_covariance += kTimeDeviation * (kEvent.location.y - mean_y);
   }
-  if (elapsed_time <= 0) {
+  if (time_variance <= 0) {
     return;
   }
+  const float kXVelocity = time_x_covariance / time_variance;
+  const float kYVelocity = time_y_covariance / time_variance;
 
   // If both vertical and horizontal directions are accepted. The velocities
   // of each direction are calculated separated based on the displacements
   // of different directions.
-  const float kXDifference = last_event.location.x - initial_event.location.x;
-  const float kYDifference = last_event.location.y - initial_event.location.y;
   if ((locked_scroll_directions_ & ScrollDirection::kHorizontal) != 0 &&
       (locked_scroll_directions_ & ScrollDirection::kVertical) != 0) {
     if (horizontal_velocity != nullptr &&
         (locked_scroll_directions_ & ScrollDirection::kHorizontal) != 0) {
-      *horizontal_velocity = ReviseScrollVelocity(kXDifference / elapsed_time);
+      *horizontal_velocity = ReviseScrollVelocity(kXVelocity);
     }
     if (vertical_velocity != nullptr &&
         (locked_scroll_directions_ & ScrollDirection::kVertical) != 0) {
-      *vertical_velocity = ReviseScrollVelocity(kYDifference / elapsed_time);
+      *vertical_velocity = ReviseScrollVelocity(kYVelocity);
     }
   // However, if only one direction is accepted. The velocity is calculated
-  // based on the distance between two event locations.
+  // based on the speed regardless of the direction.
   } else {
-    const float kDistance = \
-        std::sqrt(std::pow(kXDifference, 2) + std::pow(kYDifference, 2));
+    const float kSpeed = \
+        std::sqrt(std::pow(kXVelocity, 2) + std::pow(kYVelocity, 2));
     if (horizontal_velocity != nullptr &&
         (locked_scroll_directions_ & ScrollDirection::kHorizontal) != 0) {
-      const float kDisplacement = kXDifference > 0 ? kDistance : -kDistance;
-      *horizontal_velocity = ReviseScrollVelocity(kDisplacement / elapsed_time);
+      *horizontal_velocity = ReviseScrollVelocity(kXVelocity > 0 ? kSpeed :
+                                                                   -kSpeed);
     } else if (vertical_velocity != nullptr &&
         (locked_scroll_directions_ & ScrollDirection::kVertical) != 0) {
-      const float kDisplacement = kYDifference > 0 ? kDistance : -kDistance;
-      *vertical_velocity = ReviseScrollVelocity(kDisplacement / elapsed_time);
+      *vertical_velocity = ReviseScrollVelocity(kYVelocity > 0 ? kSpeed :
+                                                                 -kSpeed);
     }
   }
 }
@@ -415,12 +564,13 @@ bool ScrollView::HandleEvent(Event* event) {
   Point current_location = event->locations()->at(0);
 
   // Handles the first receivied event.
-  if (event_history_.empty()) {
+  if (event_history_size_ == 0) {
     StopAnimation();
     initial_scroll_content_view_origin_ = {content_view_->GetX(),
                                            content_view_->GetY()};
+    initial_scroll_location_ = current_location;
   }
-  event_history_.push_back({current_location, kTimestamp});
+  RecordScrollEvent(current_location, kTimestamp);
 
   // Handles the move event.
   if (event->type() != Event::Type::kMove)
@@ -446,12 +596,11 @@ bool ScrollView::HandleEvent(Event* event) {
   }
 
   // Moves the content view.
-  ScrollEvent first_event = event_history_.front();
   Point origin = initial_scroll_content_view_origin_;
   if ((locked_scroll_directions_ & ScrollDirection::kHorizontal) != 0)
-    origin.x += current_location.x - first_event.location.x;
+    origin.x += current_location.x - initial_scroll_location_.x;
   if ((locked_scroll_directions_ & ScrollDirection::kVertical) != 0)
-    origin.y += current_location.y - first_event.location.y;
+    origin.y += current_location.y - initial_scroll_location_.y;
   SetContentViewOrigin(origin);
   return false;
 }
@@ -473,6 +622,14 @@ bool ScrollView::InsertChildBelowSibling(Widget* child, Widget* sibling) {
   return content_view_->InsertChildBelowSibling(child, sibling);
 }
 
+void ScrollView::RecordScrollEvent(const Point& location,
+                                   const double timestamp) {
+  const int kCapacity = static_cast<int>(event_history_.size());
+  event_history_head_ = (event_history_head_ + 1) % kCapacity;
+  event_history_[event_history_head_] = {location, timestamp};
+  event_history_size_ = std::min(kCapacity, event_history_size_ + 1);
+}
+
 void ScrollView::RedrawScroller(const float scroll_view_length,
                                 const float content_view_offset,
                                 const float content_view_length,
@@ -521,12 +678,12 @@ void ScrollView::RedrawScrollers() {
   const bool kShowsHorizontalScroller = \
       !horizontal_scroller_->IsHidden() ||
       (shows_horizontal_scroll_indicator_ &&
-       (is_scrolling_ || IsAnimating()) &&
+       (is_scrolling_ || requests_animation_) &&
        kContentViewWidth > kScrollViewWidth);
   const bool kShowsVerticalScroller = \
       !vertical_scroller_->IsHidden() ||
       (shows_vertical_scroll_indicator_ &&
-       (is_scrolling_ || IsAnimating()) &&
+       (is_scrolling_ || requests_animation_) &&
        kContentViewHeight > kScrollViewHeight);
   const bool kShowsScrollersOnBothDirections = kShowsHorizontalScroller &&
                                                kShowsVerticalScroller;
@@ -603,13 +760,21 @@ bool ScrollView::SendChildToBack(Widget* child) {
   return content_view_->SendChildToBack(child);
 }
 
+void ScrollView::SetAnimatedContentViewLocation(const AnimationStates* states,
+                                                const float location) {
+  if (states == &horizontal_animation_states_)
+    content_view_->SetX(location);
+  else if (states == &vertical_animation_states_)
+    content_view_->SetY(location);
+}
+
 void ScrollView::SetContentViewOffset(const Point offset) {
   SetContentViewOrigin({-offset.x, -offset.y});
 }
 
 void ScrollView::SetContentViewOrigin(const Point& origin) {
   Point resolved_origin = origin;
-  if (!IsAnimating()) {
+  if (!requests_animation_) {
     resolved_origin.x = ResolveContentViewOrigin(
         origin.x, this->GetWidth(), content_view_->GetWidth(),
         (GetWidth() - page_width()) / 2, always_bounce_horizontal_);
@@ -633,6 +798,25 @@ void ScrollView::SetContentViewSize(const float width, const float height) {
     content_view_->SetHeight(height);
 }
 
+void ScrollView::ShiftContentViewOffset(const Point offset) {
+  if (offset.x == 0 && offset.y == 0)
+    return;
+
+  content_view_->SetX(content_view_->GetX() - offset.x);
+  content_view_->SetY(content_view_->GetY() - offset.y);
+  initial_scroll_content_view_origin_.x -= offset.x;
+  initial_scroll_content_view_origin_.y -= offset.y;
+  horizontal_animation_states_.initial_location -= offset.x;
+  horizontal_animation_states_.destination_location -= offset.x;
+  horizontal_animation_states_.location -= offset.x;
+  horizontal_animation_states_.previous_location -= offset.x;
+  vertical_animation_states_.initial_location -= offset.y;
+  vertical_animation_states_.destination_location -= offset.y;
+  vertical_animation_states_.location -= offset.y;
+  vertical_animation_states_.previous_location -= offset.y;
+  RedrawScrollers();
+}
+
 bool ScrollView::ShouldHandleEvent(const Point location) {
   if (!enables_scroll_ || !CollidePoint(location, 0))
     return false;
@@ -650,7 +834,7 @@ bool ScrollView::ShouldHandleEvent(const Point location) {
   if (acceptable_scroll_directions_ == static_cast<ScrollDirection>(0))
     return false;
 
-  event_history_.clear();
+  event_history_size_ = 0;
   ignores_upcoming_events_ = false;
   locked_scroll_directions_ = static_cast<ScrollDirection>(0);
   is_scrolling_ = false;
@@ -670,10 +854,11 @@ void ScrollView::StopAnimation() {
   vertical_animation_states_.is_animating = false;
   horizontal_animation_states_.is_bouncing = false;
   vertical_animation_states_.is_bouncing = false;
-  if (IsAnimating()) {
+  if (requests_animation_) {
     horizontal_scroller_->HideInAnimation();
     vertical_scroller_->HideInAnimation();
-    Widget::StopAnimation(true);
+    requests_animation_ = false;
+    Widget::StopAnimation(false);
   }
 }
 
@@ -749,90 +934,26 @@ void ScrollView::UpdateAnimationOriginAndStates(const double timestamp,
   if (!states->is_animating)
     return;
 
-  if (states->initial_timestamp < 0) {
-    states->initial_timestamp = Clock::GetTimestamp();
-    states->elapsed_time = 0;
-  } else {
-    // Updates elapsed time and the origin for the current timing.
-    states->elapsed_time = timestamp - states->initial_timestamp;
-  }
-  // Updates the origin.
-  states->is_animating = (states->elapsed_time < states->duration);
-  float origin = !states->is_animating ?
-                 states->destination_location :
-                 states->initial_location + \
-                     CalculateDisplacement(states->initial_velocity,
-                                           states->deceleration,
-                                           states->elapsed_time);
-  if (states == &horizontal_animation_states_)
-    content_view_->SetX(origin);
-  else if (states == &vertical_animation_states_)
-    content_view_->SetY(origin);
-
-  // Finds the timing to bounce the content view. Do nothing if it's already
-  // bouncing.
-  if (states->is_bouncing)
-    return;
-
-  // Bounces back immediately once the duration since reaching the boundary
-  // has exceeded `kMaximumReachingBoundaryDuration`.
-  if (states->reaches_boundary_timestamp >= 0 &&
-      (timestamp - states->reaches_boundary_timestamp) >= \
-       kMaximumReachingBoundaryDuration) {
-    return BounceContentView(states);
-  }
-
-  float min_boundary_origin, max_boundary_origin, view_length;
-  bool always_bounces = false;
-  if (states == &horizontal_animation_states_) {
-    GetContentViewBoundaries(&min_boundary_origin, nullptr,
-                             &max_boundary_origin, nullptr);
-    view_length = GetWidth();
-    always_bounces = always_bounce_horizontal_ ||
-                     content_view_->GetWidth() > GetWidth();
-  } else if (states == &vertical_animation_states_) {
-    GetContentViewBoundaries(nullptr, &min_boundary_origin,
-                             nullptr, &max_boundary_origin);
-    view_length = GetHeight();
-    always_bounces = always_bounce_vertical_ ||
-                     content_view_->GetHeight() > GetHeight();
-  }
-  const float kMaxOverflowPadding = view_length / 3;
-
-  // Stops animation immediately if reaching the content view boundary while
-  // bouncing is disabled.
-  if (!bounces_ || !always_bounces) {
-    bool stops_animation = false;
-    if (origin > max_boundary_origin) {
-      origin = max_boundary_origin;
-      stops_animation = true;
-    } else if (origin < min_boundary_origin) {
-      origin = min_boundary_origin;
-      stops_animation = true;
-    }
+  if (states->initial_timestamp < 0)
+    BeginAnimationStates(timestamp, states);
 
-    if (stops_animation) {
-      states->is_animating = false;
-      if (states == &horizontal_animation_states_)
-        content_view_->SetX(origin);
-      else if (states == &vertical_animation_states_)
-        content_view_->SetY(origin);
-      return;
-    }
+  // Integrates in fixed steps until the simulation covers the frame time. A
+  // bounce restarts the states from the step it begins, so the frame time is
+  // measured against the latest `initial_timestamp`.
+  while (states->is_animating &&
+         states->initial_timestamp + states->simulated_time < timestamp) {
+    AdvanceAnimationStates(states);
   }
+  if (!states->is_animating)
+    return;
 
-  // Bounces back immediately if reaching the maximum acceptable overflowed
-  // boundary limits.
-  if (origin > (max_boundary_origin + kMaxOverflowPadding) ||
-      origin < (min_boundary_origin - kMaxOverflowPadding)) {
-    BounceContentView(states);
-  // Updates the timestamp when first time reaching the content view boundary.
-  } else if (states->reaches_boundary_timestamp < 0 &&
-             origin != states->initial_location &&
-             (origin >= max_boundary_origin ||
-              origin <= min_boundary_origin)) {
-    states->reaches_boundary_timestamp = timestamp;
-  }
+  // Interpolates between the two latest steps at the frame time.
+  const double kFrameTime = timestamp - states->initial_timestamp;
+  const float kProgress = std::max(
+      0.0, 1 - (states->simulated_time - kFrameTime) / kIntegrationStep);
+  const float kOrigin = states->previous_location + \
+      (states->location - states->previous_location) * kProgress;
+  SetAnimatedContentViewLocation(states, kOrigin);
 }
 
 bool ScrollView::VerticalScrollingIsAcceptable() const {
@@ -851,7 +972,8 @@ bool ScrollView::WidgetViewWillRender(NVGcontext* context) {
       !vertical_animation_states_.is_animating)
     return true;
 
-  const double kCurrentTimestamp = Clock::GetTimestamp();
+  const double kCurrentTimestamp = \
+      AnimationEngine::GetSharedEngine()->frame_timestamp();
   UpdateAnimationOriginAndStates(kCurrentTimestamp,
                                  &horizontal_animation_states_);
   UpdateAnimationOriginAndStates(kCurrentTimestamp,
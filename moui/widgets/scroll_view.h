@@ -47,6 +47,11 @@ class ScrollView : public Widget {
   // Inherited from `Widget` class.
   bool BringChildToFront(Widget* child);
 
+  // Returns the offset where the content view will stop after the ongoing
+  // scrolling animation. The current offset is returned if the content view
+  // is not animating.
+  Point GetContentViewDestinationOffset() const;
+
   // Returns the offset of the content view.
   Point GetContentViewOffset() const;
 
@@ -183,6 +188,12 @@ class ScrollView : public Widget {
   // Inherited from `Widget` class.
   bool ShouldHandleEvent(const Point location) override;
 
+  // Moves the content view by the specified offset while keeping ongoing
+  // dragging and animations continuous. This is useful for compensating the
+  // size changes of the content above the visible area without any visual
+  // jump.
+  void ShiftContentViewOffset(const Point offset);
+
   // Animates content view to stop gradually.
   void StopScrollingGradually();
 
@@ -199,7 +210,10 @@ class ScrollView : public Widget {
     kVertical = 0x01 << 1,
   };
 
-  // The animation states for either horizontal or vertical direction.
+  // The animation states for either horizontal or vertical direction. The
+  // motion is integrated in fixed time steps starting from `initial_timestamp`
+  // so it doesn't depend on the frame rate, and the content view is placed by
+  // interpolating the two latest steps at the frame time.
   struct AnimationStates {
     // The deceleration for animating the content view.
     float deceleration;
@@ -207,8 +221,6 @@ class ScrollView : public Widget {
     float destination_location;
     // The animation duration measured in seconds.
     double duration;
-    // Records the elapsed time of the current animation.
-    double elapsed_time;
     // The initial location of the content view.
     float initial_location;
     // Records the timestamp when starting the animation.
@@ -219,8 +231,16 @@ class ScrollView : public Widget {
     bool is_animating;
     // Indicates whether the animation behaviors as a bouncing effect.
     bool is_bouncing;
+    // The location of the content view at `simulated_time`.
+    float location;
+    // The location of the content view one step before `simulated_time`.
+    float previous_location;
     // Records the timestamp when reaching the current content view's boundary.
     double reaches_boundary_timestamp;
+    // The time of the latest integration step relative to `initial_timestamp`.
+    double simulated_time;
+    // The velocity of the content view at `simulated_time`.
+    float velocity;
   };
 
   // The record of a scroll event.
@@ -245,6 +265,15 @@ class ScrollView : public Widget {
                                     const float deceleration,
                                     const double duration);
 
+  // Advances the animation by one fixed integration step. The boundary checks
+  // are made at the step's time so bouncing begins at the same moment on any
+  // frame rate.
+  void AdvanceAnimationStates(AnimationStates* states);
+
+  // Starts integrating the animation at the specified `timestamp` from the
+  // animation's initial location and velocity.
+  void BeginAnimationStates(const double timestamp, AnimationStates* states);
+
   // Bounces the content view based on the direction of the specified
   // `animation_states`.
   void BounceContentView(AnimationStates* animation_states);
@@ -270,10 +299,15 @@ class ScrollView : public Widget {
   int GetPage(const float origin_x) const;
 
   // Gets the current scroll direction based on the
-  // `acceptable_scroll_directions_` and the latest `event_history_`.
+  // `acceptable_scroll_directions_`, `initial_scroll_location_` and the latest
+  // event in `event_history_`.
   // Returns `false` on failure.
   bool GetScrollDirection(ScrollDirection* direction) const;
 
+  // Records a scroll event in `event_history_` and overwrites the oldest
+  // record if the history is full.
+  void RecordScrollEvent(const Point& location, const double timestamp);
+
   // Redraws the scroller for a specific direction.
   void RedrawScroller(const float scroll_view_length,
                       const float content_view_offset,
@@ -295,6 +329,12 @@ class ScrollView : public Widget {
                                  const float content_view_padding,
                                  const bool always_bounces) const;
 
+  // Moves the content view to `location` in the direction of `states`.
+  void SetAnimatedContentViewLocation(const AnimationStates* states,
+                                      const float location);
+
+  // Integrates the animation up to the specified `timestamp` and moves the
+  // content view to the interpolated location.
   void UpdateAnimationOriginAndStates(const double timestamp,
                                       AnimationStates* states);
 
@@ -354,9 +394,16 @@ class ScrollView : public Widget {
   // view does not respond to coming events. The default value is `true`.
   bool enables_scroll_;
 
-  // Keeps all event reocrds in the current sequenece of events.
+  // A ring buffer keeping the latest event records in the current sequence of
+  // events. Its size is fixed on construction so long drags don't grow it.
   std::vector<ScrollEvent> event_history_;
 
+  // The index of the latest event record in `event_history_`.
+  int event_history_head_;
+
+  // The number of valid event records in `event_history_`.
+  int event_history_size_;
+
   // Keeps the states for animating content view in horizontal direction.
   AnimationStates horizontal_animation_states_;
 
@@ -371,6 +418,9 @@ class ScrollView : public Widget {
   // Records the content view's origin when receiving the first scroll event.
   Point initial_scroll_content_view_origin_;
 
+  // Records the location of the first scroll event.
+  Point initial_scroll_location_;
+
   // Records the current page when received the first scroll event.
   int initial_scroll_page_;
 
@@ -389,6 +439,11 @@ class ScrollView : public Widget {
   // The page to move to when `enables_paging_` is `true`.
   int moves_content_view_to_page_;
 
+  // Indicates whether the scroll view holds a `StartAnimation()` request for
+  // animating its content view. Animations run by `AnimationEngine` on the
+  // scroll view are not counted.
+  bool requests_animation_;
+
   // Indicates the distance the scroll indicators are inset from the edge of
   // the scroll view.
   EdgeInsets scroll_indicator_insets_;
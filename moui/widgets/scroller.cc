@@ -22,6 +22,7 @@
 
 #include "moui/core/clock.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
 #include "moui/widgets/widget.h"
 
 namespace {
@@ -92,7 +93,7 @@ void Scroller::Render(NVGcontext* context) {
 // Stops animation immediately before redrawing.
 void Scroller::Redraw() {
   if (hiding_in_animation_) {
-    StopAnimation(true);
+    StopAnimation(false);
     hiding_in_animation_ = false;
   }
   Widget::Redraw();
@@ -129,27 +130,23 @@ void Scroller::SetHidden(const bool hidden) {
 
 // Stops animation if reaching the animation duration.
 void Scroller::WidgetViewDidRender(NVGcontext* context) {
-  if (animation_progress_ < 1)
+  if (!hiding_in_animation_ || animation_progress_ < 1)
     return;
-  StopAnimation(true);
-
-  if (hiding_in_animation_) {
-    SetHidden(true);
-    hiding_in_animation_ = false;
-  }
+  StopAnimation(false);
+  SetHidden(true);
+  hiding_in_animation_ = false;
   animation_progress_ = -1;
 }
 
 // Calculates the animation progress.
 bool Scroller::WidgetViewWillRender(NVGcontext* context) {
-  if (!IsAnimating())
+  if (!hiding_in_animation_)
     return true;
 
-  const double kElapsedTime = \
-      Clock::GetTimestamp() - animation_initial_timestamp_;
-
-  if (hiding_in_animation_)
-    animation_progress_ = kElapsedTime / kAnimatingHideDuration;
+  const double kElapsedTime = std::max(
+      0.0, AnimationEngine::GetSharedEngine()->frame_timestamp()
+           - animation_initial_timestamp_);
+  animation_progress_ = kElapsedTime / kAnimatingHideDuration;
 
   animation_progress_ = std::min(1.0f, animation_progress_);
   return true;
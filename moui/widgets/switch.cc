@@ -17,10 +17,8 @@
 
 #include "moui/widgets/switch.h"
 
-#include <algorithm>
-
-#include "moui/core/clock.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
 #include "moui/widgets/control.h"
 
 namespace {
@@ -34,12 +32,55 @@ const float kTrackWidth = kSwitchWidth - (kOutlineWidth + kKnobRadius) * 2;
 
 const float kAnimationDuration = 0.15;
 
+// Records the rounded rectangle filling the switch into the path.
+void AddBackgroundShape(moui::NVGretainedPath* path) {
+  moui::nvgRetainedPathMoveTo(path, 35.5, 0);
+  moui::nvgRetainedPathLineTo(path, 15.5, 0);
+  moui::nvgRetainedPathBezierTo(path, 6.939, 0, 0, 6.939, 0, 15.5);
+  moui::nvgRetainedPathBezierTo(path, 0, 24.061, 6.939, 31, 15.5, 31);
+  moui::nvgRetainedPathLineTo(path, 35.5, 31);
+  moui::nvgRetainedPathBezierTo(path, 44.061, 31, 51, 24.061, 51, 15.5);
+  moui::nvgRetainedPathBezierTo(path, 51, 6.939, 44.061, 0, 35.5, 0);
+  moui::nvgRetainedPathClose(path);
+}
+
+// Returns the path of the background shared by all switches.
+moui::NVGretainedPath* GetBackgroundPath() {
+  static moui::NVGretainedPath* path = nullptr;
+  if (path == nullptr) {
+    path = moui::nvgCreateRetainedPath();
+    AddBackgroundShape(path);
+  }
+  return path;
+}
+
+// Returns the path of the outline shared by all switches.
+moui::NVGretainedPath* GetOutlinePath() {
+  static moui::NVGretainedPath* path = nullptr;
+  if (path == nullptr) {
+    path = moui::nvgCreateRetainedPath();
+    AddBackgroundShape(path);
+    moui::nvgRetainedPathMoveTo(path, 35.292, 29.208);
+    moui::nvgRetainedPathLineTo(path, 15.708, 29.208);
+    moui::nvgRetainedPathBezierTo(path, 8.149, 29.208, 2, 23.06, 2, 15.5);
+    moui::nvgRetainedPathBezierTo(path, 2, 7.94, 8.149, 1.792, 15.708,
+                                  1.792);
+    moui::nvgRetainedPathLineTo(path, 35.291, 1.792);
+    moui::nvgRetainedPathBezierTo(path, 42.852, 1.792, 49, 7.94, 49, 15.5);
+    moui::nvgRetainedPathBezierTo(path, 49, 23.06, 42.852, 29.208, 35.292,
+                                  29.208);
+    moui::nvgRetainedPathClose(path);
+    moui::nvgRetainedPathWinding(path, NVG_HOLE);
+  }
+  return path;
+}
+
 }  // namespace
 
 namespace moui {
 
-Switch::Switch() : Control(true), is_on_(false),
-                   tint_color_(kDefaultTintColor) {
+Switch::Switch() : Control(true), is_on_(false), knob_animation_(-1),
+                   knob_position_(0), tint_color_(kDefaultTintColor) {
   set_is_opaque(false);
   BindAction(ControlEvents::kTouchUpInside, &Switch::ToggleState, this);
 }
@@ -47,59 +88,29 @@ Switch::Switch() : Control(true), is_on_(false),
 Switch::~Switch() {
 }
 
+bool Switch::GetRasterizationKey(std::string* key) const {
+  *key = std::string("Switch|") + (is_on_ ? "on" : "off");
+  for (const float kComponent : tint_color_.rgba)
+    *key += "|" + std::to_string(kComponent);
+  return true;
+}
+
 bool Switch::IsOn() const {
   return is_on_;
 }
 
 void Switch::Render(NVGcontext* context) {
-  float knob_position = is_on_ ? 1 : 0;
-  if (IsAnimating()) {
-    const float kElapsedTime = \
-        Clock::GetTimestamp() - animation_start_timestamp_;
-    const float kAnimationProgress = \
-        std::min(1.0f, kElapsedTime / kAnimationDuration);
-    knob_position = is_on_ ? kAnimationProgress : 1 - kAnimationProgress;
-    if (kAnimationProgress == 1)
-      StopAnimation(true);
-  }
-
   // Draws the outline.
-  nvgBeginPath(context);
-  nvgMoveTo(context, 35.5, 0);
-  nvgLineTo(context, 15.5, 0);
-  nvgBezierTo(context, 6.939, 0, 0, 6.939, 0, 15.5);
-  nvgBezierTo(context, 0, 24.061, 6.939, 31, 15.5, 31);
-  nvgLineTo(context, 35.5, 31);
-  nvgBezierTo(context, 44.061, 31, 51, 24.061, 51, 15.5);
-  nvgBezierTo(context, 51, 6.939, 44.061, 0, 35.5, 0);
-  nvgClosePath(context);
-  nvgMoveTo(context, 35.292, 29.208);
-  nvgLineTo(context, 15.708, 29.208);
-  nvgBezierTo(context, 8.149, 29.208, 2, 23.06, 2, 15.5);
-  nvgBezierTo(context, 2.0, 7.940000000000001, 8.149, 1.792, 15.708, 1.792);
-  nvgLineTo(context, 35.291, 1.792);
-  nvgBezierTo(context, 42.852, 1.792, 49, 7.94, 49, 15.5);
-  nvgBezierTo(context, 49.0, 23.06, 42.852, 29.208, 35.292, 29.208);
-  nvgClosePath(context);
-  nvgPathWinding(context, NVG_HOLE);
   nvgFillColor(context, nvgRGB(229, 229, 229));
-  nvgFill(context);
+  nvgFillRetainedPath(context, GetOutlinePath(), nullptr);
 
   // Draws the background.
-  nvgBeginPath(context);
-  nvgMoveTo(context, 35.5, 0);
-  nvgLineTo(context, 15.5, 0);
-  nvgBezierTo(context, 6.939, 0, 0, 6.939, 0, 15.5);
-  nvgBezierTo(context, 0.0, 24.061, 6.939, 31, 15.5, 31);
-  nvgLineTo(context, 35.5, 31);
-  nvgBezierTo(context, 44.061, 31, 51, 24.061, 51, 15.5);
-  nvgBezierTo(context, 51.0, 6.939, 44.061, 0, 35.5, 0);
-  nvgFillColor(context, nvgTransRGBA(tint_color_, 255 * knob_position));
-  nvgFill(context);
+  nvgFillColor(context, nvgTransRGBA(tint_color_, 255 * knob_position_));
+  nvgFillRetainedPath(context, GetBackgroundPath(), nullptr);
 
   // Draws the shadow of knob.
   const float kKnobCenterX = kOutlineWidth + kKnobRadius \
-                             + kTrackWidth * knob_position;
+                             + kTrackWidth * knob_position_;
   const float kKnobCenterY = kOutlineWidth + kKnobRadius;
   const float kShadowOuterRadius = kKnobRadius + kOutlineWidth * 1.5;
   const NVGpaint kShadow = nvgRadialGradient(context, kKnobCenterX,
@@ -124,18 +135,31 @@ void Switch::Render(NVGcontext* context) {
 void Switch::SetOn(const bool is_on, const bool animated) {
   if (is_on == is_on_)
     return;
-  if (animated)
+  if (animated) {
     ToggleState(nullptr);
-  else
-    is_on_ = is_on;
+    return;
+  }
+  AnimationEngine::GetSharedEngine()->CancelAnimation(knob_animation_);
+  is_on_ = is_on;
+  knob_position_ = is_on ? 1 : 0;
+  Redraw();
 }
 
 void Switch::ToggleState(Control* control) {
-  if (!IsAnimating()) {
-    is_on_ = !is_on_;
-    animation_start_timestamp_ = Clock::GetTimestamp();
-    StartAnimation();
-  }
+  AnimationEngine* engine = AnimationEngine::GetSharedEngine();
+  if (engine->IsAnimationActive(knob_animation_))
+    return;
+
+  is_on_ = !is_on_;
+  knob_animation_ = engine->AnimateValue(
+      this, knob_position_, is_on_ ? 1 : 0,
+      AnimationEngine::GetCurveTiming(AnimationEngine::Curve::kLinear,
+                                      kAnimationDuration),
+      [this](const float value) {
+        knob_position_ = value;
+        Redraw();
+      },
+      nullptr);
 }
 
 bool Switch::WidgetViewWillRender(NVGcontext* context) {
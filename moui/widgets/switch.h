@@ -18,6 +18,8 @@
 #ifndef MOUI_WIDGETS_SWITCH_H_
 #define MOUI_WIDGETS_SWITCH_H_
 
+#include <string>
+
 #include "moui/base.h"
 #include "moui/nanovg_hook.h"
 #include "moui/widgets/control.h"
@@ -42,6 +44,10 @@ class Switch : public Control {
   void set_tint_color(const NVGcolor tint_color);
 
  private:
+  // Inherited from `Widget` class. Switches with the same state and tint
+  // color share their rendering results.
+  bool GetRasterizationKey(std::string* key) const final;
+
   // Inherited from `Widget` class.
   void Render(NVGcontext* context) final;
 
@@ -51,11 +57,16 @@ class Switch : public Control {
   // Inherited from `Widget` class.
   bool WidgetViewWillRender(NVGcontext* context) final;
 
-  double animation_start_timestamp_;
-
   // Indicates the On/Off state of the switch.
   bool is_on_;
 
+  // The id of the `AnimationEngine` animation moving the knob, or -1 if the
+  // knob never moved.
+  int knob_animation_;
+
+  // The position of the knob from 0 when turned off to 1 when turned on.
+  float knob_position_;
+
   // Indicates the color used to tint the outline of the switch when it is
   // turned off.
   NVGcolor tint_color_;
@@ -18,15 +18,23 @@
 #include "moui/widgets/table_view.h"
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <string>
-#include <queue>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "moui/base.h"
 #include "moui/core/clock.h"
 #include "moui/core/event.h"
+#include "moui/core/index_set.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/animation_engine.h"
+#include "moui/widgets/reuse_pool.h"
 #include "moui/widgets/scroll_view.h"
 #include "moui/widgets/table_view_cell.h"
 #include "moui/widgets/widget_view.h"
@@ -37,6 +45,20 @@ namespace {
 const float kDefaultHeightBetweenSections = 35;
 // The default row height in points.
 const float kDefaultRowHeight = 44;
+// The maximum number of rows to prefetch at a time.
+const int kMaximumNumberOfPrefetchedRows = 32;
+// The minimum number of reusable cells to keep for each reuse identifier
+// when warming up reusable cells.
+const int kMinimumNumberOfSpareReusableCells = 2;
+// The interval in seconds between creating reusable cells while warming up.
+const float kWarmUpReusableCellsInterval = 0.05;
+
+// Returns `true` if the cell index `a` is ahead of `b`.
+bool CompareCellIndexes(const moui::TableView::CellIndex& a,
+                        const moui::TableView::CellIndex& b) {
+  return a.section_index < b.section_index ||
+         (a.section_index == b.section_index && a.row_index < b.row_index);
+}
 
 }  // namespace
 
@@ -44,16 +66,20 @@ namespace moui {
 
 TableView::TableView() :
     ScrollView(), data_source_(nullptr), delegate_(nullptr),
-    down_event_cell_(nullptr),
+    down_event_cell_(nullptr), estimated_row_height_(0),
+    first_non_empty_section_index_(-1),
     height_between_sections_(kDefaultHeightBetweenSections),
+    is_animating_row_updates_(false), is_warming_up_reusable_cells_(false),
     last_bottommost_content_view_offset_(-1),
-    last_topmost_content_view_offset_(-1),
+    last_topmost_content_view_offset_(-1), number_of_estimated_rows_(0),
+    number_of_pending_update_batches_(0), table_footer_view_(nullptr),
+    table_header_view_(nullptr), prefetch_data_source_(nullptr),
+    row_animation_duration_(0), row_animation_initial_timestamp_(0),
     row_height_(TableView::kAutomaticDimenstion),
-    should_update_layout_(true),
+    should_update_layout_(true), should_update_row_offset_index_(true),
     separator_color_(nvgRGB(234, 234, 234)),
     separator_insets_({0, 20, 0, 20}),
-    table_footer_view_(nullptr),
-    table_header_view_(nullptr) {
+    warm_up_reusable_cells_token_(new bool(true)) {
   set_always_bounce_vertical(true);
   set_always_scroll_both_directions(false);
   set_background_color(nvgRGBA(240, 239, 245, 255));
@@ -67,26 +93,577 @@ TableView::TableView() :
 }
 
 TableView::~TableView() {
+  // Invalidates the scheduled `WarmUpReusableCells()` calls.
+  warm_up_reusable_cells_token_.reset();
   // Releases visible cells.
   for (TableViewCell* cell : visible_cells_) {
     cell->RemoveFromParent();
     delete cell;
   }
-  // Releases reusable cells.
-  for (auto iterator = reusable_cells_.begin();
-       iterator != reusable_cells_.end();
-       ++iterator) {
-    std::queue<TableViewCell*>* table_view_cells = &(iterator->second);
-    while (!table_view_cells->empty()) {
-      TableViewCell* cell = table_view_cells->front();
-      table_view_cells->pop();
-      delete cell;
-    }
-  }
   // Releases managed widgets.
   delete layout_view_;
 }
 
+bool TableView::ApplyUpdates() {
+  PendingUpdates updates;
+  std::swap(updates, pending_updates_);
+
+  const int kNumberOfOldSections = \
+      static_cast<int>(number_of_rows_in_sections_.size());
+  const int kNumberOfSections = std::max(
+      0, data_source_->GetNumberOfSections(this));
+
+  // Maps every section after updates to its section before updates, or -1 if
+  // the section is inserted. Sections that are neither inserted nor moved
+  // keep their relative order.
+  std::vector<int> section_sources(kNumberOfSections, -1);
+  std::vector<bool> section_is_taken(kNumberOfSections, false);
+  std::vector<bool> old_section_is_deleted(kNumberOfOldSections, false);
+  std::vector<bool> old_section_is_moved(kNumberOfOldSections, false);
+  std::vector<bool> old_section_is_reloaded(kNumberOfOldSections, false);
+  for (const int kSectionIndex : updates.deleted_sections) {
+    if (kSectionIndex < 0 || kSectionIndex >= kNumberOfOldSections)
+      return false;
+    old_section_is_deleted[kSectionIndex] = true;
+  }
+  for (const int kSectionIndex : updates.reloaded_sections) {
+    if (kSectionIndex < 0 || kSectionIndex >= kNumberOfOldSections)
+      return false;
+    old_section_is_reloaded[kSectionIndex] = true;
+  }
+  for (const auto& move : updates.moved_sections) {
+    if (move.first < 0 || move.first >= kNumberOfOldSections ||
+        move.second < 0 || move.second >= kNumberOfSections ||
+        old_section_is_deleted[move.first] ||
+        old_section_is_moved[move.first] || section_is_taken[move.second]) {
+      return false;
+    }
+    old_section_is_moved[move.first] = true;
+    section_is_taken[move.second] = true;
+    section_sources[move.second] = move.first;
+  }
+  for (const int kSectionIndex : updates.inserted_sections) {
+    if (kSectionIndex < 0 || kSectionIndex >= kNumberOfSections ||
+        section_is_taken[kSectionIndex]) {
+      return false;
+    }
+    section_is_taken[kSectionIndex] = true;
+  }
+  int section_index = 0;
+  for (int old_section_index = 0;
+       old_section_index < kNumberOfOldSections;
+       ++old_section_index) {
+    if (old_section_is_deleted[old_section_index] ||
+        old_section_is_moved[old_section_index]) {
+      continue;
+    }
+    while (section_index < kNumberOfSections &&
+           section_is_taken[section_index]) {
+      ++section_index;
+    }
+    if (section_index == kNumberOfSections)
+      return false;
+    section_sources[section_index] = old_section_index;
+    section_is_taken[section_index] = true;
+  }
+  if (std::find(section_is_taken.begin(), section_is_taken.end(), false) !=
+      section_is_taken.end()) {
+    return false;
+  }
+  std::vector<int> section_targets(kNumberOfOldSections, -1);
+  for (section_index = 0; section_index < kNumberOfSections; ++section_index) {
+    if (section_sources[section_index] >= 0)
+      section_targets[section_sources[section_index]] = section_index;
+  }
+
+  // Returns `true` if the row before updates exists and its section is
+  // neither deleted nor reloaded.
+  auto old_row_is_valid = [&](const CellIndex& cell_index) {
+    return cell_index.section_index >= 0 &&
+           cell_index.section_index < kNumberOfOldSections &&
+           cell_index.row_index >= 0 &&
+           cell_index.row_index <
+               number_of_rows_in_sections_[cell_index.section_index] &&
+           !old_section_is_deleted[cell_index.section_index] &&
+           !old_section_is_reloaded[cell_index.section_index];
+  };
+
+  // Groups the row changes by sections. `removed_rows` is keyed by the
+  // sections before updates and `added_rows` is keyed by the sections after
+  // updates, whose values pair the row index with the source cell index
+  // before updates, or `{-1, -1}` for inserted rows.
+  std::map<int, std::vector<int>> removed_rows;
+  std::map<int, std::vector<std::pair<int, CellIndex>>> added_rows;
+  for (const CellIndex& cell_index : updates.deleted_rows) {
+    if (!old_row_is_valid(cell_index))
+      return false;
+    removed_rows[cell_index.section_index].push_back(cell_index.row_index);
+  }
+  for (const auto& move : updates.moved_rows) {
+    if (!old_row_is_valid(move.first) || move.second.section_index < 0 ||
+        move.second.section_index >= kNumberOfSections) {
+      return false;
+    }
+    removed_rows[move.first.section_index].push_back(move.first.row_index);
+    added_rows[move.second.section_index].push_back(
+        {move.second.row_index, move.first});
+  }
+  for (const CellIndex& cell_index : updates.inserted_rows) {
+    if (cell_index.section_index < 0 ||
+        cell_index.section_index >= kNumberOfSections) {
+      return false;
+    }
+    added_rows[cell_index.section_index].push_back(
+        {cell_index.row_index, {-1, -1}});
+  }
+  std::vector<CellIndex> reloaded_rows;
+  for (const CellIndex& cell_index : updates.reloaded_rows) {
+    if (!old_row_is_valid(cell_index))
+      return false;
+    reloaded_rows.push_back(cell_index);
+  }
+  std::sort(reloaded_rows.begin(), reloaded_rows.end(), CompareCellIndexes);
+
+  // Returns `true` if the row before updates should be requested again.
+  auto old_row_is_reloaded = [&](const CellIndex& cell_index) {
+    return old_section_is_reloaded[cell_index.section_index] ||
+           std::binary_search(reloaded_rows.begin(), reloaded_rows.end(),
+                              cell_index, CompareCellIndexes);
+  };
+
+  // Maps the rows before updates to the rows after updates for the sections
+  // whose rows are not simply carried over. Rows that don't survive the
+  // updates are mapped to `{-1, -1}`.
+  std::map<int, std::vector<CellIndex>> row_targets;
+  for (const auto& pair : removed_rows) {
+    row_targets[pair.first].assign(
+        number_of_rows_in_sections_[pair.first], {-1, -1});
+  }
+
+  // Finds the first section affected by the updates. The sections before it
+  // keep their cached information and items in `row_offset_index_`, so only
+  // the items from that section onward are rebuilt.
+  int first_updated_section_index = 0;
+  for (; first_updated_section_index < kNumberOfSections;
+       ++first_updated_section_index) {
+    const int kSourceSectionIndex = \
+        section_sources[first_updated_section_index];
+    if (kSourceSectionIndex != first_updated_section_index ||
+        old_section_is_reloaded[kSourceSectionIndex] ||
+        removed_rows.find(kSourceSectionIndex) != removed_rows.end() ||
+        added_rows.find(first_updated_section_index) != added_rows.end() ||
+        (!reloaded_rows.empty() &&
+         reloaded_rows.front().section_index <= kSourceSectionIndex)) {
+      break;
+    }
+    const int kNumberOfRows = std::max(
+        0, data_source_->GetNumberOfRowsInSection(this, kSourceSectionIndex));
+    if (kNumberOfRows != number_of_rows_in_sections_[kSourceSectionIndex])
+      return false;
+  }
+  const int kNumberOfKeptItems = \
+      first_updated_section_index < kNumberOfOldSections ?
+      section_item_indexes_[first_updated_section_index] :
+      row_offset_index_.size();
+
+  // Rebuilds the cached section information and the items of
+  // `row_offset_index_` from the first updated section. Only inserted and
+  // reloaded rows are measured, the other rows carry over their heights.
+  std::vector<int> number_of_rows_in_sections(
+      number_of_rows_in_sections_.begin(),
+      number_of_rows_in_sections_.begin() + first_updated_section_index);
+  std::vector<float> section_footer_heights(
+      section_footer_heights_.begin(),
+      section_footer_heights_.begin() + first_updated_section_index);
+  std::vector<float> section_header_heights(
+      section_header_heights_.begin(),
+      section_header_heights_.begin() + first_updated_section_index);
+  std::vector<int> section_item_indexes(
+      section_item_indexes_.begin(),
+      section_item_indexes_.begin() + first_updated_section_index);
+  std::vector<double> items;
+  std::vector<bool> estimated_items;
+  int first_non_empty_section_index = \
+      first_non_empty_section_index_ < first_updated_section_index ?
+      first_non_empty_section_index_ : -1;
+  int number_of_estimated_rows = number_of_estimated_rows_ - static_cast<int>(
+      std::count(estimated_items_.begin() + kNumberOfKeptItems,
+                 estimated_items_.end(), true));
+  for (section_index = first_updated_section_index;
+       section_index < kNumberOfSections;
+       ++section_index) {
+    const int kNumberOfRows = std::max(
+        0, data_source_->GetNumberOfRowsInSection(this, section_index));
+    const int kSourceSectionIndex = section_sources[section_index];
+    const bool kIsFreshSection = kSourceSectionIndex < 0 ||
+                                 old_section_is_reloaded[kSourceSectionIndex];
+    auto removed_match = kIsFreshSection ?
+                         removed_rows.end() :
+                         removed_rows.find(kSourceSectionIndex);
+    auto added_match = added_rows.find(section_index);
+
+    // Determines the source of every row after updates.
+    std::vector<CellIndex> row_sources(kNumberOfRows, {-1, -1});
+    if (!kIsFreshSection && removed_match == removed_rows.end() &&
+        added_match == added_rows.end()) {
+      if (kNumberOfRows != number_of_rows_in_sections_[kSourceSectionIndex])
+        return false;
+      for (int row_index = 0; row_index < kNumberOfRows; ++row_index)
+        row_sources[row_index] = {kSourceSectionIndex, row_index};
+    } else {
+      std::vector<bool> row_is_taken(kNumberOfRows, false);
+      if (added_match != added_rows.end()) {
+        for (const auto& pair : added_match->second) {
+          if (pair.first < 0 || pair.first >= kNumberOfRows ||
+              row_is_taken[pair.first]) {
+            return false;
+          }
+          row_is_taken[pair.first] = true;
+          row_sources[pair.first] = pair.second;
+        }
+      }
+      if (!kIsFreshSection) {
+        const int kNumberOfSourceRows = \
+            number_of_rows_in_sections_[kSourceSectionIndex];
+        std::vector<bool> source_row_is_removed(kNumberOfSourceRows, false);
+        if (removed_match != removed_rows.end()) {
+          for (const int kRowIndex : removed_match->second) {
+            if (source_row_is_removed[kRowIndex])
+              return false;
+            source_row_is_removed[kRowIndex] = true;
+          }
+        }
+        int row_index = 0;
+        for (int source_row_index = 0;
+             source_row_index < kNumberOfSourceRows;
+             ++source_row_index) {
+          if (source_row_is_removed[source_row_index])
+            continue;
+          while (row_index < kNumberOfRows && row_is_taken[row_index])
+            ++row_index;
+          if (row_index == kNumberOfRows)
+            return false;
+          row_sources[row_index] = {kSourceSectionIndex, source_row_index};
+          row_is_taken[row_index] = true;
+        }
+        if (row_targets.find(kSourceSectionIndex) == row_targets.end()) {
+          row_targets[kSourceSectionIndex].assign(kNumberOfSourceRows,
+                                                  {-1, -1});
+        }
+      }
+      // The remaining rows of an inserted or reloaded section are new rows.
+      if (!kIsFreshSection &&
+          std::find(row_is_taken.begin(), row_is_taken.end(), false) !=
+              row_is_taken.end()) {
+        return false;
+      }
+    }
+
+    float header_height = 0;
+    float footer_height = 0;
+    if (kNumberOfRows > 0 && delegate_ != nullptr) {
+      header_height = delegate_->GetTableViewSectionHeaderHeight(
+          this, section_index);
+      footer_height = delegate_->GetTableViewSectionFooterHeight(
+          this, section_index);
+    }
+    number_of_rows_in_sections.push_back(kNumberOfRows);
+    section_footer_heights.push_back(footer_height);
+    section_header_heights.push_back(header_height);
+    section_item_indexes.push_back(
+        kNumberOfKeptItems + static_cast<int>(items.size()));
+    if (kNumberOfRows == 0)
+      continue;
+    if (first_non_empty_section_index < 0)
+      first_non_empty_section_index = section_index;
+
+    const float kSpacing = section_index > 0 ? height_between_sections_ : 0;
+    items.push_back(std::max(0.0f, kSpacing + header_height));
+    estimated_items.push_back(false);
+    for (int row_index = 0; row_index < kNumberOfRows; ++row_index) {
+      const CellIndex kSourceCellIndex = row_sources[row_index];
+      if (kSourceCellIndex.section_index >= 0) {
+        auto target_match = row_targets.find(kSourceCellIndex.section_index);
+        if (target_match != row_targets.end()) {
+          target_match->second[kSourceCellIndex.row_index] = \
+              {section_index, row_index};
+        }
+      }
+      if (kSourceCellIndex.section_index >= 0 &&
+          !old_row_is_reloaded(kSourceCellIndex)) {
+        const int kItemIndex = \
+            section_item_indexes_[kSourceCellIndex.section_index] + 1
+            + kSourceCellIndex.row_index;
+        items.push_back(row_offset_index_.GetValue(kItemIndex));
+        estimated_items.push_back(estimated_items_[kItemIndex]);
+      } else {
+        bool is_estimated = false;
+        const float kRowHeight = GetRowHeight({section_index, row_index},
+                                              &is_estimated);
+        items.push_back(std::max(0.0f, kRowHeight - 1));
+        estimated_items.push_back(is_estimated);
+      }
+      if (estimated_items.back())
+        ++number_of_estimated_rows;
+    }
+    items.push_back(std::max(0.0f, footer_height));
+    estimated_items.push_back(false);
+  }
+
+  // Returns the cell index after updates for the specified cell index before
+  // updates, or `{-1, -1}` if the row is deleted or reloaded.
+  auto get_new_cell_index = [&](const CellIndex& cell_index) -> CellIndex {
+    if (cell_index.section_index < 0 ||
+        cell_index.section_index >= kNumberOfOldSections ||
+        cell_index.row_index < 0 ||
+        cell_index.row_index >=
+            number_of_rows_in_sections_[cell_index.section_index] ||
+        old_row_is_reloaded(cell_index)) {
+      return {-1, -1};
+    }
+    auto target_match = row_targets.find(cell_index.section_index);
+    if (target_match != row_targets.end())
+      return target_match->second[cell_index.row_index];
+    const int kSectionIndex = section_targets[cell_index.section_index];
+    if (kSectionIndex < 0)
+      return {-1, -1};
+    return {kSectionIndex, cell_index.row_index};
+  };
+
+  // Remaps the visible cells, and reuses the cells whose rows are deleted or
+  // reloaded. The first remaining cell is the anchor that stays in place.
+  std::vector<std::pair<CellIndex, TableViewCell*>> remaining_cells;
+  TableViewCell* anchor_cell = nullptr;
+  CellIndex anchor_cell_index = {-1, -1};
+  for (int i = 0; i < static_cast<int>(visible_cells_.size()); ++i) {
+    TableViewCell* cell = visible_cells_[i];
+    const CellIndex kCellIndex = get_new_cell_index(
+        cell_indexes_for_visible_rows_[i]);
+    if (kCellIndex.section_index < 0) {
+      if (cell == down_event_cell_)
+        down_event_cell_ = nullptr;
+      ReuseCell(cell);
+      continue;
+    }
+    if (anchor_cell == nullptr) {
+      anchor_cell = cell;
+      anchor_cell_index = kCellIndex;
+    }
+    remaining_cells.push_back({kCellIndex, cell});
+  }
+  std::sort(remaining_cells.begin(), remaining_cells.end(),
+            [](const std::pair<CellIndex, TableViewCell*>& a,
+               const std::pair<CellIndex, TableViewCell*>& b) {
+              return CompareCellIndexes(a.first, b.first);
+            });
+  visible_cells_.clear();
+  cell_indexes_for_visible_rows_.clear();
+  cell_indexes_for_visible_cells_.clear();
+  visible_cells_by_key_.clear();
+  for (const auto& pair : remaining_cells) {
+    cell_indexes_for_visible_rows_.push_back(pair.first);
+    visible_cells_.push_back(pair.second);
+    cell_indexes_for_visible_cells_[pair.second] = pair.first;
+    visible_cells_by_key_[GetCellKey(pair.first)] = pair.second;
+  }
+
+  // Remaps the selection. The selected rows of a section whose rows are
+  // simply carried over move along with the section as a whole. Otherwise,
+  // the selected ranges are split around the removed and reloaded rows and
+  // shifted around the added rows, which takes time proportional to the
+  // number of ranges and changes rather than the number of selected rows.
+  std::map<int, IndexSet> selected_rows;
+  for (auto& pair : selected_rows_) {
+    const int kOldSectionIndex = pair.first;
+    if (kOldSectionIndex >= kNumberOfOldSections ||
+        old_section_is_reloaded[kOldSectionIndex]) {
+      continue;
+    }
+    const int kSectionIndex = section_targets[kOldSectionIndex];
+    if (kSectionIndex < 0)
+      continue;
+    auto reloaded_match = std::lower_bound(
+        reloaded_rows.begin(), reloaded_rows.end(),
+        CellIndex({kOldSectionIndex, 0}), CompareCellIndexes);
+    const bool kHasReloadedRows = \
+        reloaded_match != reloaded_rows.end() &&
+        reloaded_match->section_index == kOldSectionIndex;
+    if (row_targets.find(kOldSectionIndex) == row_targets.end() &&
+        !kHasReloadedRows) {
+      selected_rows[kSectionIndex] = pair.second;
+      continue;
+    }
+
+    IndexSet old_rows = pair.second;
+    for (; reloaded_match != reloaded_rows.end() &&
+           reloaded_match->section_index == kOldSectionIndex;
+         ++reloaded_match) {
+      old_rows.RemoveIndex(reloaded_match->row_index);
+    }
+    std::vector<int> removed_row_indexes;
+    auto removed_match = removed_rows.find(kOldSectionIndex);
+    if (removed_match != removed_rows.end()) {
+      removed_row_indexes = removed_match->second;
+      std::sort(removed_row_indexes.begin(), removed_row_indexes.end());
+    }
+    // Keeps the number of carried over rows placed before each added row of
+    // the section after updates, in ascending order of the added rows.
+    std::vector<int> carried_rows_before_added_rows;
+    auto added_match = added_rows.find(kSectionIndex);
+    if (added_match != added_rows.end()) {
+      for (const auto& added_row : added_match->second)
+        carried_rows_before_added_rows.push_back(added_row.first);
+      std::sort(carried_rows_before_added_rows.begin(),
+                carried_rows_before_added_rows.end());
+      const int kNumberOfAddedRows = \
+          static_cast<int>(carried_rows_before_added_rows.size());
+      for (int i = 0; i < kNumberOfAddedRows; ++i)
+        carried_rows_before_added_rows[i] -= i;
+    }
+
+    IndexSet* new_rows = &selected_rows[kSectionIndex];
+    for (const auto& range : old_rows.ranges()) {
+      int row_index = range.first;
+      while (row_index < range.second) {
+        auto removed_iterator = std::lower_bound(removed_row_indexes.begin(),
+                                                 removed_row_indexes.end(),
+                                                 row_index);
+        if (removed_iterator != removed_row_indexes.end() &&
+            *removed_iterator == row_index) {
+          ++row_index;
+          continue;
+        }
+        const int kSegmentEnd = \
+            removed_iterator == removed_row_indexes.end() ?
+            range.second : std::min(range.second, *removed_iterator);
+        // Maps the rank of the carried over rows in the segment to the rows
+        // between added rows after updates.
+        int rank = row_index - static_cast<int>(
+            removed_iterator - removed_row_indexes.begin());
+        const int kRankEnd = rank + kSegmentEnd - row_index;
+        while (rank < kRankEnd) {
+          const int kNumberOfAddedRowsBefore = static_cast<int>(
+              std::upper_bound(carried_rows_before_added_rows.begin(),
+                               carried_rows_before_added_rows.end(), rank)
+              - carried_rows_before_added_rows.begin());
+          int count = kRankEnd - rank;
+          if (kNumberOfAddedRowsBefore <
+              static_cast<int>(carried_rows_before_added_rows.size())) {
+            count = std::min(count, carried_rows_before_added_rows[
+                kNumberOfAddedRowsBefore] - rank);
+          }
+          new_rows->AddRange(rank + kNumberOfAddedRowsBefore, count);
+          rank += count;
+        }
+        row_index = kSegmentEnd;
+      }
+    }
+  }
+  // Carries the selection of moved rows to their destinations.
+  for (const auto& move : updates.moved_rows) {
+    if (IsRowSelected(move.first) && !old_row_is_reloaded(move.first)) {
+      selected_rows[move.second.section_index].AddIndex(
+          move.second.row_index);
+    }
+  }
+  for (auto iterator = selected_rows.begin();
+       iterator != selected_rows.end();) {
+    if (iterator->second.empty())
+      iterator = selected_rows.erase(iterator);
+    else
+      ++iterator;
+  }
+  selected_rows_.swap(selected_rows);
+
+  // Commits the rebuilt section information.
+  estimated_items_.resize(kNumberOfKeptItems);
+  estimated_items_.insert(estimated_items_.end(), estimated_items.begin(),
+                          estimated_items.end());
+  first_non_empty_section_index_ = first_non_empty_section_index;
+  number_of_estimated_rows_ = number_of_estimated_rows;
+  number_of_rows_in_sections_.swap(number_of_rows_in_sections);
+  section_footer_heights_.swap(section_footer_heights);
+  section_header_heights_.swap(section_header_heights);
+  section_item_indexes_.swap(section_item_indexes);
+  row_offset_index_.AssignFrom(kNumberOfKeptItems, items);
+
+  const float kRowOffsetBase = GetRowOffsetBase();
+  auto get_cell_top_offset = [&](const CellIndex& cell_index) {
+    return kRowOffsetBase + static_cast<float>(
+        row_offset_index_.GetPrefixSum(
+            section_item_indexes_[cell_index.section_index] + 1
+            + cell_index.row_index));
+  };
+
+  // Keeps the anchor cell in place unless the table view is scrolled to the
+  // top.
+  float offset_change = 0;
+  if (anchor_cell != nullptr && GetContentViewOffset().y > 0) {
+    offset_change = get_cell_top_offset(anchor_cell_index) - \
+                    anchor_cell->GetY();
+    if (offset_change != 0)
+      ShiftContentViewOffset({0, offset_change});
+  }
+
+  // Animates the remaining cells from their current positions.
+  row_animation_displacements_.clear();
+  if (row_animation_duration_ > 0) {
+    for (const auto& pair : remaining_cells) {
+      const float kDisplacement = \
+          pair.second->GetY() + offset_change - get_cell_top_offset(pair.first);
+      if (kDisplacement != 0)
+        row_animation_displacements_[pair.second] = kDisplacement;
+    }
+  }
+  if (!row_animation_displacements_.empty()) {
+    row_animation_initial_timestamp_ = Clock::GetTimestamp();
+    if (!is_animating_row_updates_) {
+      is_animating_row_updates_ = true;
+      Widget::StartAnimation();
+    }
+  }
+
+  CancelPrefetchingRows();
+  should_update_layout_ = true;
+  layout_view_->Redraw();
+  Redraw();
+  return true;
+}
+
+void TableView::BeginUpdates() {
+  ++number_of_pending_update_batches_;
+}
+
+void TableView::CancelPrefetchingRows() {
+  if (prefetch_data_source_ != nullptr &&
+      !cell_indexes_for_prefetched_rows_.empty()) {
+    prefetch_data_source_->TableViewCancelPrefetchingForRows(
+        this, cell_indexes_for_prefetched_rows_);
+  }
+  cell_indexes_for_prefetched_rows_.clear();
+}
+
+void TableView::DeleteRows(const std::vector<CellIndex>& cell_indexes) {
+  BeginUpdates();
+  pending_updates_.deleted_rows.insert(pending_updates_.deleted_rows.end(),
+                                       cell_indexes.begin(),
+                                       cell_indexes.end());
+  EndUpdates();
+}
+
+void TableView::DeleteSections(const std::vector<int>& section_indexes) {
+  BeginUpdates();
+  pending_updates_.deleted_sections.insert(
+      pending_updates_.deleted_sections.end(), section_indexes.begin(),
+      section_indexes.end());
+  EndUpdates();
+}
+
+void TableView::DeselectAllRows() {
+  selected_rows_.clear();
+  UpdateSelectedStatesOfVisibleCells();
+}
+
 void TableView::DeselectRow(const CellIndex cell_index) {
   if (cell_index.section_index < 0 || cell_index.row_index < 0) {
     return;
@@ -97,76 +674,188 @@ void TableView::DeselectRow(const CellIndex cell_index) {
     return;
   }
 
-  auto iterator = cell_indexes_for_selected_rows_.begin();
-  for (; iterator != cell_indexes_for_selected_rows_.end(); ++iterator) {
-    const CellIndex kCachedCellIndex = static_cast<CellIndex>(*iterator);
-    if (cell_index.section_index == kCachedCellIndex.section_index &&
-        cell_index.row_index == kCachedCellIndex.row_index) {
-      break;
-    }
-  }  // end of `cell_indexes_for_selected_rows_` iterator.
-
   // Updates the sates of the corresopnded cell.
   TableViewCell* cell = GetCell(cell_index);
   if (cell != nullptr) {
     cell->set_selected(false);
   }
 
-  // Removes the cell index from `cell_indexes_for_selected_rows_`.
-  if (iterator != cell_indexes_for_selected_rows_.end()) {
-    cell_indexes_for_selected_rows_.erase(iterator);
-    if (delegate_ != nullptr)
-      delegate_->TableViewDidDeselectRow(this, cell_index);
+  // Removes the cell index from `selected_rows_`.
+  auto match = selected_rows_.find(cell_index.section_index);
+  if (match == selected_rows_.end() ||
+      !match->second.ContainsIndex(cell_index.row_index)) {
+    return;
   }
+  match->second.RemoveIndex(cell_index.row_index);
+  if (match->second.empty())
+    selected_rows_.erase(match);
+  if (delegate_ != nullptr)
+    delegate_->TableViewDidDeselectRow(this, cell_index);
+}
+
+void TableView::DeselectRows(const CellIndex cell_index, const int count) {
+  auto match = selected_rows_.find(cell_index.section_index);
+  if (match == selected_rows_.end() || cell_index.row_index < 0)
+    return;
+
+  match->second.RemoveRange(cell_index.row_index, count);
+  if (match->second.empty())
+    selected_rows_.erase(match);
+  UpdateSelectedStatesOfVisibleCells();
 }
 
 TableViewCell* TableView::DequeueReusableCell(const std::string identifier) {
-  auto queue_match = reusable_cells_.find(identifier);
-  if (queue_match == reusable_cells_.end())
-    return nullptr;
+  return DequeueReusableCell(ReusePool::GetReuseId(identifier));
+}
 
-  auto reusable_cells = &(queue_match->second);
-  if (reusable_cells->empty())
+TableViewCell* TableView::DequeueReusableCell(const int reuse_id) {
+  auto cell = static_cast<TableViewCell*>(reusable_cells_.Dequeue(reuse_id));
+  if (cell == nullptr)
     return nullptr;
 
-  TableViewCell* cell = reusable_cells->front();
-  reusable_cells->pop();
   cell->PrepareForReuse();
   return cell;
 }
 
+bool TableView::EndUpdates() {
+  if (number_of_pending_update_batches_ == 0 ||
+      --number_of_pending_update_batches_ > 0) {
+    return true;
+  }
+
+  // Updates incrementally against the cached section information. It still
+  // describes the rows before updates when `row_offset_index_` is only marked
+  // for rebuilding, which then happens with the next layout.
+  if (data_source_ != nullptr && ApplyUpdates())
+    return true;
+
+  const bool kIsConsistent = data_source_ == nullptr;
+  pending_updates_ = PendingUpdates();
+  down_event_cell_ = nullptr;
+  CancelPrefetchingRows();
+  ReuseVisibleCells(0, static_cast<int>(visible_cells_.size()));
+  selected_rows_.clear();
+  RefreshLayout();
+  return kIsConsistent;
+}
+
 TableViewCell* TableView::GetCell(const CellIndex cell_index) const {
-  int vector_index = 0;
-  for (CellIndex visible_cell_index : cell_indexes_for_visible_rows_) {
-    if (visible_cell_index.section_index == cell_index.section_index &&
-        visible_cell_index.row_index == cell_index.row_index) {
-      return visible_cells_[vector_index];
+  auto match = visible_cells_by_key_.find(GetCellKey(cell_index));
+  if (match == visible_cells_by_key_.end())
+    return nullptr;
+  return match->second;
+}
+
+TableView::CellIndex TableView::GetCellIndex(TableViewCell* cell) const {
+  auto match = cell_indexes_for_visible_cells_.find(cell);
+  if (match == cell_indexes_for_visible_cells_.end())
+    return {-1, -1};
+  return match->second;
+}
+
+std::vector<TableView::CellIndex> TableView::GetCellIndexesForSelectedRows()
+    const {
+  std::vector<CellIndex> cell_indexes;
+  cell_indexes.reserve(GetNumberOfSelectedRows());
+  for (const auto& pair : selected_rows_) {
+    for (const auto& range : pair.second.ranges()) {
+      for (int row_index = range.first; row_index < range.second; ++row_index)
+        cell_indexes.push_back({pair.first, row_index});
     }
-    ++vector_index;
   }
-  return nullptr;
+  return cell_indexes;
 }
 
-TableView::CellIndex TableView::GetCellIndex(TableViewCell* cell) const {
-  int vector_index = 0;
-  for (TableViewCell* visible_cell : visible_cells_) {
-    if (visible_cell == cell)
-      return cell_indexes_for_visible_rows_[vector_index];
-    ++vector_index;
+void TableView::GetCellIndexesInRange(
+    const float top, const float bottom, const int capacity,
+    std::vector<CellIndex>* cell_indexes) const {
+  if (row_offset_index_.empty())
+    return;
+
+  const float kRowOffsetBase = GetRowOffsetBase();
+  const int kNumberOfItems = row_offset_index_.size();
+  for (int item_index = row_offset_index_.FindLowerBound(top - kRowOffsetBase);
+       item_index < kNumberOfItems &&
+           static_cast<int>(cell_indexes->size()) < capacity;
+       ++item_index) {
+    if (kRowOffsetBase + row_offset_index_.GetPrefixSum(item_index) >= bottom)
+      break;
+    const int kSectionIndex = GetSectionIndexForItem(item_index);
+    const int kRowIndex = \
+        item_index - section_item_indexes_[kSectionIndex] - 1;
+    if (kRowIndex >= 0 &&
+        kRowIndex < number_of_rows_in_sections_[kSectionIndex])
+      cell_indexes->push_back({kSectionIndex, kRowIndex});
   }
-  return {-1, -1};
 }
 
-float TableView::GetRowHeight(const CellIndex cell_index) {
+int TableView::GetNumberOfSelectedRows() const {
+  int number_of_selected_rows = 0;
+  for (const auto& pair : selected_rows_)
+    number_of_selected_rows += pair.second.GetCount();
+  return number_of_selected_rows;
+}
+
+float TableView::GetRowHeight(const CellIndex cell_index,
+                              bool* is_estimated) {
+  *is_estimated = false;
   float row_height = TableView::kAutomaticDimenstion;
   if (delegate_ != nullptr) {
     row_height = delegate_->GetTableViewRowHeight(this, cell_index);
   }
   if (row_height == TableView::kAutomaticDimenstion)
     row_height = row_height_;
-  if (row_height == TableView::kAutomaticDimenstion)
-    row_height = kDefaultRowHeight;
-  return row_height;
+  if (row_height != TableView::kAutomaticDimenstion)
+    return row_height;
+
+  // Self-sizing row.
+  float estimated_row_height = TableView::kAutomaticDimenstion;
+  if (delegate_ != nullptr) {
+    estimated_row_height = delegate_->GetTableViewEstimatedRowHeight(
+        this, cell_index);
+  }
+  if (estimated_row_height == TableView::kAutomaticDimenstion)
+    estimated_row_height = estimated_row_height_;
+  if (estimated_row_height > 0) {
+    *is_estimated = true;
+    return estimated_row_height;
+  }
+  return kDefaultRowHeight;
+}
+
+float TableView::GetRowOffsetBase() const {
+  if (first_non_empty_section_index_ < 0)
+    return 0;
+
+  const int kSectionIndex = first_non_empty_section_index_;
+  float content_view_offset = -1;
+  if (table_header_view_ != nullptr)
+    content_view_offset = table_header_view_->GetHeight();
+  if (kSectionIndex > 0)
+    content_view_offset += height_between_sections_;
+  if (delegate_ != nullptr) {
+    const float kHeaderHeight = section_header_heights_[kSectionIndex];
+    content_view_offset = content_view_offset < 0 ?
+                          kHeaderHeight :
+                          content_view_offset + kHeaderHeight;
+  }
+  const float kFirstCellTopOffset = content_view_offset <= 0 ?
+                                    0 : content_view_offset - 1;
+  return kFirstCellTopOffset - row_offset_index_.GetValue(
+      section_item_indexes_[kSectionIndex]);
+}
+
+int TableView::GetSectionIndexForItem(const int item_index) const {
+  auto iterator = std::upper_bound(section_item_indexes_.begin(),
+                                   section_item_indexes_.end(),
+                                   item_index);
+  return static_cast<int>(iterator - section_item_indexes_.begin()) - 1;
+}
+
+void TableView::HandleMemoryWarning(NVGcontext* context) {
+  ScrollView::HandleMemoryWarning(context);
+  reusable_cells_.Clear();
+  spare_reusable_cell_counts_.clear();
 }
 
 bool TableView::HandleEvent(Event* event) {
@@ -208,37 +897,240 @@ void TableView::HighlightDownEventCell() {
   SetCellHighlighted(down_event_cell_, true);
 }
 
+void TableView::InsertRows(const std::vector<CellIndex>& cell_indexes) {
+  BeginUpdates();
+  pending_updates_.inserted_rows.insert(pending_updates_.inserted_rows.end(),
+                                        cell_indexes.begin(),
+                                        cell_indexes.end());
+  EndUpdates();
+}
+
+void TableView::InsertSections(const std::vector<int>& section_indexes) {
+  BeginUpdates();
+  pending_updates_.inserted_sections.insert(
+      pending_updates_.inserted_sections.end(), section_indexes.begin(),
+      section_indexes.end());
+  EndUpdates();
+}
+
+bool TableView::IsRowSelected(const CellIndex cell_index) const {
+  auto match = selected_rows_.find(cell_index.section_index);
+  return match != selected_rows_.end() &&
+         match->second.ContainsIndex(cell_index.row_index);
+}
+
+void TableView::MeasureEstimatedRows(NVGcontext* context) {
+  if (data_source_ == nullptr || IsHidden() || widget_view() == nullptr ||
+      (GetWidth() == 0 && GetHeight() == 0)) {
+    return;
+  }
+  if (should_update_row_offset_index_) {
+    should_update_row_offset_index_ = false;
+    should_update_layout_ = true;
+    UpdateRowOffsetIndex();
+  }
+  if (number_of_estimated_rows_ == 0)
+    return;
+
+  const float kTopmostContentViewOffset = GetContentViewOffset().y;
+  const float kHeight = GetHeight();
+  const float kRowOffsetBase = GetRowOffsetBase();
+  const int kNumberOfItems = row_offset_index_.size();
+
+  // The item whose top offset should stay still after measurement.
+  const int kAnchorItemIndex = row_offset_index_.FindLowerBound(
+      kTopmostContentViewOffset - kRowOffsetBase);
+  const double kAnchorItemOffset = \
+      row_offset_index_.GetPrefixSum(kAnchorItemIndex);
+
+  // Measures the rows within one screen above and below the visible area.
+  const int kFirstItemIndex = row_offset_index_.FindLowerBound(
+      kTopmostContentViewOffset - kHeight - kRowOffsetBase);
+  const int kLastItemIndex = std::min(
+      kNumberOfItems - 1,
+      row_offset_index_.FindLowerBound(
+          kTopmostContentViewOffset + kHeight * 2 - kRowOffsetBase));
+  const float kTableWidth = GetWidth() - left_padding() - right_padding();
+  bool did_measure = false;
+  for (int item_index = kFirstItemIndex;
+       item_index <= kLastItemIndex;
+       ++item_index) {
+    if (!estimated_items_[item_index])
+      continue;
+
+    const int kSectionIndex = GetSectionIndexForItem(item_index);
+    const int kRowIndex = \
+        item_index - section_item_indexes_[kSectionIndex] - 1;
+    TableViewCell* cell = GetCell({kSectionIndex, kRowIndex});
+    const bool kCellIsVisible = cell != nullptr;
+    if (!kCellIsVisible) {
+      cell = data_source_->GetTableViewCell(this, kSectionIndex, kRowIndex);
+      if (cell == nullptr)
+        continue;
+      cell->SetWidth(kTableWidth);
+      cell->SetHeight(row_offset_index_.GetValue(item_index) + 1);
+    }
+    const float kRowHeight = cell->GetFittingHeight(context);
+    if (!kCellIsVisible)
+      ReuseCell(cell);
+
+    row_offset_index_.SetValue(item_index, std::max(0.0f, kRowHeight - 1));
+    estimated_items_[item_index] = false;
+    --number_of_estimated_rows_;
+    did_measure = true;
+  }
+  if (!did_measure)
+    return;
+
+  should_update_layout_ = true;
+  // Keeps the visible rows in place unless the table view is scrolled to the
+  // top.
+  if (kTopmostContentViewOffset > 0 && kAnchorItemIndex < kNumberOfItems) {
+    const double kOffsetChange = \
+        row_offset_index_.GetPrefixSum(kAnchorItemIndex) - kAnchorItemOffset;
+    ShiftContentViewOffset({0, static_cast<float>(kOffsetChange)});
+  }
+}
+
+void TableView::MoveRow(const CellIndex cell_index,
+                        const CellIndex new_cell_index) {
+  BeginUpdates();
+  pending_updates_.moved_rows.push_back({cell_index, new_cell_index});
+  EndUpdates();
+}
+
+void TableView::MoveSection(const int section_index,
+                            const int new_section_index) {
+  BeginUpdates();
+  pending_updates_.moved_sections.push_back(
+      {section_index, new_section_index});
+  EndUpdates();
+}
+
+void TableView::PrefetchRows(
+    const float previous_topmost_content_view_offset) {
+  if (prefetch_data_source_ == nullptr)
+    return;
+
+  const float kTopmostContentViewOffset = GetContentViewOffset().y;
+  const float kHeight = GetHeight();
+  const float kDestinationOffset = GetContentViewDestinationOffset().y;
+  float direction = kDestinationOffset - kTopmostContentViewOffset;
+  if (direction == 0)
+    direction = \
+        kTopmostContentViewOffset - previous_topmost_content_view_offset;
+  if (direction == 0)
+    return;
+
+  // Collects the rows in the next screen along the scroll direction, then the
+  // rows around the projected offset where the scrolling will stop.
+  std::vector<CellIndex> cell_indexes;
+  if (direction > 0) {
+    GetCellIndexesInRange(kTopmostContentViewOffset + kHeight,
+                          kTopmostContentViewOffset + kHeight * 2,
+                          kMaximumNumberOfPrefetchedRows, &cell_indexes);
+  } else {
+    GetCellIndexesInRange(kTopmostContentViewOffset - kHeight,
+                          kTopmostContentViewOffset,
+                          kMaximumNumberOfPrefetchedRows, &cell_indexes);
+  }
+  if (std::abs(kDestinationOffset - kTopmostContentViewOffset) > kHeight) {
+    GetCellIndexesInRange(kDestinationOffset, kDestinationOffset + kHeight,
+                          kMaximumNumberOfPrefetchedRows, &cell_indexes);
+  }
+
+  // Visible rows don't need prefetching.
+  cell_indexes.erase(
+      std::remove_if(cell_indexes.begin(), cell_indexes.end(),
+                     [this](const CellIndex& cell_index) {
+                       return GetCell(cell_index) != nullptr;
+                     }),
+      cell_indexes.end());
+  std::sort(cell_indexes.begin(), cell_indexes.end(), CompareCellIndexes);
+  cell_indexes.erase(
+      std::unique(cell_indexes.begin(), cell_indexes.end(),
+                  [](const CellIndex& a, const CellIndex& b) {
+                    return a.section_index == b.section_index &&
+                           a.row_index == b.row_index;
+                  }),
+      cell_indexes.end());
+
+  std::vector<CellIndex> canceled_cell_indexes;
+  std::set_difference(cell_indexes_for_prefetched_rows_.begin(),
+                      cell_indexes_for_prefetched_rows_.end(),
+                      cell_indexes.begin(), cell_indexes.end(),
+                      std::back_inserter(canceled_cell_indexes),
+                      CompareCellIndexes);
+  // Rows that became visible are not canceled.
+  canceled_cell_indexes.erase(
+      std::remove_if(canceled_cell_indexes.begin(),
+                     canceled_cell_indexes.end(),
+                     [this](const CellIndex& cell_index) {
+                       return GetCell(cell_index) != nullptr;
+                     }),
+      canceled_cell_indexes.end());
+  std::vector<CellIndex> requested_cell_indexes;
+  std::set_difference(cell_indexes.begin(), cell_indexes.end(),
+                      cell_indexes_for_prefetched_rows_.begin(),
+                      cell_indexes_for_prefetched_rows_.end(),
+                      std::back_inserter(requested_cell_indexes),
+                      CompareCellIndexes);
+  cell_indexes_for_prefetched_rows_.swap(cell_indexes);
+
+  if (!canceled_cell_indexes.empty()) {
+    prefetch_data_source_->TableViewCancelPrefetchingForRows(
+        this, canceled_cell_indexes);
+  }
+  if (!requested_cell_indexes.empty()) {
+    prefetch_data_source_->TableViewPrefetchRows(this, requested_cell_indexes);
+  }
+}
+
 void TableView::ReloadData() {
   down_event_cell_ = nullptr;
+  CancelPrefetchingRows();
   for (TableViewCell* cell : visible_cells_) {
     cell->RemoveFromParent();
     ReuseCell(cell);
   }
   visible_cells_.clear();
   cell_indexes_for_visible_rows_.clear();
-  cell_indexes_for_selected_rows_.clear();
+  cell_indexes_for_visible_cells_.clear();
+  visible_cells_by_key_.clear();
+  selected_rows_.clear();
   should_update_layout_ = true;
+  should_update_row_offset_index_ = true;
   SetContentViewOffset({0, 0});
   layout_view_->Redraw();
 }
 
+void TableView::ReloadRows(const std::vector<CellIndex>& cell_indexes) {
+  BeginUpdates();
+  pending_updates_.reloaded_rows.insert(pending_updates_.reloaded_rows.end(),
+                                        cell_indexes.begin(),
+                                        cell_indexes.end());
+  EndUpdates();
+}
+
+void TableView::ReloadSections(const std::vector<int>& section_indexes) {
+  BeginUpdates();
+  pending_updates_.reloaded_sections.insert(
+      pending_updates_.reloaded_sections.end(), section_indexes.begin(),
+      section_indexes.end());
+  EndUpdates();
+}
+
 void TableView::RefreshLayout() {
   should_update_layout_ = true;
+  should_update_row_offset_index_ = true;
   layout_view_->Redraw();
   Redraw();
 }
 
 void TableView::ReuseCell(TableViewCell* cell) {
   cell->RemoveFromParent();
-  const std::string kReuseIdentifier = cell->reuse_identifier();
-  if (kReuseIdentifier.empty()) {
-    delete cell;
-    return;
-  }
-
-  std::queue<TableViewCell*>* reusable_cells = \
-      &(reusable_cells_[kReuseIdentifier]);
-  reusable_cells->push(cell);
+  row_animation_displacements_.erase(cell);
+  reusable_cells_.Enqueue(cell->reuse_id(), cell);
 }
 
 void TableView::ReuseVisibleCells(const int begin, const int last) {
@@ -249,8 +1141,14 @@ void TableView::ReuseVisibleCells(const int begin, const int last) {
        iterator < visible_cells_.begin() + last;
        ++iterator) {
     auto cell = reinterpret_cast<TableViewCell*>(*iterator);
+    cell_indexes_for_visible_cells_.erase(cell);
     ReuseCell(cell);
   }
+  for (auto iterator = cell_indexes_for_visible_rows_.begin() + begin;
+       iterator < cell_indexes_for_visible_rows_.begin() + last;
+       ++iterator) {
+    visible_cells_by_key_.erase(GetCellKey(*iterator));
+  }
   visible_cells_.erase(visible_cells_.begin() + begin,
                        visible_cells_.begin() + last);
   cell_indexes_for_visible_rows_.erase(
@@ -275,7 +1173,7 @@ void TableView::RenderLayoutView(moui::Widget* widget, NVGcontext* context) {
     if (cell_index.section_index != current_section) {
       current_section = cell_index.section_index;
       last_row_of_the_current_section = \
-          data_source_->GetNumberOfRowsInSection(this, current_section) - 1;
+          number_of_rows_in_sections_[current_section] - 1;
     }
 
     TableViewCell* cell = visible_cells_[vector_index];
@@ -322,58 +1220,32 @@ void TableView::ScrollToCellIndex(const CellIndex cell_index,
     cell_offset = cell->GetY();
     cell_height = cell->GetHeight();
   } else {
-    float content_view_offset = -1;
-    bool finished = false;
-
-    // Table header view.
-    if (table_header_view_ != nullptr) {
-      content_view_offset = table_header_view_->GetHeight();
+    if (should_update_row_offset_index_) {
+      should_update_row_offset_index_ = false;
+      should_update_layout_ = true;
+      UpdateRowOffsetIndex();
     }
-
-    const int kNumberOfSections = data_source_->GetNumberOfSections(this);
-    for (int section_index = 0;
-         section_index < kNumberOfSections;
-         ++section_index) {
-      const int kNumberOfRows = data_source_->GetNumberOfRowsInSection(
-          this, section_index);
-      if (kNumberOfRows == 0) {
-        cell_height = 0;
-        cell_offset = std::max(0.0f, content_view_offset);
-        break;
-      }
-      if (section_index > 0) {
-        content_view_offset += height_between_sections_;
-      }
-
-      // Section header.
-      if (delegate_ != nullptr) {
-        const float kHeaderHeight = delegate_->GetTableViewSectionHeaderHeight(
-            this, section_index);
-        content_view_offset = content_view_offset < 0 ?
-                              kHeaderHeight :
-                              content_view_offset + kHeaderHeight;
-      }
-
-      // Rows.
-      for (int row_index = 0; row_index < kNumberOfRows; ++row_index) {
-        cell_offset = content_view_offset <= 0 ? 0 : content_view_offset - 1;
-        cell_height = GetRowHeight({section_index, row_index});
-        if (section_index == cell_index.section_index &&
-            row_index == cell_index.row_index) {
-          finished = true;
-          break;
-        }
-        content_view_offset = cell_offset + cell_height;
-      }
-      if (finished)
-        break;
-
-      // Section footer.
-      if (delegate_ != nullptr) {
-        const float kFooterHeight = delegate_->GetTableViewSectionFooterHeight(
-            this, section_index);
-        content_view_offset += kFooterHeight;
-      }
+    if (cell_index.section_index < 0 || cell_index.row_index < 0 ||
+        cell_index.section_index >=
+            static_cast<int>(section_item_indexes_.size())) {
+      return;
+    }
+    const int kNumberOfRows = \
+        number_of_rows_in_sections_[cell_index.section_index];
+    const int kHeaderItemIndex = \
+        section_item_indexes_[cell_index.section_index];
+    const float kRowOffsetBase = GetRowOffsetBase();
+    if (kNumberOfRows == 0) {
+      cell_height = 0;
+      cell_offset = std::max(
+          0.0f,
+          kRowOffsetBase
+          + static_cast<float>(
+                row_offset_index_.GetPrefixSum(kHeaderItemIndex)));
+    } else if (cell_index.row_index < kNumberOfRows) {
+      const int kItemIndex = kHeaderItemIndex + 1 + cell_index.row_index;
+      cell_offset = kRowOffsetBase + row_offset_index_.GetPrefixSum(kItemIndex);
+      cell_height = row_offset_index_.GetValue(kItemIndex) + 1;
     }
   }
   if (cell_offset < 0 || cell_height < 0)
@@ -415,6 +1287,23 @@ void TableView::ScrollToCellIndex(const CellIndex cell_index,
     SetContentViewOffset({0, new_content_view_offset});
 }
 
+void TableView::SelectAllRows() {
+  if (data_source_ == nullptr)
+    return;
+
+  selected_rows_.clear();
+  const int kNumberOfSections = data_source_->GetNumberOfSections(this);
+  for (int section_index = 0;
+       section_index < kNumberOfSections;
+       ++section_index) {
+    const int kNumberOfRows = data_source_->GetNumberOfRowsInSection(
+        this, section_index);
+    if (kNumberOfRows > 0)
+      selected_rows_[section_index].AddRange(0, kNumberOfRows);
+  }
+  UpdateSelectedStatesOfVisibleCells();
+}
+
 void TableView::SelectRow(const CellIndex cell_index) {
   if (cell_index.section_index < 0 || cell_index.row_index < 0) {
     return;
@@ -425,22 +1314,6 @@ void TableView::SelectRow(const CellIndex cell_index) {
     return;
   }
 
-  int position = 0;
-  for (auto iterator = cell_indexes_for_selected_rows_.begin();
-       iterator != cell_indexes_for_selected_rows_.end();
-       ++iterator) {
-    const CellIndex kCachedCellIndex = static_cast<CellIndex>(*iterator);
-    if (kCachedCellIndex.section_index < cell_index.section_index ||
-        (kCachedCellIndex.section_index == cell_index.section_index &&
-         kCachedCellIndex.row_index < cell_index.row_index)) {
-      ++position;
-    } else if (kCachedCellIndex.section_index > cell_index.section_index ||
-               (cell_index.section_index == kCachedCellIndex.section_index &&
-                cell_index.row_index == kCachedCellIndex.row_index)) {
-      break;
-    }
-  }  // end of `cell_indexes_for_selected_rows_` iterator.
-
   // Updates the states of the corresponded cell.
   TableViewCell* cell = GetCell(cell_index);
   if (cell != nullptr) {
@@ -448,13 +1321,32 @@ void TableView::SelectRow(const CellIndex cell_index) {
     BringChildToFront(cell);
   }
 
-  // Inserts the cell index to `cell_indexes_for_selected_rows_`.
-  cell_indexes_for_selected_rows_.insert(
-      cell_indexes_for_selected_rows_.begin() + position, cell_index);
+  // Inserts the cell index to `selected_rows_`.
+  selected_rows_[cell_index.section_index].AddIndex(cell_index.row_index);
   if (delegate_ != nullptr)
     delegate_->TableViewDidSelectRow(this, cell_index);
 }
 
+void TableView::SelectRows(const CellIndex cell_index, const int count) {
+  if (cell_index.section_index < 0 || cell_index.row_index < 0 || count <= 0)
+    return;
+
+  selected_rows_[cell_index.section_index].AddRange(cell_index.row_index,
+                                                    count);
+  UpdateSelectedStatesOfVisibleCells();
+}
+
+void TableView::ScheduleWarmingUpReusableCells() {
+  is_warming_up_reusable_cells_ = true;
+  std::weak_ptr<bool> token = warm_up_reusable_cells_token_;
+  Clock::ExecuteCallbackOnMainThread(
+      kWarmUpReusableCellsInterval,
+      [this, token]() {
+        if (!token.expired())
+          WarmUpReusableCells();
+      });
+}
+
 void TableView::SetCellHighlighted(TableViewCell* cell,
                                    const bool highlighted) {
   if (cell->highlighted() == highlighted)
@@ -499,6 +1391,27 @@ bool TableView::UpdateLayout() {
     return false;
   }
 
+  if (should_update_row_offset_index_) {
+    should_update_row_offset_index_ = false;
+    should_update_layout_ = true;
+    UpdateRowOffsetIndex();
+  }
+
+  // Determines the progress of animating the displacement of visible cells
+  // after `EndUpdates()`.
+  float row_animation_progress = 1;
+  if (is_animating_row_updates_) {
+    const double kElapsedTime = std::max(
+        0.0, AnimationEngine::GetSharedEngine()->frame_timestamp()
+             - row_animation_initial_timestamp_);
+    if (kElapsedTime < row_animation_duration_ &&
+        !row_animation_displacements_.empty()) {
+      const float kTime = kElapsedTime / row_animation_duration_;
+      row_animation_progress = 1 - (1 - kTime) * (1 - kTime);  // ease out
+    }
+    should_update_layout_ = true;
+  }
+
   const Point kContentViewOffset = GetContentViewOffset();
   const float kTopmostContentViewOffset = kContentViewOffset.y;
   const float kBottommostContentViewOffset = \
@@ -510,13 +1423,13 @@ bool TableView::UpdateLayout() {
     return false;
   }
   should_update_layout_ = false;
+  const float kPreviousTopmostContentViewOffset = \
+      last_topmost_content_view_offset_;
   last_topmost_content_view_offset_ = kTopmostContentViewOffset;
   last_bottommost_content_view_offset_ = kBottommostContentViewOffset;
 
   float content_view_offset = -1;
   int index_of_visible_cells = -1;
-  bool previous_cell_is_visible = false;
-  bool done_processing_visible_cells = false;
   const float kLeftPadding = left_padding();
   const float kTableWidth = GetWidth() - kLeftPadding - right_padding();
 
@@ -529,75 +1442,103 @@ bool TableView::UpdateLayout() {
     content_view_offset = table_header_view_->GetHeight();
   }
 
-  const int kNumberOfSections = data_source_->GetNumberOfSections(this);
-  for (int section_index = 0;
-       section_index < kNumberOfSections;
-       ++section_index) {
-    const int kNumberOfRows = data_source_->GetNumberOfRowsInSection(
-        this, section_index);
-    if (kNumberOfRows == 0) {
+  // Locates the first item whose bottom reaches the topmost content view
+  // offset, and begins with the section that item belongs to.
+  const float kRowOffsetBase = GetRowOffsetBase();
+  const int kNumberOfItems = row_offset_index_.size();
+  const int kNumberOfSections = \
+      static_cast<int>(number_of_rows_in_sections_.size());
+  const int kFirstItemIndex = row_offset_index_.FindLowerBound(
+      kTopmostContentViewOffset - kRowOffsetBase);
+  int section_index = kNumberOfSections;
+  int row_index = 0;
+  if (kFirstItemIndex < kNumberOfItems) {
+    section_index = GetSectionIndexForItem(kFirstItemIndex);
+    row_index = std::min(
+        number_of_rows_in_sections_[section_index],
+        std::max(0,
+                 kFirstItemIndex - section_item_indexes_[section_index] - 1));
+  }
+
+  // Removes all previous visible cells ahead of the first visible cell.
+  int erase_last_index = 0;
+  for (CellIndex& cell_index : cell_indexes_for_visible_rows_) {
+    if (cell_index.section_index < section_index ||
+        (cell_index.section_index == section_index &&
+         cell_index.row_index < row_index)) {
+      ++erase_last_index;
       continue;
     }
-    if (section_index > 0) {
-      content_view_offset += height_between_sections_;
+    break;
+  }
+  ReuseVisibleCells(0, erase_last_index);
+
+  // Counts the cells created for each reuse identifier while scrolling,
+  // which is used for determining the number of cells to warm up.
+  const bool kIsScrolling = !visible_cells_.empty();
+  std::map<int, int> numbers_of_created_cells;
+
+  bool done_processing_visible_cells = false;
+  for (; section_index < kNumberOfSections && !done_processing_visible_cells;
+       ++section_index, row_index = 0) {
+    const int kNumberOfRows = number_of_rows_in_sections_[section_index];
+    if (kNumberOfRows == 0) {
+      continue;
     }
+    const int kHeaderItemIndex = section_item_indexes_[section_index];
+    const int kFooterItemIndex = kHeaderItemIndex + kNumberOfRows + 1;
 
     // Section header.
+    if (section_index == first_non_empty_section_index_) {
+      if (section_index > 0)
+        content_view_offset += height_between_sections_;
+    } else {
+      content_view_offset = \
+          kRowOffsetBase + row_offset_index_.GetPrefixSum(kHeaderItemIndex)
+          + 1 + height_between_sections_;
+    }
     if (delegate_ != nullptr) {
-      const float kHeaderHeight = delegate_->GetTableViewSectionHeaderHeight(
-          this, section_index);
       moui::Widget* header = delegate_->GetTableViewSectionHeader(
           this, section_index);
       if (header != nullptr) {
         header->SetBounds(kLeftPadding, content_view_offset, kTableWidth,
-                          kHeaderHeight);
+                          section_header_heights_[section_index]);
         AddChild(header);
       }
-      content_view_offset = content_view_offset < 0 ?
-                            kHeaderHeight :
-                            content_view_offset + kHeaderHeight;
     }
 
-    // Rows.
-    for (int row_index = 0; row_index < kNumberOfRows; ++row_index) {
-      const float kRowHeight = GetRowHeight({section_index, row_index});
-      const float kCellTopOffset = content_view_offset <= 0 ?
-                                   0 : content_view_offset - 1;
-      const float kCellBottomOffset = kCellTopOffset + kRowHeight - 1;
-      content_view_offset = kCellTopOffset + kRowHeight;
-
-      if (done_processing_visible_cells)
-        continue;
-
-      const bool kCellIsVisible = \
-          kCellBottomOffset >= kTopmostContentViewOffset &&
-          kBottommostContentViewOffset > kCellTopOffset;
-
-      // Skips if the both the current and previous cells are invisible.
-      if (!kCellIsVisible && !previous_cell_is_visible) {
-        continue;
+    // Section footer.
+    if (delegate_ != nullptr) {
+      moui::Widget* footer = delegate_->GetTableViewSectionFooter(
+          this, section_index);
+      if (footer != nullptr) {
+        footer->SetBounds(
+            kLeftPadding,
+            kRowOffsetBase + row_offset_index_.GetPrefixSum(kFooterItemIndex)
+                + 1,
+            kTableWidth, section_footer_heights_[section_index]);
+        AddChild(footer);
       }
+    }
 
-      // Deals with the first visible cell. Removes all previous visible cells
-      // ahead of which.
-      if (kCellIsVisible && !previous_cell_is_visible) {
-        previous_cell_is_visible = kCellIsVisible;
-        int erase_last_index = 0;
-        for (CellIndex& cell_index : cell_indexes_for_visible_rows_) {
-          if (cell_index.section_index < section_index ||
-              (cell_index.section_index == section_index &&
-               cell_index.row_index < row_index)) {
-             ++erase_last_index;
-             continue;
-          }
-          break;
-        }
-        ReuseVisibleCells(0, erase_last_index);
-      }  // end of dealing with the first visible cell.
+    // Rows.
+    float cell_top_offset = \
+        kRowOffsetBase
+        + row_offset_index_.GetPrefixSum(kHeaderItemIndex + 1 + row_index);
+    for (; row_index < kNumberOfRows; ++row_index) {
+      const float kCellTopOffset = cell_top_offset;
+      if (kCellTopOffset >= kBottommostContentViewOffset) {
+        done_processing_visible_cells = true;
+        break;
+      }
+      const float kRowHeight = row_offset_index_.GetValue(
+          kHeaderItemIndex + 1 + row_index) + 1;
+      cell_top_offset += kRowHeight - 1;
 
       ++index_of_visible_cells;
       bool cell_was_visible = false;
-      if (index_of_visible_cells < cell_indexes_for_visible_rows_.size()) {
+      if (index_of_visible_cells <
+          static_cast<int>(cell_indexes_for_visible_rows_.size())) {
         const CellIndex kCellIndex = \
             cell_indexes_for_visible_rows_[index_of_visible_cells];
         cell_was_visible = kCellIndex.section_index == section_index &&
@@ -608,55 +1549,50 @@ bool TableView::UpdateLayout() {
       if (cell_was_visible) {
         cell = visible_cells_[index_of_visible_cells];
       } else {
+        const int kNumberOfHits = reusable_cells_.number_of_hits();
         cell = data_source_->GetTableViewCell(this, section_index, row_index);
+        // The data source created a new cell if no reusable cell was
+        // dequeued.
+        if (reusable_cells_.number_of_hits() == kNumberOfHits)
+          reusable_cells_.RecordAllocation();
         visible_cells_.insert(visible_cells_.begin() + index_of_visible_cells,
                               cell);
         cell_indexes_for_visible_rows_.insert(
             cell_indexes_for_visible_rows_.begin() + index_of_visible_cells,
             {section_index, row_index});
+        cell_indexes_for_visible_cells_[cell] = {section_index, row_index};
+        visible_cells_by_key_[GetCellKey({section_index, row_index})] = cell;
 
         // Updates the selected state of the cell.
-        bool cell_is_selected = false;
-        for (CellIndex& cell_index : cell_indexes_for_selected_rows_) {
-          if (cell_index.section_index == section_index &&
-              cell_index.row_index == row_index) {
-             cell_is_selected = true;
-             break;
-          }
-        }
-        cell->set_selected(cell_is_selected);
+        cell->set_selected(IsRowSelected({section_index, row_index}));
         AddChild(cell);
+        if (kIsScrolling && cell->reuse_id() != ReusePool::kInvalidReuseId)
+          ++numbers_of_created_cells[cell->reuse_id()];
       }
       if (cell->highlighted())
         BringChildToFront(cell);
       else
         SendChildToBack(cell);
       cell->SetBounds(kLeftPadding, kCellTopOffset, kTableWidth, kRowHeight);
-
-      if (kCellBottomOffset >= kBottommostContentViewOffset) {
-        ReuseVisibleCells(
-            index_of_visible_cells + 1,
-            static_cast<int>(cell_indexes_for_visible_rows_.size()));
-        done_processing_visible_cells = true;
+      if (row_animation_progress < 1) {
+        auto displacement_match = row_animation_displacements_.find(cell);
+        if (displacement_match != row_animation_displacements_.end()) {
+          cell->SetY(kCellTopOffset
+                     + displacement_match->second
+                       * (1 - row_animation_progress));
+        }
       }
     }  // end of row
-
-    // Section footer.
-    if (delegate_ != nullptr) {
-      const float kFooterHeight = delegate_->GetTableViewSectionFooterHeight(
-          this, section_index);
-      moui::Widget* footer = delegate_->GetTableViewSectionFooter(
-          this, section_index);
-      if (footer != nullptr) {
-        footer->SetBounds(kLeftPadding, content_view_offset, kTableWidth,
-                          kFooterHeight);
-        AddChild(footer);
-      }
-      content_view_offset += kFooterHeight;
-    }
   }  // end of section
 
+  // Reuses the remaining cells that are no longer visible.
+  ReuseVisibleCells(index_of_visible_cells + 1,
+                    static_cast<int>(cell_indexes_for_visible_rows_.size()));
+
   // Table footer view.
+  if (first_non_empty_section_index_ >= 0) {
+    content_view_offset = kRowOffsetBase + row_offset_index_.GetTotal() + 1;
+  }
   if (table_footer_view_ != nullptr) {
     table_footer_view_->SetX(kLeftPadding);
     table_footer_view_->SetY(content_view_offset);
@@ -667,9 +1603,92 @@ bool TableView::UpdateLayout() {
 
   SetContentViewSize(-1, content_view_offset);
   layout_view_->Redraw();
+
+  if (is_animating_row_updates_) {
+    if (row_animation_progress >= 1) {
+      is_animating_row_updates_ = false;
+      row_animation_displacements_.clear();
+      Widget::StopAnimation(false);
+    }
+  }
+
+  if (prefetch_data_source_ != nullptr) {
+    PrefetchRows(kPreviousTopmostContentViewOffset);
+
+    // Updates the expected numbers of reusable cells and warms them up.
+    for (auto& pair : numbers_of_created_cells) {
+      int* spare_reusable_cell_count = \
+          &spare_reusable_cell_counts_[pair.first];
+      *spare_reusable_cell_count = std::min(
+          reusable_cells_.GetCapacity(pair.first),
+          std::max(*spare_reusable_cell_count,
+                   std::max(kMinimumNumberOfSpareReusableCells, pair.second)));
+    }
+    if (!numbers_of_created_cells.empty() && !is_warming_up_reusable_cells_) {
+      ScheduleWarmingUpReusableCells();
+    }
+  }
   return true;
 }
 
+void TableView::UpdateRowOffsetIndex() {
+  number_of_rows_in_sections_.clear();
+  section_footer_heights_.clear();
+  section_header_heights_.clear();
+  section_item_indexes_.clear();
+  estimated_items_.clear();
+  first_non_empty_section_index_ = -1;
+  number_of_estimated_rows_ = 0;
+
+  std::vector<double> items;
+  const int kNumberOfSections = data_source_->GetNumberOfSections(this);
+  for (int section_index = 0;
+       section_index < kNumberOfSections;
+       ++section_index) {
+    const int kNumberOfRows = std::max(
+        0, data_source_->GetNumberOfRowsInSection(this, section_index));
+    float header_height = 0;
+    float footer_height = 0;
+    if (kNumberOfRows > 0 && delegate_ != nullptr) {
+      header_height = delegate_->GetTableViewSectionHeaderHeight(
+          this, section_index);
+      footer_height = delegate_->GetTableViewSectionFooterHeight(
+          this, section_index);
+    }
+    number_of_rows_in_sections_.push_back(kNumberOfRows);
+    section_footer_heights_.push_back(footer_height);
+    section_header_heights_.push_back(header_height);
+    section_item_indexes_.push_back(static_cast<int>(items.size()));
+    if (kNumberOfRows == 0)
+      continue;
+    if (first_non_empty_section_index_ < 0)
+      first_non_empty_section_index_ = section_index;
+
+    const float kSpacing = section_index > 0 ? height_between_sections_ : 0;
+    items.push_back(std::max(0.0f, kSpacing + header_height));
+    estimated_items_.push_back(false);
+    for (int row_index = 0; row_index < kNumberOfRows; ++row_index) {
+      bool is_estimated = false;
+      const float kRowHeight = GetRowHeight({section_index, row_index},
+                                            &is_estimated);
+      items.push_back(std::max(0.0f, kRowHeight - 1));
+      estimated_items_.push_back(is_estimated);
+      if (is_estimated)
+        ++number_of_estimated_rows_;
+    }
+    items.push_back(std::max(0.0f, footer_height));
+    estimated_items_.push_back(false);
+  }
+  row_offset_index_.Assign(items);
+}
+
+void TableView::UpdateSelectedStatesOfVisibleCells() {
+  for (int i = 0; i < static_cast<int>(visible_cells_.size()); ++i) {
+    visible_cells_[i]->set_selected(
+        IsRowSelected(cell_indexes_for_visible_rows_[i]));
+  }
+}
+
 bool TableView::ValidateCellIndex(const CellIndex cell_index) {
   if (data_source_ == nullptr) {
     return false;
@@ -686,11 +1705,45 @@ bool TableView::ValidateCellIndex(const CellIndex cell_index) {
   return true;
 }
 
+void TableView::WarmUpReusableCells() {
+  is_warming_up_reusable_cells_ = false;
+  if (prefetch_data_source_ == nullptr)
+    return;
+
+  auto iterator = spare_reusable_cell_counts_.begin();
+  for (; iterator != spare_reusable_cell_counts_.end(); ++iterator) {
+    if (reusable_cells_.GetNumberOfWidgets(iterator->first) <
+        iterator->second) {
+      break;
+    }
+  }
+  if (iterator == spare_reusable_cell_counts_.end())
+    return;
+
+  // Creates a cell only when the table view is idle.
+  if (!is_scrolling() && !IsAnimating()) {
+    TableViewCell* cell = prefetch_data_source_->CreateTableViewCell(
+        this, ReusePool::GetReuseIdentifier(iterator->first));
+    if (cell == nullptr) {
+      // Stops warming up the identifier that the data source doesn't support.
+      iterator->second = 0;
+    } else if (cell->reuse_id() != iterator->first) {
+      delete cell;
+      iterator->second = 0;
+    } else {
+      reusable_cells_.RecordAllocation();
+      reusable_cells_.Enqueue(iterator->first, cell);
+    }
+  }
+  ScheduleWarmingUpReusableCells();
+}
+
 bool TableView::WidgetViewWillRender(NVGcontext* context) {
   const bool kResult = ScrollView::WidgetViewWillRender(context);
   if (!kResult)
     return false;
 
+  MeasureEstimatedRows(context);
   UpdateLayout();
   return true;
 }
@@ -702,6 +1755,24 @@ void TableView::set_data_source(TableViewDataSource* data_source) {
   }
 }
 
+void TableView::set_delegate(TableViewDelegate* delegate) {
+  if (delegate != delegate_) {
+    delegate_ = delegate;
+    should_update_layout_ = true;
+    should_update_row_offset_index_ = true;
+    Redraw();
+  }
+}
+
+void TableView::set_estimated_row_height(const float estimated_row_height) {
+  if (estimated_row_height != estimated_row_height_) {
+    estimated_row_height_ = estimated_row_height;
+    should_update_layout_ = true;
+    should_update_row_offset_index_ = true;
+    Redraw();
+  }
+}
+
 void TableView::set_height_between_sections(
     const float height_between_sections) {
   if (height_between_sections != height_between_sections_) {
@@ -710,12 +1781,21 @@ void TableView::set_height_between_sections(
   }
 }
 
+void TableView::set_prefetch_data_source(
+    TableViewDataSourcePrefetching* prefetch_data_source) {
+  if (prefetch_data_source != prefetch_data_source_) {
+    prefetch_data_source_ = prefetch_data_source;
+    cell_indexes_for_prefetched_rows_.clear();
+  }
+}
+
 void TableView::set_row_height(const float row_height) {
   if (row_height == row_height_) {
     return;
   }
   row_height_ = row_height;
   should_update_layout_ = true;
+  should_update_row_offset_index_ = true;
   if (widget_view() != nullptr)
     widget_view()->Redraw();
 }
@@ -20,12 +20,17 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
-#include <queue>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "moui/base.h"
+#include "moui/core/fenwick_tree.h"
+#include "moui/core/index_set.h"
 #include "moui/nanovg_hook.h"
+#include "moui/widgets/reuse_pool.h"
 #include "moui/widgets/scroll_view.h"
 
 namespace moui {
@@ -33,6 +38,7 @@ namespace moui {
 // Forward declaration.
 class TableViewCell;
 class TableViewDataSource;
+class TableViewDataSourcePrefetching;
 class TableViewDelegate;
 
 // The `TableView` widget is a means for displaying and editing hierachical
@@ -68,12 +74,50 @@ class TableView : public ScrollView {
   TableView();
   ~TableView();
 
+  // Begins a series of method calls that insert, delete, reload or move rows
+  // and sections of the table view. The changes are applied at once when the
+  // outermost `EndUpdates()` is called, so the cell indexes passed to
+  // deletion, reload and the source of move operations always refer to the
+  // table view before updates, and the cell indexes passed to insertion and
+  // the destination of move operations always refer to the table view after
+  // updates. Calls to `BeginUpdates()` and `EndUpdates()` can be nested.
+  void BeginUpdates();
+
+  // Deletes the rows identified by `cell_indexes`.
+  void DeleteRows(const std::vector<CellIndex>& cell_indexes);
+
+  // Deletes the sections identified by `section_indexes`.
+  void DeleteSections(const std::vector<int>& section_indexes);
+
+  // Deselects all rows in O(1) time. Unlike `DeselectRow()`, the delegate is
+  // neither consulted nor notified.
+  void DeselectAllRows();
+
   // Deselects a row in the table view identified by `cell_index`.
   void DeselectRow(const CellIndex cell_index);
 
+  // Deselects `count` consecutive rows in the same section beginning at
+  // `cell_index` in O(log n) time. Unlike `DeselectRow()`, the delegate is
+  // neither consulted nor notified.
+  void DeselectRows(const CellIndex cell_index, const int count);
+
   // Returns a reusable table-view cell object located by its identifier.
   TableViewCell* DequeueReusableCell(const std::string identifier);
 
+  // Returns a reusable table-view cell object located by its reuse ID, which
+  // avoids interning the identifier on every call. See
+  // `ReusePool::GetReuseId()`.
+  TableViewCell* DequeueReusableCell(const int reuse_id);
+
+  // Concludes a series of method calls that insert, delete, reload or move
+  // rows and sections. Unlike `ReloadData()`, only the affected visible cells
+  // are updated, and both the selection and the scroll position are
+  // preserved. The displacement of visible cells is animated if
+  // `row_animation_duration_` is greater than 0. Returns `false` if the
+  // updates are inconsistent with the data source, in which case all visible
+  // cells are reloaded and the selection is cleared.
+  bool EndUpdates();
+
   // Returns the cell object at the specified cell index, or `nullptr` if the
   // cell is not visible or `cell_index` is out of range.
   TableViewCell* GetCell(const CellIndex cell_index) const;
@@ -82,9 +126,40 @@ class TableView : public ScrollView {
   // table-view cell. `nullptr` is returned if the cell index is invalid.
   CellIndex GetCellIndex(TableViewCell* cell) const;
 
+  // Returns the cell indexes of all selected rows in ascending order. This
+  // takes time proportional to the number of selected rows.
+  std::vector<CellIndex> GetCellIndexesForSelectedRows() const;
+
+  // Returns the number of selected rows.
+  int GetNumberOfSelectedRows() const;
+
+  // Inherited from `Widget` class. Releases the reusable cells.
+  void HandleMemoryWarning(NVGcontext* context) override;
+
+  // Inserts rows at the locations identified by `cell_indexes`.
+  void InsertRows(const std::vector<CellIndex>& cell_indexes);
+
+  // Inserts sections at the locations identified by `section_indexes`.
+  void InsertSections(const std::vector<int>& section_indexes);
+
+  // Returns `true` if the row identified by `cell_index` is selected.
+  bool IsRowSelected(const CellIndex cell_index) const;
+
+  // Moves the row at `cell_index` to `new_cell_index`.
+  void MoveRow(const CellIndex cell_index, const CellIndex new_cell_index);
+
+  // Moves the section at `section_index` to `new_section_index`.
+  void MoveSection(const int section_index, const int new_section_index);
+
   // Reloads the rows and sections of the table view.
   void ReloadData();
 
+  // Reloads the rows identified by `cell_indexes`.
+  void ReloadRows(const std::vector<CellIndex>& cell_indexes);
+
+  // Reloads the sections identified by `section_indexes`.
+  void ReloadSections(const std::vector<int>& section_indexes);
+
   // Refreshes the layout.
   void RefreshLayout();
 
@@ -94,14 +169,27 @@ class TableView : public ScrollView {
                          const ScrollPosition scroll_position,
                          const bool animating);
 
+  // Selects all rows in O(m log n) time where m is the number of sections.
+  // Unlike `SelectRow()`, the delegate is neither consulted nor notified.
+  void SelectAllRows();
+
   // Selects a row in the table view identified by `cell_index`.
   void SelectRow(const CellIndex cell_index);
 
+  // Selects `count` consecutive rows in the same section beginning at
+  // `cell_index` in O(log n) time. Unlike `SelectRow()`, the delegate is
+  // neither consulted nor notified.
+  void SelectRows(const CellIndex cell_index, const int count);
+
   // Returns `true` if the specified cell index is valid.
   bool ValidateCellIndex(const CellIndex cell_index);
 
   // Setters and accessors.
+  // Deprecated. Use `GetCellIndexesForSelectedRows()` instead. The returned
+  // vector is a snapshot of the selection, and changing it doesn't select or
+  // deselect any row.
   std::vector<CellIndex>* cell_indexes_for_selected_rows() {
+    cell_indexes_for_selected_rows_ = GetCellIndexesForSelectedRows();
     return &cell_indexes_for_selected_rows_;
   }
   std::vector<CellIndex>* cell_indexes_for_visible_rows() {
@@ -110,9 +198,21 @@ class TableView : public ScrollView {
   TableViewDataSource* data_source() const { return data_source_; }
   void set_data_source(TableViewDataSource* data_source);
   TableViewDelegate* delegate() const { return delegate_; }
-  void set_delegate(TableViewDelegate* delegate) { delegate_ = delegate; }
+  void set_delegate(TableViewDelegate* delegate);
+  float estimated_row_height() const { return estimated_row_height_; }
+  void set_estimated_row_height(const float estimated_row_height);
   float height_between_sections() const { return height_between_sections_; }
   void set_height_between_sections(const float height_between_sections);
+  TableViewDataSourcePrefetching* prefetch_data_source() const {
+    return prefetch_data_source_;
+  }
+  void set_prefetch_data_source(
+      TableViewDataSourcePrefetching* prefetch_data_source);
+  ReusePool* reusable_cells() { return &reusable_cells_; }
+  double row_animation_duration() const { return row_animation_duration_; }
+  void set_row_animation_duration(const double duration) {
+    row_animation_duration_ = duration;
+  }
   float row_height() const { return row_height_; }
   void set_row_height(const float row_height);
   NVGcolor separator_color() const { return separator_color_; }
@@ -130,18 +230,82 @@ class TableView : public ScrollView {
   bool WidgetViewWillRender(NVGcontext* context) override;
 
  private:
-  // Returns the height to use for a row in a specified location.
-  float GetRowHeight(const CellIndex cell_index);
+  // Returns the key of `visible_cells_by_key_` for the specified cell index.
+  static int64_t GetCellKey(const CellIndex cell_index) {
+    return (static_cast<int64_t>(cell_index.section_index) << 32) |
+           static_cast<uint32_t>(cell_index.row_index);
+  }
+
+  // The changes recorded between `BeginUpdates()` and `EndUpdates()`.
+  struct PendingUpdates {
+    // The cell indexes of the rows to delete before updates.
+    std::vector<CellIndex> deleted_rows;
+    // The indexes of the sections to delete before updates.
+    std::vector<int> deleted_sections;
+    // The cell indexes of the rows to insert after updates.
+    std::vector<CellIndex> inserted_rows;
+    // The indexes of the sections to insert after updates.
+    std::vector<int> inserted_sections;
+    // The pairs of cell indexes before and after moving rows.
+    std::vector<std::pair<CellIndex, CellIndex>> moved_rows;
+    // The pairs of section indexes before and after moving sections.
+    std::vector<std::pair<int, int>> moved_sections;
+    // The cell indexes of the rows to reload before updates.
+    std::vector<CellIndex> reloaded_rows;
+    // The indexes of the sections to reload before updates.
+    std::vector<int> reloaded_sections;
+  };
+
+  // Applies `pending_updates_` to the cached section information,
+  // `row_offset_index_`, visible cells and the selection. Only the items from
+  // the first updated section onward are rebuilt. Returns `false` if the
+  // updates are inconsistent with the data source.
+  bool ApplyUpdates();
+
+  // Cancels the prefetching of `cell_indexes_for_prefetched_rows_`.
+  void CancelPrefetchingRows();
+
+  // Appends the cell indexes of rows overlapping the vertical range between
+  // `top` and `bottom` in the content view to `cell_indexes`, until the number
+  // of elements in `cell_indexes` reaches `capacity`.
+  void GetCellIndexesInRange(const float top, const float bottom,
+                             const int capacity,
+                             std::vector<CellIndex>* cell_indexes) const;
+
+  // Returns the height to use for a row in a specified location. If the row
+  // is self-sizing, the estimated height is returned and `is_estimated` is
+  // set to `true`.
+  float GetRowHeight(const CellIndex cell_index, bool* is_estimated);
+
+  // Returns the offset to add to the prefix sums of `row_offset_index_` to
+  // get the top offset of the corresponded rows in the content view. This
+  // value depends on the table header view and the first non-empty section.
+  float GetRowOffsetBase() const;
+
+  // Returns the section index that the item at the specified index of
+  // `row_offset_index_` belongs to.
+  int GetSectionIndexForItem(const int item_index) const;
 
   // Inherited from `Widget` class.
   bool HandleEvent(Event* event) final;
 
+  // Measures the exact heights of self-sizing rows that are close to the
+  // visible area, and shifts the content view to keep the visible rows in
+  // place if the heights of the rows above them are changed.
+  void MeasureEstimatedRows(NVGcontext* context);
+
   // Highlights the `down_event_cell_` if the cell object is not `nullptr`.
   // This method exists for the purpose of delay highlighting.
   void HighlightDownEventCell();
 
-  // Adds the specified cell to the `reusable_cells_` vector if the cell's
-  // reusable identifier is not empty.
+  // Tells the `prefetch_data_source_` which rows are expected to be
+  // displayed soon based on the scroll direction and the projected offset
+  // where the scrolling will stop. The `previous_topmost_content_view_offset`
+  // is used for determining the scroll direction when not animating.
+  void PrefetchRows(const float previous_topmost_content_view_offset);
+
+  // Adds the specified cell to `reusable_cells_` if the cell's reusable
+  // identifier is not empty. Otherwise, the cell is released.
   void ReuseCell(TableViewCell* cell);
 
   // Reuses visible cells.
@@ -150,6 +314,10 @@ class TableView : public ScrollView {
   // Renders the `layout_view_`.
   void RenderLayoutView(moui::Widget* widget, NVGcontext* context);
 
+  // Schedules `WarmUpReusableCells()` on the main thread. The scheduled call
+  // does nothing if the table view is destroyed before it runs.
+  void ScheduleWarmingUpReusableCells();
+
   // Sets the highlighted state of a table-view cell.
   void SetCellHighlighted(TableViewCell* cell, const bool highlighted);
 
@@ -160,9 +328,32 @@ class TableView : public ScrollView {
   // update.
   bool UpdateLayout();
 
-  // The cell indexes representing the selected rows.
+  // Rebuilds `row_offset_index_` and the cached section information by asking
+  // the data source and delegate for the dimensions of every section and row.
+  void UpdateRowOffsetIndex();
+
+  // Updates the selected states of visible cells according to
+  // `selected_rows_`.
+  void UpdateSelectedStatesOfVisibleCells();
+
+  // Creates a reusable cell for an identifier that has fewer reusable cells
+  // than expected by `spare_reusable_cell_counts_`. This method creates at
+  // most one cell at a time and reschedules itself while the table view is
+  // idle until all expectations are met.
+  void WarmUpReusableCells();
+
+  // The cell indexes of the rows that are being prefetched, sorted in
+  // ascending order.
+  std::vector<CellIndex> cell_indexes_for_prefetched_rows_;
+
+  // The snapshot of the selected rows returned by the deprecated
+  // `cell_indexes_for_selected_rows()`.
   std::vector<CellIndex> cell_indexes_for_selected_rows_;
 
+  // Maps the cells in `visible_cells_` to their cell indexes.
+  std::unordered_map<TableViewCell*, CellIndex>
+      cell_indexes_for_visible_cells_;
+
   // Indicates a list of cell indexes each identifying a visible row in the
   // table view.
   std::vector<CellIndex> cell_indexes_for_visible_rows_;
@@ -179,9 +370,32 @@ class TableView : public ScrollView {
   // Keeps the location of the last down event.
   Point down_event_location_;
 
+  // Indicates whether the height of the item at the same position in
+  // `row_offset_index_` is an estimate that has not been measured yet.
+  std::vector<bool> estimated_items_;
+
+  // Indicates the estimated height of self-sizing rows. A row is self-sizing
+  // if its height is `kAutomaticDimenstion` and an estimated height is
+  // available either from this value or the delegate. The exact height of a
+  // self-sizing row is measured by `TableViewCell::GetFittingHeight()` when
+  // the row approaches the visible area. The default value is 0, which
+  // disables self-sizing rows.
+  float estimated_row_height_;
+
+  // Indicates the index of the first section that contains rows, or -1 if
+  // every section is empty.
+  int first_non_empty_section_index_;
+
   // Indicates the height in points between sections.
   float height_between_sections_;
 
+  // Indicates whether the displacement of visible cells is animating after
+  // `EndUpdates()`.
+  bool is_animating_row_updates_;
+
+  // Indicates whether `WarmUpReusableCells()` is scheduled.
+  bool is_warming_up_reusable_cells_;
+
   // Keeps the bottommost content view offset last time updated layout.
   float last_bottommost_content_view_offset_;
 
@@ -192,6 +406,18 @@ class TableView : public ScrollView {
   // the layout such as separators.
   moui::Widget* layout_view_;
 
+  // Indicates the number of self-sizing rows that have not been measured.
+  int number_of_estimated_rows_;
+
+  // Indicates the depth of nested `BeginUpdates()` calls.
+  int number_of_pending_update_batches_;
+
+  // Caches the number of rows of each section.
+  std::vector<int> number_of_rows_in_sections_;
+
+  // Keeps the changes recorded since the outermost `BeginUpdates()` call.
+  PendingUpdates pending_updates_;
+
   // The weak reference to the accessory view that is displayed below the table.
   // The default value is `nullptr`. The table view is different from a section
   // footer.
@@ -202,16 +428,63 @@ class TableView : public ScrollView {
   // header.
   moui::Widget* table_header_view_;
 
+  // The weak reference to the `TableViewDataSourcePrefetching` instance.
+  TableViewDataSourcePrefetching* prefetch_data_source_;
+
   // Keeps strong reference to the cell objects that are marked as reusable.
-  // The key indicates the cells' `reuse_identifier` property.
-  std::map<std::string, std::queue<TableViewCell*>> reusable_cells_;
+  ReusePool reusable_cells_;
+
+  // Keeps the vertical displacements of visible cells at the beginning of the
+  // animation after `EndUpdates()`. The displacements decrease to 0 in
+  // `row_animation_duration_`.
+  std::map<TableViewCell*, float> row_animation_displacements_;
+
+  // Indicates the duration in seconds of animating the displacement of
+  // visible cells after `EndUpdates()`. The default value is 0, which
+  // disables the animation.
+  double row_animation_duration_;
+
+  // Records the timestamp when the animation after `EndUpdates()` began.
+  double row_animation_initial_timestamp_;
 
   // Indicates the height of each row in the table view.
   float row_height_;
 
+  // Indexes the vertical extents of the table content for looking up the
+  // visible rows in logarithmic time. Every non-empty section contributes
+  // consecutive items to the index: a leading item for the spacing and
+  // section header, an item for each row, and a trailing item for the section
+  // footer. Because adjacent rows share a one-point separator, a row item
+  // keeps the row height minus one.
+  FenwickTree row_offset_index_;
+
+  // Caches the footer height of each section.
+  std::vector<float> section_footer_heights_;
+
+  // Caches the header height of each section.
+  std::vector<float> section_header_heights_;
+
+  // Keeps the index of each section's leading item in `row_offset_index_`.
+  // Empty sections share the index with the next non-empty section.
+  std::vector<int> section_item_indexes_;
+
+  // Keeps the selected rows of each section. The key indicates the section
+  // index, and sections without selected rows are not kept.
+  std::map<int, IndexSet> selected_rows_;
+
   // Indicates whether the layout should update.
   bool should_update_layout_;
 
+  // Indicates whether `row_offset_index_` should be rebuilt.
+  bool should_update_row_offset_index_;
+
+  // Keeps the number of reusable cells expected to be available for each
+  // reuse ID, which is the largest number of cells ever created for that
+  // reuse ID in a single layout pass, but no less than
+  // `kMinimumNumberOfSpareReusableCells` and no more than the capacity of
+  // `reusable_cells_`.
+  std::map<int, int> spare_reusable_cell_counts_;
+
   // The color of separator rows in the table view.
   NVGcolor separator_color_;
 
@@ -222,6 +495,14 @@ class TableView : public ScrollView {
   // The table cells that are visible in the table view.
   std::vector<TableViewCell*> visible_cells_;
 
+  // Maps the keys generated by `GetCellKey()` to the cells in
+  // `visible_cells_`.
+  std::unordered_map<int64_t, TableViewCell*> visible_cells_by_key_;
+
+  // The token observed by the callbacks scheduled in
+  // `ScheduleWarmingUpReusableCells()`. It expires with the table view.
+  std::shared_ptr<bool> warm_up_reusable_cells_token_;
+
   DISALLOW_COPY_AND_ASSIGN(TableView);
 };
 
@@ -253,6 +534,40 @@ class TableViewDataSource {
   DISALLOW_COPY_AND_ASSIGN(TableViewDataSource);
 };
 
+// The `TableViewDataSourcePrefetching` class is adopted by an object that
+// prepares the data of table-view rows ahead of time, and provides cells for
+// warming up the table view's reusable cells while the table view is idle.
+class TableViewDataSourcePrefetching {
+ public:
+  TableViewDataSourcePrefetching() {}
+  ~TableViewDataSourcePrefetching() {}
+
+  // Asks the data source to create a new cell object with the specified
+  // reuse identifier. The cell is kept by the table view as a reusable cell
+  // so that `TableViewDataSource::GetTableViewCell()` could dequeue it
+  // instead of creating one while scrolling. Returning `nullptr` disables
+  // warming up the reusable cells of the identifier.
+  virtual TableViewCell* CreateTableViewCell(
+      TableView* table_view, const std::string& reuse_identifier) {
+    return nullptr;
+  }
+
+  // Tells the data source to cancel the prefetch requests for rows that are
+  // no longer expected to be displayed soon.
+  virtual void TableViewCancelPrefetchingForRows(
+      TableView* table_view,
+      const std::vector<TableView::CellIndex>& cell_indexes) {}
+
+  // Tells the data source to start preparing data for the rows that are
+  // expected to be displayed soon, such as loading images or measuring text.
+  virtual void TableViewPrefetchRows(
+      TableView* table_view,
+      const std::vector<TableView::CellIndex>& cell_indexes) = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TableViewDataSourcePrefetching);
+};
+
 // The `TableViewDelegate` class allows the table view delegate to manage
 // selections, configure section headings and footers, and perform other
 // actions.
@@ -291,6 +606,14 @@ class TableViewDelegate {
     return 0;
   }
 
+  // Asks the delegate for the estimated height of a self-sizing row in a
+  // specified location. Returning `kAutomaticDimenstion` falls back to the
+  // table view's `estimated_row_height()`.
+  virtual float GetTableViewEstimatedRowHeight(
+      TableView* table_view, const TableView::CellIndex cell_index) {
+    return TableView::kAutomaticDimenstion;
+  }
+
   // Asks the delegate for the height to use for a row in a specified location.
   virtual float GetTableViewRowHeight(TableView* table_view,
                                       const TableView::CellIndex cell_index) {
@@ -18,8 +18,11 @@
 #include "moui/widgets/table_view_cell.h"
 
 #include <algorithm>
+#include <cmath>
 
+#include "moui/widgets/icon_atlas.h"
 #include "moui/widgets/label.h"
+#include "moui/widgets/reuse_pool.h"
 #include "moui/widgets/table_view.h"
 #include "moui/widgets/widget.h"
 #include "moui/widgets/widget_view.h"
@@ -30,6 +33,8 @@ namespace {
 const float kAccessoryCheckmarkVectorWidth = 13;
 // The default horizontal padding in points of a cell.
 const float kDefaultCellHorizontalPadding = 20;
+// The default vertical padding in points of a self-sizing cell.
+const float kDefaultCellVerticalPadding = 11;
 // The default text color of the detail text label.
 const NVGcolor kDefaultDetailTextLabelTextColor = nvgRGB(170, 170, 170);
 // The default width and height of the cell's image view.
@@ -42,6 +47,38 @@ const float kDefaultTextLabelFontSize = 18;
 // The vector width of the disclosure indicator accessory.
 const float kAccessoryDisclosureIndicatorVectorWidth = 8;
 
+// Returns the path of the checkmark accessory shared by all cells.
+moui::NVGretainedPath* GetCheckmarkPath() {
+  static moui::NVGretainedPath* path = nullptr;
+  if (path == nullptr) {
+    path = moui::nvgCreateRetainedPath();
+    moui::nvgRetainedPathMoveTo(path, 11.401, 0.067);
+    moui::nvgRetainedPathLineTo(path, 4.346, 7.186);
+    moui::nvgRetainedPathLineTo(path, 1.474, 4.313);
+    moui::nvgRetainedPathLineTo(path, 0.1, 5.812);
+    moui::nvgRetainedPathLineTo(path, 4.346, 9.933);
+    moui::nvgRetainedPathLineTo(path, 12.9, 1.441);
+    moui::nvgRetainedPathClose(path);
+  }
+  return path;
+}
+
+// Returns the path of the disclosure indicator accessory shared by all cells.
+moui::NVGretainedPath* GetDisclosureIndicatorPath() {
+  static moui::NVGretainedPath* path = nullptr;
+  if (path == nullptr) {
+    path = moui::nvgCreateRetainedPath();
+    moui::nvgRetainedPathMoveTo(path, 1, 0);
+    moui::nvgRetainedPathLineTo(path, 0, 1);
+    moui::nvgRetainedPathLineTo(path, 5.75, 6.5);
+    moui::nvgRetainedPathLineTo(path, 0, 12);
+    moui::nvgRetainedPathLineTo(path, 1, 13);
+    moui::nvgRetainedPathLineTo(path, 8, 6.5);
+    moui::nvgRetainedPathClose(path);
+  }
+  return path;
+}
+
 }  // namespace
 
 namespace moui {
@@ -49,8 +86,9 @@ namespace moui {
 TableViewCell::TableViewCell(const Style style,
                              const std::string& reuse_identifier)
     : accessory_type_(AccessoryType::kNone), detail_text_label_(nullptr),
-      highlighted_(false), selected_(false), style_(style),
-      reuse_identifier_(reuse_identifier) {
+      highlighted_(false),
+      reuse_id_(ReusePool::GetReuseId(reuse_identifier)),
+      reuse_identifier_(reuse_identifier), selected_(false), style_(style) {
   set_frees_children_on_destruction(true);
 
   // Initializes content view.
@@ -94,43 +132,53 @@ TableViewCell::~TableViewCell() {
   delete detail_text_label_;
 }
 
+float TableViewCell::GetFittingHeight(NVGcontext* context) {
+  UpdateLayout(context);
+  float content_height = text_label_->GetHeightToFitWidth(
+      context, text_label_->GetWidth());
+  if (detail_text_label_ != nullptr) {
+    content_height = std::max(
+        content_height,
+        detail_text_label_->GetHeightToFitWidth(
+            context, detail_text_label_->GetWidth()));
+  }
+  if (!image_view_->IsHidden())
+    content_height = std::max(content_height, image_view_->GetHeight());
+  return std::ceil(content_height) + kDefaultCellVerticalPadding * 2
+         + top_padding() + bottom_padding();
+}
+
 void TableViewCell::PrepareForReuse() {
 }
 
 void TableViewCell::RenderContentView(moui::Widget* widget,
                                       NVGcontext* context) {
+  float transform[6];
   if (accessory_type_ == AccessoryType::kCheckmark) {
     const int kVectorHeight = 10;
-    nvgTranslate(context,
-                 GetWidth() - kDefaultCellHorizontalPadding
-                     - kAccessoryCheckmarkVectorWidth,
-                 (GetHeight() - kVectorHeight) / 2);
-    nvgBeginPath(context);
-    nvgMoveTo(context, 11.401, 0.067);
-    nvgLineTo(context, 4.346, 7.186);
-    nvgLineTo(context, 1.474, 4.313);
-    nvgLineTo(context, 0.1, 5.812);
-    nvgLineTo(context, 4.346, 9.933);
-    nvgLineTo(context, 12.9, 1.441);
-    nvgClosePath(context);
+    nvgTransformTranslate(transform,
+                          GetWidth() - kDefaultCellHorizontalPadding
+                              - kAccessoryCheckmarkVectorWidth,
+                          (GetHeight() - kVectorHeight) / 2);
     nvgFillColor(context, nvgRGBA(0, 122, 255, 255));
-    nvgFill(context);
+    nvgFillRetainedPath(context, GetCheckmarkPath(), transform);
   } else if (accessory_type_ == AccessoryType::kDisclosureIndicator) {
     const int kVectorHeight = 13;
-    nvgTranslate(context,
-                 GetWidth() - kDefaultCellHorizontalPadding
-                     - kAccessoryDisclosureIndicatorVectorWidth,
-                 (GetHeight() - kVectorHeight) / 2);
-    nvgBeginPath(context);
-    nvgMoveTo(context, 1, 0);
-    nvgLineTo(context, 0, 1);
-    nvgLineTo(context, 5.75, 6.5);
-    nvgLineTo(context, 0, 12);
-    nvgLineTo(context, 1, 13);
-    nvgLineTo(context, 8, 6.5);
-    nvgClosePath(context);
+    nvgTransformTranslate(transform,
+                          GetWidth() - kDefaultCellHorizontalPadding
+                              - kAccessoryDisclosureIndicatorVectorWidth,
+                          (GetHeight() - kVectorHeight) / 2);
     nvgFillColor(context, nvgRGB(200, 200, 200));
-    nvgFill(context);
+    nvgFillRetainedPath(context, GetDisclosureIndicatorPath(), transform);
+  }
+}
+
+void TableViewCell::RenderImageView(moui::Widget* widget,
+                                    NVGcontext* context) {
+  if (!icon_name_.empty()) {
+    IconAtlas::GetSharedAtlas()->DrawIcon(context, icon_name_, 0, 0,
+                                          widget->GetWidth(),
+                                          widget->GetHeight(), 1);
   }
 }
 
@@ -197,6 +245,8 @@ void TableViewCell::UpdateLayout(NVGcontext* context) {
 bool TableViewCell::WidgetViewWillRender(NVGcontext* context) {
   const bool kResult = Widget::WidgetViewWillRender(context);
   UpdateLayout(context);
+  if (!icon_name_.empty())
+    IconAtlas::GetSharedAtlas()->PrepareIcon(context, icon_name_);
   return kResult;
 }
 
@@ -215,6 +265,18 @@ void TableViewCell::set_highlighted(const bool highlighted) {
   }
 }
 
+void TableViewCell::set_icon_name(const std::string& icon_name) {
+  if (icon_name == icon_name_)
+    return;
+  icon_name_ = icon_name;
+  // Keeps the render function already bound to the image view, which may be
+  // bound by the user to draw custom content.
+  if (!icon_name.empty() && !image_view_->RenderFunctionIsBinded())
+    image_view_->BindRenderFunction(&TableViewCell::RenderImageView, this);
+  image_view_->SetHidden(icon_name.empty());
+  Redraw();
+}
+
 void TableViewCell::set_selected(const bool selected) {
   if (selected != selected_) {
     selected_ = selected;
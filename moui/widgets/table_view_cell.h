@@ -60,6 +60,13 @@ class TableViewCell : public Widget {
   explicit TableViewCell(const Style style);
   ~TableViewCell();
 
+  // Returns the height that best fits the cell's content for the current
+  // width. The table view calls this method to measure self-sizing rows, see
+  // `TableView::estimated_row_height()` for details. The default
+  // implementation fits the text labels and the image view. Subclasses that
+  // display custom content should override this method.
+  virtual float GetFittingHeight(NVGcontext* context);
+
   // Prepares a reusable cell for reuse by the table view's delegate. This
   // method is invoked just before the object is returned from the
   // `TableView::DequeueReusableCell()` method. If the cell object does not
@@ -73,7 +80,10 @@ class TableViewCell : public Widget {
   Label* detail_text_label() const { return detail_text_label_; }
   bool highlighted() const { return highlighted_; }
   void set_highlighted(const bool highlighted);
+  std::string icon_name() const { return icon_name_; }
+  void set_icon_name(const std::string& icon_name);
   Widget* image_view() const { return image_view_; }
+  int reuse_id() const { return reuse_id_; }
   std::string reuse_identifier() const { return reuse_identifier_; }
   bool selected() const { return selected_; }
   void set_selected(const bool selected);
@@ -88,6 +98,9 @@ class TableViewCell : public Widget {
   // Renders the content view.
   void RenderContentView(moui::Widget* widget, NVGcontext* context);
 
+  // Renders the icon in the image view.
+  void RenderImageView(moui::Widget* widget, NVGcontext* context);
+
   // Updates the cell's layout with the configured style.
   void UpdateLayout(NVGcontext* context);
 
@@ -105,11 +118,22 @@ class TableViewCell : public Widget {
   // Indicates whether the cell is highlighted.
   bool highlighted_;
 
+  // The name of the `IconAtlas` icon rendered in the image view. Setting a
+  // non-empty name shows the image view and binds its render function to
+  // draw the icon if no render function is bound yet. Setting an empty name
+  // hides the image view. The icon is not drawn if the image view's render
+  // function is bound by the user instead.
+  std::string icon_name_;
+
   // The strong reference to the image view object of the table view, which
   // initially sets to hidden. If the view is set not hidden, it appears on
   // the left side of the cell, before any label.
   Widget* image_view_;
 
+  // The reuse ID interned from `reuse_identifier_` by
+  // `ReusePool::GetReuseId()`.
+  int reuse_id_;
+
   // Indicates a string used to identify the cell object if it is to be reused
   // for drawing multiple rows of a table view. Pass an empty string if the
   // cell object is not to be reused.
@@ -0,0 +1,163 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/text_measurement_cache.h"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "moui/nanovg_hook.h"
+
+namespace {
+
+// The default maximum number of bytes to be used by cached results.
+const size_t kDefaultByteBudget = 256 * 1024;
+
+}  // namespace
+
+namespace moui {
+
+TextMeasurementCache::TextMeasurementCache()
+    : byte_budget_(kDefaultByteBudget), number_of_hits_(0),
+      number_of_misses_(0), number_of_bytes_(0) {
+}
+
+TextMeasurementCache::~TextMeasurementCache() {
+}
+
+bool TextMeasurementCache::Key::operator==(const Key& other) const {
+  return context == other.context && font_id == other.font_id &&
+         font_size == other.font_size &&
+         letter_spacing == other.letter_spacing &&
+         text_alignment == other.text_alignment && text == other.text;
+}
+
+size_t TextMeasurementCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = std::hash<std::string>()(key.text);
+  auto combine = [&hash](const size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  };
+  combine(std::hash<NVGcontext*>()(key.context));
+  combine(std::hash<int>()(key.font_id));
+  combine(std::hash<float>()(key.font_size));
+  combine(std::hash<float>()(key.letter_spacing));
+  combine(std::hash<int>()(key.text_alignment));
+  return hash;
+}
+
+void TextMeasurementCache::Clear() {
+  recently_used_keys_.clear();
+  results_.clear();
+  number_of_bytes_ = 0;
+}
+
+void TextMeasurementCache::EvictResults() {
+  while (number_of_bytes_ > byte_budget_ && !recently_used_keys_.empty()) {
+    const Key* key = recently_used_keys_.back();
+    recently_used_keys_.pop_back();
+    number_of_bytes_ -= GetNumberOfBytes(*key);
+    results_.erase(results_.find(*key));
+  }
+}
+
+float TextMeasurementCache::GetHitRate() const {
+  const int kNumberOfMeasurements = number_of_hits_ + number_of_misses_;
+  if (kNumberOfMeasurements == 0)
+    return 0;
+  return static_cast<float>(number_of_hits_) / kNumberOfMeasurements;
+}
+
+size_t TextMeasurementCache::GetNumberOfBytes(const Key& key) {
+  // Approximates the overhead of the hash table node and the list node.
+  return sizeof(Key) + sizeof(Result) + key.text.capacity()
+         + sizeof(void*) * 6;
+}
+
+TextMeasurementCache* TextMeasurementCache::GetSharedCache() {
+  static TextMeasurementCache* shared_cache = new TextMeasurementCache;
+  return shared_cache;
+}
+
+float TextMeasurementCache::MeasureText(NVGcontext* context,
+                                        const int font_id,
+                                        const float font_size,
+                                        const float letter_spacing,
+                                        const int text_alignment,
+                                        const std::string& text,
+                                        float* bounds) {
+  Key key = {context, font_id, font_size, letter_spacing, text_alignment,
+             text};
+  auto match = results_.find(key);
+  if (match != results_.end()) {
+    ++number_of_hits_;
+    Result* result = &match->second;
+    recently_used_keys_.splice(recently_used_keys_.begin(),
+                               recently_used_keys_,
+                               result->recently_used_position);
+    if (bounds != nullptr) {
+      for (int i = 0; i < 4; ++i)
+        bounds[i] = result->bounds[i];
+    }
+    return result->advance;
+  }
+
+  ++number_of_misses_;
+  Result result;
+  result.advance = nvgTextBounds(context, 0, 0, text.c_str(), NULL,
+                                 result.bounds);
+  if (bounds != nullptr) {
+    for (int i = 0; i < 4; ++i)
+      bounds[i] = result.bounds[i];
+  }
+  // Skips caching results that are not measured with a valid font.
+  if (font_id < 0)
+    return result.advance;
+
+  auto insertion = results_.insert({std::move(key), result});
+  const Key* cached_key = &insertion.first->first;
+  recently_used_keys_.push_front(cached_key);
+  insertion.first->second.recently_used_position = \
+      recently_used_keys_.begin();
+  number_of_bytes_ += GetNumberOfBytes(*cached_key);
+  EvictResults();
+  return result.advance;
+}
+
+void TextMeasurementCache::RemoveResultsForContext(NVGcontext* context) {
+  for (auto iterator = recently_used_keys_.begin();
+       iterator != recently_used_keys_.end();) {
+    const Key* key = *iterator;
+    if (key->context != context) {
+      ++iterator;
+      continue;
+    }
+    iterator = recently_used_keys_.erase(iterator);
+    number_of_bytes_ -= GetNumberOfBytes(*key);
+    results_.erase(results_.find(*key));
+  }
+}
+
+void TextMeasurementCache::set_byte_budget(const size_t byte_budget) {
+  byte_budget_ = byte_budget;
+  EvictResults();
+}
+
+}  // namespace moui
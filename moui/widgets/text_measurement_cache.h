@@ -0,0 +1,133 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_TEXT_MEASUREMENT_CACHE_H_
+#define MOUI_WIDGETS_TEXT_MEASUREMENT_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+
+namespace moui {
+
+// The `TextMeasurementCache` class memoizes the results of `nvgTextBounds()`
+// across all widgets in the process. The same strings such as cell titles are
+// measured over and over while laying out, and each measurement shapes every
+// glyph of the string. Results are keyed by the nanovg context, font handle,
+// font size, letter spacing, text alignment and the text itself, and the
+// least recently used results are evicted once the cache exceeds its byte
+// budget. This class is not thread-safe and must be used on the main thread.
+class TextMeasurementCache {
+ public:
+  // Returns the cache shared by the entire process.
+  static TextMeasurementCache* GetSharedCache();
+
+  // Removes all cached results.
+  void Clear();
+
+  // Returns the ratio of measurements served from the cache, or 0 if nothing
+  // has been measured.
+  float GetHitRate() const;
+
+  // Returns the same result as `nvgTextBounds(context, 0, 0, text, NULL,
+  // bounds)`. The text attributes of `context` must already be configured
+  // with the specified `font_id`, `font_size`, `letter_spacing` and
+  // `text_alignment`, which are used for looking up the cached result and
+  // measuring the text on cache misses. `bounds` can be `nullptr`.
+  float MeasureText(NVGcontext* context, const int font_id,
+                    const float font_size, const float letter_spacing,
+                    const int text_alignment, const std::string& text,
+                    float* bounds);
+
+  // Removes all cached results measured with the specified context. This
+  // method should be called before the context is deleted since a new
+  // context may be allocated at the same address with different fonts.
+  void RemoveResultsForContext(NVGcontext* context);
+
+  // Accessors and setters.
+  size_t byte_budget() const { return byte_budget_; }
+  void set_byte_budget(const size_t byte_budget);
+  size_t number_of_bytes() const { return number_of_bytes_; }
+  int number_of_hits() const { return number_of_hits_; }
+  int number_of_misses() const { return number_of_misses_; }
+
+ private:
+  // The attributes identifying a measurement.
+  struct Key {
+    NVGcontext* context;
+    int font_id;
+    float font_size;
+    float letter_spacing;
+    int text_alignment;
+    std::string text;
+
+    bool operator==(const Key& other) const;
+  };
+
+  // Returns the hash value of a `Key` object.
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  // A cached measurement.
+  struct Result {
+    // The advance width returned by `nvgTextBounds()`.
+    float advance;
+    // The bounding box filled by `nvgTextBounds()`.
+    float bounds[4];
+    // The position of the result's key in `recently_used_keys_`.
+    std::list<const Key*>::iterator recently_used_position;
+  };
+
+  TextMeasurementCache();
+  ~TextMeasurementCache();
+
+  // Returns the number of bytes charged for caching the result of the key.
+  static size_t GetNumberOfBytes(const Key& key);
+
+  // Evicts the least recently used results until the cache fits its budget.
+  void EvictResults();
+
+  // Indicates the maximum number of bytes to be used by cached results.
+  size_t byte_budget_;
+
+  // Counts the measurements served from the cache.
+  int number_of_hits_;
+
+  // Counts the measurements that had to call `nvgTextBounds()`.
+  int number_of_misses_;
+
+  // Keeps the number of bytes used by cached results.
+  size_t number_of_bytes_;
+
+  // The keys of cached results ordered from the most recently used to the
+  // least recently used. The keys point to the keys of `results_`.
+  std::list<const Key*> recently_used_keys_;
+
+  // The cached results.
+  std::unordered_map<Key, Result, KeyHash> results_;
+
+  DISALLOW_COPY_AND_ASSIGN(TextMeasurementCache);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_TEXT_MEASUREMENT_CACHE_H_
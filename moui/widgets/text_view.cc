@@ -0,0 +1,315 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#include "moui/widgets/text_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/font_registry.h"
+#include "moui/widgets/scroll_view.h"
+#include "moui/widgets/widget.h"
+
+namespace {
+
+// The default size of the font.
+const float kDefaultFontSize = 12;
+
+// The maximum number of rows to receive from a single `nvgTextBreakLines()`
+// call.
+const int kMaximumNumberOfRowsPerBreak = 256;
+
+// The number of bytes to index in the background per frame.
+const size_t kNumberOfBytesToIndexPerFrame = 64 * 1024;
+
+// The number of bytes to index at a time while breaking the text required
+// for the visible area.
+const size_t kNumberOfBytesToIndexPerStep = 4 * 1024;
+
+}  // namespace
+
+namespace moui {
+
+TextView::TextView() : TextView("") {
+}
+
+TextView::TextView(const std::string& font_name)
+    : ScrollView(), anchor_text_offset_(std::string::npos),
+      font_handle_(FontRegistry::GetSharedRegistry()->GetFontHandle(
+          font_name)),
+      font_name_(font_name), font_size_(kDefaultFontSize), layout_width_(-1),
+      line_height_(1), number_of_indexed_bytes_(0), paragraph_end_offset_(0),
+      row_height_(0),
+      text_color_(nvgRGBA(0, 0, 0, 255)) {
+  set_always_bounce_vertical(true);
+  set_always_scroll_both_directions(false);
+
+  text_layer_ = new Widget;
+  text_layer_->set_is_opaque(false);
+  text_layer_->BindRenderFunction(&TextView::RenderTextLayer, this);
+  text_layer_->SetWidth(Widget::Unit::kPercent, 100);
+  text_layer_->SetHeight(Widget::Unit::kPercent, 100);
+  InsertChildAboveContentView(text_layer_);
+}
+
+TextView::~TextView() {
+  delete text_layer_;
+}
+
+void TextView::AppendText(const std::string& text) {
+  if (text.empty())
+    return;
+
+  // The last paragraph may continue with the appended text. Rows are broken
+  // greedily so only its last row has to be broken again.
+  if (!text_.empty() && text_.back() != '\n' &&
+      number_of_indexed_bytes_ == text_.size() && !rows_.empty()) {
+    number_of_indexed_bytes_ = rows_.back().begin;
+    rows_.pop_back();
+  }
+  paragraph_end_offset_ = 0;
+  text_ += text;
+  Redraw();
+}
+
+void TextView::BreakText(NVGcontext* context, const size_t offset) {
+  const size_t kTextSize = text_.size();
+  const char* kText = text_.c_str();
+  NVGtextRow text_rows[kMaximumNumberOfRowsPerBreak];
+  while (number_of_indexed_bytes_ < kTextSize &&
+         number_of_indexed_bytes_ <= offset) {
+    // Rows never span paragraphs, so the text is broken within the paragraph
+    // containing the first unindexed byte.
+    if (paragraph_end_offset_ <= number_of_indexed_bytes_) {
+      const size_t kNewline = text_.find('\n', number_of_indexed_bytes_);
+      paragraph_end_offset_ = \
+          kNewline == std::string::npos ? kTextSize : kNewline + 1;
+    }
+    const int kNumberOfRows = nvgTextBreakLines(
+        context, kText + number_of_indexed_bytes_,
+        kText + paragraph_end_offset_, layout_width_, text_rows,
+        kMaximumNumberOfRowsPerBreak);
+    if (kNumberOfRows <= 0) {
+      number_of_indexed_bytes_ = paragraph_end_offset_;
+      continue;
+    }
+    // Stops at the first row boundary past `offset`, which may be in the
+    // middle of the paragraph.
+    for (int i = 0; i < kNumberOfRows; ++i) {
+      rows_.push_back({static_cast<size_t>(text_rows[i].start - kText),
+                       static_cast<size_t>(text_rows[i].end - kText)});
+      if (i == kNumberOfRows - 1 &&
+          kNumberOfRows < kMaximumNumberOfRowsPerBreak) {
+        number_of_indexed_bytes_ = paragraph_end_offset_;
+      } else {
+        number_of_indexed_bytes_ = std::min(
+            paragraph_end_offset_,
+            static_cast<size_t>(text_rows[i].next - kText));
+      }
+      if (number_of_indexed_bytes_ > offset)
+        break;
+    }
+  }
+}
+
+void TextView::ConfigureTextAttributes(NVGcontext* context) {
+  nvgFillColor(context, text_color_);
+  nvgFontFaceId(context, FontRegistry::GetSharedRegistry()->GetFontId(
+      context, font_handle_));
+  nvgFontSize(context, font_size_);
+  nvgTextAlign(context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+  nvgTextLetterSpacing(context, 0);
+  nvgTextLineHeight(context, line_height_);
+}
+
+int TextView::FindRow(const size_t offset) const {
+  if (rows_.empty())
+    return -1;
+
+  auto iterator = std::upper_bound(
+      rows_.begin(), rows_.end(), offset,
+      [](const size_t value, const TextRow& row) {
+        return value < row.begin;
+      });
+  if (iterator == rows_.begin())
+    return 0;
+  return static_cast<int>(iterator - rows_.begin()) - 1;
+}
+
+int TextView::GetFirstVisibleRow() const {
+  if (row_height_ <= 0)
+    return 0;
+  const float kOffset = GetContentViewOffset().y - top_padding();
+  return std::max(0, static_cast<int>(std::floor(kOffset / row_height_)));
+}
+
+void TextView::InvalidateRows() {
+  if (anchor_text_offset_ == std::string::npos && !rows_.empty()) {
+    const int kFirstVisibleRow = GetFirstVisibleRow();
+    if (kFirstVisibleRow > 0 &&
+        kFirstVisibleRow < static_cast<int>(rows_.size())) {
+      anchor_text_offset_ = rows_[kFirstVisibleRow].begin;
+    }
+  }
+  layout_width_ = -1;
+  number_of_indexed_bytes_ = 0;
+  paragraph_end_offset_ = 0;
+  rows_.clear();
+  Redraw();
+}
+
+void TextView::RenderTextLayer(Widget* widget, NVGcontext* context) {
+  if (rows_.empty() || row_height_ <= 0)
+    return;
+
+  const Point kContentViewOffset = GetContentViewOffset();
+  const float kFirstRowY = top_padding() - kContentViewOffset.y;
+  const int kNumberOfRows = static_cast<int>(rows_.size());
+  const int kFirstVisibleRow = GetFirstVisibleRow();
+  const int kLastVisibleRow = std::min(
+      kNumberOfRows - 1,
+      static_cast<int>((GetHeight() - kFirstRowY) / row_height_));
+  if (kFirstVisibleRow > kLastVisibleRow)
+    return;
+
+  ConfigureTextAttributes(context);
+  const char* kText = text_.c_str();
+  const float kX = left_padding() - kContentViewOffset.x;
+  float y = kFirstRowY + kFirstVisibleRow * row_height_;
+  for (int i = kFirstVisibleRow; i <= kLastVisibleRow; ++i) {
+    const TextRow& kRow = rows_[i];
+    nvgText(context, kX, y, kText + kRow.begin, kText + kRow.end);
+    y += row_height_;
+  }
+}
+
+void TextView::ScrollToTextOffset(const size_t offset) {
+  anchor_text_offset_ = std::min(offset, text_.size());
+  Redraw();
+}
+
+void TextView::UpdateContentViewSize() {
+  float number_of_rows = rows_.size();
+  // Estimates the rows of the unindexed text by the average number of bytes
+  // per row in the indexed text.
+  if (number_of_indexed_bytes_ > 0 && !IsFullyIndexed()) {
+    number_of_rows += static_cast<float>(
+        text_.size() - number_of_indexed_bytes_) * rows_.size() /
+        number_of_indexed_bytes_;
+  }
+  SetContentViewSize(
+      -1,
+      top_padding() + std::ceil(number_of_rows) * row_height_ +
+      bottom_padding());
+}
+
+bool TextView::WidgetViewWillRender(NVGcontext* context) {
+  if (!ScrollView::WidgetViewWillRender(context))
+    return false;
+
+  const float kWidth = GetWidth() - left_padding() - right_padding();
+  if (kWidth <= 0 || GetHeight() <= 0)
+    return true;
+  if (kWidth != layout_width_) {
+    InvalidateRows();
+    layout_width_ = kWidth;
+  }
+
+  ConfigureTextAttributes(context);
+  float line_height = 0;
+  nvgTextMetrics(context, nullptr, nullptr, &line_height);
+  row_height_ = line_height * line_height_;
+  if (row_height_ <= 0)  // the font is not available
+    return true;
+
+  // Breaks the text until the row to scroll to is indexed.
+  if (anchor_text_offset_ != std::string::npos) {
+    BreakText(context, anchor_text_offset_);
+    UpdateContentViewSize();
+    const int kRow = FindRow(anchor_text_offset_);
+    anchor_text_offset_ = std::string::npos;
+    SetContentViewOffset({GetContentViewOffset().x,
+                          top_padding() + std::max(0, kRow) * row_height_});
+  }
+
+  // Breaks the text until the visible area is filled.
+  const int kLastVisibleRow = GetFirstVisibleRow() + static_cast<int>(
+      std::ceil(GetHeight() / row_height_));
+  while (!IsFullyIndexed() &&
+         static_cast<int>(rows_.size()) <= kLastVisibleRow) {
+    BreakText(context,
+              number_of_indexed_bytes_ + kNumberOfBytesToIndexPerStep);
+  }
+
+  // Continues indexing the rest of the text in the next frame.
+  if (!IsFullyIndexed()) {
+    BreakText(context,
+              number_of_indexed_bytes_ + kNumberOfBytesToIndexPerFrame);
+    if (!IsFullyIndexed())
+      Redraw();
+  }
+  UpdateContentViewSize();
+  text_layer_->Redraw();
+  return true;
+}
+
+void TextView::set_font_name(const std::string& name) {
+  if (name != font_name_) {
+    font_name_ = name;
+    font_handle_ = FontRegistry::GetSharedRegistry()->GetFontHandle(name);
+    InvalidateRows();
+  }
+}
+
+void TextView::set_font_size(const float font_size) {
+  if (font_size != font_size_ && font_size > 0) {
+    font_size_ = font_size;
+    InvalidateRows();
+  }
+}
+
+void TextView::set_line_height(const float line_height) {
+  if (line_height != line_height_) {
+    line_height_ = line_height;
+    Redraw();
+  }
+}
+
+void TextView::set_text(const std::string& text) {
+  if (text.size() != text_.size() || text != text_) {
+    text_ = text;
+    anchor_text_offset_ = std::string::npos;
+    number_of_indexed_bytes_ = 0;
+    paragraph_end_offset_ = 0;
+    rows_.clear();
+    SetContentViewOffset({0, 0});
+    Redraw();
+  }
+}
+
+void TextView::set_text_color(const NVGcolor text_color) {
+  if (!nvgCompareColor(text_color, text_color_)) {
+    text_color_ = text_color;
+    text_layer_->Redraw();
+  }
+}
+
+}  // namespace moui
@@ -0,0 +1,180 @@
+// Copyright (c) 2017 Ollix. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ---
+// Author: olliwang@ollix.com (Olli Wang)
+
+#ifndef MOUI_WIDGETS_TEXT_VIEW_H_
+#define MOUI_WIDGETS_TEXT_VIEW_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "moui/base.h"
+#include "moui/nanovg_hook.h"
+#include "moui/widgets/scroll_view.h"
+
+namespace moui {
+
+// Forward declaration.
+class Widget;
+
+// The `TextView` class implements a scrollable read-only view for displaying
+// large amounts of text such as logs or documents. Unlike `Label`, the text
+// is not laid out as a whole. Instead, the view maintains an index of the
+// rows the text breaks into, which is built incrementally from the beginning
+// of the text, and only draws the rows that are visible on screen.
+//
+// The rows required to fill the visible area are broken immediately. The
+// rest of the text is indexed in the background a chunk per frame, and the
+// height of the unindexed text is estimated from the indexed part until
+// then. Rows never span paragraphs, but the indexing may stop at any row
+// boundary so even a single huge paragraph is indexed across frames.
+// Appending text only breaks the last row again.
+class TextView : public ScrollView {
+ public:
+  TextView();
+  explicit TextView(const std::string& font_name);
+  ~TextView();
+
+  // Appends the passed `text` to the end of the text. Rows that have been
+  // broken are kept except the last row, which is broken again if its
+  // paragraph is not terminated by a newline.
+  void AppendText(const std::string& text);
+
+  // Returns the number of rows that the text has been broken into so far.
+  int GetNumberOfIndexedRows() const {
+    return static_cast<int>(rows_.size());
+  }
+
+  // Returns `true` if the entire text has been broken into rows.
+  bool IsFullyIndexed() const {
+    return number_of_indexed_bytes_ == text_.size();
+  }
+
+  // Scrolls the content view to show the row containing the character at the
+  // specified byte `offset` at the top of the view. The scrolling happens
+  // before the next rendering because the row may have not been indexed yet.
+  void ScrollToTextOffset(const size_t offset);
+
+  // Accessors and setters.
+  std::string font_name() const { return font_name_; }
+  void set_font_name(const std::string& name);
+  float font_size() const { return font_size_; }
+  void set_font_size(const float font_size);
+  float line_height() const { return line_height_; }
+  void set_line_height(const float line_height);
+  const std::string& text() const { return text_; }
+  void set_text(const std::string& text);
+  NVGcolor text_color() const { return text_color_; }
+  void set_text_color(const NVGcolor text_color);
+
+ protected:
+  // Inherited from `Widget` class. Breaks the text required for the visible
+  // area and continues indexing the rest of the text.
+  bool WidgetViewWillRender(NVGcontext* context) final;
+
+ private:
+  // A row of broken text.
+  struct TextRow {
+    // The byte offset of the first character of the row in the text.
+    size_t begin;
+    // The byte offset past the last character of the row in the text.
+    size_t end;
+  };
+
+  // Breaks the unindexed text into rows until at least the byte at
+  // `offset` is indexed. The indexed range is extended to the end of the row
+  // containing `offset` rather than the end of its paragraph.
+  void BreakText(NVGcontext* context, const size_t offset);
+
+  // Configures text attributes through nanovg APIs.
+  void ConfigureTextAttributes(NVGcontext* context);
+
+  // Returns the index of the row containing the character at the specified
+  // byte `offset`. Returns -1 if there is no indexed row.
+  int FindRow(const size_t offset) const;
+
+  // Returns the index of the first row intersecting the visible area. The
+  // returned value may exceed the number of indexed rows.
+  int GetFirstVisibleRow() const;
+
+  // Discards the indexed rows because an attribute affecting the layout has
+  // changed. The first visible row is remembered to keep the same text at
+  // the top of the view after the text is broken again.
+  void InvalidateRows();
+
+  // Renders the visible rows in `text_layer_`.
+  void RenderTextLayer(Widget* widget, NVGcontext* context);
+
+  // Updates the content view's height to fit both the indexed rows and the
+  // estimated rows of the unindexed text.
+  void UpdateContentViewSize();
+
+  // The byte offset in the text whose row should be scrolled to the top of
+  // the view in the next `WidgetViewWillRender()`. The value is
+  // `std::string::npos` if there is no pending scrolling.
+  size_t anchor_text_offset_;
+
+  // The `FontRegistry` handle of `font_name_`.
+  int font_handle_;
+
+  // The font name of the font that applies to the text. The font must be
+  // previously registered through `nvgCreateFont()`.
+  std::string font_name_;
+
+  // The size of the font that applies to the text. The default value is 12.
+  float font_size_;
+
+  // The width the indexed rows were broken within. The value is negative if
+  // the rows have not been broken.
+  float layout_width_;
+
+  // Indicates the proportional line height of the text. The line height is
+  // specified as multiple of the font's line height. The default value is 1.
+  float line_height_;
+
+  // The number of bytes from the beginning of the text that have been broken
+  // into `rows_`. The value always ends at a row boundary or the end of the
+  // text.
+  size_t number_of_indexed_bytes_;
+
+  // The byte offset past the paragraph containing the first unindexed byte.
+  // The value is recomputed if it doesn't exceed `number_of_indexed_bytes_`.
+  size_t paragraph_end_offset_;
+
+  // The vertical distance between the tops of two adjacent rows. The value
+  // is updated in `WidgetViewWillRender()`.
+  float row_height_;
+
+  // The rows broken from the first `number_of_indexed_bytes_` of the text.
+  std::vector<TextRow> rows_;
+
+  // The text displayed by the view.
+  std::string text_;
+
+  // The color of the text.
+  NVGcolor text_color_;
+
+  // The strong reference to the widget rendering the visible rows above the
+  // content view.
+  Widget* text_layer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TextView);
+};
+
+}  // namespace moui
+
+#endif  // MOUI_WIDGETS_TEXT_VIEW_H_
@@ -22,10 +22,14 @@
 #include <cmath>
 #include <cstdlib>
 #include <stack>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "moui/core/device.h"
 #include "moui/core/event.h"
+#include "moui/widgets/animation_engine.h"
+#include "moui/widgets/rasterization_cache.h"
 #include "moui/widgets/widget_view.h"
 
 namespace {
@@ -51,17 +55,43 @@ float CalculatePoints(const moui::Widget::Unit unit, const float value,
 
 namespace moui {
 
+bool Widget::RasterizationInputs::operator==(
+    const RasterizationInputs& other) const {
+  if (width != other.width || height != other.height ||
+      scale_factor != other.scale_factor ||
+      rendering_offset.x != other.rendering_offset.x ||
+      rendering_offset.y != other.rendering_offset.y ||
+      rendering_scale != other.rendering_scale ||
+      is_opaque != other.is_opaque) {
+    return false;
+  }
+  // The background color is only rendered if the widget is opaque.
+  if (!is_opaque)
+    return true;
+  for (int i = 0; i < 4; ++i) {
+    if (background_color.rgba[i] != other.background_color.rgba[i])
+      return false;
+  }
+  return true;
+}
+
 Widget::Widget(const bool caches_rendering)
-    : alpha_(1), animation_count_(0),
-      background_color_(nvgRGBA(255, 255, 255, 255)), bottom_padding_(0),
+    : alpha_(1), background_color_(nvgRGBA(255, 255, 255, 255)),
+      bottom_padding_(0),
       box_sizing_(BoxSizing::kContentBox), caches_rendering_(caches_rendering),
       default_framebuffer_(nullptr), frees_children_on_destruction_(false),
       height_unit_(Unit::kPoint), height_value_(0), hidden_(false),
       is_visible_(false), left_padding_(0), is_opaque_(true),
-      measured_scale_(-1), parent_(nullptr), paused_animation_(false),
+      layer_framebuffer_(nullptr), measured_scale_(-1),
+      number_of_layer_animations_(0), parent_(nullptr),
+      paused_animation_(false),
+      presentation_alpha_(-1), presentation_offset_({0, 0}),
+      presentation_scale_(-1),
       real_parent_(nullptr), render_function_(NULL), rendering_offset_({0, 0}),
       rendering_scale_(1), right_padding_(0), scale_(1),
-      should_redraw_default_framebuffer_(false), tag_(0), top_padding_(0),
+      shared_framebuffer_(nullptr), should_redraw_default_framebuffer_(false),
+      should_redraw_layer_(false), tag_(0), top_padding_(0),
+      view_animation_interval_(0),
       widget_view_(nullptr), width_unit_(Unit::kPoint), width_value_(0),
       x_alignment_(Alignment::kLeft), x_unit_(Unit::kPoint), x_value_(0),
       y_alignment_(Alignment::kTop), y_unit_(Unit::kPoint), y_value_(0) {
@@ -71,8 +101,14 @@ Widget::Widget() : Widget(false) {
 }
 
 Widget::~Widget() {
+  AnimationEngine::GetSharedEngine()->CancelAnimations(this);
   StopAnimation(true);
   set_widget_view(nullptr);
+  nvgDeleteFramebuffer(default_framebuffer_);
+  nvgDeleteFramebuffer(layer_framebuffer_);
+  // The shared framebuffer is released with the context it was created in.
+  if (shared_framebuffer_ != nullptr)
+    ReleaseSharedFramebuffer(shared_framebuffer_->ctx);
   if (frees_children_on_destruction_) {
     for (Widget* child : children_)
       delete child;
@@ -158,8 +194,10 @@ void Widget::NotifyContextChange(NVGcontext* old_context,
   if (old_context == new_context)
     return;
 
-  if (old_context != nullptr)
+  if (old_context != nullptr) {
+    DeleteLayerFramebuffer();
     ContextWillChange(old_context);
+  }
   ContextDidChange(new_context);
 }
 
@@ -181,9 +219,23 @@ bool Widget::CollidePoint(const Point point, const float top_padding,
           point.y < (origin.y + size.height + bottom_padding));
 }
 
+void Widget::CompositeLayer(NVGcontext* context) {
+  nvgBeginPath(context);
+  nvgRect(context, 0, 0, GetWidth(), GetHeight());
+  nvgFillPaint(context, layer_paint_);
+  nvgFill(context);
+}
+
 void Widget::ContextWillChange(NVGcontext* context) {
   nvgDeleteFramebuffer(default_framebuffer_);
   default_framebuffer_ = nullptr;
+  ReleaseSharedFramebuffer(context);
+}
+
+void Widget::DeleteLayerFramebuffer() {
+  nvgDeleteFramebuffer(layer_framebuffer_);
+  layer_framebuffer_ = nullptr;
+  should_redraw_layer_ = true;
 }
 
 void Widget::EndFramebufferUpdates() {
@@ -208,6 +260,12 @@ void Widget::ExecuteRenderFunction(NVGcontext* context) {
   }
 }
 
+double Widget::GetAnimationInterval() const {
+  if (animation_intervals_.empty())
+    return 0;
+  return *animation_intervals_.begin();
+}
+
 float Widget::GetHeight() const {
   float parent_height = parent_ == nullptr ? 0 : parent_->GetHeight();
   if (box_sizing_ == BoxSizing::kBorderBox) {
@@ -289,6 +347,14 @@ void Widget::GetOccupiedSpace(Size* size) const {
   size->height *= scale_;
 }
 
+float Widget::GetPresentationAlpha() const {
+  return presentation_alpha_ < 0 ? alpha_ : presentation_alpha_;
+}
+
+float Widget::GetPresentationScale() const {
+  return presentation_scale_ > 0 ? presentation_scale_ : scale_;
+}
+
 float Widget::GetScaledHeight() const {
   return GetHeight() * scale_;
 }
@@ -402,6 +468,7 @@ float Widget::GetY() const {
 void Widget::HandleMemoryWarning(NVGcontext* context) {
   nvgDeleteFramebuffer(default_framebuffer_);
   default_framebuffer_ = nullptr;
+  ReleaseSharedFramebuffer(context);
 }
 
 bool Widget::InsertChildAboveSibling(Widget* child, Widget* sibling) {
@@ -437,7 +504,7 @@ bool Widget::InsertChildBelowSibling(Widget* child, Widget* sibling) {
 }
 
 bool Widget::IsAnimating() const {
-  return animation_count_ > 0;
+  return !animation_intervals_.empty();
 }
 
 bool Widget::IsChild(Widget* parent) {
@@ -455,14 +522,52 @@ bool Widget::IsHidden() const {
   return hidden_;
 }
 
+bool Widget::NeedsRendering() const {
+  if (IsAnimating() || should_redraw_default_framebuffer_)
+    return true;
+  if (caches_rendering_)
+    return default_framebuffer_ == nullptr && shared_framebuffer_ == nullptr;
+  return render_function_ != NULL || typeid(*this) != typeid(Widget);
+}
+
+void Widget::Recomposite() {
+  // The presentation values are part of the layers of the ancestors.
+  for (Widget* ancestor = real_parent_; ancestor != nullptr;
+       ancestor = ancestor->real_parent_) {
+    if (ancestor->number_of_layer_animations_ > 0)
+      ancestor->should_redraw_layer_ = true;
+  }
+  if (widget_view_ != nullptr)
+    widget_view_->Recomposite();
+}
+
 void Widget::Redraw() {
   if (caches_rendering_) {
     should_redraw_default_framebuffer_ = true;
   }
+  for (Widget* widget = this; widget != nullptr;
+       widget = widget->real_parent_) {
+    if (widget->number_of_layer_animations_ > 0)
+      widget->should_redraw_layer_ = true;
+  }
   if (widget_view_ != nullptr)
     widget_view_->Redraw(this);
 }
 
+void Widget::ReleaseLayer() {
+  if (--number_of_layer_animations_ == 0)
+    DeleteLayerFramebuffer();
+}
+
+void Widget::ReleaseSharedFramebuffer(NVGcontext* context) {
+  if (shared_framebuffer_ == nullptr)
+    return;
+  RasterizationCache::GetSharedCache()->ReleaseFramebuffer(
+      context, shared_framebuffer_);
+  shared_framebuffer_ = nullptr;
+  shared_framebuffer_key_.clear();
+}
+
 bool Widget::RemoveChild(Widget* child) {
   auto iterator = std::find(children_.begin(), children_.end(), child);
   if (iterator == children_.end())
@@ -483,7 +588,7 @@ bool Widget::RemoveFromParent() {
 }
 
 void Widget::RenderDefaultFramebuffer(NVGcontext* context) {
-  if (!caches_rendering_)
+  if (!caches_rendering_ || RenderSharedFramebuffer(context))
     return;
 
   // Resets the default framebuffer if the widget's size has been changed.
@@ -530,7 +635,8 @@ bool Widget::RenderFunctionIsBinded() const {
 }
 
 void Widget::RenderOnDemand(NVGcontext* context) {
-  if (caches_rendering_ && default_framebuffer_ != nullptr) {
+  if (caches_rendering_ && (default_framebuffer_ != nullptr ||
+                            shared_framebuffer_ != nullptr)) {
     nvgBeginPath(context);
     nvgRect(context, 0, 0, GetWidth(), GetHeight());
     nvgFillPaint(context, default_framebuffer_paint_);
@@ -540,6 +646,79 @@ void Widget::RenderOnDemand(NVGcontext* context) {
   }
 }
 
+bool Widget::RenderSharedFramebuffer(NVGcontext* context) {
+  if (IsAnimating()) {
+    ReleaseSharedFramebuffer(context);
+    return false;
+  }
+
+  const float kWidth = GetWidth();
+  const float kHeight = GetHeight();
+  RasterizationInputs inputs;
+  inputs.width = kWidth;
+  inputs.height = kHeight;
+  inputs.scale_factor = Device::GetScreenScaleFactor() * GetMeasuredScale();
+  inputs.rendering_offset = rendering_offset_;
+  inputs.rendering_scale = rendering_scale_;
+  inputs.is_opaque = is_opaque_;
+  inputs.background_color = background_color_;
+
+  // Keeps the retained framebuffer without building the key again until the
+  // widget is redrawn or the attributes appended to the key change.
+  if (shared_framebuffer_ != nullptr && !should_redraw_default_framebuffer_ &&
+      inputs == shared_framebuffer_inputs_) {
+    return true;
+  }
+
+  std::string key;
+  if (!GetRasterizationKey(&key)) {
+    ReleaseSharedFramebuffer(context);
+    return false;
+  }
+
+  // Appends the attributes rendered by every widget to the key.
+  key += "|" + std::to_string(static_cast<int>(kWidth * inputs.scale_factor)) +
+         "x" + std::to_string(static_cast<int>(kHeight * inputs.scale_factor)) +
+         "|" + std::to_string(inputs.scale_factor) + "|" +
+         std::to_string(rendering_offset_.x) + "," +
+         std::to_string(rendering_offset_.y) + "|" +
+         std::to_string(rendering_scale_);
+  if (is_opaque_) {
+    for (const float kComponent : background_color_.rgba)
+      key += "|" + std::to_string(kComponent);
+  }
+  if (shared_framebuffer_ != nullptr && key == shared_framebuffer_key_) {
+    shared_framebuffer_inputs_ = inputs;
+    should_redraw_default_framebuffer_ = false;
+    return true;
+  }
+
+  ReleaseSharedFramebuffer(context);
+  RasterizationCache* cache = RasterizationCache::GetSharedCache();
+  NVGframebuffer* framebuffer = cache->FindFramebuffer(context, key);
+  if (framebuffer == nullptr) {
+    float scale_factor;
+    if (!BeginFramebufferUpdates(context, &framebuffer, &scale_factor))
+      return false;
+    nvgBeginFrame(context, kWidth, kHeight, scale_factor);
+    ExecuteRenderFunction(context);
+    nvgEndFrame(context);
+    EndFramebufferUpdates();
+    framebuffer = cache->AddFramebuffer(context, key, framebuffer);
+  }
+  shared_framebuffer_ = framebuffer;
+  shared_framebuffer_inputs_ = inputs;
+  shared_framebuffer_key_ = key;
+  default_framebuffer_paint_ = nvgImagePattern(context, 0, 0, kWidth, kHeight,
+                                               0, framebuffer->image, 1);
+
+  // The own framebuffer is no longer needed while sharing.
+  nvgDeleteFramebuffer(default_framebuffer_);
+  default_framebuffer_ = nullptr;
+  should_redraw_default_framebuffer_ = false;
+  return true;
+}
+
 void Widget::ResetMeasuredScale() {
   measured_scale_ = -1;
   Redraw();
@@ -551,6 +730,11 @@ void Widget::ResetMeasuredScaleRecursively(Widget* widget) {
     ResetMeasuredScaleRecursively(child);
 }
 
+void Widget::RetainLayer() {
+  if (number_of_layer_animations_++ == 0)
+    should_redraw_layer_ = true;
+}
+
 bool Widget::SendChildToBack(Widget* child) {
   if (!children_.empty()) {
     auto iterator = std::find(children_.begin(), children_.end(), child);
@@ -659,22 +843,51 @@ bool Widget::ShouldHandleEvent(const Point location) {
 }
 
 void Widget::StartAnimation() {
-  if (animation_count_++ == 0 && !paused_animation_) {
-    if (is_visible_ && widget_view_ != nullptr)
-      widget_view_->StartAnimation();
-    else
+  StartAnimation(0);
+}
+
+void Widget::StartAnimation(const double interval) {
+  const bool kWasAnimating = IsAnimating();
+  animation_intervals_.insert(std::max(0.0, interval));
+  if (kWasAnimating) {
+    UpdateViewAnimationInterval();
+  } else if (!paused_animation_) {
+    if (is_visible_ && widget_view_ != nullptr) {
+      view_animation_interval_ = GetAnimationInterval();
+      widget_view_->StartAnimation(view_animation_interval_);
+    } else {
       paused_animation_ = true;
+    }
   }
 }
 
 void Widget::StopAnimation(const bool force) {
-  const bool kIsAnimating = IsAnimating();
-  animation_count_ = force ? 0 : std::max(0, animation_count_ - 1);
-  if (kIsAnimating && animation_count_ == 0) {
-    if (paused_animation_)
-      paused_animation_ = false;
-    else
-      widget_view_->StopAnimation();
+  if (!force) {
+    StopAnimation(0.0);
+    return;
+  }
+  if (!IsAnimating())
+    return;
+
+  // Keeps a single request and ends it the regular way.
+  const double kInterval = *animation_intervals_.begin();
+  animation_intervals_.clear();
+  animation_intervals_.insert(kInterval);
+  StopAnimation(kInterval);
+}
+
+void Widget::StopAnimation(const double interval) {
+  auto iterator = animation_intervals_.find(std::max(0.0, interval));
+  if (iterator == animation_intervals_.end())
+    return;
+  animation_intervals_.erase(iterator);
+
+  if (IsAnimating()) {
+    UpdateViewAnimationInterval();
+  } else if (paused_animation_) {
+    paused_animation_ = false;
+  } else {
+    widget_view_->StopAnimation(view_animation_interval_);
   }
 }
 
@@ -682,6 +895,20 @@ void Widget::UnbindRenderFunction() {
   render_function_ = NULL;
 }
 
+void Widget::UpdateViewAnimationInterval() {
+  if (!IsAnimating() || paused_animation_)
+    return;
+
+  const double kInterval = GetAnimationInterval();
+  if (kInterval == view_animation_interval_)
+    return;
+  // Starts the new request before ending the old one so the native view never
+  // stops updating in between.
+  widget_view_->StartAnimation(kInterval);
+  widget_view_->StopAnimation(view_animation_interval_);
+  view_animation_interval_ = kInterval;
+}
+
 void Widget::set_alpha(const float alpha) {
   float revised_alpha = alpha;
   if (alpha > 1)
@@ -735,14 +962,37 @@ void Widget::set_is_visible(const bool is_visible) {
 
   if (is_visible && paused_animation_ && widget_view_ != nullptr) {
     paused_animation_ = false;
-    widget_view_->StartAnimation();
+    view_animation_interval_ = GetAnimationInterval();
+    widget_view_->StartAnimation(view_animation_interval_);
   } else if (!is_visible && !paused_animation_ && IsAnimating()) {
     paused_animation_ = true;
-    widget_view_->StopAnimation();
+    widget_view_->StopAnimation(view_animation_interval_);
   }
   is_visible_ = is_visible;
 }
 
+void Widget::set_presentation_alpha(const float alpha) {
+  if (alpha != presentation_alpha_) {
+    presentation_alpha_ = alpha < 0 ? -1 : std::min(1.0f, alpha);
+    Recomposite();
+  }
+}
+
+void Widget::set_presentation_offset(const Point offset) {
+  if (offset.x != presentation_offset_.x ||
+      offset.y != presentation_offset_.y) {
+    presentation_offset_ = offset;
+    Recomposite();
+  }
+}
+
+void Widget::set_presentation_scale(const float scale) {
+  if (scale != presentation_scale_) {
+    presentation_scale_ = scale;
+    Recomposite();
+  }
+}
+
 void Widget::set_rendering_offset(const Point offset) {
   if (offset.x == rendering_offset_.x && offset.y == rendering_offset_.y)
     return;
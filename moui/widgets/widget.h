@@ -19,6 +19,7 @@
 #define MOUI_WIDGETS_WIDGET_H_
 
 #include <functional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -102,6 +103,12 @@ class Widget {
                     const float right_padding, const float bottom_padding,
                     const float left_padding);
 
+  // Returns the interval in seconds between the frames required by the
+  // widget's animations, which is the smallest interval passed to
+  // `StartAnimation()`. Returns 0 if the widget updates on every refresh of
+  // the display or is not animating.
+  double GetAnimationInterval() const;
+
   // Returns the height in points.
   float GetHeight() const;
 
@@ -224,11 +231,21 @@ class Widget {
   // nothing happened.
   void StartAnimation();
 
+  // Same as `StartAnimation()` but the animation only changes the widget's
+  // visual state every `interval` seconds, which allows the widget view to
+  // skip the refreshes in between as long as no other animation requires
+  // them.
+  void StartAnimation(const double interval);
+
   // Stops animation. If `force` is `true`, animation stops immediately no
-  // matter how many times `StartAnimation()` is called. Otherwise, the same
-  // number of
+  // matter how many times `StartAnimation()` is called. Otherwise, one
+  // `StartAnimation()` call is ended.
   void StopAnimation(const bool force);
 
+  // Ends one `StartAnimation(interval)` call made with the same `interval`.
+  // Nothing happens if there is no such call.
+  void StopAnimation(const double interval);
+
   // Unbinds the render function.
   void UnbindRenderFunction();
 
@@ -307,6 +324,19 @@ class Widget {
   // `BeginFramebufferUpdates()`.
   void EndFramebufferUpdates();
 
+  // Returns `true` and sets `key` if the rendering result of `Render()` can
+  // be shared through `RasterizationCache` with other widgets returning the
+  // same key. The key must identify everything affecting the rendering
+  // result except the widget's size, scale and background, which are
+  // appended automatically, so it usually consists of the class name, the
+  // state and the style attributes. This method is only called if
+  // `caches_rendering_` is true and the widget is not animating. Once a
+  // framebuffer is shared, the key is only requested again after `Redraw()`
+  // or a change of the size, scale or background, so changes of the state
+  // affecting the key must call `Redraw()`. The default implementation
+  // returns `false` and the widget renders in its own framebuffer.
+  virtual bool GetRasterizationKey(std::string* key) const { return false; }
+
   // This method gets called when the widget received an event. In order to
   // receive an event, the `ShouldHandleEvent()` method must return `true`.
   // The actual implementation should be done in subclass and the passed event
@@ -377,13 +407,51 @@ class Widget {
   virtual void WidgetWillRender(NVGcontext* context) {}
 
  private:
+  friend class AnimationEngine;
   friend class WidgetView;
 
+  // The attributes appended to the key returned by `GetRasterizationKey()`
+  // for every widget.
+  struct RasterizationInputs {
+    float width;
+    float height;
+    float scale_factor;
+    Point rendering_offset;
+    float rendering_scale;
+    bool is_opaque;
+    NVGcolor background_color;
+
+    bool operator==(const RasterizationInputs& other) const;
+  };
+
+  // Draws `layer_framebuffer_` in place of the widget and its descendants.
+  void CompositeLayer(NVGcontext* context);
+
+  // Deletes `layer_framebuffer_` so the layer is rasterized again if still
+  // retained.
+  void DeleteLayerFramebuffer();
+
   // Executes either the binded `render_function_` or `Render()` if no render
   // function is binded. This method respects the `rendering_offset_` and it
   // also fills the background color if the widget is opaque.
   void ExecuteRenderFunction(NVGcontext* context);
 
+  // Returns the alpha value applied when compositing the widget, which is
+  // `presentation_alpha_` if set or `alpha_` otherwise.
+  float GetPresentationAlpha() const;
+
+  // Returns the scale applied when compositing the widget, which is
+  // `presentation_scale_` if set or `scale_` otherwise.
+  float GetPresentationScale() const;
+
+  // Returns `true` if compositing the widget's cached rasterization again
+  // isn't enough to display the widget's current state, that is, the widget
+  // is animating, was asked to redraw, has no rasterization yet, or renders
+  // on every frame. Only plain `Widget` instances without a render function
+  // are composited without caching their rendering, as they render nothing
+  // but the background color.
+  bool NeedsRendering() const;
+
   // Notifies that the corresponded context has been changed. This method
   // would call `ContextWillChange()` and `ContextDidChange()` on demand.
   void NotifyContextChange(NVGcontext* old_context, NVGcontext* new_context);
@@ -393,6 +461,13 @@ class Widget {
   // Calls the child widget's `RemoveFromParent()` method instead.
   bool RemoveChild(Widget* child);
 
+  // Releases a layer retained by `RetainLayer()`. The layer framebuffer is
+  // deleted once no compositor-only animation retains the layer.
+  void ReleaseLayer();
+
+  // Releases `shared_framebuffer_` back to `RasterizationCache` if retained.
+  void ReleaseSharedFramebuffer(NVGcontext* context);
+
   // Renders `Render()` in `default_framebuffer_` if `caches_rendering_` is
   // true. Note that this method should only be called by
   // `WidgetView::RenderWidget()`.
@@ -402,16 +477,45 @@ class Widget {
   // `caches_rendering_` is true.
   void RenderOnDemand(NVGcontext* context);
 
+  // Retains the framebuffer shared with other widgets returning the same
+  // `GetRasterizationKey()`, and renders `Render()` in it if no widget did.
+  // Returns `false` if the widget should render in `default_framebuffer_`
+  // instead.
+  bool RenderSharedFramebuffer(NVGcontext* context);
+
+  // Asks the widget view to composite the widgets again without rendering
+  // them. This is called whenever a presentation value changes, which also
+  // outdates the layers of the ancestors.
+  void Recomposite();
+
+  // Asks the widget view to rasterize the widget and its descendants into
+  // `layer_framebuffer_` once and composite the layer in their place, which
+  // is called when a compositor-only animation of the widget starts. The
+  // layer is rasterized again only if a widget in it redraws or animates on
+  // its own. Every call must be balanced by `ReleaseLayer()`.
+  void RetainLayer();
+
   // Resets the `measured_scale_` property so the value will be re-calculated
   // the next time calling `GetMeasuredScale()`.
   void ResetMeasuredScale();
 
+  // Requests the widget view to animate at `GetAnimationInterval()` instead of
+  // `view_animation_interval_` if they differ and the widget's animation is
+  // not paused.
+  void UpdateViewAnimationInterval();
+
   // Resets the measured scale for the passed widget and all of its descendants
   // recursively.
   void ResetMeasuredScaleRecursively(Widget* widget);
 
   // This setters that should only be called by the `WidgetView` class.
   void set_is_visible(const bool is_visible);
+
+  // The setters of the presentation values that should only be called by the
+  // `AnimationEngine` class.
+  void set_presentation_alpha(const float alpha);
+  void set_presentation_offset(const Point offset);
+  void set_presentation_scale(const float scale);
   void set_widget_view(WidgetView* widget_view);
 
   // The opacity value of the widget, specified as a value from 0.0 to 1.0.
@@ -419,9 +523,10 @@ class Widget {
   // interpreted as 1.0. The default value is 1.0.
   float alpha_;
 
-  // The number of animation reuqests that updated by `StartAnimation()` and
-  // `StopAnimation()`. The widget is animating if this value is greater than 0.
-  int animation_count_;
+  // The intervals of the animation requests made by `StartAnimation()` calls.
+  // `StopAnimation()` removes the one matching its interval. The widget is
+  // animating if this is not empty.
+  std::multiset<double> animation_intervals_;
 
   // The background color of the widget that will be rendered automatically if
   // `is_opaque_` is true. The default color is white.
@@ -447,7 +552,8 @@ class Widget {
   // `caches_rendering_` is set to `true`.
   NVGframebuffer* default_framebuffer_;
 
-  // The `NVGpaint` object corresonded to the `default_framebuffer_`.
+  // The `NVGpaint` object corresonded to the `default_framebuffer_` or the
+  // `shared_framebuffer_`.
   NVGpaint default_framebuffer_paint_;
 
   // Indicates whether all the widget's children should be freed when
@@ -478,12 +584,22 @@ class Widget {
   // Indicates if the widget is visible to the corresponded widget view.
   bool is_visible_;
 
+  // The framebuffer the widget and its descendants are rasterized into while
+  // a layer is retained, and the `NVGpaint` object corresponded to it. The
+  // framebuffer is `nullptr` until the layer is rasterized.
+  NVGframebuffer* layer_framebuffer_;
+  NVGpaint layer_paint_;
+
   // Keeps the calculated scale related to the corresponded widget view's
   // coordinate system. This property should never be accessed directly.
   // Instead, calling the `GetMeasuredScale()` method to retrieve this value
   // and calling `ResetMeasuredScale()` to reset this value.
   float measured_scale_;
 
+  // The number of compositor-only animations retaining the layer of the
+  // widget. The widget is composited from `layer_framebuffer_` if positive.
+  int number_of_layer_animations_;
+
   // Keeps the pointer to the logical parent widget of the current widget. The
   // logical parent can be changed through `set_parent()` in inherited widgets
   // whenever needed.
@@ -493,6 +609,16 @@ class Widget {
   // currently invisible to the corresponded widget view..
   bool paused_animation_;
 
+  // The values applied when compositing the widget while `AnimationEngine`
+  // animates its alpha, position or scale. Unlike the regular properties,
+  // changing them neither runs the layout hooks nor renders the widget
+  // again, and its cached rasterization is composited as is. The alpha value
+  // replaces `alpha_` unless negative, the offset in points is added to the
+  // position, and the scale replaces `scale_` unless not positive.
+  float presentation_alpha_;
+  Point presentation_offset_;
+  float presentation_scale_;
+
   // Keeps the real parent widget of the current widget. Unlike the logical
   // `parent_` property. This value is always pointing to the real parent
   // widget and cannot be changed manually.
@@ -517,12 +643,27 @@ class Widget {
   // The default value is 1.
   float scale_;
 
+  // The framebuffer retained from `RasterizationCache` that is rendered
+  // instead of `default_framebuffer_`, and the key and the attributes it was
+  // retained with. The framebuffer is `nullptr` if the rendering result is
+  // not shared.
+  NVGframebuffer* shared_framebuffer_;
+  RasterizationInputs shared_framebuffer_inputs_;
+  std::string shared_framebuffer_key_;
+
   // Indicates whether the `default_framebuffer_` should be drawn.
   bool should_redraw_default_framebuffer_;
 
+  // Indicates whether `layer_framebuffer_` should be rasterized again.
+  bool should_redraw_layer_;
+
   // The padding in points on the top side of the widget.
   float top_padding_;
 
+  // The interval of the animation requested from `widget_view_` while the
+  // widget is animating and its animation is not paused.
+  double view_animation_interval_;
+
   // The `WidgetView` that manages this widget instance.
   WidgetView* widget_view_;
 
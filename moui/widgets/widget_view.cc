@@ -20,23 +20,33 @@
 #include <algorithm>
 #include <stack>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
+#include "moui/core/clock.h"
 #include "moui/core/device.h"
 #include "moui/core/event.h"
+#include "moui/core/gpu_memory_tracker.h"
 #include "moui/defines.h"
 #include "moui/native/native_view.h"
 #include "moui/nanovg_hook.h"
 #include "moui/ui/view.h"
+#include "moui/widgets/animation_engine.h"
+#include "moui/widgets/font_registry.h"
+#include "moui/widgets/glyph_atlas.h"
+#include "moui/widgets/icon_atlas.h"
+#include "moui/widgets/image_cache.h"
+#include "moui/widgets/rasterization_cache.h"
 #include "moui/widgets/scroll_view.h"
+#include "moui/widgets/text_measurement_cache.h"
 #include "moui/widgets/widget.h"
 
 namespace moui {
 
 WidgetView::WidgetView(const int context_flags)
     : context_(nullptr), context_flags_(context_flags),
-      preparing_for_rendering_(false), requests_redraw_(false),
-      root_widget_(new Widget) {
+      needs_full_render_(true), preparing_for_rendering_(false),
+      requests_redraw_(false), root_widget_(new Widget) {
   root_widget_->set_widget_view(this);
 }
 
@@ -45,8 +55,47 @@ WidgetView::WidgetView() : WidgetView(nvgContextFlags(true, true, 3)) {
 
 WidgetView::~WidgetView() {
   delete root_widget_;
-  if (context_ != nullptr)
+  if (context_ != nullptr) {
+    FontRegistry::GetSharedRegistry()->RemoveContext(context_);
+    GlyphAtlas::GetSharedAtlas()->RemoveContext(context_);
+    IconAtlas::GetSharedAtlas()->RemoveContext(context_);
+    ImageCache::GetSharedCache()->RemoveContext(context_);
+    RasterizationCache::GetSharedCache()->RemoveContext(context_);
+    GpuMemoryTracker::GetSharedTracker()->RemoveContext(context_);
+    TextMeasurementCache::GetSharedCache()->RemoveResultsForContext(context_);
     nvgDeleteContext(context_);
+  }
+}
+
+bool WidgetView::Composite() {
+  if (context_ == nullptr || visible_widgets_.empty())
+    return false;
+
+  // Populates the widgets again as the presentation values may move them.
+  // Widgets becoming visible must be prepared for rendering first.
+  const std::vector<Widget*> kPreviousVisibleWidgets = visible_widgets_;
+  visible_widgets_.clear();
+  WidgetList widget_list;
+  PopulateWidgetList(0, root_widget_->GetMeasuredScale(), &widget_list,
+                     root_widget_, nullptr);
+  bool can_composite = visible_widgets_ == kPreviousVisibleWidgets;
+  for (WidgetItem* item : widget_list) {
+    if (!can_composite)
+      break;
+    if (item->layer_item == nullptr) {
+      can_composite = !item->widget->NeedsRendering();
+    } else if (item->layer_item == item) {
+      can_composite = item->widget->layer_framebuffer_ != nullptr &&
+                      !item->widget->should_redraw_layer_;
+    }
+  }
+  if (!can_composite) {
+    for (WidgetItem* item : widget_list)
+      reusable_widget_items_.push(item);
+    return false;
+  }
+  RenderWidgetList(root_widget_, widget_list);
+  return true;
 }
 
 void WidgetView::HandleEvent(Event* event) {
@@ -128,10 +177,24 @@ void WidgetView::HandleEvent(Event* event) {
 }
 
 void WidgetView::HandleMemoryWarning() {
+  needs_full_render_ = true;
+  if (context_ != nullptr) {
+    GlyphAtlas::GetSharedAtlas()->RemoveContext(context_);
+    IconAtlas::GetSharedAtlas()->RemoveContext(context_);
+  }
+  TextMeasurementCache::GetSharedCache()->Clear();
   HandleMemoryWarningRecursively(root_widget_);
+  // Evicts images and rasterizations after widgets had the chance to release
+  // them.
+  if (context_ != nullptr) {
+    ImageCache::GetSharedCache()->EvictUnreferencedImages(context_);
+    RasterizationCache::GetSharedCache()->EvictUnreferencedFramebuffers(
+        context_);
+  }
 }
 
 void WidgetView::HandleMemoryWarningRecursively(moui::Widget* widget) {
+  widget->DeleteLayerFramebuffer();
   widget->HandleMemoryWarning(context_);
   for (Widget* child_widget : *(widget->children()))
     HandleMemoryWarningRecursively(child_widget);
@@ -141,7 +204,15 @@ void WidgetView::OnSurfaceDestroyed() {
   if (context_ == nullptr)
     return;
 
+  needs_full_render_ = true;
   SetWidgetContextRecursively(root_widget_, context_, nullptr);
+  FontRegistry::GetSharedRegistry()->RemoveContext(context_);
+  GlyphAtlas::GetSharedAtlas()->RemoveContext(context_);
+  IconAtlas::GetSharedAtlas()->RemoveContext(context_);
+  ImageCache::GetSharedCache()->RemoveContext(context_);
+  RasterizationCache::GetSharedCache()->RemoveContext(context_);
+  GpuMemoryTracker::GetSharedTracker()->RemoveContext(context_);
+  TextMeasurementCache::GetSharedCache()->RemoveResultsForContext(context_);
   nvgDeleteContext(context_);
   context_ = nullptr;
 }
@@ -160,6 +231,45 @@ void WidgetView::PopAndFinalizeWidgetItems(const int level,
   }
 }
 
+void WidgetView::PopulateLayerWidgetList(const int level,
+                                         WidgetList* widget_list,
+                                         Widget* widget,
+                                         WidgetItem* parent_item) {
+  if (level > 0 && widget->IsHidden())
+    return;
+  const float kWidth = widget->GetWidth();
+  const float kHeight = widget->GetHeight();
+  if (kWidth <= 0 || kHeight <= 0)
+    return;
+
+  WidgetItem* item;
+  if (reusable_widget_items_.empty()) {
+    item = new WidgetItem;
+  } else {
+    item = reusable_widget_items_.front();
+    reusable_widget_items_.pop();
+  }
+  item->widget = widget;
+  item->width = kWidth;
+  item->height = kHeight;
+  item->level = level;
+  item->parent_item = parent_item;
+  item->layer_item = nullptr;
+  if (parent_item == nullptr) {
+    item->origin = {0, 0};
+    item->alpha = 1;
+    item->scale = 1;
+  } else {
+    item->origin.x = widget->GetX() + widget->presentation_offset_.x;
+    item->origin.y = widget->GetY() + widget->presentation_offset_.y;
+    item->alpha = widget->GetPresentationAlpha() * parent_item->alpha;
+    item->scale = widget->GetPresentationScale();
+  }
+  widget_list->push_back(item);
+  for (Widget* child : *(widget->children()))
+    PopulateLayerWidgetList(level + 1, widget_list, child, item);
+}
+
 // If the passed widget is visible on screen. Creates a WidgetItem object for
 // the widget and adds it to the `widget_list`. Then repeats this process for
 // its child widgets.
@@ -187,10 +297,13 @@ void WidgetView::PopulateWidgetList(const int level, const float scale,
   if (item->width <= 0) return;
   item->height = widget->GetHeight();
   if (item->height <= 0) return;
-  item->origin.x = level == 0 ? 0 : widget->GetX();
-  item->origin.y = level == 0 ? 0 : widget->GetY();
-  const float kScaledWidgetWidth = item->width * scale * widget->scale();
-  const float kScaledWidgetHeight = item->height * scale * widget->scale();
+  item->origin.x = \
+      level == 0 ? 0 : widget->GetX() + widget->presentation_offset_.x;
+  item->origin.y = \
+      level == 0 ? 0 : widget->GetY() + widget->presentation_offset_.y;
+  const float kWidgetScale = widget->GetPresentationScale();
+  const float kScaledWidgetWidth = item->width * scale * kWidgetScale;
+  const float kScaledWidgetHeight = item->height * scale * kWidgetScale;
 
   // Determines the translate origin and the scissor area.
   item->translated_origin = {0.0f, 0.0f};
@@ -198,7 +311,7 @@ void WidgetView::PopulateWidgetList(const int level, const float scale,
   item->scissor_width = kScaledWidgetWidth;
   item->scissor_height = kScaledWidgetHeight;
   if (parent_item == nullptr) {
-    item->alpha = widget->alpha();
+    item->alpha = widget->GetPresentationAlpha();
   } else {
     item->translated_origin.x = parent_item->translated_origin.x
                                 + item->origin.x * scale;
@@ -243,7 +356,7 @@ void WidgetView::PopulateWidgetList(const int level, const float scale,
         (item->scissor_origin.y + item->scissor_height - 1) < 0)
       return SetWidgetAndDescendantsInvisible(widget);
     // Determines the alpha value.
-    item->alpha = widget->alpha() * parent_item->alpha;
+    item->alpha = widget->GetPresentationAlpha() * parent_item->alpha;
   }
 
   // The widget is visible. Adds it to the widget list and checks its children.
@@ -252,22 +365,38 @@ void WidgetView::PopulateWidgetList(const int level, const float scale,
   item->widget = widget;
   item->level = level;
   item->parent_item = parent_item;
+  item->scale = kWidgetScale;
+  item->layer_item = parent_item == nullptr ? nullptr : parent_item->layer_item;
+  if (item->layer_item == nullptr && widget->number_of_layer_animations_ > 0)
+    item->layer_item = item;
+  // Widgets animating on their own outdate the layer compositing them.
+  if (item->layer_item != nullptr && widget->IsAnimating())
+    item->layer_item->widget->should_redraw_layer_ = true;
   reusable_widget_items_.pop();
   widget_list->push_back(item);
   for (Widget* child : *(widget->children())) {
     if (child->IsHidden()) {
       SetWidgetAndDescendantsInvisible(child);
     } else {
-      PopulateWidgetList(level + 1, scale * widget->scale(), widget_list,
-                         child, item);
+      PopulateWidgetList(level + 1, scale * kWidgetScale, widget_list, child,
+                         item);
     }
   }
 }
 
+void WidgetView::Recomposite() {
+  View::Redraw();
+}
+
+// Redraw requests while preparing for rendering are handled in the same frame
+// unless the view renders on every refresh anyway, since requesting another
+// frame would defeat skipping refreshes between animation intervals.
 void WidgetView::Redraw() {
-  if (!IsAnimating() && preparing_for_rendering_) {
+  if (preparing_for_rendering_ &&
+      (!IsAnimating() || GetAnimationInterval() > 0)) {
     requests_redraw_ = true;
   } else {
+    needs_full_render_ = true;
     View::Redraw();
   }
 }
@@ -300,6 +429,10 @@ void WidgetView::RemoveResponder(Widget* widget) {
 }
 
 void WidgetView::Render() {
+  AnimationEngine::GetSharedEngine()->Update(Clock::GetTimestamp());
+  if (!needs_full_render_ && Composite())
+    return;
+  needs_full_render_ = false;
   Render(root_widget_, nullptr);
 }
 
@@ -322,20 +455,73 @@ void WidgetView::Render(Widget* widget, NVGframebuffer* framebuffer) {
     WidgetViewWillRender(widget);
   }
   preparing_for_rendering_ = false;
+  IconAtlas::GetSharedAtlas()->UpdatePages(context);
   std::vector<WidgetItem*> widget_list;
   PopulateWidgetList(0, widget->GetMeasuredScale(), &widget_list, widget,
                      nullptr);
 
   // Renders offscreen stuff here so it won't interfere the onscreen rendering.
+  // Widgets in a layer are only rendered when rasterizing the layer, and are
+  // rendered directly if the layer is unavailable.
   if (framebuffer != nullptr)
     nvgBindFramebuffer(NULL);
   for (WidgetItem* item : widget_list) {
+    if (item->layer_item == item && !RenderLayer(item->widget)) {
+      for (WidgetItem* layer_item : widget_list) {
+        if (layer_item->layer_item == item)
+          layer_item->layer_item = nullptr;
+      }
+    }
+    if (item->layer_item != nullptr)
+      continue;
+    GpuMemoryTracker::ScopedOwner scoped_owner(item->widget,
+                                               typeid(*item->widget).name());
     item->widget->RenderFramebuffer(context);
     item->widget->RenderDefaultFramebuffer(context);
   }
   if (framebuffer != nullptr)
     nvgBindFramebuffer(framebuffer);
 
+  RenderWidgetList(widget, widget_list);
+
+  // Notifies all attached widgets that the rendering process is done.
+  WidgetViewDidRender(widget);
+}
+
+bool WidgetView::RenderLayer(Widget* widget) {
+  if (widget->layer_framebuffer_ != nullptr && !widget->should_redraw_layer_)
+    return true;
+
+  WidgetList widget_list;
+  PopulateLayerWidgetList(0, &widget_list, widget, nullptr);
+  for (WidgetItem* item : widget_list) {
+    GpuMemoryTracker::ScopedOwner scoped_owner(item->widget,
+                                               typeid(*item->widget).name());
+    item->widget->RenderFramebuffer(context_);
+    item->widget->RenderDefaultFramebuffer(context_);
+  }
+
+  GpuMemoryTracker::ScopedOwner scoped_owner(widget, typeid(*widget).name());
+  if (widget_list.empty() ||
+      !widget->BeginFramebufferUpdates(context_, &widget->layer_framebuffer_,
+                                       nullptr)) {
+    for (WidgetItem* item : widget_list)
+      reusable_widget_items_.push(item);
+    return false;
+  }
+  RenderWidgetList(widget, widget_list);
+  widget->EndFramebufferUpdates();
+  widget->layer_paint_ = nvgImagePattern(context_, 0, 0, widget->GetWidth(),
+                                         widget->GetHeight(), 0,
+                                         widget->layer_framebuffer_->image, 1);
+  widget->should_redraw_layer_ = false;
+  return true;
+}
+
+void WidgetView::RenderWidgetList(Widget* widget,
+                                  const WidgetList& widget_list) {
+  NVGcontext* context = context_;
+
   // Clears the render buffer.
   const float kWidth = widget->GetWidth();
   const float kHeight = widget->GetHeight();
@@ -353,15 +539,27 @@ void WidgetView::Render(Widget* widget, NVGframebuffer* framebuffer) {
 
   // Renders visible widgets on screen.
   nvgBeginFrame(context, kWidth , kHeight, kScreenScaleFactor);
+  FontRegistry::GetSharedRegistry()->WarmUpContext(context);
   WidgetItemStack rendering_stack;
   for (WidgetItem* item : widget_list) {
+    // Widgets in a layer are drawn by compositing the layer.
+    if (item->layer_item != nullptr && item->layer_item != item) {
+      reusable_widget_items_.push(item);
+      continue;
+    }
     PopAndFinalizeWidgetItems(item->level, &rendering_stack);
-    rendering_stack.push(item);
     nvgSave(context);
     nvgGlobalAlpha(context, item->alpha);
     nvgTranslate(context, item->origin.x, item->origin.y);
-    nvgScale(context, item->widget->scale(), item->widget->scale());
+    nvgScale(context, item->scale, item->scale);
     nvgIntersectScissor(context, 0, 0, item->width, item->height);
+    if (item->layer_item == item) {
+      item->widget->CompositeLayer(context);
+      nvgRestore(context);
+      reusable_widget_items_.push(item);
+      continue;
+    }
+    rendering_stack.push(item);
     item->widget->WidgetWillRender(context);
     nvgSave(context);
     item->widget->RenderOnDemand(context);
@@ -369,9 +567,6 @@ void WidgetView::Render(Widget* widget, NVGframebuffer* framebuffer) {
   }
   PopAndFinalizeWidgetItems(0, &rendering_stack);
   nvgEndFrame(context);
-
-  // Notifies all attached widgets that the rendering process is done.
-  WidgetViewDidRender(widget);
 }
 
 void WidgetView::SetBounds(const float x, const float y, const float width,
@@ -436,7 +631,11 @@ void WidgetView::WidgetViewWillRender(Widget* widget) {
   NVGcontext* context = this->context();
   bool result = false;
   while (!result) {
-    result = widget->WidgetViewWillRender(context);
+    {
+      GpuMemoryTracker::ScopedOwner scoped_owner(widget,
+                                                 typeid(*widget).name());
+      result = widget->WidgetViewWillRender(context);
+    }
 
     for (Widget* child : *(widget->children()))
       WidgetViewWillRender(child);
@@ -451,6 +650,7 @@ NVGcontext* WidgetView::context() {
     context_ = nvgCreateContext(context_flags_);
 #endif  // MOUI_METAL
     SetWidgetContextRecursively(root_widget_, nullptr, context_);
+    FontRegistry::GetSharedRegistry()->PrepareContext(context_);
   }
   return context_;
 }
@@ -45,6 +45,11 @@ class WidgetView : public View {
   // all managed widgets recursively.
   void HandleMemoryWarning() final;
 
+  // Composites the visible widgets again from their cached rasterizations on
+  // the next display refresh without running the layout hooks, unless a full
+  // redraw is required by then.
+  void Recomposite();
+
   // Inherited from `View` class.
   void Redraw() final;
 
@@ -100,6 +105,12 @@ class WidgetView : public View {
     float scissor_width;
     // The scissor's height in points of the widget.
     float scissor_height;
+    // The scale applied when rendering the widget.
+    float scale;
+    // The item of the widget whose layer composites the widget, which is the
+    // item itself if the widget composites its own layer, or `nullptr` if
+    // the widget is rendered directly.
+    WidgetItem* layer_item;
   };
 
   // Keeps a stack of widget items in the rendering hierarchy.
@@ -108,6 +119,15 @@ class WidgetView : public View {
   // Keeps a list of widget items to render in order.
   typedef std::vector<WidgetItem*> WidgetList;
 
+  // Composites the widgets visible in the last frame again with their
+  // current presentation values and cached rasterizations. Widgets in a
+  // layer are composited through the layer. Returns `false` without
+  // rendering anything if a widget outside layers needs rendering, including
+  // any widget that doesn't cache its rendering, a layer needs rasterizing,
+  // or the set of visible widgets changed, in which case a full render is
+  // required.
+  bool Composite();
+
   // Inherited from `BaseView` class.
   void HandleEvent(Event* event) final;
 
@@ -119,6 +139,13 @@ class WidgetView : public View {
   // reaching the passed level.
   void PopAndFinalizeWidgetItems(const int level, WidgetItemStack* stack);
 
+  // Populates a list of widgets to rasterize the layer of the specified
+  // `widget` in order, which consists of the widget and its descendants that
+  // are not hidden regardless of whether they are visible on screen. The
+  // widget's own presentation values are left to compositing the layer.
+  void PopulateLayerWidgetList(const int level, WidgetList* widget_list,
+                               Widget* widget, WidgetItem* parent_item);
+
   // Populates a list of widgets to render on screen in order. This method
   // itertates all children widgets and filters invisible onces.
   void PopulateWidgetList(const int level, const float scale,
@@ -135,6 +162,16 @@ class WidgetView : public View {
   // is set to `true`.
   void Render(Widget* widget, NVGframebuffer* framebuffer);
 
+  // Rasterizes the specified `widget` and its descendants into the widget's
+  // layer framebuffer if the layer needs rasterizing. Returns `false` if the
+  // layer framebuffer is unavailable.
+  bool RenderLayer(Widget* widget);
+
+  // Clears the render buffer and composites the widgets in `widget_list`,
+  // which must be populated for the specified `widget`. A widget compositing
+  // its layer draws the layer in place of itself and its descendants.
+  void RenderWidgetList(Widget* widget, const WidgetList& widget_list);
+
   // Sets the specified `widget` and all of its descendants as invisible.
   void SetWidgetAndDescendantsInvisible(Widget* widget);
 
@@ -172,6 +209,11 @@ class WidgetView : public View {
   // method. The list could be updated by `UpdateEventResponders()`.
   std::vector<Widget*> event_responders_;
 
+  // Indicates whether the next frame must run the entire rendering process
+  // instead of only compositing the widgets again. The value is set by
+  // `Redraw()` and reset by `Render()`.
+  bool needs_full_render_;
+
   // Keeps a list of reusable `WidgetItem` instances.
   std::queue<WidgetItem*> reusable_widget_items_;
 
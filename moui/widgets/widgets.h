@@ -19,19 +19,32 @@
 #define MOUI_WIDGETS_WIDGETS_H_
 
 #include "moui/widgets/activity_indicator_view.h"
+#include "moui/widgets/animation_engine.h"
 #include "moui/widgets/button.h"
 #include "moui/widgets/control.h"
+#include "moui/widgets/font_registry.h"
+#include "moui/widgets/glyph_atlas.h"
 #include "moui/widgets/grid_layout.h"
+#include "moui/widgets/grid_view.h"
+#include "moui/widgets/grid_view_cell.h"
+#include "moui/widgets/icon_atlas.h"
+#include "moui/widgets/image_cache.h"
+#include "moui/widgets/image_view.h"
 #include "moui/widgets/label.h"
 #include "moui/widgets/layout.h"
 #include "moui/widgets/linear_layout.h"
 #include "moui/widgets/page_control.h"
 #include "moui/widgets/progress_view.h"
+#include "moui/widgets/rasterization_cache.h"
+#include "moui/widgets/resource_cache.h"
+#include "moui/widgets/reuse_pool.h"
 #include "moui/widgets/scroll_view.h"
 #include "moui/widgets/scroller.h"
 #include "moui/widgets/switch.h"
 #include "moui/widgets/table_view.h"
 #include "moui/widgets/table_view_cell.h"
+#include "moui/widgets/text_measurement_cache.h"
+#include "moui/widgets/text_view.h"
 #include "moui/widgets/widget.h"
 #include "moui/widgets/widget_view.h"
 
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# Copyright (c) 2017 Ollix. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# ---
+# Author: olliwang@ollix.com (Olli Wang)
+#
+# This script packs the files in a resource directory into a single archive
+# that can be loaded through `moui::ResourceArchive`. Files are named by
+# their paths relative to the resource directory, so the archive should be
+# placed at the root of the resource directory it replaces.
+#
+# Usage: pack_resources.py <resource directory> <archive path>
+
+import os
+import struct
+import sys
+
+MAGIC = b'MOUIPACK'
+VERSION = 1
+ALIGNMENT = 16
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def collect_files(directory, excluded_path):
+    files = []
+    for root, dirnames, filenames in os.walk(directory):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(root, filename)
+            if filename.startswith('.') or \
+               os.path.abspath(path) == excluded_path:
+                continue
+            name = os.path.relpath(path, directory).replace(os.sep, '/')
+            files.append((name.encode('utf-8'), path))
+    return files
+
+
+def pack(directory, archive_path):
+    files = collect_files(directory, os.path.abspath(archive_path))
+
+    index_size = 16 + sum(8 + 8 + 4 + len(name) for name, _ in files)
+    entries = []
+    offset = align(index_size)
+    for name, path in files:
+        size = os.path.getsize(path)
+        entries.append((name, path, offset, size))
+        offset = align(offset + size)
+
+    with open(archive_path, 'wb') as archive:
+        archive.write(MAGIC + struct.pack('<II', VERSION, len(entries)))
+        for name, _, offset, size in entries:
+            archive.write(struct.pack('<QQI', offset, size, len(name)))
+            archive.write(name)
+        for _, path, offset, _ in entries:
+            archive.write(b'\0' * (offset - archive.tell()))
+            with open(path, 'rb') as packed_file:
+                archive.write(packed_file.read())
+    return len(entries)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('Usage: %s <resource directory> <archive path>' %
+                 os.path.basename(sys.argv[0]))
+    number_of_files = pack(sys.argv[1], sys.argv[2])
+    print('Packed %d files into %s' % (number_of_files, sys.argv[2]))
+
+
+if __name__ == '__main__':
+    main()